@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dist-cache.dir/main.cpp.o"
+  "CMakeFiles/dist-cache.dir/main.cpp.o.d"
+  "dist-cache"
+  "dist-cache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dist-cache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../run_benchmark"
+  "../run_benchmark.pdb"
+  "CMakeFiles/run_benchmark.dir/benchmark.cpp.o"
+  "CMakeFiles/run_benchmark.dir/benchmark.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/run_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
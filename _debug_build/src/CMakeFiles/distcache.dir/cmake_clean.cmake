@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/distcache.dir/__/main.cpp.o"
+  "CMakeFiles/distcache.dir/__/main.cpp.o.d"
+  "distcache"
+  "distcache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/distcache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,49 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/client/ClusterClient.cpp" "src/CMakeFiles/distcache_core.dir/client/ClusterClient.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/client/ClusterClient.cpp.o.d"
+  "/root/repo/src/cluster/AntiEntropy.cpp" "src/CMakeFiles/distcache_core.dir/cluster/AntiEntropy.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/AntiEntropy.cpp.o.d"
+  "/root/repo/src/cluster/HashRing.cpp" "src/CMakeFiles/distcache_core.dir/cluster/HashRing.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/HashRing.cpp.o.d"
+  "/root/repo/src/cluster/HintedHandoff.cpp" "src/CMakeFiles/distcache_core.dir/cluster/HintedHandoff.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/HintedHandoff.cpp.o.d"
+  "/root/repo/src/cluster/MigrationManager.cpp" "src/CMakeFiles/distcache_core.dir/cluster/MigrationManager.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/MigrationManager.cpp.o.d"
+  "/root/repo/src/cluster/NodeDiscovery.cpp" "src/CMakeFiles/distcache_core.dir/cluster/NodeDiscovery.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/NodeDiscovery.cpp.o.d"
+  "/root/repo/src/cluster/QuorumCoordinator.cpp" "src/CMakeFiles/distcache_core.dir/cluster/QuorumCoordinator.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/QuorumCoordinator.cpp.o.d"
+  "/root/repo/src/cluster/Replica.cpp" "src/CMakeFiles/distcache_core.dir/cluster/Replica.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/Replica.cpp.o.d"
+  "/root/repo/src/cluster/ReplicationSource.cpp" "src/CMakeFiles/distcache_core.dir/cluster/ReplicationSource.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/cluster/ReplicationSource.cpp.o.d"
+  "/root/repo/src/monitoring/Clock.cpp" "src/CMakeFiles/distcache_core.dir/monitoring/Clock.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/monitoring/Clock.cpp.o.d"
+  "/root/repo/src/monitoring/HttpDashboard.cpp" "src/CMakeFiles/distcache_core.dir/monitoring/HttpDashboard.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/monitoring/HttpDashboard.cpp.o.d"
+  "/root/repo/src/monitoring/LatencyHistogram.cpp" "src/CMakeFiles/distcache_core.dir/monitoring/LatencyHistogram.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/monitoring/LatencyHistogram.cpp.o.d"
+  "/root/repo/src/monitoring/Logger.cpp" "src/CMakeFiles/distcache_core.dir/monitoring/Logger.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/monitoring/Logger.cpp.o.d"
+  "/root/repo/src/monitoring/MetricsCollector.cpp" "src/CMakeFiles/distcache_core.dir/monitoring/MetricsCollector.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/monitoring/MetricsCollector.cpp.o.d"
+  "/root/repo/src/network/PeerConnection.cpp" "src/CMakeFiles/distcache_core.dir/network/PeerConnection.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/network/PeerConnection.cpp.o.d"
+  "/root/repo/src/network/PeerPool.cpp" "src/CMakeFiles/distcache_core.dir/network/PeerPool.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/network/PeerPool.cpp.o.d"
+  "/root/repo/src/network/RESPParser.cpp" "src/CMakeFiles/distcache_core.dir/network/RESPParser.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/network/RESPParser.cpp.o.d"
+  "/root/repo/src/network/Socket.cpp" "src/CMakeFiles/distcache_core.dir/network/Socket.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/network/Socket.cpp.o.d"
+  "/root/repo/src/network/TCPServer.cpp" "src/CMakeFiles/distcache_core.dir/network/TCPServer.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/network/TCPServer.cpp.o.d"
+  "/root/repo/src/patterns/CircuitBreaker.cpp" "src/CMakeFiles/distcache_core.dir/patterns/CircuitBreaker.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/patterns/CircuitBreaker.cpp.o.d"
+  "/root/repo/src/patterns/CircuitBreakerRegistry.cpp" "src/CMakeFiles/distcache_core.dir/patterns/CircuitBreakerRegistry.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/patterns/CircuitBreakerRegistry.cpp.o.d"
+  "/root/repo/src/patterns/ConcurrencyLimiter.cpp" "src/CMakeFiles/distcache_core.dir/patterns/ConcurrencyLimiter.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/patterns/ConcurrencyLimiter.cpp.o.d"
+  "/root/repo/src/patterns/RetryBudget.cpp" "src/CMakeFiles/distcache_core.dir/patterns/RetryBudget.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/patterns/RetryBudget.cpp.o.d"
+  "/root/repo/src/patterns/TokenBucket.cpp" "src/CMakeFiles/distcache_core.dir/patterns/TokenBucket.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/patterns/TokenBucket.cpp.o.d"
+  "/root/repo/src/storage/LRUCache.cpp" "src/CMakeFiles/distcache_core.dir/storage/LRUCache.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/LRUCache.cpp.o.d"
+  "/root/repo/src/storage/LazySnapshot.cpp" "src/CMakeFiles/distcache_core.dir/storage/LazySnapshot.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/LazySnapshot.cpp.o.d"
+  "/root/repo/src/storage/MMapPersistence.cpp" "src/CMakeFiles/distcache_core.dir/storage/MMapPersistence.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/MMapPersistence.cpp.o.d"
+  "/root/repo/src/storage/MappedFile.cpp" "src/CMakeFiles/distcache_core.dir/storage/MappedFile.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/MappedFile.cpp.o.d"
+  "/root/repo/src/storage/MerkleTree.cpp" "src/CMakeFiles/distcache_core.dir/storage/MerkleTree.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/MerkleTree.cpp.o.d"
+  "/root/repo/src/storage/SharedMemoryStore.cpp" "src/CMakeFiles/distcache_core.dir/storage/SharedMemoryStore.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/SharedMemoryStore.cpp.o.d"
+  "/root/repo/src/storage/WAL.cpp" "src/CMakeFiles/distcache_core.dir/storage/WAL.cpp.o" "gcc" "src/CMakeFiles/distcache_core.dir/storage/WAL.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,71 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/distcache_core.dir/client/ClusterClient.cpp.o"
+  "CMakeFiles/distcache_core.dir/client/ClusterClient.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/AntiEntropy.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/AntiEntropy.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/HashRing.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/HashRing.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/HintedHandoff.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/HintedHandoff.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/MigrationManager.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/MigrationManager.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/NodeDiscovery.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/NodeDiscovery.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/QuorumCoordinator.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/QuorumCoordinator.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/Replica.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/Replica.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/cluster/ReplicationSource.cpp.o"
+  "CMakeFiles/distcache_core.dir/cluster/ReplicationSource.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/monitoring/Clock.cpp.o"
+  "CMakeFiles/distcache_core.dir/monitoring/Clock.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/monitoring/HttpDashboard.cpp.o"
+  "CMakeFiles/distcache_core.dir/monitoring/HttpDashboard.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/monitoring/LatencyHistogram.cpp.o"
+  "CMakeFiles/distcache_core.dir/monitoring/LatencyHistogram.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/monitoring/Logger.cpp.o"
+  "CMakeFiles/distcache_core.dir/monitoring/Logger.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/monitoring/MetricsCollector.cpp.o"
+  "CMakeFiles/distcache_core.dir/monitoring/MetricsCollector.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/network/PeerConnection.cpp.o"
+  "CMakeFiles/distcache_core.dir/network/PeerConnection.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/network/PeerPool.cpp.o"
+  "CMakeFiles/distcache_core.dir/network/PeerPool.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/network/RESPParser.cpp.o"
+  "CMakeFiles/distcache_core.dir/network/RESPParser.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/network/Socket.cpp.o"
+  "CMakeFiles/distcache_core.dir/network/Socket.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/network/TCPServer.cpp.o"
+  "CMakeFiles/distcache_core.dir/network/TCPServer.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/patterns/CircuitBreaker.cpp.o"
+  "CMakeFiles/distcache_core.dir/patterns/CircuitBreaker.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/patterns/CircuitBreakerRegistry.cpp.o"
+  "CMakeFiles/distcache_core.dir/patterns/CircuitBreakerRegistry.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/patterns/ConcurrencyLimiter.cpp.o"
+  "CMakeFiles/distcache_core.dir/patterns/ConcurrencyLimiter.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/patterns/RetryBudget.cpp.o"
+  "CMakeFiles/distcache_core.dir/patterns/RetryBudget.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/patterns/TokenBucket.cpp.o"
+  "CMakeFiles/distcache_core.dir/patterns/TokenBucket.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/LRUCache.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/LRUCache.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/LazySnapshot.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/LazySnapshot.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/MMapPersistence.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/MMapPersistence.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/MappedFile.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/MappedFile.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/MerkleTree.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/MerkleTree.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/SharedMemoryStore.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/SharedMemoryStore.cpp.o.d"
+  "CMakeFiles/distcache_core.dir/storage/WAL.cpp.o"
+  "CMakeFiles/distcache_core.dir/storage/WAL.cpp.o.d"
+  "libdistcache_core.a"
+  "libdistcache_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/distcache_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,43 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/test_AntiEntropy.cpp" "tests/CMakeFiles/run_tests.dir/test_AntiEntropy.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_AntiEntropy.cpp.o.d"
+  "/root/repo/tests/test_CircuitBreaker.cpp" "tests/CMakeFiles/run_tests.dir/test_CircuitBreaker.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_CircuitBreaker.cpp.o.d"
+  "/root/repo/tests/test_ClusterClient.cpp" "tests/CMakeFiles/run_tests.dir/test_ClusterClient.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_ClusterClient.cpp.o.d"
+  "/root/repo/tests/test_ConcurrencyLimiter.cpp" "tests/CMakeFiles/run_tests.dir/test_ConcurrencyLimiter.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_ConcurrencyLimiter.cpp.o.d"
+  "/root/repo/tests/test_HashRing.cpp" "tests/CMakeFiles/run_tests.dir/test_HashRing.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_HashRing.cpp.o.d"
+  "/root/repo/tests/test_HintedHandoff.cpp" "tests/CMakeFiles/run_tests.dir/test_HintedHandoff.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_HintedHandoff.cpp.o.d"
+  "/root/repo/tests/test_HttpDashboard.cpp" "tests/CMakeFiles/run_tests.dir/test_HttpDashboard.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_HttpDashboard.cpp.o.d"
+  "/root/repo/tests/test_LRUCache.cpp" "tests/CMakeFiles/run_tests.dir/test_LRUCache.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_LRUCache.cpp.o.d"
+  "/root/repo/tests/test_LatencyHistogram.cpp" "tests/CMakeFiles/run_tests.dir/test_LatencyHistogram.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_LatencyHistogram.cpp.o.d"
+  "/root/repo/tests/test_LazySnapshot.cpp" "tests/CMakeFiles/run_tests.dir/test_LazySnapshot.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_LazySnapshot.cpp.o.d"
+  "/root/repo/tests/test_Logger.cpp" "tests/CMakeFiles/run_tests.dir/test_Logger.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_Logger.cpp.o.d"
+  "/root/repo/tests/test_MMapPersistence.cpp" "tests/CMakeFiles/run_tests.dir/test_MMapPersistence.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_MMapPersistence.cpp.o.d"
+  "/root/repo/tests/test_MetricsCollector.cpp" "tests/CMakeFiles/run_tests.dir/test_MetricsCollector.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_MetricsCollector.cpp.o.d"
+  "/root/repo/tests/test_MigrationManager.cpp" "tests/CMakeFiles/run_tests.dir/test_MigrationManager.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_MigrationManager.cpp.o.d"
+  "/root/repo/tests/test_NodeDiscovery.cpp" "tests/CMakeFiles/run_tests.dir/test_NodeDiscovery.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_NodeDiscovery.cpp.o.d"
+  "/root/repo/tests/test_QuorumCoordinator.cpp" "tests/CMakeFiles/run_tests.dir/test_QuorumCoordinator.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_QuorumCoordinator.cpp.o.d"
+  "/root/repo/tests/test_RESPParser.cpp" "tests/CMakeFiles/run_tests.dir/test_RESPParser.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_RESPParser.cpp.o.d"
+  "/root/repo/tests/test_Replication.cpp" "tests/CMakeFiles/run_tests.dir/test_Replication.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_Replication.cpp.o.d"
+  "/root/repo/tests/test_RetryBudget.cpp" "tests/CMakeFiles/run_tests.dir/test_RetryBudget.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_RetryBudget.cpp.o.d"
+  "/root/repo/tests/test_SharedMemoryStore.cpp" "tests/CMakeFiles/run_tests.dir/test_SharedMemoryStore.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_SharedMemoryStore.cpp.o.d"
+  "/root/repo/tests/test_TCPServer.cpp" "tests/CMakeFiles/run_tests.dir/test_TCPServer.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_TCPServer.cpp.o.d"
+  "/root/repo/tests/test_TokenBucket.cpp" "tests/CMakeFiles/run_tests.dir/test_TokenBucket.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_TokenBucket.cpp.o.d"
+  "/root/repo/tests/test_WAL.cpp" "tests/CMakeFiles/run_tests.dir/test_WAL.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_WAL.cpp.o.d"
+  "/root/repo/tests/test_main.cpp" "tests/CMakeFiles/run_tests.dir/test_main.cpp.o" "gcc" "tests/CMakeFiles/run_tests.dir/test_main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_debug_build/src/CMakeFiles/distcache_core.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
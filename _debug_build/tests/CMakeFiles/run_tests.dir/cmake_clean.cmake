@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "../run_tests"
+  "../run_tests.pdb"
+  "CMakeFiles/run_tests.dir/test_AntiEntropy.cpp.o"
+  "CMakeFiles/run_tests.dir/test_AntiEntropy.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_CircuitBreaker.cpp.o"
+  "CMakeFiles/run_tests.dir/test_CircuitBreaker.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_ClusterClient.cpp.o"
+  "CMakeFiles/run_tests.dir/test_ClusterClient.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_ConcurrencyLimiter.cpp.o"
+  "CMakeFiles/run_tests.dir/test_ConcurrencyLimiter.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_HashRing.cpp.o"
+  "CMakeFiles/run_tests.dir/test_HashRing.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_HintedHandoff.cpp.o"
+  "CMakeFiles/run_tests.dir/test_HintedHandoff.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_HttpDashboard.cpp.o"
+  "CMakeFiles/run_tests.dir/test_HttpDashboard.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_LRUCache.cpp.o"
+  "CMakeFiles/run_tests.dir/test_LRUCache.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_LatencyHistogram.cpp.o"
+  "CMakeFiles/run_tests.dir/test_LatencyHistogram.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_LazySnapshot.cpp.o"
+  "CMakeFiles/run_tests.dir/test_LazySnapshot.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_Logger.cpp.o"
+  "CMakeFiles/run_tests.dir/test_Logger.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_MMapPersistence.cpp.o"
+  "CMakeFiles/run_tests.dir/test_MMapPersistence.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_MetricsCollector.cpp.o"
+  "CMakeFiles/run_tests.dir/test_MetricsCollector.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_MigrationManager.cpp.o"
+  "CMakeFiles/run_tests.dir/test_MigrationManager.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_NodeDiscovery.cpp.o"
+  "CMakeFiles/run_tests.dir/test_NodeDiscovery.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_QuorumCoordinator.cpp.o"
+  "CMakeFiles/run_tests.dir/test_QuorumCoordinator.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_RESPParser.cpp.o"
+  "CMakeFiles/run_tests.dir/test_RESPParser.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_Replication.cpp.o"
+  "CMakeFiles/run_tests.dir/test_Replication.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_RetryBudget.cpp.o"
+  "CMakeFiles/run_tests.dir/test_RetryBudget.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_SharedMemoryStore.cpp.o"
+  "CMakeFiles/run_tests.dir/test_SharedMemoryStore.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_TCPServer.cpp.o"
+  "CMakeFiles/run_tests.dir/test_TCPServer.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_TokenBucket.cpp.o"
+  "CMakeFiles/run_tests.dir/test_TokenBucket.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_WAL.cpp.o"
+  "CMakeFiles/run_tests.dir/test_WAL.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test_main.cpp.o"
+  "CMakeFiles/run_tests.dir/test_main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/run_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
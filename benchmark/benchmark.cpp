@@ -6,12 +6,16 @@
 #include <atomic>
 #include <future>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
 #include "storage/LRUCache.h"
 #include "storage/WAL.h"
 #include "storage/MMapPersistence.h"
 #include "cluster/HashRing.h"
 #include "patterns/CircuitBreaker.h"
 #include "monitoring/MetricsCollector.h"
+#include "network/TCPServer.h"
+#include "client/ClusterClient.h"
 
 class BenchmarkSuite {
 public:
@@ -20,9 +24,12 @@ public:
 private:
     void benchmark_cache_operations();
     void benchmark_hash_ring_distribution();
+    void benchmark_hash_ring_skew();
     void benchmark_circuit_breaker_performance();
     void benchmark_persistence_operations();
+    void benchmark_snapshot_interference();
     void benchmark_concurrent_operations();
+    void benchmark_cluster_fan_out();
     
     void print_header(const std::string& title);
     void print_result(const std::string& operation, double ops_per_sec, double avg_latency_us);
@@ -89,48 +96,132 @@ void BenchmarkSuite::benchmark_cache_operations() {
 void BenchmarkSuite::benchmark_hash_ring_distribution() {
     print_header("Consistent Hash Ring Performance");
     
-    HashRing ring;
-    ring.add_node("node-1");
-    ring.add_node("node-2");
-    ring.add_node("node-3");
-    ring.add_node("node-4");
-    
-    const int num_keys = 100000;
-    std::map<std::string, int> distribution;
-    
-    auto start = std::chrono::high_resolution_clock::now();
+    // Keys are built up front so only the lookups are timed
+    const int num_keys = 1000000;
+    std::vector<std::string> keys;
+    keys.reserve(num_keys);
     for (int i = 0; i < num_keys; ++i) {
-        std::string key = "benchmark_key_" + std::to_string(i);
-        std::string node = ring.get_node(key);
-        distribution[node]++;
+        keys.push_back("benchmark_key_" + std::to_string(i));
     }
-    auto end = std::chrono::high_resolution_clock::now();
     
-    double duration = std::chrono::duration<double>(end - start).count();
-    double ops_per_sec = num_keys / duration;
-    double latency_us = (duration * 1000000) / num_keys;
+    auto route_all = [&](const HashRing& ring) {
+        std::vector<uint32_t> owners(num_keys);
+        for (int i = 0; i < num_keys; ++i) owners[i] = ring.get_node_index(keys[i]);
+        return owners;
+    };
+    auto moved_percent = [&](const std::vector<uint32_t>& before, const std::vector<uint32_t>& after) {
+        int moved = 0;
+        for (int i = 0; i < num_keys; ++i) moved += before[i] != after[i];
+        return 100.0 * moved / num_keys;
+    };
     
-    print_result("Hash Ring Lookup", ops_per_sec, latency_us);
+    std::cout << std::left << std::setw(12) << "Strategy" << std::right
+              << std::setw(12) << "ns/lookup" << std::setw(10) << "CV"
+              << std::setw(12) << "add moved" << std::setw(14) << "remove moved" << std::endl;
     
-    std::cout << "\nLoad Distribution:" << std::endl;
-    for (const auto& [node, count] : distribution) {
-        double percentage = (100.0 * count) / num_keys;
-        std::cout << "  " << node << ": " << count << " keys (" 
-                  << std::fixed << std::setprecision(1) << percentage << "%)" << std::endl;
+    const HashRing::Strategy strategies[] = {
+        HashRing::Strategy::RING, HashRing::Strategy::JUMP,
+        HashRing::Strategy::RENDEZVOUS, HashRing::Strategy::MAGLEV
+    };
+    for (auto strategy : strategies) {
+        HashRing ring(strategy);
+        for (int n = 1; n <= 4; ++n) ring.add_node("node-" + std::to_string(n));
+        
+        std::vector<uint32_t> counts;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& key : keys) {
+            uint32_t node = ring.get_node_index(key);
+            if (node >= counts.size()) counts.resize(node + 1);
+            counts[node]++;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ns_per_lookup = std::chrono::duration<double, std::nano>(end - start).count() / num_keys;
+        
+        // Coefficient of variation of keys per node
+        double mean = static_cast<double>(num_keys) / counts.size();
+        double variance = 0.0;
+        for (uint32_t count : counts) variance += (count - mean) * (count - mean);
+        double cv = std::sqrt(variance / counts.size()) / mean;
+        
+        // Key movement: ideal is 1/5 on add and 1/4 on remove
+        auto base = route_all(ring);
+        ring.add_node("node-5");
+        double add_moved = moved_percent(base, route_all(ring));
+        ring.remove_node("node-5");
+        ring.remove_node("node-2");
+        double remove_moved = moved_percent(base, route_all(ring));
+        
+        std::cout << std::left << std::setw(12) << HashRing::strategy_name(strategy) << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(12) << ns_per_lookup
+                  << std::setprecision(3) << std::setw(10) << cv
+                  << std::setprecision(1) << std::setw(11) << add_moved << "%"
+                  << std::setw(13) << remove_moved << "%" << std::endl;
     }
     
-    // Calculate standard deviation to measure distribution quality
-    double mean = num_keys / distribution.size();
-    double variance = 0.0;
-    for (const auto& [node, count] : distribution) {
-        variance += (count - mean) * (count - mean);
+    // Weighted nodes: node-4 at weight 2 should take ~2/5 of the keys
+    HashRing weighted;
+    weighted.add_node("node-1");
+    weighted.add_node("node-2");
+    weighted.add_node("node-3");
+    weighted.add_node("node-4", 2);
+    int heavy = 0;
+    for (const auto& key : keys) {
+        if (weighted.get_node(key) == "node-4") heavy++;
+    }
+    std::cout << "Weighted node-4 (w=2) share: " << std::fixed << std::setprecision(1)
+              << (100.0 * heavy / num_keys) << "% (ideal 40.0%)" << std::endl;
+}
+
+void BenchmarkSuite::benchmark_hash_ring_skew() {
+    print_header("Hash Ring Under Skewed Load");
+    
+    // Zipf(1.1) over 10k keys; each request stays in flight until 64 newer
+    // ones have arrived, and the node's queue depth on arrival stands in
+    // for its queueing delay
+    const int num_keys = 10000;
+    const int num_requests = 500000;
+    const size_t in_flight = 64;
+    std::vector<double> cdf(num_keys);
+    double sum = 0.0;
+    for (int i = 0; i < num_keys; ++i) {
+        sum += 1.0 / std::pow(i + 1, 1.1);
+        cdf[i] = sum;
+    }
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    std::vector<std::string> requests(num_requests);
+    for (auto& request : requests) {
+        int rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        request = "user:" + std::to_string(rank);
     }
-    variance /= distribution.size();
-    double std_dev = std::sqrt(variance);
-    double cv = std_dev / mean; // Coefficient of variation
     
-    std::cout << "Distribution Quality (CV): " << std::fixed << std::setprecision(3) 
-              << cv << " (lower is better)" << std::endl;
+    for (double epsilon : {0.0, 0.25, 0.1}) {
+        HashRing ring(HashRing::DEFAULT_VIRTUAL_NODES);
+        for (int n = 1; n <= 8; ++n) ring.add_node("node-" + std::to_string(n));
+        if (epsilon > 0.0) ring.enable_bounded_load(epsilon);
+        
+        std::vector<uint32_t> window;
+        std::vector<int64_t> depths;
+        std::vector<int> served(8);
+        depths.reserve(num_requests);
+        size_t head = 0;
+        for (const auto& key : requests) {
+            uint32_t node = ring.acquire(key);
+            depths.push_back(ring.load(node));
+            served[node]++;
+            window.push_back(node);
+            if (window.size() - head > in_flight) ring.release(window[head++]);
+        }
+        while (head < window.size()) ring.release(window[head++]);
+        
+        std::sort(depths.begin(), depths.end());
+        int busiest = *std::max_element(served.begin(), served.end());
+        std::cout << (epsilon > 0.0 ? "bounded e=" + std::to_string(epsilon).substr(0, 4) : std::string("unbounded     "))
+                  << "  queue depth p50=" << depths[depths.size() / 2]
+                  << " p99=" << depths[depths.size() * 99 / 100]
+                  << "  busiest node " << std::fixed << std::setprecision(1)
+                  << (100.0 * busiest / num_requests) << "% of requests (fair 12.5%)" << std::endl;
+    }
 }
 
 void BenchmarkSuite::benchmark_circuit_breaker_performance() {
@@ -202,6 +293,15 @@ void BenchmarkSuite::benchmark_persistence_operations() {
     
     print_result("WAL Replay", replay_ops_per_sec, (duration * 1000000) / ops.size());
     
+    size_t recovery_threads = std::max(2u, std::thread::hardware_concurrency());
+    LRUCache recovered(100000, 16);
+    start = std::chrono::high_resolution_clock::now();
+    size_t replayed = wal.replay_into(recovered, recovery_threads);
+    end = std::chrono::high_resolution_clock::now();
+    
+    duration = std::chrono::duration<double>(end - start).count();
+    print_result("WAL Replay (parallel)", replayed / duration, (duration * 1000000) / replayed);
+    
     // MMap persistence
     MMapPersistence persistence("benchmark_snapshot.dat");
     std::unordered_map<std::string, std::string> test_data;
@@ -226,9 +326,69 @@ void BenchmarkSuite::benchmark_persistence_operations() {
     print_result("Snapshot Load", loaded_data.size() / duration,
                  (duration * 1000000) / loaded_data.size());
     
+    LRUCache restored(100000, 16);
+    start = std::chrono::high_resolution_clock::now();
+    size_t restored_count = persistence.load_into(restored, recovery_threads);
+    end = std::chrono::high_resolution_clock::now();
+    
+    duration = std::chrono::duration<double>(end - start).count();
+    print_result("Snapshot Load (parallel)", restored_count / duration,
+                 (duration * 1000000) / restored_count);
+    
     // Cleanup
     std::remove("benchmark_wal.log");
     std::remove("benchmark_snapshot.dat");
+    std::remove("benchmark_snapshot.dat.idx");
+}
+
+void BenchmarkSuite::benchmark_snapshot_interference() {
+    print_header("Foreground Latency During Snapshot");
+    
+    LRUCache cache(200000, 16);
+    const int num_keys = 200000;
+    for (int i = 0; i < num_keys; ++i) {
+        cache.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    
+    MMapPersistence persistence("benchmark_snapshot_bg.dat");
+    
+    auto measure_p99_us = [&](bool with_snapshot) {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<> dist(0, num_keys - 1);
+        std::vector<double> samples;
+        const int num_reads = 100000;
+        samples.reserve(num_reads);
+        
+        if (with_snapshot) persistence.async_snapshot(cache);
+        for (int i = 0; i < num_reads; ++i) {
+            std::string key = "key" + std::to_string(dist(gen));
+            std::string value;
+            auto start = std::chrono::high_resolution_clock::now();
+            cache.get(key, value);
+            auto end = std::chrono::high_resolution_clock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            
+            // Keep a snapshot running for the whole measurement window
+            if (with_snapshot && !persistence.snapshot_in_progress()) {
+                persistence.async_snapshot(cache);
+            }
+        }
+        persistence.wait_for_snapshot();
+        
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() * 99 / 100];
+    };
+    
+    double baseline_p99 = measure_p99_us(false);
+    double snapshot_p99 = measure_p99_us(true);
+    
+    std::cout << "GET p99 (idle):         " << std::fixed << std::setprecision(2) 
+              << baseline_p99 << " μs" << std::endl;
+    std::cout << "GET p99 (snapshotting): " << std::fixed << std::setprecision(2) 
+              << snapshot_p99 << " μs" << std::endl;
+    
+    std::remove("benchmark_snapshot_bg.dat");
+    std::remove("benchmark_snapshot_bg.dat.idx");
 }
 
 void BenchmarkSuite::benchmark_concurrent_operations() {
@@ -287,6 +447,82 @@ void BenchmarkSuite::benchmark_concurrent_operations() {
     std::cout << "Threads: " << num_threads << ", Total Operations: " << total_ops << std::endl;
 }
 
+void BenchmarkSuite::benchmark_cluster_fan_out() {
+    print_header("Cluster Fan-Out: Proxy vs Ring-Aware Client");
+    
+    // Three nodes on loopback, each with its own cache and peer pool
+    struct Node {
+        explicit Node(const std::string& node_id)
+            : id(node_id), wal_file("bench_" + node_id + ".wal"), cache(100000, 8), wal(wal_file),
+              breaker(5, 1000), server(0, cache, wal, ring, breaker, metrics) {}
+        std::string id, wal_file;
+        LRUCache cache;
+        WAL wal;
+        HashRing ring;
+        CircuitBreaker breaker;
+        MetricsCollector metrics;
+        PeerPool peers;
+        TCPServer server;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (const char* id : {"node-a", "node-b", "node-c"}) {
+        nodes.push_back(std::make_unique<Node>(id));
+        nodes.back()->server.listen();
+    }
+    for (auto& node : nodes) {
+        for (auto& member : nodes) {
+            node->ring.add_node(member->id);
+            if (member != node) node->peers.add_peer(member->id, "127.0.0.1", member->server.port());
+        }
+        node->server.enable_forwarding(node->id, node->peers);
+        Node* raw = node.get();
+        node->thread = std::thread([raw]() { raw->server.start(); });
+    }
+    
+    const int batch = 50, rounds = 500;
+    std::vector<std::pair<std::string, std::string>> entries;
+    std::vector<std::string> keys;
+    for (int i = 0; i < batch; ++i) {
+        keys.push_back("fanout_key_" + std::to_string(i));
+        entries.emplace_back(keys.back(), std::string(64, 'v'));
+    }
+    
+    std::string seed = "127.0.0.1:" + std::to_string(nodes[0]->server.port());
+    ClusterClient smart({seed});
+    smart.mset(entries);
+    
+    // Proxy mode: every MGET goes to one node, which forwards per key
+    PeerPool proxy_pool(1, false);
+    proxy_pool.add_peer("entry", "127.0.0.1", nodes[0]->server.port());
+    std::vector<std::string> mget{"MGET"};
+    mget.insert(mget.end(), keys.begin(), keys.end());
+    
+    auto measure = [&](const std::string& label, const std::function<void()>& op) {
+        std::vector<double> samples;
+        for (int r = 0; r < rounds; ++r) {
+            auto start = std::chrono::high_resolution_clock::now();
+            op();
+            auto end = std::chrono::high_resolution_clock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        std::cout << std::left << std::setw(24) << label << std::right
+                  << " p50 " << std::fixed << std::setprecision(1) << std::setw(8) << samples[rounds / 2]
+                  << " us   p99 " << std::setw(8) << samples[rounds * 99 / 100] << " us" << std::endl;
+    };
+    
+    std::cout << "MGET of " << batch << " keys over 3 nodes:" << std::endl;
+    measure("proxied via one node", [&]() { proxy_pool.forward("entry", mget).get(); });
+    measure("client fan-out", [&]() { smart.mget(keys); });
+    
+    for (auto& node : nodes) {
+        node->server.stop();
+        node->thread.join();
+        std::remove(node->wal_file.c_str());
+    }
+}
+
 void BenchmarkSuite::run_all_benchmarks() {
     std::cout << "DistCache Enhanced Benchmark Suite" << std::endl;
     std::cout << "===================================" << std::endl;
@@ -295,9 +531,12 @@ void BenchmarkSuite::run_all_benchmarks() {
     
     benchmark_cache_operations();
     benchmark_hash_ring_distribution();
+    benchmark_hash_ring_skew();
     benchmark_circuit_breaker_performance();
     benchmark_persistence_operations();
+    benchmark_snapshot_interference();
     benchmark_concurrent_operations();
+    benchmark_cluster_fan_out();
     
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "  Benchmark Suite Complete" << std::endl;
@@ -1,17 +1,31 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
 #include <signal.h>
 #include "storage/LRUCache.h"
 #include "storage/WAL.h"
 #include "storage/MMapPersistence.h"
+#include "storage/LazySnapshot.h"
+#include "storage/SharedMemoryStore.h"
 #include "network/TCPServer.h"
 #include "network/RESPParser.h"
+#include "network/PeerPool.h"
+#include "network/Socket.h"
 #include "cluster/HashRing.h"
 #include "cluster/NodeDiscovery.h"
+#include "cluster/Replica.h"
+#include "cluster/QuorumCoordinator.h"
+#include "cluster/MigrationManager.h"
+#include "cluster/AntiEntropy.h"
+#include "cluster/HintedHandoff.h"
 #include "patterns/CircuitBreaker.h"
+#include "patterns/ConcurrencyLimiter.h"
 #include "monitoring/MetricsCollector.h"
 #include "monitoring/HttpDashboard.h"
+#include "monitoring/Logger.h"
 
 std::atomic<bool> shutdown_requested(false);
 
@@ -25,67 +39,323 @@ int main() {
     signal(SIGTERM, signal_handler);
     
     std::cout << "=== DistCache Enhanced v2.0 ===" << std::endl;
-    std::cout << "[DistCache] Initializing distributed cache components...\n";
+    if (const char* level_env = std::getenv("LOG_LEVEL")) {
+        Logger::Level level;
+        if (Logger::parse_level(level_env, level)) Logger::instance().set_level(level);
+        else std::cerr << "[DistCache] Ignoring malformed LOG_LEVEL '" << level_env << "'\n";
+    }
+    LOG_INFO("DistCache", "Initializing distributed cache components");
     
     // Core storage components
-    LRUCache cache(10000);
+    LRUCache cache(10000, 16);
     WAL wal("wal.log");
     MMapPersistence persistence("snapshot.dat");
+    persistence.attach_wal(wal);
     RESPParser parser;
     MetricsCollector metrics;
     
     // NEW: Distributed systems components
     HashRing hash_ring;
-    CircuitBreaker circuit_breaker(5, 30000); // 5 failures, 30s timeout
-    
-    // Add some nodes to demonstrate consistent hashing
-    hash_ring.add_node("node-1");
-    hash_ring.add_node("node-2");  
-    hash_ring.add_node("node-3");
-    std::cout << "[HashRing] Initialized with 3 nodes\n";
-    
-    // Recovery from persistence
-    std::cout << "[DistCache] Loading persisted data...\n";
-    auto persisted_data = persistence.load();
-    for (const auto& [key, val] : persisted_data) {
-        cache.set(key, val);
+    // Local breaker: opens when half of the last 100 requests failed (with
+    // at least 20 seen), stays open 30s, then probes with 3 requests
+    CircuitBreaker::Config breaker_config;
+    breaker_config.open_timeout_ms = 30000;
+    CircuitBreaker circuit_breaker(breaker_config);
+    
+    // Cluster membership: NODE_ID names this node and CLUSTER_NODES lists
+    // every member as id=host:port, comma separated. Keys owned by another
+    // member are forwarded to it; without CLUSTER_NODES this node owns all.
+    // NODE_ADDR is the address handed to clients by the NODES command.
+    const char* node_env = std::getenv("NODE_ID");
+    const char* port_env = std::getenv("PORT");
+    const char* cluster_env = std::getenv("CLUSTER_NODES");
+    std::string node_id = node_env ? node_env : "node-1";
+    int port = port_env ? std::stoi(port_env) : 6379;
+    PeerPool peers;
+    // PEER_SECRET, shared by every member, authenticates node-to-node links:
+    // only they skip routing and client rate limits (see TCPServer)
+    const char* peer_secret_env = std::getenv("PEER_SECRET");
+    std::string peer_secret = peer_secret_env ? peer_secret_env : "";
+    peers.set_peer_secret(peer_secret);
+    // Hedged reads may add up to HEDGE_BUDGET_PERCENT (default 10) extra
+    // requests to each peer
+    PeerPool::HedgeConfig hedge_config;
+    if (const char* budget = std::getenv("HEDGE_BUDGET_PERCENT")) hedge_config.budget_ratio = std::stod(budget) / 100;
+    peers.set_hedge_config(hedge_config);
+    
+    hash_ring.add_node(node_id);
+    if (cluster_env) {
+        for (const auto& member : RESPParser::split(cluster_env, ',')) {
+            size_t eq = member.find('=');
+            std::string id = member.substr(0, eq), host;
+            int peer_port = 0;
+            if (eq == std::string::npos || !Socket::split_address(member.substr(eq + 1), host, peer_port)) {
+                LOG_WARN("DistCache", "Ignoring malformed cluster member '" << member << "'");
+                continue;
+            }
+            if (id == node_id) continue;
+            hash_ring.add_node(id);
+            peers.add_peer(id, host, peer_port);
+        }
     }
+    LOG_INFO("HashRing", "Initialized with " << hash_ring.get_all_nodes().size() << " nodes");
     
-    // WAL replay
-    std::cout << "[DistCache] Replaying WAL entries...\n";
-    for (auto [op, key, val] : wal.replay()) {
-        if (op == "SET") cache.set(key, val);
-        else if (op == "DEL") cache.del(key);
+    // Anti-entropy: per-range Merkle trees kept current from here on, so it
+    // is registered before recovery fills the cache. Replicas are compared
+    // every ANTI_ENTROPY_INTERVAL_MS (default 10000, 0 disables) over the
+    // replica sets of QUORUM_DEFAULT's N; deletes are remembered for
+    // TOMBSTONE_TTL_MS (default one hour).
+    AntiEntropy::Config anti_entropy_config;
+    QuorumCoordinator::Policy replication;
+    if (const char* quorum_default = std::getenv("QUORUM_DEFAULT")) {
+        QuorumCoordinator::parse_policy(quorum_default, replication);
     }
+    anti_entropy_config.replicas = replication.n;
+    if (const char* interval = std::getenv("ANTI_ENTROPY_INTERVAL_MS")) {
+        anti_entropy_config.interval_ms = std::stoi(interval);
+    }
+    if (const char* tombstone_ttl = std::getenv("TOMBSTONE_TTL_MS")) {
+        anti_entropy_config.tombstone_ttl_ms = std::stoi(tombstone_ttl);
+    }
+    AntiEntropy anti_entropy(node_id, cache, wal, hash_ring, peers, anti_entropy_config);
+    cache.add_listener(&anti_entropy);
+    
+    // Recovery: snapshot then WAL, both streamed from mappings and applied
+    // on one worker per core. Every committed snapshot compacts the WAL, so
+    // only the records after it are replayed. In lazy mode (default,
+    // WARM_START=eager to disable) the base snapshot is served straight
+    // from its mapping and it and the WAL are filled in behind live traffic.
+    size_t recovery_threads = std::max(2u, std::thread::hardware_concurrency());
+    const char* warm_start = std::getenv("WARM_START");
+    bool eager_load = warm_start && std::string(warm_start) == "eager";
+    
+    // Shared-memory mirror (SHM_NAME, e.g. /distcache): a restart after a
+    // clean shutdown re-attaches it and skips disk recovery entirely. A
+    // missing, crashed or incomplete region falls back to the snapshot and
+    // WAL below, which also fill the mirror back in. SHM_SLOT_BYTES (default
+    // 512, a multiple of 8) is the allocation unit; larger entries span
+    // several slots.
+    std::shared_ptr<SharedMemoryStore> shm_store;
+    if (const char* shm_name = std::getenv("SHM_NAME")) {
+        const char* shm_size = std::getenv("SHM_SIZE_MB");
+        const char* shm_slot = std::getenv("SHM_SLOT_BYTES");
+        size_t region_mb = shm_size ? std::stoul(shm_size) : 64;
+        size_t slot_bytes = shm_slot ? std::stoul(shm_slot) : 512;
+        shm_store = std::make_shared<SharedMemoryStore>(shm_name, region_mb << 20, slot_bytes);
+        cache.add_listener(shm_store.get());
+    }
+    
+    auto lazy_snapshot = std::make_shared<LazySnapshot>("snapshot.dat");
+    std::thread warm_thread;
+    if (shm_store && shm_store->restored()) {
+        LOG_INFO("DistCache", "Warm restart from shared memory ("
+                              << shm_store->size() << " entries)");
+        cache.attach_warm_source(shm_store);
+        warm_thread = std::thread([&cache, shm_store]() {
+            size_t promoted = shm_store->load_remaining(cache);
+            cache.detach_warm_source();
+            LOG_INFO("DistCache", "Warm start complete (" << promoted
+                                  << " records loaded in background)");
+        });
+    } else if (!eager_load && lazy_snapshot->is_valid()) {
+        LOG_INFO("DistCache", "Mapping snapshot for lazy warm start ("
+                              << lazy_snapshot->record_count() << " records)");
+        cache.attach_warm_source(lazy_snapshot);
+        persistence.apply_deltas(cache);
+    } else {
+        LOG_INFO("DistCache", "Loading persisted data");
+        size_t loaded = persistence.load_into(cache, recovery_threads);
+        LOG_INFO("DistCache", "Loaded " << loaded << " snapshot entries");
+        LOG_INFO("DistCache", "Replaying WAL entries");
+        size_t replayed = wal.replay_into(cache, recovery_threads);
+        LOG_INFO("DistCache", "Replayed " << replayed << " WAL records on "
+                              << recovery_threads << " threads");
+        if (shm_store) shm_store->mark_complete();
+    }
+    
+    if (cache.has_warm_source() && !warm_thread.joinable()) {
+        // The WAL suffix is replayed behind live traffic too; keys clients
+        // write in the meantime keep their newer value
+        cache.begin_replay();
+        warm_thread = std::thread([&cache, &wal, lazy_snapshot, shm_store, recovery_threads]() {
+            size_t replayed = wal.replay_into(cache, recovery_threads);
+            cache.end_replay();
+            LOG_INFO("DistCache", "Replayed " << replayed << " WAL records in background");
+            size_t promoted = lazy_snapshot->load_remaining(cache);
+            cache.detach_warm_source();
+            if (shm_store) shm_store->mark_complete();
+            LOG_INFO("DistCache", "Warm start complete (" << promoted
+                                  << " records loaded in background)");
+        });
+    }
+    lazy_snapshot.reset();
     
     // Network components
-    std::cout << "[DistCache] Starting TCP server on port 6379...\n";
-    TCPServer server(6379, cache, wal, hash_ring, circuit_breaker, metrics);
+    LOG_INFO("DistCache", "Starting TCP server on port " << port);
+    TCPServer server(port, cache, wal, hash_ring, circuit_breaker, metrics);
+    server.set_peer_secret(peer_secret);
+    if (!peers.peer_ids().empty()) server.enable_forwarding(node_id, peers);
+    
+    // Adaptive in-flight limit; requests past it are shed with -BUSY.
+    // MAX_CONCURRENCY caps how far it can grow (default 1024).
+    ConcurrencyLimiter::Config limiter_config;
+    if (const char* max_concurrency = std::getenv("MAX_CONCURRENCY")) {
+        limiter_config.max_limit = std::stoi(max_concurrency);
+    }
+    ConcurrencyLimiter limiter(limiter_config);
+    server.set_concurrency_limiter(limiter);
+    
+    // Client rate limits in ops and bytes per second, per connection
+    // (CONNECTION_OPS_LIMIT, CONNECTION_BYTES_LIMIT) and per CLIENT SETNAME
+    // name (CLIENT_OPS_LIMIT, CLIENT_BYTES_LIMIT); unset means unlimited
+    TCPServer::RateLimits connection_limits, client_limits;
+    auto env_rate = [](const char* name) {
+        const char* value = std::getenv(name);
+        return value ? std::stod(value) : 0.0;
+    };
+    connection_limits.ops_per_sec = env_rate("CONNECTION_OPS_LIMIT");
+    connection_limits.bytes_per_sec = env_rate("CONNECTION_BYTES_LIMIT");
+    client_limits.ops_per_sec = env_rate("CLIENT_OPS_LIMIT");
+    client_limits.bytes_per_sec = env_rate("CLIENT_BYTES_LIMIT");
+    server.set_rate_limits(connection_limits, client_limits);
+    
+    // Quorum replication for QGET/QSET. QUORUM_DEFAULT is "N/R/W" (3/2/2
+    // if unset) and QUORUM_POLICIES overrides it per key prefix, e.g.
+    // "session:=3/1/1,account:=3/3/3"
+    QuorumCoordinator quorum(node_id, cache, wal, hash_ring, peers);
+    QuorumCoordinator::Policy policy;
+    if (const char* quorum_default = std::getenv("QUORUM_DEFAULT")) {
+        if (QuorumCoordinator::parse_policy(quorum_default, policy)) {
+            quorum.set_default_policy(policy);
+        } else {
+            LOG_WARN("DistCache", "Ignoring malformed QUORUM_DEFAULT '" << quorum_default << "'");
+        }
+    }
+    if (const char* quorum_policies = std::getenv("QUORUM_POLICIES")) {
+        for (const auto& entry : RESPParser::split(quorum_policies, ',')) {
+            size_t eq = entry.rfind('=');
+            if (eq != std::string::npos && QuorumCoordinator::parse_policy(entry.substr(eq + 1), policy)) {
+                quorum.set_policy(entry.substr(0, eq), policy);
+            } else {
+                LOG_WARN("DistCache", "Ignoring malformed quorum policy '" << entry << "'");
+            }
+        }
+    }
+    server.enable_quorum(quorum);
+    // BOUNDED_LOAD_EPSILON (e.g. 0.25, unset disables) caps each replica of
+    // a QUORUM_POLICIES keyspace at (1 + epsilon) times the average
+    // in-flight reads; GETs over the cap go to the key's next replica
+    if (const char* epsilon = std::getenv("BOUNDED_LOAD_EPSILON")) hash_ring.enable_bounded_load(std::stod(epsilon));
+    // Forwarded GETs of QUORUM_POLICIES keyspaces slower than the owner's
+    // p95 are also sent to another replica; HEDGE_READS=0 turns this off
+    const char* hedge_reads = std::getenv("HEDGE_READS");
+    if (!hedge_reads || std::string(hedge_reads) != "0") server.enable_hedged_reads();
+    
+    // Rebalancing: ring changes stream moved keys to their new owners at
+    // MIGRATION_RATE_MB per second (default 8). JOIN=1 marks a node joining
+    // a running cluster, which reads misses from the old owners until they
+    // have handed its share over.
+    MigrationManager::Config migration_config;
+    if (const char* rate = std::getenv("MIGRATION_RATE_MB")) migration_config.max_bytes_per_sec = std::stoul(rate) << 20;
+    MigrationManager migration(node_id, cache, wal, hash_ring, peers, migration_config);
+    server.enable_migration(migration);
+    server.enable_anti_entropy(anti_entropy);
+    
+    // Hinted handoff: writes for an unreachable owner are kept in
+    // hints.log (at most HINTS_MAX, default 100000) and replayed when the
+    // owner is seen again
+    HintedHandoff::Config hints_config;
+    if (const char* max_hints = std::getenv("HINTS_MAX")) hints_config.max_hints = std::stoul(max_hints);
+    HintedHandoff hints(node_id, hash_ring, peers, "hints.log", hints_config);
+    server.enable_hinted_handoff(hints);
+    const char* join_env = std::getenv("JOIN");
+    if (join_env && std::string(join_env) == "1") migration.join();
+    if (const char* node_addr = std::getenv("NODE_ADDR")) server.set_node_address(node_addr);
+    
+    // Replica mode (REPLICA_OF=host:port): the cache follows the primary's
+    // WAL stream and this node only serves reads
+    std::unique_ptr<Replica> replica;
+    if (const char* primary = std::getenv("REPLICA_OF")) {
+        std::string primary_host;
+        int primary_port = 0;
+        if (Socket::split_address(primary, primary_host, primary_port)) {
+            replica = std::make_unique<Replica>(cache, primary_host, primary_port, &metrics);
+            server.attach_replica(*replica);
+            replica->start();
+        } else {
+            LOG_WARN("DistCache", "Ignoring malformed REPLICA_OF '" << primary << "'");
+        }
+    }
     std::thread server_thread([&]() { server.start(); });
     
-    // Node discovery
-    std::cout << "[DistCache] Launching node discovery...\n";
-    NodeDiscovery discovery;
-    std::thread discovery_thread([&]() {
-        discovery.broadcast_heartbeat();
-        discovery.listen_for_heartbeats();
+    // Node discovery: SWIM gossip on GOSSIP_PORT (UDP, default 7946, the
+    // same on every member). Cluster members are the seeds; nodes found
+    // dead leave the ring and nodes that join or come back are added.
+    LOG_INFO("DistCache", "Launching node discovery");
+    const char* gossip_env = std::getenv("GOSSIP_PORT");
+    int gossip_port = gossip_env ? std::stoi(gossip_env) : 7946;
+    NodeDiscovery discovery(node_id, gossip_port);
+    std::string service_address = std::getenv("NODE_ADDR") ? std::getenv("NODE_ADDR")
+                                                           : "127.0.0.1:" + std::to_string(port);
+    std::string advertise_host;
+    int advertise_port = 0;
+    if (Socket::split_address(service_address, advertise_host, advertise_port)) {
+        discovery.set_advertise_address(advertise_host);
+    }
+    discovery.set_service_address(service_address);
+    for (const auto& id : peers.peer_ids()) {
+        std::string host;
+        int peer_port = 0;
+        if (Socket::split_address(peers.peer_address(id), host, peer_port)) {
+            discovery.add_seed_node(id, host, gossip_port);
+        }
+    }
+    discovery.set_listener([&](const NodeDiscovery::NodeInfo& node) {
+        if (node.state == NodeDiscovery::State::DEAD) {
+            migration.remove_node(node.node_id);
+        } else if (node.state == NodeDiscovery::State::ALIVE) {
+            std::string host;
+            int peer_port = 0;
+            if (!peers.has_peer(node.node_id) && Socket::split_address(node.service_address, host, peer_port)) {
+                peers.add_peer(node.node_id, host, peer_port);
+            }
+            if (peers.has_peer(node.node_id)) migration.add_node(node.node_id);
+            hints.owner_alive(node.node_id);
+        }
     });
+    discovery.start_discovery();
     
-    // HTTP Dashboard
-    std::cout << "[DistCache] Starting HTTP dashboard on port 8080...\n";
-    HttpDashboard dashboard(metrics, hash_ring, circuit_breaker);
-    std::thread dashboard_thread([&]() { dashboard.start(8080); });
+    // Monitoring: Prometheus /metrics and JSON /stats on HTTP_PORT (default
+    // 8080)
+    const char* http_port = std::getenv("HTTP_PORT");
+    HttpDashboard dashboard(metrics, cache, hash_ring, circuit_breaker);
+    dashboard.set_peer_breakers(peers.breakers());
+    dashboard.start(http_port ? std::stoi(http_port) : 8080);
     
-    // Background cleanup
+    // Background cleanup and periodic delta snapshots (every 60s); deltas are
+    // folded into a new base once enough of them pile up
     std::thread cleanup_thread([&]() {
+        int ticks = 0;
+        bool snapshot_due = false;
         while (!shutdown_requested) {
             std::this_thread::sleep_for(std::chrono::seconds(5));
             cache.cleanup_expired();
             metrics.record_active_connections(server.get_connection_count());
+            // No snapshots until the warm start has pulled in every key, and
+            // none while client traffic needs the headroom: a due snapshot
+            // waits for a tick where background work is admitted
+            if (++ticks % 12 == 0) snapshot_due = true;
+            if (snapshot_due && !cache.has_warm_source() &&
+                limiter.try_acquire(ConcurrencyLimiter::Priority::BACKGROUND)) {
+                limiter.cancel();
+                persistence.async_snapshot_delta(cache);
+                snapshot_due = false;
+            }
         }
     });
     
-    std::cout << "[DistCache] System ready! Features enabled:\n";
+    LOG_INFO("DistCache", "System ready! Features enabled:");
+    Logger::instance().flush();
     std::cout << "  ✓ Consistent Hashing for data distribution\n";
     std::cout << "  ✓ Circuit Breaker for failure protection\n"; 
     std::cout << "  ✓ LRU Cache with TTL support\n";
@@ -99,15 +369,19 @@ int main() {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
     
-    std::cout << "[DistCache] Graceful shutdown initiated...\n";
+    LOG_INFO("DistCache", "Graceful shutdown initiated");
     shutdown_requested = true;
     
     // Cleanup
+    if (replica) replica->stop();
+    server.stop();
     if (server_thread.joinable()) server_thread.join();
-    if (discovery_thread.joinable()) discovery_thread.join();
-    if (dashboard_thread.joinable()) dashboard_thread.join();
+    discovery.stop_discovery();
+    dashboard.stop();
     if (cleanup_thread.joinable()) cleanup_thread.join();
+    if (warm_thread.joinable()) warm_thread.join();
     
-    std::cout << "[DistCache] Shutdown complete.\n";
+    LOG_INFO("DistCache", "Shutdown complete.");
+    Logger::instance().flush();
     return 0;
 }
@@ -0,0 +1,279 @@
+#include "ClusterClient.h"
+#include "network/RESPParser.h"
+#include "network/Socket.h"
+#include <unistd.h>
+#include <sys/socket.h>
+#include <stdexcept>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+ClusterClient::ClusterClient(const std::vector<std::string>& seeds, size_t connections_per_node,
+                             int refresh_interval_ms)
+    : seeds_(seeds), pool_(connections_per_node, false), refresh_interval_(refresh_interval_ms) {
+    if (!refresh()) {
+        throw std::runtime_error("No reachable cluster node among seeds");
+    }
+}
+
+bool ClusterClient::refresh() {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    std::vector<std::string> candidates;
+    for (const auto& id : pool_.peer_ids()) candidates.push_back(pool_.peer_address(id));
+    candidates.insert(candidates.end(), seeds_.begin(), seeds_.end());
+
+    for (const auto& address : candidates) {
+        if (refresh_from(address)) {
+            stale_ = false;
+            last_refresh_ = std::chrono::steady_clock::now().time_since_epoch().count();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClusterClient::refresh_if_due() {
+    auto last = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_refresh_.load()));
+    if (stale_ || std::chrono::steady_clock::now() - last >= refresh_interval_) refresh();
+}
+
+bool ClusterClient::refresh_from(const std::string& address) {
+    std::string host;
+    int port = 0;
+    if (!Socket::split_address(address, host, port)) return false;
+
+    // A one-off connection: the pool is keyed by node id, which is what we
+    // are about to learn
+    int fd = Socket::connect_tcp(host, port, 1000);
+    if (fd < 0) return false;
+
+    std::string buffer;
+    RESPParser::Reply reply;
+    size_t consumed = 0;
+    bool ok = Socket::send_all(fd, RESPParser::serialize_command({"NODES"}));
+    char chunk[4096];
+    try {
+        while (ok && !RESPParser::parse_reply(buffer, consumed, reply)) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) ok = false;
+            else buffer.append(chunk, static_cast<size_t>(n));
+        }
+    } catch (const std::exception&) {
+        ok = false;
+    }
+    ::close(fd);
+    if (!ok || reply.type != '*') return false;
+
+    auto known = ring_.get_all_nodes();
+    std::unordered_set<std::string> current(known.begin(), known.end()), members;
+    for (const auto& entry : reply.elements) {
+        size_t eq = entry.str.find('=');
+        std::string peer_host;
+        int peer_port = 0;
+        if (eq == std::string::npos || !Socket::split_address(entry.str.substr(eq + 1), peer_host, peer_port)) {
+            continue;
+        }
+        std::string id = entry.str.substr(0, eq);
+        members.insert(id);
+        if (pool_.peer_address(id) != entry.str.substr(eq + 1)) {
+            pool_.add_peer(id, peer_host, peer_port);
+        }
+        if (!current.count(id)) ring_.add_node(id);
+    }
+    for (const auto& id : known) {
+        if (!members.count(id)) {
+            ring_.remove_node(id);
+            pool_.remove_peer(id);
+        }
+    }
+    return !members.empty();
+}
+
+size_t ClusterClient::node_count() const {
+    return ring_.get_all_nodes().size();
+}
+
+bool ClusterClient::send(const std::string& node_id, const std::vector<std::string>& argv, std::string& raw) {
+    auto promise = std::make_shared<std::promise<std::pair<bool, std::string>>>();
+    auto future = promise->get_future();
+    pool_.forward(node_id, argv, [promise](bool ok, std::string reply) {
+        promise->set_value({ok, std::move(reply)});
+    });
+    auto [ok, reply] = future.get();
+    raw = std::move(reply);
+    if (!ok) stale_ = true;
+    return ok;
+}
+
+RESPParser::Reply ClusterClient::call(const std::string& key, const std::vector<std::string>& argv) {
+    refresh_if_due();
+    std::string raw;
+    if (!send(ring_.get_node(key), argv, raw)) {
+        // The owner may have left or moved: re-read the ring and try once
+        // more with whoever owns the key now
+        refresh();
+        send(ring_.get_node(key), argv, raw);
+    }
+
+    RESPParser::Reply reply;
+    size_t consumed = 0;
+    if (!RESPParser::parse_reply(raw, consumed, reply)) {
+        throw std::runtime_error("Truncated reply for " + key);
+    }
+    if (reply.type == '-') {
+        throw std::runtime_error(reply.str);
+    }
+    return reply;
+}
+
+std::optional<std::string> ClusterClient::get(const std::string& key) {
+    auto reply = call(key, {"GET", key});
+    if (reply.is_nil) return std::nullopt;
+    return reply.str;
+}
+
+bool ClusterClient::set(const std::string& key, const std::string& value, int ttl_seconds) {
+    std::vector<std::string> argv{"SET", key, value};
+    if (ttl_seconds > 0) {
+        argv.push_back("EX");
+        argv.push_back(std::to_string(ttl_seconds));
+    }
+    return call(key, argv).str == "OK";
+}
+
+bool ClusterClient::del(const std::string& key) {
+    return call(key, {"DEL", key}).integer > 0;
+}
+
+std::vector<std::optional<std::string>> ClusterClient::mget(const std::vector<std::string>& keys) {
+    refresh_if_due();
+    try {
+        return mget_async(keys).get();
+    } catch (const std::runtime_error&) {
+        if (!stale_) throw;
+        refresh();
+        return mget_async(keys).get();
+    }
+}
+
+void ClusterClient::mset(const std::vector<std::pair<std::string, std::string>>& entries) {
+    refresh_if_due();
+    try {
+        mset_async(entries).get();
+    } catch (const std::runtime_error&) {
+        if (!stale_) throw;
+        refresh();
+        mset_async(entries).get();
+    }
+}
+
+namespace {
+
+// Shared state of one fan-out: the last node to answer completes it
+template <typename T>
+struct FanOut {
+    std::promise<T> promise;
+    std::atomic<size_t> remaining{0};
+    std::atomic<bool> failed{false};
+    
+    void fail(const std::string& error) {
+        if (!failed.exchange(true)) {
+            promise.set_exception(std::make_exception_ptr(std::runtime_error(error)));
+        }
+    }
+    bool last() { return remaining.fetch_sub(1) == 1; }
+};
+
+bool parse_node_reply(const std::string& raw, RESPParser::Reply& reply, std::string& error) {
+    size_t consumed = 0;
+    try {
+        if (!RESPParser::parse_reply(raw, consumed, reply)) {
+            error = "Truncated reply";
+            return false;
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    if (reply.type == '-') {
+        error = reply.str;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::future<std::vector<std::optional<std::string>>> ClusterClient::mget_async(const std::vector<std::string>& keys) {
+    using Result = std::vector<std::optional<std::string>>;
+    struct State : FanOut<Result> {
+        Result values;
+    };
+    auto state = std::make_shared<State>();
+    state->values.resize(keys.size());
+    auto future = state->promise.get_future();
+
+    // Group key positions by owner
+    std::unordered_map<std::string, std::vector<size_t>> by_node;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        by_node[ring_.get_node(keys[i])].push_back(i);
+    }
+    if (by_node.empty()) {
+        state->promise.set_value({});
+        return future;
+    }
+
+    state->remaining = by_node.size();
+    for (auto& [node, positions] : by_node) {
+        std::vector<std::string> argv{"MGET"};
+        for (size_t i : positions) argv.push_back(keys[i]);
+
+        pool_.forward(node, argv, [this, state, positions = std::move(positions)](bool ok, std::string raw) {
+            if (!ok) stale_ = true;
+            RESPParser::Reply reply;
+            std::string error;
+            if (!parse_node_reply(raw, reply, error) || reply.elements.size() != positions.size()) {
+                state->fail(error.empty() ? "Unexpected MGET reply" : error);
+            } else {
+                // Each node writes only its own positions
+                for (size_t j = 0; j < positions.size(); ++j) {
+                    if (!reply.elements[j].is_nil) state->values[positions[j]] = reply.elements[j].str;
+                }
+            }
+            if (state->last() && !state->failed) {
+                state->promise.set_value(std::move(state->values));
+            }
+        });
+    }
+    return future;
+}
+
+std::future<void> ClusterClient::mset_async(const std::vector<std::pair<std::string, std::string>>& entries) {
+    auto state = std::make_shared<FanOut<void>>();
+    auto future = state->promise.get_future();
+
+    std::unordered_map<std::string, std::vector<std::string>> by_node;
+    for (const auto& [key, value] : entries) {
+        auto& argv = by_node[ring_.get_node(key)];
+        if (argv.empty()) argv.push_back("MSET");
+        argv.push_back(key);
+        argv.push_back(value);
+    }
+    if (by_node.empty()) {
+        state->promise.set_value();
+        return future;
+    }
+
+    state->remaining = by_node.size();
+    for (const auto& [node, argv] : by_node) {
+        pool_.forward(node, argv, [this, state](bool ok, std::string raw) {
+            if (!ok) stale_ = true;
+            RESPParser::Reply reply;
+            std::string error;
+            if (!parse_node_reply(raw, reply, error)) state->fail(error);
+            if (state->last() && !state->failed) state->promise.set_value();
+        });
+    }
+    return future;
+}
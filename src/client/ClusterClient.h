@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include "cluster/HashRing.h"
+#include "network/PeerPool.h"
+#include "network/RESPParser.h"
+
+// Ring-aware client: learns the membership from any node (NODES), routes
+// each key straight to its owner over pooled pipelined connections and
+// fans batched calls out one request per node. Uses the same HashRing
+// settings as the servers, so routing matches theirs; a stale view still
+// works because servers forward what they do not own. The view is re-read
+// every refresh_interval_ms and whenever a node cannot be reached, in which
+// case single-key calls and the blocking batch calls are retried once.
+class ClusterClient {
+public:
+    explicit ClusterClient(const std::vector<std::string>& seeds, size_t connections_per_node = 2,
+                           int refresh_interval_ms = 30000);
+
+    // Re-reads the membership from the first reachable seed or known node
+    bool refresh();
+    size_t node_count() const;
+    std::string node_for(const std::string& key) const { return ring_.get_node(key); }
+
+    std::optional<std::string> get(const std::string& key);
+    bool set(const std::string& key, const std::string& value, int ttl_seconds = -1);
+    // True only if a copy is known to be deleted; a DEL hinted for an
+    // unreachable owner answers +ACCEPTED and reports false
+    bool del(const std::string& key);
+
+    // One MGET/MSET per owning node, sent concurrently; results come back
+    // in key order. Node failures surface as exceptions from the future, and
+    // an unreachable node makes the next call refresh first.
+    std::future<std::vector<std::optional<std::string>>> mget_async(const std::vector<std::string>& keys);
+    std::future<void> mset_async(const std::vector<std::pair<std::string, std::string>>& entries);
+    std::vector<std::optional<std::string>> mget(const std::vector<std::string>& keys);
+    void mset(const std::vector<std::pair<std::string, std::string>>& entries);
+
+private:
+    std::vector<std::string> seeds_;
+    HashRing ring_;
+    PeerPool pool_;
+    std::mutex refresh_mutex_;
+    std::chrono::milliseconds refresh_interval_;
+    std::atomic<std::chrono::steady_clock::rep> last_refresh_{0};
+    std::atomic<bool> stale_{false};  // A node was unreachable since the last refresh
+
+    // Sends to the key's owner, refreshing and retrying once if it is unreachable
+    RESPParser::Reply call(const std::string& key, const std::vector<std::string>& argv);
+    bool send(const std::string& node_id, const std::vector<std::string>& argv, std::string& raw);
+    void refresh_if_due();
+    bool refresh_from(const std::string& address);
+};
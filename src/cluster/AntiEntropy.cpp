@@ -0,0 +1,376 @@
+#include "AntiEntropy.h"
+#include "monitoring/Logger.h"
+#include "network/RESPParser.h"
+#include <algorithm>
+#include <future>
+#include <map>
+#include <stdexcept>
+#include <unordered_set>
+
+AntiEntropy::AntiEntropy(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers)
+    : AntiEntropy(self_id, cache, wal, ring, peers, Config{}) {}
+
+AntiEntropy::AntiEntropy(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers,
+                         const Config& config)
+    : self_id_(self_id), cache_(cache), wal_(wal), ring_(ring), peers_(peers), config_(config),
+      members_(ring.get_all_nodes()) {
+    if (config_.interval_ms > 0) worker_ = std::thread([this]() { worker_loop(); });
+}
+
+AntiEntropy::~AntiEntropy() {
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stopping_ = true;
+    }
+    worker_cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void AntiEntropy::on_set(const std::string& key, const std::string* old_value, const std::string& value,
+                         std::chrono::steady_clock::time_point) {
+    update(key, old_value, &value);
+}
+
+void AntiEntropy::on_erase(const std::string& key, const std::string& old_value) {
+    update(key, &old_value, nullptr);
+}
+
+void AntiEntropy::update(const std::string& key, const std::string* old_value, const std::string* value) {
+    std::string range = range_of(key);
+    if (range.empty()) return;
+    
+    auto apply = [&](MerkleTree& tree) {
+        if (old_value) tree.remove(key, *old_value);
+        if (value) tree.add(key, *value);
+    };
+    {
+        std::shared_lock<std::shared_mutex> lock(trees_mutex_);
+        auto it = trees_.find(range);
+        if (it != trees_.end()) {
+            apply(*it->second);
+            return;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(trees_mutex_);
+    auto& tree = trees_[range];
+    if (!tree) tree = std::make_unique<MerkleTree>();
+    apply(*tree);
+}
+
+std::string AntiEntropy::range_of(std::string_view key) const {
+    auto replicas = ring_.preference_list(key, config_.replicas);
+    if (std::find(replicas.begin(), replicas.end(), self_id_) == replicas.end()) return "";
+    
+    std::sort(replicas.begin(), replicas.end());
+    std::string range;
+    for (const auto& node : replicas) {
+        if (!range.empty()) range += ',';
+        range += node;
+    }
+    return range;
+}
+
+void AntiEntropy::rebuild() {
+    // Built aside and swapped in, so no shard lock is taken under
+    // trees_mutex_ (on_set takes them in the other order)
+    std::unordered_map<std::string, std::unique_ptr<MerkleTree>> trees;
+    for (size_t i = 0; i < cache_.shard_count(); ++i) {
+        for (const auto& [key, value] : cache_.snapshot_shard(i)) {
+            std::string range = range_of(key);
+            if (range.empty()) continue;
+            auto& tree = trees[range];
+            if (!tree) tree = std::make_unique<MerkleTree>();
+            tree->add(key, value);
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(trees_mutex_);
+    trees_.swap(trees);
+    LOG_INFO("AntiEntropy", "Rebuilt " << trees_.size() << " range trees");
+}
+
+void AntiEntropy::record_delete(const std::string& key) {
+    // Newer than the copy just deleted: the cache's clock is past every
+    // version it has stored
+    if (!range_of(key).empty()) add_tombstone(key, cache_.next_version());
+}
+
+bool AntiEntropy::apply_delete(const std::string& key, uint64_t version) {
+    if (!range_of(key).empty()) add_tombstone(key, version);
+    return cache_.del_versioned(key, version, [&] { wal_.append("DEL", key); });
+}
+
+bool AntiEntropy::deleted_since(const std::string& key, uint64_t version) const {
+    uint64_t deleted = tombstone_version(key);
+    return deleted != 0 && deleted >= version;
+}
+
+size_t AntiEntropy::tombstone_count() const {
+    std::shared_lock<std::shared_mutex> lock(tombstones_mutex_);
+    return tombstones_.size();
+}
+
+void AntiEntropy::add_tombstone(const std::string& key, uint64_t version) {
+    std::unique_lock<std::shared_mutex> lock(tombstones_mutex_);
+    Tombstone& tombstone = tombstones_[key];
+    if (version >= tombstone.version) tombstone = {version, std::chrono::steady_clock::now()};
+}
+
+uint64_t AntiEntropy::tombstone_version(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lock(tombstones_mutex_);
+    auto it = tombstones_.find(key);
+    return it != tombstones_.end() ? it->second.version : 0;
+}
+
+void AntiEntropy::expire_tombstones() {
+    auto cutoff = std::chrono::steady_clock::now() - std::chrono::milliseconds(config_.tombstone_ttl_ms);
+    std::unique_lock<std::shared_mutex> lock(tombstones_mutex_);
+    for (auto it = tombstones_.begin(); it != tombstones_.end();) {
+        if (it->second.created < cutoff) it = tombstones_.erase(it);
+        else ++it;
+    }
+}
+
+std::vector<std::string> AntiEntropy::ranges() const {
+    std::shared_lock<std::shared_mutex> lock(trees_mutex_);
+    std::vector<std::string> names;
+    names.reserve(trees_.size());
+    for (const auto& [range, tree] : trees_) names.push_back(range);
+    return names;
+}
+
+uint64_t AntiEntropy::root(const std::string& range) const {
+    std::shared_lock<std::shared_mutex> lock(trees_mutex_);
+    auto it = trees_.find(range);
+    return it != trees_.end() ? it->second->root() : 0;
+}
+
+std::vector<uint64_t> AntiEntropy::tree_children(const std::string& range, size_t level,
+                                                 const std::vector<size_t>& indices) const {
+    size_t width = 1;
+    for (size_t l = 0; l < level; ++l) width *= MerkleTree::FANOUT;
+    if (level >= MerkleTree::DEPTH) throw std::runtime_error("level out of range");
+    
+    std::vector<uint64_t> hashes;
+    hashes.reserve(indices.size() * MerkleTree::FANOUT);
+    std::shared_lock<std::shared_mutex> lock(trees_mutex_);
+    auto it = trees_.find(range);
+    for (size_t index : indices) {
+        if (index >= width) throw std::runtime_error("node index out of range");
+        if (it == trees_.end()) {
+            hashes.insert(hashes.end(), MerkleTree::FANOUT, 0);
+            continue;
+        }
+        auto children = it->second->children(level, index);
+        hashes.insert(hashes.end(), children.begin(), children.end());
+    }
+    return hashes;
+}
+
+std::vector<LRUCache::VersionedEntry> AntiEntropy::scan_leaves(const std::string& range,
+                                                               const std::vector<size_t>& leaves) const {
+    // Keys are not indexed by leaf, so this is one pass over the cache per
+    // exchange; only the matching entries leave the node
+    std::unordered_set<size_t> wanted(leaves.begin(), leaves.end());
+    std::vector<LRUCache::VersionedEntry> entries;
+    for (size_t i = 0; i < cache_.shard_count(); ++i) {
+        for (auto& entry : cache_.snapshot_shard_versioned(i)) {
+            if (wanted.count(MerkleTree::leaf_of(entry.key)) && range_of(entry.key) == range) {
+                entries.push_back(std::move(entry));
+            }
+        }
+    }
+    return entries;
+}
+
+std::vector<AntiEntropy::KeyDigest> AntiEntropy::leaf_digests(const std::string& range,
+                                                              const std::vector<size_t>& leaves) const {
+    std::vector<KeyDigest> digests;
+    for (const auto& entry : scan_leaves(range, leaves)) {
+        digests.push_back({entry.key, entry.version, MerkleTree::entry_hash(entry.key, entry.value),
+                           entry.ttl_seconds});
+    }
+    return digests;
+}
+
+bool AntiEntropy::call(const std::string& peer, const std::vector<std::string>& argv, std::string& reply) {
+    auto future = peers_.forward(peer, argv);
+    if (future.wait_for(std::chrono::milliseconds(CALL_TIMEOUT_MS)) != std::future_status::ready) return false;
+    reply = future.get();
+    bytes_exchanged_ += RESPParser::serialize_command(argv).size() + reply.size();
+    return !reply.empty() && reply[0] != '-';
+}
+
+size_t AntiEntropy::sync_with(const std::string& peer) {
+    std::lock_guard<std::mutex> lock(sync_mutex_);
+    size_t repaired = 0;
+    for (const auto& range : ranges()) {
+        bool shared = false;
+        for (const auto& node : RESPParser::split(range, ',')) shared = shared || node == peer;
+        if (shared) repaired += sync_range(peer, range);
+    }
+    return repaired;
+}
+
+size_t AntiEntropy::sync_range(const std::string& peer, const std::string& range) {
+    // Walk down level by level, asking only for the children of nodes that
+    // differed one level up
+    std::vector<size_t> differing{0};
+    for (size_t level = 0; level < MerkleTree::DEPTH && !differing.empty(); ++level) {
+        std::vector<std::string> argv{"MTREE", range, std::to_string(level)};
+        for (size_t index : differing) argv.push_back(std::to_string(index));
+        
+        std::string raw;
+        RESPParser::Reply reply;
+        size_t consumed = 0;
+        if (!call(peer, argv, raw) || !RESPParser::parse_reply(raw, consumed, reply) ||
+            reply.elements.size() != differing.size() * MerkleTree::FANOUT) {
+            return 0;
+        }
+        
+        auto local = tree_children(range, level, differing);
+        std::vector<size_t> next;
+        for (size_t i = 0; i < local.size(); ++i) {
+            if (local[i] != std::stoull(reply.elements[i].str)) {
+                next.push_back(differing[i / MerkleTree::FANOUT] * MerkleTree::FANOUT + i % MerkleTree::FANOUT);
+            }
+        }
+        differing = std::move(next);
+    }
+    if (differing.empty()) return 0;
+    
+    // Differing leaves: compare their entries key by key
+    std::vector<std::string> argv{"MKEYS", range};
+    for (size_t leaf : differing) argv.push_back(std::to_string(leaf));
+    std::string raw;
+    RESPParser::Reply reply;
+    size_t consumed = 0;
+    if (!call(peer, argv, raw) || !RESPParser::parse_reply(raw, consumed, reply) ||
+        reply.elements.size() % 4 != 0) {
+        return 0;
+    }
+    
+    std::map<std::string, KeyDigest> remote;
+    for (size_t i = 0; i + 3 < reply.elements.size(); i += 4) {
+        const std::string& key = reply.elements[i].str;
+        remote[key] = {key, std::stoull(reply.elements[i + 1].str), std::stoull(reply.elements[i + 2].str),
+                       std::stoi(reply.elements[i + 3].str)};
+    }
+    std::vector<std::string> pull;
+    std::vector<const LRUCache::VersionedEntry*> push;
+    std::vector<std::pair<std::string, uint64_t>> remove;
+    size_t settled = 0;
+    auto local = scan_leaves(range, differing);
+    for (const auto& entry : local) {
+        uint64_t deleted = tombstone_version(entry.key);
+        if (deleted != 0 && deleted >= entry.version) {
+            // A VSET that raced with the delete put an older copy back
+            cache_.del_versioned(entry.key, deleted, [&] { wal_.append("DEL", entry.key); });
+            settled++;
+            continue;
+        }
+        auto it = remote.find(entry.key);
+        if (it == remote.end()) {
+            push.push_back(&entry);
+            continue;
+        }
+        const KeyDigest& theirs = it->second;
+        if (theirs.hash != MerkleTree::entry_hash(entry.key, entry.value)) {
+            // Equal versions with different values: both sides settle on the
+            // same copy through set_versioned's tie-break
+            if (entry.version >= theirs.version) push.push_back(&entry);
+            if (theirs.version >= entry.version) pull.push_back(entry.key);
+        }
+        remote.erase(it);
+    }
+    for (const auto& [key, digest] : remote) {
+        uint64_t deleted = tombstone_version(key);
+        if (deleted != 0 && deleted >= digest.version) {
+            remove.emplace_back(key, deleted);
+        } else if (digest.ttl_seconds > 1) {
+            pull.push_back(key);
+        } else {
+            // Gone from there within a second; copying it would only
+            // race the expiry
+            settled++;
+        }
+    }
+    if (pull.empty() && push.empty() && remove.empty() && settled == 0) {
+        // The trees disagree while the data does not: a leaf missed an
+        // update during a rebuild
+        stale_ = true;
+        return 0;
+    }
+    
+    // Pipelined both ways: every request is sent before any reply is awaited
+    std::vector<std::pair<std::string, std::future<std::string>>> fetches;
+    for (const auto& key : pull) fetches.emplace_back(key, peers_.forward(peer, {"VGET", key}));
+    std::vector<std::pair<std::vector<std::string>, std::future<std::string>>> stores;
+    for (const auto* entry : push) {
+        std::vector<std::string> vset{"VSET", entry->key, entry->value, std::to_string(entry->version),
+                                      std::to_string(entry->ttl_seconds)};
+        auto future = peers_.forward(peer, vset);
+        stores.emplace_back(std::move(vset), std::move(future));
+    }
+    for (const auto& [key, version] : remove) {
+        std::vector<std::string> vdel{"VDEL", key, std::to_string(version)};
+        auto future = peers_.forward(peer, vdel);
+        stores.emplace_back(std::move(vdel), std::move(future));
+    }
+    
+    size_t repaired = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CALL_TIMEOUT_MS);
+    for (auto& [key, future] : fetches) {
+        if (future.wait_until(deadline) != std::future_status::ready) continue;
+        std::string fetched = future.get();
+        bytes_exchanged_ += RESPParser::serialize_command({"VGET", key}).size() + fetched.size();
+        RESPParser::Reply parsed;
+        size_t used = 0;
+        if (!RESPParser::parse_reply(fetched, used, parsed) || parsed.type != '*' || parsed.elements.size() < 3) {
+            continue;
+        }
+        const std::string& value = parsed.elements[0].str;
+        uint64_t version = std::stoull(parsed.elements[1].str);
+        int ttl = std::stoi(parsed.elements[2].str);
+        if (cache_.set_versioned(key, value, version, ttl, [&] { wal_.append_set(key, value, ttl, version); })) {
+            repaired++;
+        }
+    }
+    for (auto& [vset, future] : stores) {
+        if (future.wait_until(deadline) != std::future_status::ready) continue;
+        std::string stored = future.get();
+        bytes_exchanged_ += RESPParser::serialize_command(vset).size() + stored.size();
+        if (stored == ":1\r\n") repaired++;
+    }
+    
+    keys_repaired_ += repaired;
+    return repaired;
+}
+
+void AntiEntropy::sync_all() {
+    auto members = ring_.get_all_nodes();
+    bool changed;
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        changed = members != members_;
+        members_ = members;
+    }
+    if (changed || stale_.exchange(false)) rebuild();
+    expire_tombstones();
+    
+    size_t repaired = 0;
+    for (const auto& peer : peers_.peer_ids()) repaired += sync_with(peer);
+    if (repaired > 0) {
+        LOG_INFO("AntiEntropy", self_id_ << " repaired " << repaired << " keys");
+    }
+}
+
+void AntiEntropy::worker_loop() {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    while (!worker_cv_.wait_for(lock, std::chrono::milliseconds(config_.interval_ms),
+                                [this]() { return stopping_; })) {
+        lock.unlock();
+        sync_all();
+        lock.lock();
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "storage/LRUCache.h"
+#include "storage/MerkleTree.h"
+#include "storage/WAL.h"
+#include "cluster/HashRing.h"
+#include "network/PeerPool.h"
+
+// Background repair between replicas (Dynamo-style anti-entropy). Keys are
+// grouped into ranges by their replica set, the first N nodes of the ring
+// preference list; for every range this node belongs to it keeps a
+// MerkleTree that is updated on each change to the cache, so it is always
+// current without rescans.
+//
+// Periodically each range is compared with every other replica of it: both
+// sides walk down from the root only through children whose hashes differ,
+// exchange key digests for the differing leaves, and copy just the keys
+// that differ, newest version winning. An in-sync range costs one round
+// trip, and repair traffic grows with the divergence, not the data size.
+//
+// Copies carry their remaining TTL, so replicas expire a key together. A
+// client DEL leaves a tombstone versioned from the cache's clock; a replica
+// still holding an older copy is sent VDEL instead of being copied from,
+// and older VSETs are refused. Tombstones are dropped after tombstone_ttl_ms,
+// which has to cover the longest expected partition.
+//
+// Peer operations:
+//   MTREE range level index...  -> child hashes of each node, in order
+//   MKEYS range leaf...         -> [key, version, hash, ttl] for each entry
+//   VDEL key version            -> :1 deleted, :0 a newer copy was kept
+class AntiEntropy : public CacheListener {
+public:
+    struct Config {
+        size_t replicas = 3;
+        int interval_ms = 10000;  // 0 disables the background exchange
+        int tombstone_ttl_ms = 3600000;
+    };
+    
+    struct KeyDigest {
+        std::string key;
+        uint64_t version;
+        uint64_t hash;
+        int ttl_seconds;
+    };
+    
+    // Register with cache.add_listener() before the cache is filled
+    AntiEntropy(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers);
+    AntiEntropy(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers,
+                const Config& config);
+    ~AntiEntropy() override;
+    
+    void on_set(const std::string& key, const std::string* old_value, const std::string& value,
+                std::chrono::steady_clock::time_point expire_time) override;
+    void on_erase(const std::string& key, const std::string& old_value) override;
+    
+    // Recomputes the trees from the cache, e.g. after ring membership
+    // changed. Writes racing with the scan can leave a leaf off until the
+    // next rebuild; a sync that finds no differing keys under differing
+    // leaves schedules one.
+    void rebuild();
+    // Repairs every range shared with peer; returns the keys copied
+    size_t sync_with(const std::string& peer);
+    // One round with every peer, rebuilding first if the ring changed
+    void sync_all();
+    
+    // Serving side of MTREE/MKEYS; unknown ranges look empty
+    std::vector<uint64_t> tree_children(const std::string& range, size_t level,
+                                        const std::vector<size_t>& indices) const;
+    std::vector<KeyDigest> leaf_digests(const std::string& range, const std::vector<size_t>& leaves) const;
+    
+    // Tombstones. record_delete is called for a client DEL with the key's
+    // shard lock held (from the delete's journal callback); apply_delete
+    // serves VDEL; deleted_since tells VSET a newer delete exists.
+    void record_delete(const std::string& key);
+    bool apply_delete(const std::string& key, uint64_t version);
+    bool deleted_since(const std::string& key, uint64_t version) const;
+    size_t tombstone_count() const;
+    
+    std::vector<std::string> ranges() const;
+    uint64_t root(const std::string& range) const;
+    size_t keys_repaired() const { return keys_repaired_; }
+    size_t bytes_exchanged() const { return bytes_exchanged_; }
+    
+private:
+    std::string self_id_;
+    LRUCache& cache_;
+    WAL& wal_;
+    HashRing& ring_;
+    PeerPool& peers_;
+    Config config_;
+    
+    std::unordered_map<std::string, std::unique_ptr<MerkleTree>> trees_;
+    mutable std::shared_mutex trees_mutex_;
+    
+    struct Tombstone {
+        uint64_t version;
+        std::chrono::steady_clock::time_point created;
+    };
+    std::unordered_map<std::string, Tombstone> tombstones_;
+    mutable std::shared_mutex tombstones_mutex_;
+    
+    // One exchange at a time; members_ is the membership the trees follow
+    std::mutex sync_mutex_;
+    std::vector<std::string> members_;
+    std::atomic<bool> stale_{false};
+    std::atomic<size_t> keys_repaired_{0};
+    std::atomic<size_t> bytes_exchanged_{0};
+    
+    std::thread worker_;
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+    bool stopping_ = false;
+    
+    static constexpr int CALL_TIMEOUT_MS = 5000;
+    
+    // Sorted replica ids of the key joined by ',', empty if this node is
+    // not one of them
+    std::string range_of(std::string_view key) const;
+    void update(const std::string& key, const std::string* old_value, const std::string* value);
+    void add_tombstone(const std::string& key, uint64_t version);
+    // Version of the key's tombstone, 0 if there is none
+    uint64_t tombstone_version(const std::string& key) const;
+    void expire_tombstones();
+    std::vector<LRUCache::VersionedEntry> scan_leaves(const std::string& range,
+                                                      const std::vector<size_t>& leaves) const;
+    size_t sync_range(const std::string& peer, const std::string& range);
+    bool call(const std::string& peer, const std::vector<std::string>& argv, std::string& reply);
+    void worker_loop();
+};
@@ -1,64 +1,402 @@
 #include "HashRing.h"
+#include "monitoring/Logger.h"
+#include <thread>
+#include <stdexcept>
+#include <cmath>
 
-uint32_t HashRing::hash(const std::string& input) const {
-    // Simple but effective hash function (FNV-1a variant)
+HashRing::HashRing(size_t virtual_nodes)
+    : table_(new Table()), names_(new std::string[MAX_NODES]),
+      virtual_nodes_(virtual_nodes > 0 ? virtual_nodes : 1),
+      loads_(new LoadCounter[MAX_NODES]) {}
+
+HashRing::HashRing(Strategy strategy, size_t virtual_nodes) : HashRing(virtual_nodes) {
+    strategy_ = strategy;
+}
+
+const char* HashRing::strategy_name(Strategy strategy) {
+    switch (strategy) {
+        case Strategy::RING: return "ring";
+        case Strategy::JUMP: return "jump";
+        case Strategy::RENDEZVOUS: return "rendezvous";
+        case Strategy::MAGLEV: return "maglev";
+    }
+    return "unknown";
+}
+
+HashRing::~HashRing() {
+    delete table_.load();
+}
+
+uint32_t HashRing::hash(std::string_view input) {
+    // FNV-1a, then the murmur3 finalizer: plain FNV clusters similar
+    // strings such as "node-1:0", "node-1:1" on the ring
     uint32_t hash = 2166136261u;
     for (char c : input) {
-        hash ^= static_cast<uint32_t>(c);
+        hash ^= static_cast<uint8_t>(c);
         hash *= 16777619u;
     }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
     return hash;
 }
 
-void HashRing::add_node(const std::string& node_id) {
-    // Add virtual nodes for better load distribution
-    for (int i = 0; i < VIRTUAL_NODES; ++i) {
-        std::string virtual_node = node_id + ":" + std::to_string(i);
-        uint32_t hash_val = hash(virtual_node);
-        ring_[hash_val] = node_id;
+uint64_t HashRing::mix64(uint64_t value) {
+    // murmur3 fmix64
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+uint64_t HashRing::hash64(std::string_view input) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : input) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return mix64(hash);
+}
+
+size_t HashRing::reader_slot() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local size_t slot = next_slot++ % READER_SLOTS;
+    return slot;
+}
+
+HashRing::ReadGuard::ReadGuard(const HashRing& ring)
+    : counter_(ring.readers_[reader_slot()].active[ring.epoch_.load() & 1]) {
+    counter_.fetch_add(1);
+    table_ = ring.table_.load();
+}
+
+HashRing::ReadGuard::~ReadGuard() {
+    counter_.fetch_sub(1);
+}
+
+void HashRing::add_node(const std::string& node_id, uint32_t weight) {
+    if (weight == 0) weight = 1;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto end = names_.get() + weights_.size();
+        auto it = std::find(names_.get(), end, node_id);
+        if (it == end) {
+            if (weights_.size() == MAX_NODES) {
+                throw std::runtime_error("HashRing node registry full");
+            }
+            names_[weights_.size()] = node_id;
+            weights_.push_back(0);
+        }
+        set_weight(static_cast<uint32_t>(it - names_.get()), weight);
+        publish(build_table());
+    }
+    
+    if (strategy_ == Strategy::RING) {
+        LOG_INFO("HashRing", "Added node: " << node_id << " (" << virtual_nodes_ * weight << " virtual nodes)");
+    } else {
+        LOG_INFO("HashRing", "Added node: " << node_id);
     }
-    std::cout << "[HashRing] Added node: " << node_id 
-              << " (" << VIRTUAL_NODES << " virtual nodes)\n";
 }
 
 void HashRing::remove_node(const std::string& node_id) {
-    auto it = ring_.begin();
-    while (it != ring_.end()) {
-        if (it->second == node_id) {
-            it = ring_.erase(it);
-        } else {
-            ++it;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto end = names_.get() + weights_.size();
+        auto it = std::find(names_.get(), end, node_id);
+        if (it == end || weights_[it - names_.get()] == 0) return;
+
+        set_weight(static_cast<uint32_t>(it - names_.get()), 0);
+        publish(build_table());
+    }
+    LOG_INFO("HashRing", "Removed node: " << node_id);
+}
+
+void HashRing::set_weight(uint32_t node, uint32_t weight) {
+    uint32_t old_weight = weights_[node];
+    weights_[node] = weight;
+
+    for (uint32_t i = old_weight; i < weight; ++i) {
+        jump_buckets_.push_back(node);
+    }
+    for (uint32_t i = weight; i < old_weight; ++i) {
+        auto it = std::find(jump_buckets_.begin(), jump_buckets_.end(), node);
+        *it = jump_buckets_.back();
+        jump_buckets_.pop_back();
+    }
+}
+
+std::unique_ptr<HashRing::Table> HashRing::build_table() const {
+    auto table = std::make_unique<Table>();
+    for (uint32_t node = 0; node < weights_.size(); ++node) {
+        if (weights_[node] == 0) continue;
+        table->members.push_back(node);
+    }
+
+    switch (strategy_) {
+        case Strategy::RING:
+            build_ring(*table);
+            break;
+        case Strategy::JUMP:
+            table->buckets = jump_buckets_;
+            break;
+        case Strategy::RENDEZVOUS:
+            for (uint32_t node : table->members) {
+                table->seeds.push_back(hash64(names_[node]));
+                table->weights.push_back(weights_[node]);
+            }
+            break;
+        case Strategy::MAGLEV:
+            build_maglev(*table);
+            break;
+    }
+    return table;
+}
+
+void HashRing::build_ring(Table& table) const {
+    std::vector<std::pair<uint32_t, uint32_t>> points;
+    for (uint32_t node : table.members) {
+        size_t count = virtual_nodes_ * weights_[node];
+        for (size_t i = 0; i < count; ++i) {
+            points.emplace_back(hash(names_[node] + ":" + std::to_string(i)), node);
         }
     }
-    std::cout << "[HashRing] Removed node: " << node_id << "\n";
+    // Ties broken by node index so the layout is independent of insert order
+    std::sort(points.begin(), points.end());
+
+    table.hashes.reserve(points.size());
+    table.owners.reserve(points.size());
+    for (const auto& [point_hash, node] : points) {
+        table.hashes.push_back(point_hash);
+        table.owners.push_back(node);
+    }
 }
 
-std::string HashRing::get_node(const std::string& key) const {
-    if (ring_.empty()) return "localhost"; // Fallback
-    
-    uint32_t key_hash = hash(key);
-    
-    // Find first node with hash >= key_hash
-    auto it = ring_.lower_bound(key_hash);
-    if (it == ring_.end()) {
-        // Wrap around to first node
-        it = ring_.begin();
+void HashRing::build_maglev(Table& table) const {
+    if (table.members.empty()) return;
+
+    // Each member walks its own permutation of the slots (offset + j*skip,
+    // M prime) and claims the next free one per turn; weight = turns per round
+    const uint64_t size = MAGLEV_TABLE_SIZE;
+    size_t count = table.members.size();
+    std::vector<uint64_t> offset(count), skip(count), next(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t h = hash64(names_[table.members[i]]);
+        offset[i] = h % size;
+        skip[i] = mix64(h) % (size - 1) + 1;
+    }
+
+    table.lookup.assign(size, NO_NODE);
+    uint64_t filled = 0;
+    while (filled < size) {
+        for (size_t i = 0; i < count && filled < size; ++i) {
+            for (uint32_t turn = 0; turn < weights_[table.members[i]] && filled < size; ++turn) {
+                uint64_t slot = (offset[i] + next[i] * skip[i]) % size;
+                while (table.lookup[slot] != NO_NODE) {
+                    next[i]++;
+                    slot = (offset[i] + next[i] * skip[i]) % size;
+                }
+                table.lookup[slot] = table.members[i];
+                next[i]++;
+                filled++;
+            }
+        }
+    }
+}
+
+void HashRing::publish(std::unique_ptr<Table> table) {
+    std::unique_ptr<const Table> old(table_.exchange(table.release()));
+
+    // A reader may have picked its counter from either epoch before it saw
+    // the swap, so drain both: flip, wait for the old side, flip back, wait
+    // for the other. Readers arriving after a flip see the new table.
+    for (int phase = 0; phase < 2; ++phase) {
+        uint32_t previous = epoch_.fetch_add(1);
+        wait_for_readers(previous & 1);
+    }
+}
+
+void HashRing::wait_for_readers(uint32_t parity) const {
+    for (const auto& slot : readers_) {
+        while (slot.active[parity].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+size_t HashRing::find_point(const Table& table, uint32_t key_hash) {
+    // Branchless lower_bound: the loop trip count depends only on the size,
+    // and the comparison compiles to a conditional move
+    const uint32_t* base = table.hashes.data();
+    size_t n = table.hashes.size();
+    while (n > 1) {
+        size_t half = n / 2;
+        base = base[half] < key_hash ? base + half : base;
+        n -= half;
+    }
+    size_t index = (base - table.hashes.data()) + (*base < key_hash);
+    // Past the last point wraps around to the first
+    return index == table.hashes.size() ? 0 : index;
+}
+
+uint32_t HashRing::jump_bucket(uint64_t key, uint32_t num_buckets) {
+    // Lamping & Veach, "A Fast, Minimal Memory, Consistent Hash Algorithm"
+    int64_t b = -1, j = 0;
+    while (j < num_buckets) {
+        b = j;
+        key = key * 2862933555777941757ull + 1;
+        j = static_cast<int64_t>((b + 1) * (double(1ll << 31) / double((key >> 33) + 1)));
+    }
+    return static_cast<uint32_t>(b);
+}
+
+uint32_t HashRing::rendezvous_pick(const Table& table, uint64_t key_hash) {
+    // Weighted HRW: score = -w / ln(u) with u uniform in (0, 1)
+    uint32_t best = NO_NODE;
+    double best_score = -1.0;
+    for (size_t i = 0; i < table.members.size(); ++i) {
+        uint64_t h = mix64(key_hash ^ table.seeds[i]);
+        double u = (static_cast<double>(h >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+        double score = -table.weights[i] / std::log(u);
+        if (score > best_score) {
+            best_score = score;
+            best = table.members[i];
+        }
     }
+    return best;
+}
+
+uint32_t HashRing::owner_in(const Table& table, std::string_view key) const {
+    if (table.members.empty()) return NO_NODE;
+    switch (strategy_) {
+        case Strategy::RING:
+            return table.owners[find_point(table, hash(key))];
+        case Strategy::JUMP:
+            return table.buckets[jump_bucket(hash64(key), static_cast<uint32_t>(table.buckets.size()))];
+        case Strategy::RENDEZVOUS:
+            return rendezvous_pick(table, hash64(key));
+        case Strategy::MAGLEV:
+            return table.lookup[hash64(key) % table.lookup.size()];
+    }
+    return NO_NODE;
+}
+
+uint32_t HashRing::get_node_index(std::string_view key) const {
+    ReadGuard guard(*this);
+    return owner_in(*guard.table(), key);
+}
+
+std::vector<uint32_t> HashRing::walk_from(const Table& table, std::string_view key, uint32_t owner,
+                                          size_t n) const {
+    std::vector<uint32_t> nodes{owner};
+    n = std::min(n, table.members.size());
+    if (strategy_ == Strategy::RING) {
+        size_t start = find_point(table, hash(key));
+        for (size_t i = 1; i < table.owners.size() && nodes.size() < n; ++i) {
+            uint32_t candidate = table.owners[(start + i) % table.owners.size()];
+            if (std::find(nodes.begin(), nodes.end(), candidate) == nodes.end()) nodes.push_back(candidate);
+        }
+    } else {
+        size_t count = table.members.size();
+        size_t start = std::find(table.members.begin(), table.members.end(), owner) - table.members.begin();
+        for (size_t i = 1; i < count && nodes.size() < n; ++i) {
+            nodes.push_back(table.members[(start + i) % count]);
+        }
+    }
+    return nodes;
+}
+
+std::vector<std::string> HashRing::preference_list(std::string_view key, size_t n) const {
+    ReadGuard guard(*this);
+    const Table& table = *guard.table();
+    uint32_t owner = owner_in(table, key);
+    std::vector<std::string> nodes;
+    if (owner == NO_NODE || n == 0) return nodes;
     
-    return it->second;
+    for (uint32_t node : walk_from(table, key, owner, n)) nodes.push_back(names_[node]);
+    return nodes;
+}
+
+void HashRing::enable_bounded_load(double epsilon) {
+    epsilon_ = epsilon;
+}
+
+bool HashRing::try_reserve(uint32_t node, int64_t cap) {
+    auto& counter = loads_[node].value;
+    int64_t current = counter.load(std::memory_order_relaxed);
+    while (current < cap) {
+        if (counter.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+            total_load_.value.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t HashRing::acquire(std::string_view key, size_t replicas) {
+    ReadGuard guard(*this);
+    const Table& table = *guard.table();
+    uint32_t owner = owner_in(table, key);
+    if (owner == NO_NODE) return NO_NODE;
+
+    if (epsilon_ > 0.0) {
+        // Counters are approximate under races; the cap only needs to hold
+        // on average, not exactly
+        int64_t total = total_load_.value.load(std::memory_order_relaxed) + 1;
+        int64_t cap = static_cast<int64_t>(
+            std::ceil((1.0 + epsilon_) * total / table.members.size()));
+        if (try_reserve(owner, cap)) return owner;
+
+        // Spill in placement order: next ring points for RING, next members
+        // otherwise. Over every member the cap leaves room somewhere since
+        // it is above average; a full replica set falls back to the owner.
+        size_t n = replicas > 0 ? replicas : table.members.size();
+        for (uint32_t candidate : walk_from(table, key, owner, n)) {
+            if (candidate != owner && try_reserve(candidate, cap)) return candidate;
+        }
+    }
+
+    loads_[owner].value.fetch_add(1, std::memory_order_relaxed);
+    total_load_.value.fetch_add(1, std::memory_order_relaxed);
+    return owner;
+}
+
+void HashRing::release(uint32_t node) {
+    if (node == NO_NODE) return;
+    loads_[node].value.fetch_sub(1, std::memory_order_relaxed);
+    total_load_.value.fetch_sub(1, std::memory_order_relaxed);
+}
+
+const std::string& HashRing::get_node(const std::string& key) const {
+    static const std::string fallback = "localhost";
+    uint32_t index = get_node_index(key);
+    return index == NO_NODE ? fallback : names_[index];
 }
 
 std::vector<std::string> HashRing::get_all_nodes() const {
+    ReadGuard guard(*this);
     std::vector<std::string> nodes;
-    for (const auto& [hash_val, node] : ring_) {
-        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end()) {
-            nodes.push_back(node);
-        }
+    for (uint32_t node : guard.table()->members) {
+        nodes.push_back(names_[node]);
     }
     return nodes;
 }
 
+size_t HashRing::virtual_node_count() const {
+    ReadGuard guard(*this);
+    const Table& table = *guard.table();
+    switch (strategy_) {
+        case Strategy::JUMP: return table.buckets.size();
+        case Strategy::RENDEZVOUS: return table.members.size();
+        case Strategy::MAGLEV: return table.lookup.size();
+        default: return table.hashes.size();
+    }
+}
+
 void HashRing::print_ring_status() const {
-    std::cout << "[HashRing] Status: " << ring_.size() << " virtual nodes, "
-              << get_all_nodes().size() << " physical nodes\n";
-}
\ No newline at end of file
+    LOG_INFO("HashRing", "Status: " << virtual_node_count() << " virtual nodes, "
+                         << get_all_nodes().size() << " physical nodes");
+}
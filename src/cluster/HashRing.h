@@ -1,22 +1,149 @@
 #pragma once
-#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <cstdint>
 #include <functional>
 #include <algorithm>
 #include <iostream>
 
+// Routing is lock-free: each membership change builds a new immutable ring
+// and publishes it with one pointer swap. The old ring is freed once every
+// reader that could have seen it has left (two-phase epoch counters).
 class HashRing {
 public:
-    void add_node(const std::string& node_id);
+    // Placement algorithm, fixed for the lifetime of the ring:
+    //   RING        sorted virtual-node points, O(log n) search
+    //   JUMP        Lamping-Veach jump hash, no table, O(ln n)
+    //   RENDEZVOUS  highest random weight, O(n) per lookup
+    //   MAGLEV      prime-sized lookup table, O(1)
+    enum class Strategy { RING, JUMP, RENDEZVOUS, MAGLEV };
+
+    static constexpr size_t DEFAULT_VIRTUAL_NODES = 1024;
+    static constexpr size_t MAX_NODES = 4096;
+    static constexpr size_t MAGLEV_TABLE_SIZE = 65537;
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    // virtual_nodes is the number of ring points per unit of weight
+    explicit HashRing(size_t virtual_nodes = DEFAULT_VIRTUAL_NODES);
+    explicit HashRing(Strategy strategy, size_t virtual_nodes = DEFAULT_VIRTUAL_NODES);
+    ~HashRing();
+
+    HashRing(const HashRing&) = delete;
+    HashRing& operator=(const HashRing&) = delete;
+
+    // A node with weight w owns roughly w times the keys of a weight-1 node.
+    // Re-adding an existing node updates its weight.
+    void add_node(const std::string& node_id, uint32_t weight = 1);
     void remove_node(const std::string& node_id);
-    std::string get_node(const std::string& key) const;
+
+    // Returns the owning node's name without copying; "localhost" when empty
+    const std::string& get_node(const std::string& key) const;
+    // Stable index into the node registry, NO_NODE when the ring is empty
+    uint32_t get_node_index(std::string_view key) const;
+    // Registry names are written once and never move, so references stay
+    // valid for the ring's lifetime
+    const std::string& node_name(uint32_t index) const { return names_[index]; }
+
+    // The first n distinct nodes in placement order starting at the key's
+    // owner: clockwise ring walk for RING, member order otherwise. Used as
+    // the replica set for quorum operations.
+    std::vector<std::string> preference_list(std::string_view key, size_t n) const;
+
+    // Bounded-load routing (Mirrokni et al.): acquire() picks the key's owner
+    // unless that node already carries more than ceil((1 + epsilon) * average)
+    // in-flight requests, in which case it walks on to the next node with
+    // room, among the key's first `replicas` preference-list nodes if given.
+    // Every acquire() must be paired with release() of the returned node.
+    // Placement for get_node() is unaffected. TCPServer uses it to spread
+    // reads of replicated keys over their replicas.
+    void enable_bounded_load(double epsilon);
+    bool bounded_load_enabled() const { return epsilon_ > 0.0; }
+    uint32_t acquire(std::string_view key, size_t replicas = 0);
+    void release(uint32_t node);
+    int64_t load(uint32_t node) const { return loads_[node].value.load(std::memory_order_relaxed); }
+
     std::vector<std::string> get_all_nodes() const;
+    size_t virtual_node_count() const;
+    Strategy strategy() const { return strategy_; }
+    static const char* strategy_name(Strategy strategy);
     void print_ring_status() const;
     
 private:
-    std::map<uint32_t, std::string> ring_;
-    static const int VIRTUAL_NODES = 3; // Simple virtual nodes for better distribution
+    // Immutable once published
+    struct Table {
+        // RING: points as parallel sorted arrays, the search only touches hashes
+        std::vector<uint32_t> hashes;
+        std::vector<uint32_t> owners;
+        std::vector<uint32_t> members;
+        // JUMP: node per bucket, a weight-w node fills w buckets
+        std::vector<uint32_t> buckets;
+        // RENDEZVOUS: per-member seed and weight, parallel to members
+        std::vector<uint64_t> seeds;
+        std::vector<double> weights;
+        // MAGLEV: node per table slot
+        std::vector<uint32_t> lookup;
+    };
+
+    // Readers announce themselves in one of these counters; padded so
+    // readers on different cores do not share a cache line
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> active[2] = {0, 0};
+    };
+    static constexpr size_t READER_SLOTS = 32;
+
+    struct alignas(64) LoadCounter {
+        std::atomic<int64_t> value{0};
+    };
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const HashRing& ring);
+        ~ReadGuard();
+        const Table* table() const { return table_; }
+    private:
+        std::atomic<uint64_t>& counter_;
+        const Table* table_;
+    };
+
+    std::atomic<const Table*> table_;
+    mutable std::array<ReaderSlot, READER_SLOTS> readers_;
+    std::atomic<uint32_t> epoch_{0};
+
+    // Append-only node registry. Weight 0 marks a removed node; its slot is
+    // kept so indices handed out earlier stay valid.
+    std::unique_ptr<std::string[]> names_;
+    std::vector<uint32_t> weights_;    // Writer side only
+    // Jump bucket order; removal swaps the last bucket into the hole so only
+    // the removed node's and the last node's keys move
+    std::vector<uint32_t> jump_buckets_;
+    Strategy strategy_ = Strategy::RING;
+    size_t virtual_nodes_;
+    std::mutex write_mutex_;
+
+    // In-flight requests per node index, for bounded-load routing
+    std::unique_ptr<LoadCounter[]> loads_;
+    LoadCounter total_load_;
+    double epsilon_ = 0.0;
     
-    uint32_t hash(const std::string& input) const;
-};
\ No newline at end of file
+    std::unique_ptr<Table> build_table() const;
+    void build_ring(Table& table) const;
+    void build_maglev(Table& table) const;
+    void set_weight(uint32_t node, uint32_t weight);
+    void publish(std::unique_ptr<Table> table);
+    void wait_for_readers(uint32_t parity) const;
+    uint32_t owner_in(const Table& table, std::string_view key) const;
+    std::vector<uint32_t> walk_from(const Table& table, std::string_view key, uint32_t owner, size_t n) const;
+    bool try_reserve(uint32_t node, int64_t cap);
+    static size_t find_point(const Table& table, uint32_t key_hash);
+    static uint32_t jump_bucket(uint64_t key, uint32_t num_buckets);
+    static uint32_t rendezvous_pick(const Table& table, uint64_t key_hash);
+    static size_t reader_slot();
+    static uint32_t hash(std::string_view input);
+    static uint64_t hash64(std::string_view input);
+    static uint64_t mix64(uint64_t value);
+};
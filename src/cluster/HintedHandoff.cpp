@@ -0,0 +1,284 @@
+#include "HintedHandoff.h"
+#include "monitoring/Logger.h"
+#include "storage/MMapPersistence.h"
+#include <filesystem>
+#include <future>
+#include <string_view>
+
+namespace {
+
+// Splits on single spaces, keeping empty fields (escaped empty values)
+std::vector<std::string_view> split_fields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t space = line.find(' ', start);
+        fields.push_back(line.substr(start, space == std::string_view::npos ? space : space - start));
+        if (space == std::string_view::npos) return fields;
+        start = space + 1;
+    }
+}
+
+size_t hint_bytes(const std::vector<std::string>& argv) {
+    size_t bytes = 0;
+    for (const auto& arg : argv) bytes += arg.size();
+    return bytes;
+}
+
+}
+
+HintedHandoff::HintedHandoff(const std::string& self_id, HashRing& ring, PeerPool& peers,
+                             const std::string& filename)
+    : HintedHandoff(self_id, ring, peers, filename, Config{}) {}
+
+HintedHandoff::HintedHandoff(const std::string& self_id, HashRing& ring, PeerPool& peers,
+                             const std::string& filename, const Config& config)
+    : self_id_(self_id), ring_(ring), peers_(peers), filename_(filename), config_(config) {
+    load();
+    log_.open(filename_, std::ios::app);
+    if (!log_.is_open()) {
+        throw std::runtime_error("Failed to open hint log: " + filename_);
+    }
+    worker_ = std::thread([this]() { worker_loop(); });
+}
+
+HintedHandoff::~HintedHandoff() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        stopping_ = true;
+    }
+    jobs_cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+bool HintedHandoff::unreachable(const std::string& reply) {
+    return reply.rfind("-ERR peer ", 0) == 0;
+}
+
+std::vector<std::string> HintedHandoff::versioned(const std::vector<std::string>& argv, uint64_t version) {
+    if (argv.size() == 2) return {"VDEL", argv[1], std::to_string(version)};
+    std::vector<std::string> hint{"VSET", argv[1], argv[2], std::to_string(version)};
+    if (argv.size() == 5) hint.push_back(argv[4]);  // EX seconds
+    return hint;
+}
+
+bool HintedHandoff::hand_off(const std::string& owner, const std::vector<std::string>& argv) {
+    if (argv.size() < 2) return false;
+    
+    // The owner heads the preference list; the first node after it that
+    // takes the hint keeps it
+    for (const auto& node : ring_.preference_list(argv[1], ring_.get_all_nodes().size())) {
+        if (node == owner) continue;
+        if (node == self_id_) {
+            if (store(owner, argv)) return true;
+            continue;
+        }
+        if (!peers_.has_peer(node)) continue;
+        
+        std::vector<std::string> hint{"HINT", owner};
+        hint.insert(hint.end(), argv.begin(), argv.end());
+        auto future = peers_.forward(node, hint);
+        if (future.wait_for(std::chrono::milliseconds(CALL_TIMEOUT_MS)) == std::future_status::ready &&
+            future.get() == "+OK\r\n") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HintedHandoff::store(const std::string& owner, const std::vector<std::string>& argv) {
+    if (argv.size() < 2) return false;
+    size_t bytes = hint_bytes(argv);
+    
+    std::lock_guard<std::mutex> lock(hints_mutex_);
+    size_t replaced = 0;
+    auto owner_it = hints_.find(owner);
+    if (owner_it != hints_.end()) {
+        auto it = owner_it->second.find(argv[1]);
+        if (it != owner_it->second.end()) replaced = it->second.bytes;
+    }
+    bool over_count = replaced == 0 && count_ >= config_.max_hints;
+    if (over_count || bytes_ - replaced + bytes > config_.max_bytes) {
+        dropped_++;
+        return false;
+    }
+    
+    add_locked(owner, argv);
+    append_locked('+', owner, argv);
+    return true;
+}
+
+void HintedHandoff::owner_alive(const std::string& owner) {
+    if (pending(owner) == 0) return;
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    jobs_.push_back(owner);
+    jobs_cv_.notify_all();
+}
+
+size_t HintedHandoff::pending() const {
+    std::lock_guard<std::mutex> lock(hints_mutex_);
+    return count_;
+}
+
+size_t HintedHandoff::pending(const std::string& owner) const {
+    std::lock_guard<std::mutex> lock(hints_mutex_);
+    auto it = hints_.find(owner);
+    return it != hints_.end() ? it->second.size() : 0;
+}
+
+void HintedHandoff::worker_loop() {
+    std::unique_lock<std::mutex> lock(jobs_mutex_);
+    while (!stopping_) {
+        std::vector<std::string> owners;
+        if (jobs_cv_.wait_for(lock, std::chrono::milliseconds(config_.retry_interval_ms),
+                              [this]() { return stopping_ || !jobs_.empty(); })) {
+            if (stopping_) return;
+            owners.push_back(jobs_.front());
+            jobs_.pop_front();
+        } else {
+            std::lock_guard<std::mutex> hints_lock(hints_mutex_);
+            for (const auto& [owner, hints] : hints_) owners.push_back(owner);
+        }
+        
+        lock.unlock();
+        for (const auto& owner : owners) deliver(owner);
+        lock.lock();
+    }
+}
+
+void HintedHandoff::deliver(const std::string& owner) {
+    size_t replayed = 0;
+    bool reachable = true;
+    while (reachable) {
+        std::vector<Hint> batch;
+        {
+            std::lock_guard<std::mutex> lock(hints_mutex_);
+            auto it = hints_.find(owner);
+            if (it == hints_.end()) break;
+            for (const auto& [key, hint] : it->second) {
+                if (batch.size() >= config_.batch_keys) break;
+                batch.push_back(hint);
+            }
+        }
+        
+        // Pipelined: the whole batch is sent before any reply is awaited
+        std::vector<std::future<std::string>> replies;
+        for (const auto& hint : batch) replies.push_back(peers_.forward(owner, hint.argv));
+        
+        std::vector<const Hint*> done;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CALL_TIMEOUT_MS);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            // Any answer from the owner settles the hint, errors included,
+            // unless it shed the request
+            std::string reply = replies[i].wait_until(deadline) == std::future_status::ready
+                ? replies[i].get() : "-ERR peer timeout\r\n";
+            if (!unreachable(reply) && reply.rfind("-BUSY", 0) != 0) {
+                done.push_back(&batch[i]);
+            } else {
+                reachable = false;
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(hints_mutex_);
+        auto it = hints_.find(owner);
+        for (const Hint* hint : done) {
+            // A newer write for the key arrived meanwhile: keep that one
+            if (it == hints_.end()) break;
+            auto current = it->second.find(hint->argv[1]);
+            if (current == it->second.end() || current->second.seq != hint->seq) continue;
+            append_locked('-', owner, {hint->argv[1]});
+            remove_locked(owner, hint->argv[1]);
+            it = hints_.find(owner);
+            replayed++;
+        }
+        if (done.empty()) break;
+    }
+    
+    std::lock_guard<std::mutex> lock(hints_mutex_);
+    delivered_ += replayed;
+    compact_locked();
+    if (replayed > 0 || !reachable) {
+        auto it = hints_.find(owner);
+        LOG_INFO("HintedHandoff", "Replayed " << replayed << " hints to " << owner << " ("
+                                  << (it != hints_.end() ? it->second.size() : 0) << " left)");
+    }
+}
+
+void HintedHandoff::add_locked(const std::string& owner, const std::vector<std::string>& argv) {
+    Hint& slot = hints_[owner][argv[1]];
+    if (slot.argv.empty()) {
+        count_++;
+    } else {
+        bytes_ -= slot.bytes;
+    }
+    slot = Hint{argv, next_seq_++, hint_bytes(argv)};
+    bytes_ += slot.bytes;
+}
+
+void HintedHandoff::remove_locked(const std::string& owner, const std::string& key) {
+    auto owner_it = hints_.find(owner);
+    if (owner_it == hints_.end()) return;
+    auto it = owner_it->second.find(key);
+    if (it == owner_it->second.end()) return;
+    
+    bytes_ -= it->second.bytes;
+    count_--;
+    owner_it->second.erase(it);
+    if (owner_it->second.empty()) hints_.erase(owner_it);
+}
+
+void HintedHandoff::append_locked(char kind, const std::string& owner, const std::vector<std::string>& fields) {
+    // "+ owner argv..." stores a hint, "- owner key" marks it delivered
+    log_ << kind << ' ' << MMapPersistence::escape_string(owner);
+    for (const auto& field : fields) log_ << ' ' << MMapPersistence::escape_string(field);
+    log_ << '\n';
+    log_.flush();
+    log_records_++;
+}
+
+void HintedHandoff::load() {
+    std::ifstream in(filename_);
+    std::string line;
+    while (std::getline(in, line)) {
+        auto fields = split_fields(line);
+        if (fields.size() < 3 || fields[0].size() != 1) continue;
+        std::string owner = MMapPersistence::unescape_string(fields[1]);
+        
+        if (fields[0][0] == '+' && fields.size() >= 4) {
+            std::vector<std::string> argv;
+            for (size_t i = 2; i < fields.size(); ++i) argv.push_back(MMapPersistence::unescape_string(fields[i]));
+            add_locked(owner, argv);
+        } else if (fields[0][0] == '-') {
+            remove_locked(owner, MMapPersistence::unescape_string(fields[2]));
+        }
+        log_records_++;
+    }
+    if (count_ > 0) {
+        LOG_INFO("HintedHandoff", "Loaded " << count_ << " hints for " << hints_.size() << " owners");
+    }
+}
+
+void HintedHandoff::compact_locked() {
+    if (count_ > 0 && log_records_ <= 2 * count_ + 1024) return;
+    
+    // Rewrite the live hints only; an empty store just truncates the log
+    std::string tmp_filename = filename_ + ".tmp";
+    {
+        std::ofstream out(tmp_filename, std::ios::trunc);
+        for (const auto& [owner, hints] : hints_) {
+            for (const auto& [key, hint] : hints) {
+                out << "+ " << MMapPersistence::escape_string(owner);
+                for (const auto& arg : hint.argv) out << ' ' << MMapPersistence::escape_string(arg);
+                out << '\n';
+            }
+        }
+        if (!out) {
+            LOG_WARN("HintedHandoff", "Failed to compact " << filename_);
+            return;
+        }
+    }
+    log_.close();
+    std::filesystem::rename(tmp_filename, filename_);
+    log_.open(filename_, std::ios::app);
+    log_records_ = count_;
+}
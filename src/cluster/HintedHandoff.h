@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "cluster/HashRing.h"
+#include "network/PeerPool.h"
+
+// Writes for an owner that cannot be reached are kept as hints on the next
+// healthy node of the key's preference list instead of being lost, and are
+// replayed to the owner in batches once it is reachable again (Dynamo's
+// hinted handoff). Only the latest write per key is kept, so a hot key
+// costs one hint however often it is written.
+//
+// Hints live in memory and in an append-only log, so they survive a
+// restart of the node holding them. They are bounded by count and bytes;
+// past the bound a write is refused rather than hinted.
+//
+// Hints carry the version taken when they were made and replay as VSET/VDEL,
+// so a write that reaches the owner directly after it came back, but before
+// its hints were replayed, is not overwritten by an older hinted one.
+class HintedHandoff {
+public:
+    struct Config {
+        size_t max_hints = 100000;
+        size_t max_bytes = 64 << 20;
+        size_t batch_keys = 256;
+        // Owners with hints are retried this often even without a
+        // membership event, e.g. after a breaker trip that gossip never saw
+        int retry_interval_ms = 10000;
+    };
+    
+    HintedHandoff(const std::string& self_id, HashRing& ring, PeerPool& peers, const std::string& filename);
+    HintedHandoff(const std::string& self_id, HashRing& ring, PeerPool& peers, const std::string& filename,
+                  const Config& config);
+    ~HintedHandoff();
+    
+    // A SET or DEL for owner failed to reach it: stores the hint here or on
+    // the next healthy node after the owner; false if nobody took it
+    bool hand_off(const std::string& owner, const std::vector<std::string>& argv);
+    // Keeps a hint for owner locally; false if the bound is reached
+    bool store(const std::string& owner, const std::vector<std::string>& argv);
+    // The owner is reachable again: replay its hints in the background
+    void owner_alive(const std::string& owner);
+    
+    size_t pending() const;
+    size_t pending(const std::string& owner) const;
+    size_t delivered() const { return delivered_; }
+    size_t dropped() const { return dropped_; }
+    
+    // Transport failures worth a hint, as opposed to errors from the owner
+    static bool unreachable(const std::string& reply);
+    // SET key value [EX ttl] / DEL key as the VSET / VDEL to hint at version
+    static std::vector<std::string> versioned(const std::vector<std::string>& argv, uint64_t version);
+    
+private:
+    struct Hint {
+        std::vector<std::string> argv;
+        uint64_t seq;
+        size_t bytes;
+    };
+    
+    std::string self_id_;
+    HashRing& ring_;
+    PeerPool& peers_;
+    std::string filename_;
+    Config config_;
+    
+    // owner -> key -> latest hint
+    std::map<std::string, std::unordered_map<std::string, Hint>> hints_;
+    mutable std::mutex hints_mutex_;
+    std::ofstream log_;
+    size_t log_records_ = 0;
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+    uint64_t next_seq_ = 1;
+    std::atomic<size_t> delivered_{0};
+    std::atomic<size_t> dropped_{0};
+    
+    std::thread worker_;
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<std::string> jobs_;
+    bool stopping_ = false;
+    
+    static constexpr int CALL_TIMEOUT_MS = 2000;
+    
+    void worker_loop();
+    void deliver(const std::string& owner);
+    void load();
+    // The helpers below expect hints_mutex_ to be held
+    void add_locked(const std::string& owner, const std::vector<std::string>& argv);
+    void remove_locked(const std::string& owner, const std::string& key);
+    void append_locked(char kind, const std::string& owner, const std::vector<std::string>& fields);
+    void compact_locked();
+};
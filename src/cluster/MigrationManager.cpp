@@ -0,0 +1,259 @@
+#include "MigrationManager.h"
+#include "monitoring/Logger.h"
+#include "network/RESPParser.h"
+#include <algorithm>
+
+MigrationManager::MigrationManager(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring,
+                                   PeerPool& peers)
+    : MigrationManager(self_id, cache, wal, ring, peers, Config{}) {}
+
+MigrationManager::MigrationManager(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring,
+                                   PeerPool& peers, const Config& config)
+    : self_id_(self_id), cache_(cache), wal_(wal), ring_(ring), peers_(peers), config_(config) {
+    worker_ = std::thread([this]() { worker_loop(); });
+}
+
+MigrationManager::~MigrationManager() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        stopping_ = true;
+    }
+    jobs_cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void MigrationManager::add_node(const std::string& node_id, uint32_t weight) {
+    auto members = ring_.get_all_nodes();
+    bool is_new = std::find(members.begin(), members.end(), node_id) == members.end();
+    ring_.add_node(node_id, weight);
+    if (!is_new) return;
+    
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    active_jobs_++;
+    jobs_.push_back({node_id});
+    jobs_cv_.notify_all();
+}
+
+void MigrationManager::remove_node(const std::string& node_id) {
+    // Keys on a departed node are gone; survivors keep theirs under
+    // consistent hashing, so there is nothing to stream
+    ring_.remove_node(node_id);
+    handoff_done(node_id);
+}
+
+void MigrationManager::worker_loop() {
+    while (true) {
+        std::vector<std::string> added;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_cv_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (stopping_) return;
+            added = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        migrate(added);
+        active_jobs_--;
+    }
+}
+
+void MigrationManager::migrate(const std::vector<std::string>& added) {
+    Pace pace{std::chrono::steady_clock::now()};
+    size_t sent_before = keys_sent_;
+    std::unordered_set<std::string> moved;
+    std::unordered_set<std::string> targets(added.begin(), added.end());
+    std::unordered_set<std::string> failed;
+    stream_keys(nullptr, pace, targets, failed, moved);
+    
+    // An owner whose batch failed gets all of its keys again, read afresh.
+    // It is told HANDOFF-DONE only once they are all through; if they never
+    // are, its handoff_timeout ends the fallback instead, and until then it
+    // still finds the copies kept here.
+    for (int retry = 1; retry <= HANDOFF_RETRIES && !failed.empty(); ++retry) {
+        if (!wait_unless_stopping(std::chrono::milliseconds(RETRY_BACKOFF_MS * retry))) break;
+        std::unordered_set<std::string> retrying = std::move(failed);
+        failed.clear();
+        LOG_INFO("Migration", self_id_ << " resending handoff to " << retrying.size() << " nodes");
+        stream_keys(&retrying, pace, targets, failed, moved);
+    }
+    
+    for (const auto& target : targets) {
+        if (failed.count(target) || !peers_.has_peer(target)) continue;
+        peers_.forward(target, {"HANDOFF-DONE", self_id_}, [](bool, std::string) {});
+    }
+    // The new owners have everything now; keep copies only where a batch
+    // did not make it, so the fallback can still find them
+    size_t dropped = 0;
+    for (const auto& key : moved) {
+        const std::string& owner = ring_.get_node(key);
+        if (owner != self_id_ && !failed.count(owner)) {
+            // Logged, or a restart would replay the key back onto this node
+            cache_.del(key, [&] { wal_.append("DEL", key); });
+            dropped++;
+        }
+    }
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - pace.started);
+    LOG_INFO("Migration", self_id_ << " handed off " << (keys_sent_ - sent_before) << " keys to "
+                          << targets.size() << " nodes in " << elapsed.count() << "ms ("
+                          << dropped << " dropped locally, " << failed.size() << " nodes failed)");
+}
+
+void MigrationManager::stream_keys(const std::unordered_set<std::string>* only, Pace& pace,
+                                   std::unordered_set<std::string>& targets,
+                                   std::unordered_set<std::string>& failed,
+                                   std::unordered_set<std::string>& moved) {
+    std::map<std::string, std::vector<std::string>> batches;
+    std::map<std::string, size_t> batch_bytes;
+    
+    // One shard copy at a time keeps the extra memory to a shard's worth
+    for (size_t i = 0; i < cache_.shard_count(); ++i) {
+        for (auto& entry : cache_.snapshot_shard_versioned(i)) {
+            const std::string& owner = ring_.get_node(entry.key);
+            if (owner == self_id_ || !peers_.has_peer(owner)) continue;
+            if (only && !only->count(owner)) continue;
+            
+            auto& argv = batches[owner];
+            if (argv.empty()) argv.push_back("MIGRATE");
+            batch_bytes[owner] += entry.key.size() + entry.value.size();
+            argv.push_back(entry.key);
+            argv.push_back(std::move(entry.value));
+            argv.push_back(std::to_string(entry.version));
+            argv.push_back(std::to_string(entry.ttl_seconds));
+            targets.insert(owner);
+            moved.insert(entry.key);
+            
+            if ((argv.size() - 1) / 4 >= config_.batch_keys) {
+                if (!send_batch(owner, argv, batch_bytes[owner], pace)) failed.insert(owner);
+                batch_bytes[owner] = 0;
+            }
+        }
+    }
+    for (auto& [owner, argv] : batches) {
+        if (argv.size() > 1 && !send_batch(owner, argv, batch_bytes[owner], pace)) failed.insert(owner);
+    }
+}
+
+bool MigrationManager::wait_unless_stopping(std::chrono::milliseconds delay) {
+    std::unique_lock<std::mutex> lock(jobs_mutex_);
+    return !jobs_cv_.wait_for(lock, delay, [this]() { return stopping_; });
+}
+
+bool MigrationManager::send_batch(const std::string& owner, std::vector<std::string>& argv, size_t bytes,
+                                  Pace& pace) {
+    // Pace against everything this scan has sent: never ahead of
+    // max_bytes_per_sec
+    pace.bytes += bytes;
+    bytes_sent_ += bytes;
+    auto due = pace.started + std::chrono::microseconds(
+        static_cast<int64_t>(pace.bytes * 1e6 / std::max<size_t>(1, config_.max_bytes_per_sec)));
+    while (std::chrono::steady_clock::now() < due) {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            if (stopping_) break;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            due - std::chrono::steady_clock::now(), std::chrono::milliseconds(50)));
+    }
+    
+    size_t count = (argv.size() - 1) / 4;
+    std::string reply;
+    for (int attempt = 0; attempt <= BUSY_RETRIES; ++attempt) {
+        // The owner sheds migration first when busy: back off and resend
+        if (attempt > 0) std::this_thread::sleep_for(std::chrono::milliseconds(100 * attempt));
+        auto future = peers_.forward(owner, argv);
+        reply = future.wait_for(std::chrono::milliseconds(BATCH_TIMEOUT_MS)) == std::future_status::ready
+            ? future.get() : "-ERR timeout\r\n";
+        if (reply.rfind("-BUSY", 0) != 0) break;
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        if (stopping_) break;
+    }
+    argv.clear();
+    if (reply.empty() || reply[0] != ':') {
+        LOG_WARN("Migration", "Handoff batch to " << owner << " failed: " << RESPParser::trim(reply));
+        return false;
+    }
+    keys_sent_ += count;
+    return true;
+}
+
+void MigrationManager::join() {
+    auto members = ring_.get_all_nodes();
+    auto previous = std::make_unique<HashRing>(ring_.strategy());
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.handoff_timeout_ms);
+    
+    std::unique_lock<std::shared_mutex> lock(handoff_mutex_);
+    pending_.clear();
+    touched_.clear();
+    for (const auto& member : members) {
+        if (member == self_id_) continue;
+        previous->add_node(member);
+        pending_[member] = deadline;
+    }
+    previous_ = std::move(previous);
+    pending_count_ = pending_.size();
+    LOG_INFO("Migration", self_id_ << " joining, expecting handoffs from " << pending_.size() << " nodes");
+}
+
+size_t MigrationManager::receive(const std::vector<LRUCache::VersionedEntry>& entries) {
+    size_t stored = 0;
+    std::shared_lock<std::shared_mutex> lock(handoff_mutex_);
+    for (const auto& entry : entries) {
+        // Anything written or deleted here since ownership moved is newer
+        if (touched_.count(entry.key)) continue;
+        bool applied = cache_.set_versioned(entry.key, entry.value, entry.version, entry.ttl_seconds, [&] {
+            wal_.append_set(entry.key, entry.value, entry.ttl_seconds, entry.version);
+        });
+        if (applied) stored++;
+    }
+    return stored;
+}
+
+void MigrationManager::handoff_done(const std::string& source) {
+    std::unique_lock<std::shared_mutex> lock(handoff_mutex_);
+    if (!pending_.erase(source)) return;
+    pending_count_ = pending_.size();
+    LOG_INFO("Migration", self_id_ << " received handoff from " << source << " ("
+                          << pending_.size() << " pending)");
+    if (pending_.empty()) {
+        touched_.clear();
+        previous_.reset();
+    }
+}
+
+size_t MigrationManager::pending_handoffs() const {
+    std::shared_lock<std::shared_mutex> lock(handoff_mutex_);
+    return pending_.size();
+}
+
+bool MigrationManager::fallback_source(const std::string& key, std::string& source) {
+    if (pending_count_ == 0) return false;
+    expire_handoffs();
+    
+    std::shared_lock<std::shared_mutex> lock(handoff_mutex_);
+    if (!previous_ || touched_.count(key)) return false;
+    const std::string& owner = previous_->get_node(key);
+    if (!pending_.count(owner)) return false;
+    source = owner;
+    return true;
+}
+
+void MigrationManager::note_write(const std::string& key) {
+    if (pending_count_ == 0) return;
+    std::unique_lock<std::shared_mutex> lock(handoff_mutex_);
+    if (!pending_.empty()) touched_.insert(key);
+}
+
+void MigrationManager::expire_handoffs() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::string> expired;
+    {
+        std::shared_lock<std::shared_mutex> lock(handoff_mutex_);
+        for (const auto& [source, deadline] : pending_) {
+            if (now > deadline) expired.push_back(source);
+        }
+    }
+    for (const auto& source : expired) {
+        LOG_WARN("Migration", "Handoff from " << source << " timed out");
+        handoff_done(source);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "storage/LRUCache.h"
+#include "storage/WAL.h"
+#include "cluster/HashRing.h"
+#include "network/PeerPool.h"
+
+// Moves data along with ownership when the ring changes. Membership changes
+// go through add_node/remove_node so the previous placement is known; a
+// background thread then scans the local shards and streams every key that
+// now belongs elsewhere to its new owner (MIGRATE batches of key, value,
+// version and remaining TTL, rate limited), tells it HANDOFF-DONE, and only
+// then drops its own copies. An owner a batch failed for is retried a few
+// times and is not told HANDOFF-DONE until all of its keys got through.
+//
+// A joining node calls join(): until every old owner has finished its
+// handoff (or handoff_timeout passes) a local miss is fetched from the key's
+// previous owner, so scale-out does not turn moved keys into misses. Keys
+// written or deleted here meanwhile are never overwritten by streamed
+// copies.
+class MigrationManager {
+public:
+    struct Config {
+        size_t max_bytes_per_sec = 8 << 20;
+        size_t batch_keys = 256;
+        int handoff_timeout_ms = 60000;
+    };
+    
+    MigrationManager(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers);
+    MigrationManager(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers,
+                     const Config& config);
+    ~MigrationManager();
+    
+    // Sending side
+    void add_node(const std::string& node_id, uint32_t weight = 1);
+    void remove_node(const std::string& node_id);
+    bool migrating() const { return active_jobs_ > 0; }
+    size_t keys_sent() const { return keys_sent_; }
+    size_t bytes_sent() const { return bytes_sent_; }
+    
+    // Receiving side
+    void join();
+    // Streamed entries keep their version and remaining TTL
+    size_t receive(const std::vector<LRUCache::VersionedEntry>& entries);
+    void handoff_done(const std::string& source);
+    size_t pending_handoffs() const;
+    // Old owner to ask after a local miss on key, if one is still handing off
+    bool fallback_source(const std::string& key, std::string& source);
+    // Local writes and deletes during a handoff win over streamed copies
+    void note_write(const std::string& key);
+    
+private:
+    std::string self_id_;
+    LRUCache& cache_;
+    WAL& wal_;
+    HashRing& ring_;
+    PeerPool& peers_;
+    Config config_;
+    
+    // Jobs: one scan per membership change, run in order
+    std::thread worker_;
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<std::vector<std::string>> jobs_;
+    std::atomic<int> active_jobs_{0};
+    bool stopping_ = false;
+    std::atomic<size_t> keys_sent_{0};
+    std::atomic<size_t> bytes_sent_{0};
+    
+    // Incoming handoffs: placement before the join and who still owes keys
+    mutable std::shared_mutex handoff_mutex_;
+    std::unique_ptr<HashRing> previous_;
+    std::map<std::string, std::chrono::steady_clock::time_point> pending_;  // source -> deadline
+    std::unordered_set<std::string> touched_;
+    std::atomic<size_t> pending_count_{0};
+    
+    static constexpr int BATCH_TIMEOUT_MS = 10000;
+    static constexpr int BUSY_RETRIES = 10;
+    static constexpr int HANDOFF_RETRIES = 3;
+    static constexpr int RETRY_BACKOFF_MS = 1000;
+    
+    void worker_loop();
+    void migrate(const std::vector<std::string>& added);
+    struct Pace {
+        std::chrono::steady_clock::time_point started;
+        size_t bytes = 0;
+    };
+    // Streams every local key owned elsewhere (only by the given owners if
+    // set); owners a batch failed for are added to failed
+    void stream_keys(const std::unordered_set<std::string>* only, Pace& pace,
+                     std::unordered_set<std::string>& targets, std::unordered_set<std::string>& failed,
+                     std::unordered_set<std::string>& moved);
+    // False if the manager is stopping
+    bool wait_unless_stopping(std::chrono::milliseconds delay);
+    bool send_batch(const std::string& owner, std::vector<std::string>& argv, size_t bytes, Pace& pace);
+    void expire_handoffs();
+};
@@ -1,98 +1,483 @@
 #include "NodeDiscovery.h"
+#include "monitoring/Logger.h"
+#include "network/RESPParser.h"
+#include "network/Socket.h"
+#include <sys/socket.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
 #include <algorithm>
-#include <random>
+#include <cmath>
+#include <cstring>
+#include <sstream>
 
 NodeDiscovery::NodeDiscovery(const std::string& node_id, int port)
-    : node_id_(node_id), address_("localhost"), port_(port) {
-    
-    NodeInfo self_info;
-    self_info.node_id = node_id_;
-    self_info.address = address_;
-    self_info.port = port_;
-    self_info.last_heartbeat = std::chrono::steady_clock::now();
-    self_info.is_alive = true;
-    
-    known_nodes_[node_id_] = self_info;
-}
-
-void NodeDiscovery::broadcast_heartbeat() {
+    : NodeDiscovery(node_id, port, Config{}) {}
+
+NodeDiscovery::NodeDiscovery(const std::string& node_id, int port, const Config& config)
+    : node_id_(node_id), port_(port), config_(config) {}
+
+NodeDiscovery::~NodeDiscovery() {
+    stop_discovery();
+}
+
+void NodeDiscovery::start_discovery() {
+    if (running_) return;
+    fd_ = Socket::bind_udp(port_);
+    port_ = Socket::local_port(fd_);
+    running_ = true;
+    LOG_INFO("Discovery", "Starting discovery for " << node_id_ << " on UDP port " << port_);
+
+    receiver_ = std::thread([this]() { receive_loop(); });
+    prober_ = std::thread([this]() { probe_loop(); });
+}
+
+void NodeDiscovery::stop_discovery() {
+    if (!running_.exchange(false)) return;
+    LOG_INFO("Discovery", "Stopping discovery for " << node_id_);
+    ack_cv_.notify_all();
+    if (prober_.joinable()) prober_.join();
+    if (receiver_.joinable()) receiver_.join();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void NodeDiscovery::add_seed_node(const std::string& node_id, const std::string& address, int port) {
+    if (node_id == node_id_) return;
     std::lock_guard<std::mutex> lock(nodes_mutex_);
-    
-    auto now = std::chrono::steady_clock::now();
-    known_nodes_[node_id_].last_heartbeat = now;
-    
-    std::cout << "[Discovery] " << node_id_ << " broadcasting heartbeat to " 
-              << (known_nodes_.size() - 1) << " peers\n";
-    
-    simulate_heartbeat_exchange();
-    cleanup_dead_nodes();
+
+    Member& member = known_nodes_[node_id];
+    member.info.node_id = node_id;
+    member.info.address = address;
+    member.info.port = port;
+    member.info.last_heartbeat = std::chrono::steady_clock::now();
+    member.info.is_alive = true;
+    member.resolved = resolve(address, port, member.endpoint);
+
+    LOG_INFO("Discovery", "Added seed node: " << node_id
+                          << " at " << address << ":" << port);
 }
 
-void NodeDiscovery::listen_for_heartbeats() {
-    std::cout << "[Discovery] " << node_id_ << " listening for heartbeats\n";
-    simulate_heartbeat_exchange();
+// ---------------------------------------------------------------------------
+// Protocol loops
+
+void NodeDiscovery::probe_loop() {
+    while (running_) {
+        auto period_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.probe_interval_ms);
+
+        std::string target;
+        std::vector<NodeInfo> events;
+        {
+            std::lock_guard<std::mutex> lock(nodes_mutex_);
+            expire_suspects(events);
+
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = relays_.begin(); it != relays_.end();) {
+                it = now - it->second.created > std::chrono::milliseconds(RELAY_TTL_MS) ? relays_.erase(it) : std::next(it);
+            }
+            target = next_probe_target();
+        }
+        notify(events);
+
+        if (!target.empty()) probe(target);
+
+        while (running_ && std::chrono::steady_clock::now() < period_end) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
 }
 
-void NodeDiscovery::simulate_heartbeat_exchange() {
-    auto now = std::chrono::steady_clock::now();
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-    
-    for (auto& [node_id, node_info] : known_nodes_) {
-        if (node_id == node_id_) continue;
-        
-        if (dis(gen) < 0.95) {
-            node_info.last_heartbeat = now;
-            node_info.is_alive = true;
+void NodeDiscovery::probe(const std::string& target) {
+    uint64_t seq = next_seq_++;
+    {
+        std::lock_guard<std::mutex> lock(ack_mutex_);
+        pending_acks_[seq] = false;
+    }
+    probes_sent_++;
+    send(target, "PING " + std::to_string(seq) + " " + node_id_);
+
+    bool acked = wait_for_ack(seq, config_.probe_timeout_ms);
+    if (!acked) {
+        // Indirect probes through k random members, to tell a dead member
+        // from a lossy path between us and it
+        std::vector<std::string> helpers;
+        {
+            std::lock_guard<std::mutex> lock(nodes_mutex_);
+            for (const auto& [id, member] : known_nodes_) {
+                if (id != target && member.info.state == State::ALIVE) helpers.push_back(id);
+            }
+            std::shuffle(helpers.begin(), helpers.end(), rng_);
+        }
+        if (helpers.size() > config_.indirect_probes) helpers.resize(config_.indirect_probes);
+        for (const auto& helper : helpers) {
+            send(helper, "PINGREQ " + std::to_string(seq) + " " + node_id_ + " " + target);
+        }
+        acked = wait_for_ack(seq, std::max(0, config_.probe_interval_ms - config_.probe_timeout_ms));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ack_mutex_);
+        pending_acks_.erase(seq);
+    }
+    if (acked) return;
+
+    std::vector<NodeInfo> events;
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        auto it = known_nodes_.find(target);
+        if (it != known_nodes_.end() && it->second.info.state == State::ALIVE) {
+            set_state(it->second, State::SUSPECT, it->second.info.incarnation, events);
+            enqueue_gossip(update_for(it->second));
+        }
+    }
+    notify(events);
+}
+
+bool NodeDiscovery::wait_for_ack(uint64_t seq, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(ack_mutex_);
+    return ack_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, seq]() {
+        return !running_ || pending_acks_[seq];
+    }) && running_;
+}
+
+void NodeDiscovery::receive_loop() {
+    std::vector<char> buffer(64 * 1024);
+    while (running_) {
+        pollfd pfd{fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, 100) <= 0) continue;
+
+        ssize_t n = ::recv(fd_, buffer.data(), buffer.size(), 0);
+        if (n <= 0) continue;
+
+        std::vector<NodeInfo> events;
+        handle_message(std::string(buffer.data(), static_cast<size_t>(n)), events);
+        notify(events);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Messages: a header line "TYPE seq from [target]", then one membership
+// update per line, the sender's own record first
+
+void NodeDiscovery::handle_message(const std::string& datagram, std::vector<NodeInfo>& events) {
+    std::istringstream lines(datagram);
+    std::string header;
+    if (!std::getline(lines, header)) return;
+    auto fields = RESPParser::split(header);
+    if (fields.size() < 3) return;
+
+    uint64_t seq = 0;
+    try {
+        seq = std::stoull(fields[1]);
+    } catch (const std::exception&) {
+        return;
+    }
+    const std::string& type = fields[0];
+    const std::string& from = fields[2];
+
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        std::string line;
+        Update update;
+        while (std::getline(lines, line)) {
+            if (decode(line, update)) apply_update(update, events);
+        }
+        auto it = known_nodes_.find(from);
+        if (it != known_nodes_.end()) {
+            it->second.info.last_heartbeat = std::chrono::steady_clock::now();
+            // A sender we suspect or buried may not have heard; our reply
+            // carries the news so it can refute
+            if (it->second.info.state != State::ALIVE) enqueue_gossip(update_for(it->second));
+        }
+    }
+
+    if (type == "PING") {
+        send(from, "ACK " + fields[1] + " " + node_id_);
+    } else if (type == "PINGREQ" && fields.size() == 4) {
+        uint64_t relay_seq = next_seq_++;
+        {
+            std::lock_guard<std::mutex> lock(nodes_mutex_);
+            relays_[relay_seq] = Relay{from, seq, std::chrono::steady_clock::now()};
+        }
+        send(fields[3], "PING " + std::to_string(relay_seq) + " " + node_id_);
+    } else if (type == "ACK") {
+        {
+            std::lock_guard<std::mutex> lock(ack_mutex_);
+            auto pending = pending_acks_.find(seq);
+            if (pending != pending_acks_.end()) {
+                pending->second = true;
+                ack_cv_.notify_all();
+                return;
+            }
+        }
+        // An ACK for a probe made on someone else's behalf goes back to them
+        Relay relay;
+        {
+            std::lock_guard<std::mutex> lock(nodes_mutex_);
+            auto it = relays_.find(seq);
+            if (it == relays_.end()) return;
+            relay = it->second;
+            relays_.erase(it);
+        }
+        send(relay.origin, "ACK " + std::to_string(relay.origin_seq) + " " + node_id_);
+    }
+}
+
+void NodeDiscovery::send(const std::string& node_id, const std::string& header) {
+    sockaddr_in endpoint{};
+    std::string message;
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        auto it = known_nodes_.find(node_id);
+        if (it == known_nodes_.end() || !it->second.resolved) return;
+        endpoint = it->second.endpoint;
+        message = build_message(header);
+    }
+    ::sendto(fd_, message.data(), message.size(), 0, reinterpret_cast<sockaddr*>(&endpoint), sizeof(endpoint));
+}
+
+std::string NodeDiscovery::build_message(const std::string& header) {
+    Update self{node_id_, address_, port_, State::ALIVE, incarnation_, service_address_};
+    std::string message = header + "\n" + encode(self) + "\n";
+
+    // Least-sent updates first; each is dropped after enough retransmits
+    // for it to have reached everyone with high probability
+    std::sort(gossip_.begin(), gossip_.end(),
+              [](const Gossip& a, const Gossip& b) { return a.transmits < b.transmits; });
+    size_t limit = scaled(config_.retransmit_mult);
+    size_t sent = 0;
+    for (auto& gossip : gossip_) {
+        if (sent == config_.max_piggyback) break;
+        std::string line = encode(gossip.update) + "\n";
+        if (message.size() + line.size() > MAX_DATAGRAM) break;
+        message += line;
+        gossip.transmits++;
+        sent++;
+    }
+    gossip_.erase(std::remove_if(gossip_.begin(), gossip_.end(),
+                                 [limit](const Gossip& g) { return static_cast<size_t>(g.transmits) >= limit; }),
+                  gossip_.end());
+    return message;
+}
+
+// ---------------------------------------------------------------------------
+// Membership state
+
+void NodeDiscovery::apply_update(const Update& update, std::vector<NodeInfo>& events) {
+    if (update.node_id == node_id_) {
+        // Someone suspects us or thinks we are dead: refute by outliving
+        // their incarnation. Our own record goes out with every message.
+        if (update.state != State::ALIVE && update.incarnation >= incarnation_) {
+            incarnation_ = update.incarnation + 1;
+            LOG_INFO("Discovery", node_id_ << " refuting " << state_name(update.state)
+                                  << " (incarnation " << incarnation_ << ")");
+        }
+        return;
+    }
+
+    auto it = known_nodes_.find(update.node_id);
+    bool known = it != known_nodes_.end();
+    if (known && it->second.heard) {
+        const NodeInfo& current = it->second.info;
+        // ALIVE needs a newer incarnation to override anything; SUSPECT
+        // overrides ALIVE at the same incarnation; DEAD overrides both
+        bool newer = update.incarnation > current.incarnation;
+        bool same = update.incarnation == current.incarnation;
+        bool overrides = false;
+        switch (update.state) {
+            case State::ALIVE:
+                overrides = newer;
+                break;
+            case State::SUSPECT:
+                overrides = current.state != State::DEAD && (newer || (same && current.state == State::ALIVE));
+                break;
+            case State::DEAD:
+                overrides = current.state != State::DEAD && (newer || same);
+                break;
+        }
+        if (!overrides) return;
+    }
+
+    Member& member = known_nodes_[update.node_id];
+    member.heard = true;
+    if (!known) {
+        member.info.node_id = update.node_id;
+        member.info.last_heartbeat = std::chrono::steady_clock::now();
+        member.info.state = State::DEAD;  // So the first state change reports the join
+    }
+    if (member.info.address != update.address || member.info.port != update.port) {
+        member.info.address = update.address;
+        member.info.port = update.port;
+        member.resolved = resolve(update.address, update.port, member.endpoint);
+    }
+    member.info.service_address = update.service_address;
+
+    if (!known && update.state == State::DEAD) {
+        member.info.incarnation = update.incarnation;
+        member.info.is_alive = false;
+    } else {
+        set_state(member, update.state, update.incarnation, events);
+    }
+    enqueue_gossip(update);
+}
+
+void NodeDiscovery::set_state(Member& member, State state, uint64_t incarnation, std::vector<NodeInfo>& events) {
+    State previous = member.info.state;
+    member.info.incarnation = incarnation;
+    member.info.state = state;
+    member.info.is_alive = state != State::DEAD;
+    if (state == State::SUSPECT && previous != State::SUSPECT) {
+        member.suspect_since = std::chrono::steady_clock::now();
+    }
+    if (state != previous) {
+        LOG_INFO("Discovery", node_id_ << " sees " << member.info.node_id << " "
+                              << state_name(state) << " (incarnation " << incarnation << ")");
+        events.push_back(member.info);
+    }
+}
+
+void NodeDiscovery::enqueue_gossip(const Update& update) {
+    for (auto& gossip : gossip_) {
+        if (gossip.update.node_id == update.node_id) {
+            gossip = Gossip{update, 0};
+            return;
         }
     }
+    gossip_.push_back(Gossip{update, 0});
 }
 
-void NodeDiscovery::cleanup_dead_nodes() {
+void NodeDiscovery::expire_suspects(std::vector<NodeInfo>& events) {
+    auto timeout = std::chrono::milliseconds(config_.probe_interval_ms * scaled(config_.suspicion_mult));
     auto now = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::milliseconds(NODE_TIMEOUT_MS);
-    
-    for (auto& [node_id, node_info] : known_nodes_) {
-        if (node_id != node_id_ && 
-            (now - node_info.last_heartbeat) > timeout) {
-            node_info.is_alive = false;
+    for (auto& [id, member] : known_nodes_) {
+        if (member.info.state == State::SUSPECT && now - member.suspect_since > timeout) {
+            set_state(member, State::DEAD, member.info.incarnation, events);
+            enqueue_gossip(update_for(member));
         }
     }
 }
 
+std::string NodeDiscovery::next_probe_target() {
+    // Randomised round robin: every live member is probed once per pass, in
+    // a fresh random order each pass
+    while (true) {
+        if (probe_index_ >= probe_order_.size()) {
+            probe_order_.clear();
+            for (const auto& [id, member] : known_nodes_) {
+                if (member.info.state != State::DEAD) probe_order_.push_back(id);
+            }
+            if (probe_order_.empty()) return "";
+            std::shuffle(probe_order_.begin(), probe_order_.end(), rng_);
+            probe_index_ = 0;
+        }
+        const std::string& id = probe_order_[probe_index_++];
+        auto it = known_nodes_.find(id);
+        if (it != known_nodes_.end() && it->second.info.state != State::DEAD) return id;
+    }
+}
+
+NodeDiscovery::Update NodeDiscovery::update_for(const Member& member) const {
+    return Update{member.info.node_id, member.info.address, member.info.port,
+                  member.info.state, member.info.incarnation, member.info.service_address};
+}
+
+size_t NodeDiscovery::scaled(int mult) const {
+    size_t members = known_nodes_.size() + 1;
+    return static_cast<size_t>(mult) * std::max<size_t>(1, static_cast<size_t>(std::ceil(std::log2(members + 1))));
+}
+
+void NodeDiscovery::notify(const std::vector<NodeInfo>& events) {
+    if (!listener_) return;
+    for (const auto& event : events) listener_(event);
+}
+
+// ---------------------------------------------------------------------------
+// Queries
+
 std::vector<NodeDiscovery::NodeInfo> NodeDiscovery::get_alive_nodes() const {
     std::lock_guard<std::mutex> lock(nodes_mutex_);
-    
-    std::vector<NodeInfo> alive_nodes;
-    for (const auto& [node_id, node_info] : known_nodes_) {
-        if (node_info.is_alive) {
-            alive_nodes.push_back(node_info);
+
+    NodeInfo self{node_id_, address_, port_, std::chrono::steady_clock::now(), true,
+                  State::ALIVE, incarnation_, service_address_};
+    std::vector<NodeInfo> alive_nodes{self};
+    for (const auto& [node_id, member] : known_nodes_) {
+        if (member.info.is_alive) {
+            alive_nodes.push_back(member.info);
         }
     }
-    
+
     return alive_nodes;
 }
 
 bool NodeDiscovery::is_node_alive(const std::string& node_id) const {
+    if (node_id == node_id_) return true;
     std::lock_guard<std::mutex> lock(nodes_mutex_);
-    
+
     auto it = known_nodes_.find(node_id);
-    return it != known_nodes_.end() && it->second.is_alive;
+    return it != known_nodes_.end() && it->second.info.is_alive;
 }
 
-void NodeDiscovery::add_seed_node(const std::string& node_id, const std::string& address, int port) {
+NodeDiscovery::State NodeDiscovery::state_of(const std::string& node_id) const {
+    if (node_id == node_id_) return State::ALIVE;
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    auto it = known_nodes_.find(node_id);
+    return it != known_nodes_.end() ? it->second.info.state : State::DEAD;
+}
+
+uint64_t NodeDiscovery::incarnation() const {
     std::lock_guard<std::mutex> lock(nodes_mutex_);
-    
-    NodeInfo node_info;
-    node_info.node_id = node_id;
-    node_info.address = address;
-    node_info.port = port;
-    node_info.last_heartbeat = std::chrono::steady_clock::now();
-    node_info.is_alive = true;
-    
-    known_nodes_[node_id] = node_info;
-    
-    std::cout << "[Discovery] Added seed node: " << node_id 
-              << " at " << address << ":" << port << "\n";
-}
\ No newline at end of file
+    return incarnation_;
+}
+
+const char* NodeDiscovery::state_name(State state) {
+    switch (state) {
+        case State::ALIVE: return "alive";
+        case State::SUSPECT: return "suspect";
+        case State::DEAD: return "dead";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// Encoding: "id host port A|S|D incarnation service" with "-" for no service
+
+std::string NodeDiscovery::encode(const Update& update) {
+    const char* state = update.state == State::ALIVE ? "A" : update.state == State::SUSPECT ? "S" : "D";
+    return update.node_id + " " + update.address + " " + std::to_string(update.port) + " " + state + " " +
+           std::to_string(update.incarnation) + " " +
+           (update.service_address.empty() ? "-" : update.service_address);
+}
+
+bool NodeDiscovery::decode(const std::string& line, Update& update) {
+    auto fields = RESPParser::split(line);
+    if (fields.size() != 6 || fields[3].size() != 1) return false;
+    try {
+        update.node_id = fields[0];
+        update.address = fields[1];
+        update.port = std::stoi(fields[2]);
+        switch (fields[3][0]) {
+            case 'A': update.state = State::ALIVE; break;
+            case 'S': update.state = State::SUSPECT; break;
+            case 'D': update.state = State::DEAD; break;
+            default: return false;
+        }
+        update.incarnation = std::stoull(fields[4]);
+        update.service_address = fields[5] == "-" ? "" : fields[5];
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool NodeDiscovery::resolve(const std::string& host, int port, sockaddr_in& endpoint) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        return false;
+    }
+    std::memcpy(&endpoint, result->ai_addr, sizeof(endpoint));
+    ::freeaddrinfo(result);
+    return true;
+}
@@ -6,43 +6,157 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <functional>
+#include <random>
+#include <cstdint>
+#include <netinet/in.h>
 
+// SWIM failure detection and membership over UDP (Das et al.). Every
+// protocol period each node probes one member, round-robin in a shuffled
+// order, so probe load per node is constant however large the cluster is:
+//
+//   PING -> ACK within probe_timeout, else PINGREQ to k other members who
+//   probe on our behalf and relay the ACK; no ACK by the end of the period
+//   marks the member SUSPECT, and a suspect that does not refute within the
+//   suspicion timeout is declared DEAD.
+//
+// A member refutes suspicion by gossiping itself ALIVE with a higher
+// incarnation. Membership changes ride on every PING/ACK (piggybacking)
+// rather than being broadcast.
 class NodeDiscovery {
 public:
+    enum class State { ALIVE, SUSPECT, DEAD };
+
     struct NodeInfo {
         std::string node_id;
-        std::string address;
-        int port;
-        std::chrono::steady_clock::time_point last_heartbeat;
-        bool is_alive;
+        std::string address;        // Gossip host
+        int port;                   // Gossip UDP port
+        std::chrono::steady_clock::time_point last_heartbeat;  // Last message from it
+        bool is_alive;              // ALIVE or SUSPECT
+        State state = State::ALIVE;
+        uint64_t incarnation = 0;
+        std::string service_address;  // host:port of its cache server, if announced
+    };
+
+    struct Config {
+        int probe_interval_ms = 1000;
+        int probe_timeout_ms = 400;
+        size_t indirect_probes = 3;
+        // Suspicion lasts suspicion_mult * log2(members + 1) probe periods
+        int suspicion_mult = 2;
+        // Each update is piggybacked retransmit_mult * log2(members + 1) times
+        int retransmit_mult = 3;
+        size_t max_piggyback = 8;
     };
-    
-    explicit NodeDiscovery(const std::string& node_id = "localhost", int port = 6379);
-    
-    void broadcast_heartbeat();
-    void listen_for_heartbeats();
-    void start_discovery() { 
-        std::cout << "[Discovery] Starting discovery for " << node_id_ << "\n";
-    }
-    void stop_discovery() { 
-        std::cout << "[Discovery] Stopping discovery for " << node_id_ << "\n";
-    }
-    
+
+    // Called on every state change of another member, outside any lock
+    using Listener = std::function<void(const NodeInfo& node)>;
+
+    // port is the UDP gossip port; 0 picks a free one when started
+    explicit NodeDiscovery(const std::string& node_id = "localhost", int port = 7946);
+    NodeDiscovery(const std::string& node_id, int port, const Config& config);
+    ~NodeDiscovery();
+
+    // Host other members use to reach this node, and the cache address it
+    // announces to them; set before start_discovery()
+    void set_advertise_address(const std::string& host) { address_ = host; }
+    void set_service_address(const std::string& address) { service_address_ = address; }
+    void set_listener(Listener listener) { listener_ = std::move(listener); }
+
+    void start_discovery();
+    void stop_discovery();
+    int port() const { return port_; }
+
     std::vector<NodeInfo> get_alive_nodes() const;
     bool is_node_alive(const std::string& node_id) const;
+    State state_of(const std::string& node_id) const;
+    uint64_t incarnation() const;
+    uint64_t probes_sent() const { return probes_sent_; }
     void add_seed_node(const std::string& node_id, const std::string& address, int port);
-    
+
+    static const char* state_name(State state);
+
 private:
+    struct Member {
+        NodeInfo info;
+        sockaddr_in endpoint{};
+        bool resolved = false;
+        bool heard = false;  // False for a seed until its first record arrives
+        std::chrono::steady_clock::time_point suspect_since;
+    };
+
+    struct Update {
+        std::string node_id;
+        std::string address;
+        int port = 0;
+        State state = State::ALIVE;
+        uint64_t incarnation = 0;
+        std::string service_address;
+    };
+
+    struct Gossip {
+        Update update;
+        int transmits = 0;
+    };
+
+    struct Relay {
+        std::string origin;
+        uint64_t origin_seq;
+        std::chrono::steady_clock::time_point created;
+    };
+
     std::string node_id_;
-    std::string address_;
+    std::string address_ = "127.0.0.1";
+    std::string service_address_;
     int port_;
-    
-    std::map<std::string, NodeInfo> known_nodes_;
+    Config config_;
+    Listener listener_;
+
+    std::map<std::string, Member> known_nodes_;
     mutable std::mutex nodes_mutex_;
-    
-    void cleanup_dead_nodes();
-    void simulate_heartbeat_exchange();
-    static constexpr int HEARTBEAT_INTERVAL_MS = 5000;
-    static constexpr int NODE_TIMEOUT_MS = 15000;
-};
\ No newline at end of file
+    uint64_t incarnation_ = 0;
+    std::vector<Gossip> gossip_;
+    std::map<uint64_t, Relay> relays_;
+    std::vector<std::string> probe_order_;
+    size_t probe_index_ = 0;
+    std::mt19937 rng_{std::random_device{}()};
+
+    // Outstanding probes by sequence number; true once acked
+    std::map<uint64_t, bool> pending_acks_;
+    std::mutex ack_mutex_;
+    std::condition_variable ack_cv_;
+    std::atomic<uint64_t> next_seq_{1};
+    std::atomic<uint64_t> probes_sent_{0};
+
+    int fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread receiver_;
+    std::thread prober_;
+
+    static constexpr size_t MAX_DATAGRAM = 1400;
+    static constexpr int RELAY_TTL_MS = 5000;
+
+    void receive_loop();
+    void probe_loop();
+    void probe(const std::string& target);
+    bool wait_for_ack(uint64_t seq, int timeout_ms);
+    void handle_message(const std::string& datagram, std::vector<NodeInfo>& events);
+    void send(const std::string& node_id, const std::string& header);
+    std::string build_message(const std::string& header);
+
+    // The helpers below expect nodes_mutex_ to be held
+    void apply_update(const Update& update, std::vector<NodeInfo>& events);
+    void set_state(Member& member, State state, uint64_t incarnation, std::vector<NodeInfo>& events);
+    void enqueue_gossip(const Update& update);
+    void expire_suspects(std::vector<NodeInfo>& events);
+    std::string next_probe_target();
+    Update update_for(const Member& member) const;
+    size_t scaled(int mult) const;
+    void notify(const std::vector<NodeInfo>& events);
+
+    static std::string encode(const Update& update);
+    static bool decode(const std::string& line, Update& update);
+    static bool resolve(const std::string& host, int port, sockaddr_in& endpoint);
+};
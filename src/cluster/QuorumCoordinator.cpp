@@ -0,0 +1,258 @@
+#include "QuorumCoordinator.h"
+#include "network/RESPParser.h"
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+struct ReplicaReply {
+    std::string node;
+    bool ok = false;
+    bool found = false;
+    std::string value;
+    uint64_t version = 0;
+    int ttl_seconds = -1;
+};
+
+bool newer(const ReplicaReply& a, const ReplicaReply& b) {
+    if (a.found != b.found) return a.found;
+    return a.version > b.version || (a.version == b.version && a.value > b.value);
+}
+
+}
+
+struct QuorumCoordinator::ReadState {
+    std::mutex mutex;
+    std::string key;
+    size_t needed;
+    size_t total;
+    size_t failures = 0;
+    bool decided = false;
+    std::vector<ReplicaReply> replies;
+    std::promise<ReadResult> promise;
+};
+
+struct QuorumCoordinator::WriteState {
+    std::mutex mutex;
+    size_t needed;
+    size_t total;
+    size_t acks = 0;
+    size_t failures = 0;
+    bool decided = false;
+    uint64_t version;
+    std::string last_error;
+    std::promise<WriteResult> promise;
+};
+
+QuorumCoordinator::QuorumCoordinator(const std::string& self_id, LRUCache& cache, WAL& wal,
+                                     HashRing& ring, PeerPool& peers)
+    : self_id_(self_id), cache_(cache), wal_(wal), ring_(ring), peers_(peers) {}
+
+void QuorumCoordinator::set_default_policy(const Policy& policy) {
+    std::unique_lock<std::shared_mutex> lock(policies_mutex_);
+    default_policy_ = policy;
+}
+
+void QuorumCoordinator::set_policy(const std::string& prefix, const Policy& policy) {
+    std::unique_lock<std::shared_mutex> lock(policies_mutex_);
+    policies_[prefix] = policy;
+}
+
+QuorumCoordinator::Policy QuorumCoordinator::policy_for(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lock(policies_mutex_);
+    // Candidates sort before the key; walk back to the longest that matches
+    auto it = policies_.upper_bound(key);
+    while (it != policies_.begin()) {
+        --it;
+        if (key.compare(0, it->first.size(), it->first) == 0) return it->second;
+    }
+    return default_policy_;
+}
+
+bool QuorumCoordinator::replicated(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lock(policies_mutex_);
+    auto it = policies_.upper_bound(key);
+    while (it != policies_.begin()) {
+        --it;
+        if (key.compare(0, it->first.size(), it->first) == 0) return it->second.n > 1;
+    }
+    return false;
+}
+
+bool QuorumCoordinator::parse_policy(const std::string& text, Policy& policy) {
+    auto parts = RESPParser::split(text, '/');
+    if (parts.size() != 3) return false;
+    try {
+        Policy parsed{std::stoul(parts[0]), std::stoul(parts[1]), std::stoul(parts[2])};
+        if (parsed.r < 1 || parsed.w < 1 || parsed.r > parsed.n || parsed.w > parsed.n) return false;
+        policy = parsed;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool QuorumCoordinator::replicas_for(const std::string& key, const Policy& policy, size_t needed,
+                                     std::vector<std::string>& replicas, std::string& error) const {
+    replicas = ring_.preference_list(key, policy.n);
+    if (replicas.size() < needed) {
+        error = "quorum of " + std::to_string(needed) + " needs more than the " +
+                std::to_string(replicas.size()) + " replicas available";
+        return false;
+    }
+    return true;
+}
+
+std::future<QuorumCoordinator::ReadResult> QuorumCoordinator::read(const std::string& key,
+                                                                   const Policy& policy) {
+    auto state = std::make_shared<ReadState>();
+    auto future = state->promise.get_future();
+    
+    std::vector<std::string> replicas;
+    std::string error;
+    if (!replicas_for(key, policy, policy.r, replicas, error)) {
+        state->promise.set_value(ReadResult{false, false, "", 0, 0, error});
+        return future;
+    }
+    state->key = key;
+    state->needed = policy.r;
+    state->total = replicas.size();
+    
+    auto on_reply = [this, state](ReplicaReply reply) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->replies.push_back(std::move(reply));
+        if (!state->replies.back().ok) state->failures++;
+        
+        size_t answered = state->replies.size() - state->failures;
+        if (!state->decided && answered >= state->needed) {
+            state->decided = true;
+            const ReplicaReply* best = nullptr;
+            for (const auto& r : state->replies) {
+                if (r.ok && (!best || newer(r, *best))) best = &r;
+            }
+            state->promise.set_value(ReadResult{true, best->found, best->value, best->version, answered, ""});
+        } else if (!state->decided && state->failures > state->total - state->needed) {
+            state->decided = true;
+            state->promise.set_value(ReadResult{false, false, "", 0, answered,
+                                                "read quorum not reached (" + std::to_string(answered) +
+                                                " of " + std::to_string(state->needed) + ")"});
+        }
+        
+        bool complete = state->replies.size() == state->total;
+        lock.unlock();
+        if (complete) repair(state);
+    };
+    
+    for (const auto& node : replicas) {
+        if (node == self_id_) {
+            ReplicaReply reply;
+            reply.node = node;
+            reply.ok = true;
+            reply.found = cache_.get_versioned(key, reply.value, reply.version, &reply.ttl_seconds);
+            on_reply(std::move(reply));
+            continue;
+        }
+        peers_.forward(node, {"VGET", key}, [on_reply, node](bool ok, std::string raw) {
+            ReplicaReply reply;
+            reply.node = node;
+            RESPParser::Reply parsed;
+            size_t consumed = 0;
+            try {
+                if (ok && RESPParser::parse_reply(raw, consumed, parsed) && parsed.type != '-') {
+                    reply.ok = true;
+                    if (parsed.type == '*' && parsed.elements.size() >= 2) {
+                        reply.found = true;
+                        reply.value = parsed.elements[0].str;
+                        reply.version = std::stoull(parsed.elements[1].str);
+                        if (parsed.elements.size() > 2) reply.ttl_seconds = std::stoi(parsed.elements[2].str);
+                    }
+                }
+            } catch (const std::exception&) {
+                reply.ok = false;
+            }
+            on_reply(std::move(reply));
+        });
+    }
+    return future;
+}
+
+void QuorumCoordinator::repair(const std::shared_ptr<ReadState>& state) {
+    // Runs once, after the last replica answered; only the answering
+    // replicas are compared
+    const ReplicaReply* best = nullptr;
+    for (const auto& r : state->replies) {
+        if (r.ok && (!best || newer(r, *best))) best = &r;
+    }
+    if (!best || !best->found) return;
+    
+    for (const auto& r : state->replies) {
+        if (!r.ok || !newer(*best, r)) continue;
+        read_repairs_++;
+        if (r.node == self_id_) {
+            store(state->key, best->value, best->version, best->ttl_seconds);
+        } else {
+            peers_.forward(r.node, {"VSET", state->key, best->value, std::to_string(best->version),
+                                    std::to_string(best->ttl_seconds)},
+                           [](bool, std::string) {});
+        }
+    }
+}
+
+std::future<QuorumCoordinator::WriteResult> QuorumCoordinator::write(const std::string& key,
+                                                                     const std::string& value,
+                                                                     const Policy& policy) {
+    auto state = std::make_shared<WriteState>();
+    auto future = state->promise.get_future();
+    
+    std::vector<std::string> replicas;
+    std::string error;
+    if (!replicas_for(key, policy, policy.w, replicas, error)) {
+        state->promise.set_value(WriteResult{false, 0, 0, error});
+        return future;
+    }
+    state->needed = policy.w;
+    state->total = replicas.size();
+    state->version = cache_.next_version();
+    
+    // A replica that kept a newer copy still acks: it holds at least this
+    // write's version
+    auto on_ack = [state](bool ok, const std::string& error) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (ok) {
+            state->acks++;
+        } else {
+            state->failures++;
+            state->last_error = error;
+        }
+        if (state->decided) return;
+        if (state->acks >= state->needed) {
+            state->decided = true;
+            state->promise.set_value(WriteResult{true, state->version, state->acks, ""});
+        } else if (state->failures > state->total - state->needed) {
+            state->decided = true;
+            state->promise.set_value(WriteResult{false, state->version, state->acks,
+                                                 "write quorum not reached: " + state->last_error});
+        }
+    };
+    
+    std::string version = std::to_string(state->version);
+    for (const auto& node : replicas) {
+        if (node == self_id_) {
+            store(key, value, state->version);
+            on_ack(true, "");
+            continue;
+        }
+        peers_.forward(node, {"VSET", key, value, version}, [on_ack](bool ok, std::string raw) {
+            bool acked = ok && !raw.empty() && raw[0] == ':';
+            on_ack(acked, acked ? "" : RESPParser::trim(raw.substr(raw.empty() ? 0 : 1)));
+        });
+    }
+    return future;
+}
+
+bool QuorumCoordinator::store(const std::string& key, const std::string& value, uint64_t version,
+                              int ttl_seconds) {
+    return cache_.set_versioned(key, value, version, ttl_seconds, [&] {
+        wal_.append_set(key, value, ttl_seconds, version);
+    });
+}
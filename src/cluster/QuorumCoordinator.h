@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "storage/LRUCache.h"
+#include "storage/WAL.h"
+#include "cluster/HashRing.h"
+#include "network/PeerPool.h"
+
+// Dynamo-style quorum reads and writes. A key lives on the first N nodes of
+// its ring preference list; a write succeeds once W of them stored it and a
+// read once R answered, newest version winning. Requests go to all N in
+// parallel, and once every replica has answered a read, stale or missing
+// copies are repaired in the background.
+//
+// Replica operations between nodes:
+//   VGET key                      -> [value, version, ttl] or nil
+//   VSET key value version [ttl]  -> :1 stored, :0 a newer copy or delete was kept
+class QuorumCoordinator {
+public:
+    struct Policy {
+        size_t n = 3;
+        size_t r = 2;
+        size_t w = 2;
+    };
+    
+    struct ReadResult {
+        bool ok = false;
+        bool found = false;
+        std::string value;
+        uint64_t version = 0;
+        size_t acks = 0;
+        std::string error;
+    };
+    
+    struct WriteResult {
+        bool ok = false;
+        uint64_t version = 0;
+        size_t acks = 0;
+        std::string error;
+    };
+    
+    QuorumCoordinator(const std::string& self_id, LRUCache& cache, WAL& wal, HashRing& ring, PeerPool& peers);
+    
+    // Per-keyspace settings: the longest matching key prefix wins, then the
+    // default
+    void set_default_policy(const Policy& policy);
+    void set_policy(const std::string& prefix, const Policy& policy);
+    Policy policy_for(const std::string& key) const;
+    // True when the key falls under a keyspace given its own policy with
+    // N > 1. Those are the keyspaces written with QSET, so every node on the
+    // key's preference list has a copy; keys under the default policy are
+    // taken to be written with SET, to the owner alone.
+    bool replicated(const std::string& key) const;
+    // "N/R/W", e.g. "3/2/2"; false if malformed or R/W are outside 1..N
+    static bool parse_policy(const std::string& text, Policy& policy);
+    
+    std::future<ReadResult> read(const std::string& key, const Policy& policy);
+    std::future<WriteResult> write(const std::string& key, const std::string& value, const Policy& policy);
+    
+    // Replica side of VSET: stores if newer and logs it to the WAL
+    bool store(const std::string& key, const std::string& value, uint64_t version, int ttl_seconds = -1);
+    
+    size_t read_repairs() const { return read_repairs_; }
+    
+private:
+    struct ReadState;
+    struct WriteState;
+    
+    std::string self_id_;
+    LRUCache& cache_;
+    WAL& wal_;
+    HashRing& ring_;
+    PeerPool& peers_;
+    
+    Policy default_policy_;
+    std::map<std::string, Policy> policies_;
+    mutable std::shared_mutex policies_mutex_;
+    std::atomic<size_t> read_repairs_{0};
+    
+    bool replicas_for(const std::string& key, const Policy& policy, size_t needed,
+                      std::vector<std::string>& replicas, std::string& error) const;
+    void repair(const std::shared_ptr<ReadState>& state);
+};
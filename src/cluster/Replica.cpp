@@ -0,0 +1,190 @@
+#include "Replica.h"
+#include "monitoring/Logger.h"
+#include "network/RESPParser.h"
+#include "network/Socket.h"
+#include "storage/WAL.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+
+Replica::Replica(LRUCache& cache, const std::string& primary_host, int primary_port,
+                 MetricsCollector* metrics)
+    : cache_(cache), host_(primary_host), port_(primary_port), metrics_(metrics) {}
+
+Replica::~Replica() {
+    stop();
+}
+
+void Replica::start() {
+    if (receiver_.joinable()) return;
+    stopping_ = false;
+    receive_done_ = false;
+    applier_ = std::thread([this]() { apply_loop(); });
+    receiver_ = std::thread([this]() { receive_loop(); });
+}
+
+void Replica::stop() {
+    stopping_ = true;
+    {
+        std::lock_guard<std::mutex> lock(fd_mutex_);
+        if (fd_ >= 0) ::shutdown(fd_, SHUT_RDWR);
+    }
+    queue_cv_.notify_all();
+    if (receiver_.joinable()) receiver_.join();
+    if (applier_.joinable()) applier_.join();
+}
+
+uint64_t Replica::lag() const {
+    uint64_t primary = primary_lsn_, applied = applied_lsn_;
+    return primary > applied ? primary - applied : 0;
+}
+
+std::string Replica::primary_address() const {
+    return host_ + ":" + std::to_string(port_);
+}
+
+void Replica::receive_loop() {
+    while (!stopping_) {
+        int fd = Socket::connect_tcp(host_, port_, CONNECT_TIMEOUT_MS);
+        if (fd >= 0) {
+            {
+                std::lock_guard<std::mutex> lock(fd_mutex_);
+                fd_ = fd;
+            }
+            if (!stopping_) {
+                LOG_INFO("Replica", "Syncing from " << primary_address() << " at LSN " << resume_lsn_);
+                receive(fd);
+            }
+            {
+                std::lock_guard<std::mutex> lock(fd_mutex_);
+                fd_ = -1;
+            }
+            ::close(fd);
+        }
+        if (stopping_) break;
+        
+        LOG_WARN("Replica", "Primary " << primary_address() << " unavailable, retrying");
+        auto retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(RETRY_DELAY_MS);
+        while (!stopping_ && std::chrono::steady_clock::now() < retry_at) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    
+    // Let the apply thread finish what was received, then exit
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    receive_done_ = true;
+    queue_cv_.notify_all();
+}
+
+bool Replica::receive(int fd) {
+    if (!Socket::send_all(fd, RESPParser::serialize_command({"SYNC", std::to_string(resume_lsn_)}))) {
+        return false;
+    }
+    
+    std::string buffer;
+    std::vector<char> chunk(64 * 1024);
+    Message message;
+    uint64_t pending_snapshot = 0;
+    
+    while (!stopping_) {
+        ssize_t n = ::recv(fd, chunk.data(), chunk.size(), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk.data(), static_cast<size_t>(n));
+        
+        // Everything decoded from one read is applied as one batch
+        std::vector<Message> batch;
+        size_t parsed = 0, consumed = 0;
+        try {
+            while (RESPParser::parse_request(std::string_view(buffer).substr(parsed), consumed, message)) {
+                parsed += consumed;
+                if (message.size() < 2) {
+                    if (!message.empty() && message[0] == "SNAPSHOT-END") resume_lsn_ = pending_snapshot;
+                } else if (message[0] == "FULLRESYNC") {
+                    resume_lsn_ = 0;
+                    pending_snapshot = std::stoull(message[1]);
+                    primary_lsn_ = pending_snapshot;
+                } else if (message[0] == "REPL") {
+                    resume_lsn_ = std::stoull(message[1]);
+                } else if (message[0] == "LSN") {
+                    primary_lsn_ = std::stoull(message[1]);
+                    continue;
+                }
+                batch.push_back(std::move(message));
+            }
+        } catch (const std::exception& e) {
+            LOG_WARN("Replica", "Bad replication stream: " << e.what());
+            return false;
+        }
+        buffer.erase(0, parsed);
+        
+        if (!batch.empty()) enqueue(std::move(batch));
+        publish_lag();
+    }
+    return true;
+}
+
+void Replica::enqueue(std::vector<Message> batch) {
+    // A full queue stalls the socket, which backs up into this replica's
+    // stream on the primary and nowhere else. Batches are never dropped:
+    // resume_lsn_ already counts them as received.
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    queue_cv_.wait(lock, [this]() { return queue_.size() < MAX_QUEUED_BATCHES; });
+    queue_.push_back(std::move(batch));
+    queue_cv_.notify_all();
+}
+
+void Replica::apply_loop() {
+    while (true) {
+        std::vector<Message> batch;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this]() { return receive_done_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            batch = std::move(queue_.front());
+            queue_.pop_front();
+            queue_cv_.notify_all();
+        }
+        
+        for (const auto& message : batch) apply(message);
+        publish_lag();
+    }
+}
+
+void Replica::apply(const Message& message) {
+    const std::string& type = message[0];
+    if (type == "SET" && message.size() == 3) {
+        cache_.set(message[1], message[2]);
+    } else if (type == "VSET" && message.size() == 5) {
+        // Snapshot entry with its version and remaining TTL
+        cache_.set_versioned(message[1], message[2], std::stoull(message[3]), std::stoi(message[4]));
+    } else if (type == "REPL" && message.size() >= 4) {
+        const std::string& op = message[2];
+        const std::string& key = message[3];
+        std::string value;
+        uint64_t version = 0;
+        int ttl = -1;
+        if (WAL::decode_set(op, message.size() > 4 ? message[4] : "", value, version, ttl)) {
+            // Expired on the way here: only what it replaced goes
+            if (ttl == 0) cache_.del(key);
+            else if (version) cache_.set_versioned(key, value, version, ttl);
+            else cache_.set(key, value, ttl);
+        } else if (op == "DEL") {
+            cache_.del(key);
+        }
+        applied_lsn_ = std::stoull(message[1]);
+        synced_ = true;
+    } else if (type == "FULLRESYNC") {
+        snapshot_lsn_ = std::stoull(message[1]);
+        synced_ = false;
+        cache_.clear();
+    } else if (type == "SNAPSHOT-END") {
+        applied_lsn_ = snapshot_lsn_;
+        synced_ = true;
+        full_syncs_++;
+        LOG_INFO("Replica", "Snapshot applied (" << cache_.size() << " keys, LSN " << snapshot_lsn_ << ")");
+    }
+}
+
+void Replica::publish_lag() {
+    if (metrics_) metrics_->set_gauge("replication_lag", static_cast<double>(lag()));
+}
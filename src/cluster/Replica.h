@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/LRUCache.h"
+#include "monitoring/MetricsCollector.h"
+
+// Replica side of WAL streaming (see ReplicationSource). A receive thread
+// keeps a SYNC connection to the primary open, reconnecting from the last
+// complete LSN, and queues decoded messages; an apply thread drains them
+// into the cache in batches. Lag is the number of primary records not yet
+// applied here and is published as the "replication_lag" gauge.
+class Replica {
+public:
+    Replica(LRUCache& cache, const std::string& primary_host, int primary_port,
+            MetricsCollector* metrics = nullptr);
+    ~Replica();
+    
+    void start();
+    void stop();
+    
+    // True once a snapshot or resumed stream has been applied
+    bool synced() const { return synced_; }
+    uint64_t applied_lsn() const { return applied_lsn_; }
+    uint64_t primary_lsn() const { return primary_lsn_; }
+    uint64_t lag() const;
+    size_t full_syncs() const { return full_syncs_; }
+    std::string primary_address() const;
+    
+private:
+    using Message = std::vector<std::string>;
+    
+    LRUCache& cache_;
+    std::string host_;
+    int port_;
+    MetricsCollector* metrics_;
+    
+    std::thread receiver_;
+    std::thread applier_;
+    std::atomic<bool> stopping_{false};
+    std::mutex fd_mutex_;
+    int fd_ = -1;
+    
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::vector<Message>> queue_;
+    bool receive_done_ = false;
+    
+    std::atomic<bool> synced_{false};
+    std::atomic<uint64_t> applied_lsn_{0};
+    std::atomic<uint64_t> primary_lsn_{0};
+    std::atomic<size_t> full_syncs_{0};
+    // LSN up to which everything received is complete; 0 until a snapshot
+    // has fully arrived, so a broken one is redone. Receive thread only, and
+    // kept across stop()/start() so a restart resumes the stream.
+    uint64_t resume_lsn_ = 0;
+    uint64_t snapshot_lsn_ = 0;  // apply thread only
+    
+    static constexpr size_t MAX_QUEUED_BATCHES = 64;
+    static constexpr int CONNECT_TIMEOUT_MS = 1000;
+    static constexpr int RETRY_DELAY_MS = 500;
+    
+    void receive_loop();
+    bool receive(int fd);
+    void enqueue(std::vector<Message> batch);
+    void apply_loop();
+    void apply(const Message& message);
+    void publish_lag();
+};
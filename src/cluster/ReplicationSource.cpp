@@ -0,0 +1,76 @@
+#include "ReplicationSource.h"
+#include "monitoring/Logger.h"
+#include "network/RESPParser.h"
+#include "network/Socket.h"
+#include <chrono>
+#include <vector>
+
+ReplicationSource::ReplicationSource(LRUCache& cache, WAL& wal) : cache_(cache), wal_(wal) {}
+
+void ReplicationSource::serve(int fd, uint64_t from_lsn, const std::atomic<bool>& stopping) {
+    replicas_++;
+    LOG_INFO("Replication", "Replica attached at LSN " << from_lsn);
+    
+    std::vector<WAL::Record> probe;
+    uint64_t lsn = from_lsn;
+    bool ok = true;
+    if (lsn == 0 || lsn > wal_.last_lsn() || !wal_.read_since(lsn, 1, probe)) {
+        ok = send_snapshot(fd, lsn);
+    }
+    if (ok) stream(fd, lsn, stopping);
+    
+    replicas_--;
+    LOG_INFO("Replication", "Replica detached");
+}
+
+bool ReplicationSource::send_snapshot(int fd, uint64_t& lsn) {
+    // Every write with an LSN up to here is already in the cache (the cache
+    // is updated before the WAL append), so the shard copies below contain
+    // it; later records are streamed after the snapshot and reapplying them
+    // is harmless
+    lsn = wal_.last_lsn();
+    LOG_INFO("Replication", "Full resync at LSN " << lsn);
+    
+    std::string out = RESPParser::serialize_command({"FULLRESYNC", std::to_string(lsn)});
+    for (size_t i = 0; i < cache_.shard_count(); ++i) {
+        for (const auto& entry : cache_.snapshot_shard_versioned(i)) {
+            out += RESPParser::serialize_command({"VSET", entry.key, entry.value, std::to_string(entry.version),
+                                                  std::to_string(entry.ttl_seconds)});
+            if (out.size() >= SNAPSHOT_CHUNK_BYTES) {
+                if (!Socket::send_all(fd, out)) return false;
+                out.clear();
+            }
+        }
+    }
+    out += RESPParser::serialize_command({"SNAPSHOT-END"});
+    return Socket::send_all(fd, out);
+}
+
+bool ReplicationSource::stream(int fd, uint64_t lsn, const std::atomic<bool>& stopping) {
+    std::vector<WAL::Record> records;
+    auto last_send = std::chrono::steady_clock::now();
+    
+    while (!stopping) {
+        if (!wal_.read_since(lsn, STREAM_BATCH, records)) {
+            LOG_WARN("Replication", "Replica fell behind the WAL backlog at LSN " << lsn);
+            return false;
+        }
+        
+        std::string out;
+        if (records.empty()) {
+            if (wal_.wait_for_lsn(lsn, std::chrono::milliseconds(POLL_MS))) continue;
+            if (std::chrono::steady_clock::now() - last_send < std::chrono::milliseconds(HEARTBEAT_MS)) continue;
+        }
+        for (const auto& record : records) {
+            std::vector<std::string> message{"REPL", std::to_string(record.lsn), record.op, record.key};
+            if (!record.value.empty()) message.push_back(record.value);
+            out += RESPParser::serialize_command(message);
+            lsn = record.lsn;
+        }
+        out += RESPParser::serialize_command({"LSN", std::to_string(wal_.last_lsn())});
+        
+        if (!Socket::send_all(fd, out)) return false;
+        last_send = std::chrono::steady_clock::now();
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "storage/LRUCache.h"
+#include "storage/WAL.h"
+
+// Primary side of WAL streaming. A replica connection that sends
+// SYNC <lsn> is handed to serve(), which runs on that connection's thread:
+//
+//   FULLRESYNC <lsn>, VSET <key> <value> <version> <ttl>...,
+//   SNAPSHOT-END                                          when lsn is 0 or
+//                                                         older than the backlog
+//   REPL <lsn> <op> <key> [value]                         each WAL record after lsn
+//   LSN <last>                                            after every batch and when idle
+//
+// Writers only append to the WAL backlog; each replica reads it at its own
+// pace, so a slow replica never blocks the write path. One that falls out
+// of the backlog is disconnected and resyncs from a snapshot.
+class ReplicationSource {
+public:
+    ReplicationSource(LRUCache& cache, WAL& wal);
+    
+    // Streams until the replica disconnects or stopping is set
+    void serve(int fd, uint64_t from_lsn, const std::atomic<bool>& stopping);
+    int replica_count() const { return replicas_; }
+    
+private:
+    LRUCache& cache_;
+    WAL& wal_;
+    std::atomic<int> replicas_{0};
+    
+    static constexpr size_t STREAM_BATCH = 512;
+    static constexpr size_t SNAPSHOT_CHUNK_BYTES = 64 * 1024;
+    static constexpr int HEARTBEAT_MS = 1000;
+    static constexpr int POLL_MS = 200;
+    
+    bool send_snapshot(int fd, uint64_t& lsn);
+    bool stream(int fd, uint64_t lsn, const std::atomic<bool>& stopping);
+};
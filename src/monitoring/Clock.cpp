@@ -0,0 +1,64 @@
+#include "Clock.h"
+#include <chrono>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define DISTCACHE_HAS_TSC 1
+#endif
+
+namespace {
+
+uint64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Calibration {
+    bool tsc = false;
+    uint64_t base_ticks = 0;
+    uint64_t base_ns = 0;
+    double ns_per_tick = 0.0;
+    
+    Calibration() {
+#ifdef DISTCACHE_HAS_TSC
+        // Invariant TSC: CPUID 0x80000007, EDX bit 8. Without it the counter
+        // may stop or change rate with power states.
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8))) return;
+        
+        uint64_t start_ns = steady_ns();
+        uint64_t start_ticks = __rdtsc();
+        uint64_t end_ns;
+        while ((end_ns = steady_ns()) - start_ns < 2000000) {}
+        uint64_t end_ticks = __rdtsc();
+        if (end_ticks <= start_ticks) return;
+        
+        ns_per_tick = static_cast<double>(end_ns - start_ns) / (end_ticks - start_ticks);
+        base_ticks = end_ticks;
+        base_ns = end_ns;
+        tsc = true;
+#endif
+    }
+};
+
+const Calibration& calibration() {
+    static const Calibration instance;
+    return instance;
+}
+
+}
+
+uint64_t Clock::now_ns() {
+#ifdef DISTCACHE_HAS_TSC
+    const Calibration& c = calibration();
+    if (c.tsc) {
+        int64_t ticks = static_cast<int64_t>(__rdtsc() - c.base_ticks);
+        return c.base_ns + static_cast<int64_t>(ticks * c.ns_per_tick);
+    }
+#endif
+    return steady_ns();
+}
+
+bool Clock::uses_tsc() {
+    return calibration().tsc;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+// Monotonic nanosecond clock for latency measurement. On x86-64 with an
+// invariant TSC it reads the time stamp counter, scaled by a ratio
+// calibrated against steady_clock on first use, which avoids the clock
+// call on every timestamp; elsewhere it is steady_clock.
+class Clock {
+public:
+    static uint64_t now_ns();
+    // Time since start; 0 rather than wrapping if the counters of two
+    // cores disagree by a few ticks
+    static uint64_t elapsed_ns(uint64_t start) {
+        uint64_t now = now_ns();
+        return now > start ? now - start : 0;
+    }
+    // True if now_ns() is TSC-based
+    static bool uses_tsc();
+};
@@ -1,34 +1,286 @@
 #include "HttpDashboard.h"
-#include <thread>
-#include <chrono>
+#include "monitoring/Logger.h"
+#include "network/Socket.h"
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <sstream>
+#include <vector>
 
-HttpDashboard::HttpDashboard(MetricsCollector& metrics, HashRing& hash_ring,
+namespace {
+
+// Label values and JSON strings share the same escapes
+std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '\\' || c == '"') escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Prometheus metric names allow [a-zA-Z0-9_:]
+std::string metric_name(const std::string& name) {
+    std::string sanitized = name;
+    for (char& c : sanitized) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') c = '_';
+    }
+    return sanitized;
+}
+
+void header(std::ostringstream& out, const std::string& name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+std::string http_response(int status, const char* reason, const char* content_type,
+                          const std::string& body, bool close) {
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << " " << reason << "\r\n"
+             << "Content-Type: " << content_type << "\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: " << (close ? "close" : "keep-alive") << "\r\n\r\n"
+             << body;
+    return response.str();
+}
+
+}
+
+HttpDashboard::HttpDashboard(MetricsCollector& metrics, LRUCache& cache, HashRing& hash_ring,
                              CircuitBreaker& circuit_breaker)
-    : metrics_(metrics), hash_ring_(hash_ring), circuit_breaker_(circuit_breaker) {}
+    : metrics_(metrics), cache_(cache), hash_ring_(hash_ring), circuit_breaker_(circuit_breaker) {}
+
+HttpDashboard::~HttpDashboard() {
+    stop();
+}
 
 void HttpDashboard::start(int port) {
-    std::cout << "[Dashboard] HTTP dashboard running on port " << port << "\n";
+    if (running_) return;
+    listen_fd_ = Socket::listen_tcp(port);
+    Socket::set_nonblocking(listen_fd_);
+    port_ = Socket::local_port(listen_fd_);
+    running_ = true;
+    thread_ = std::thread(&HttpDashboard::serve_loop, this);
+    LOG_INFO("Dashboard", "Serving /metrics and /stats on port " << port_);
+}
+
+void HttpDashboard::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void HttpDashboard::serve_loop() {
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
     
-    // Simulate dashboard updates
+    while (running_) {
+        fds.clear();
+        fds.push_back({listen_fd_, POLLIN, 0});
+        for (const auto& connection : connections) {
+            fds.push_back({connection.fd, static_cast<short>(connection.out.empty() ? POLLIN : POLLOUT), 0});
+        }
+        // The timeout bounds how long stop() waits
+        if (::poll(fds.data(), fds.size(), 100) <= 0) continue;
+        
+        std::vector<Connection> open;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = connections[i];
+            short events = fds[i + 1].revents;
+            bool keep = true;
+            if (events & (POLLERR | POLLNVAL)) keep = false;
+            else if (events & POLLOUT) keep = write_pending(connection);
+            else if (events & (POLLIN | POLLHUP)) keep = read_requests(connection) && write_pending(connection);
+            if (keep) {
+                open.push_back(std::move(connection));
+            } else {
+                ::close(connection.fd);
+            }
+        }
+        connections = std::move(open);
+        
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = ::accept(listen_fd_, nullptr, nullptr)) >= 0) {
+                if (connections.size() >= MAX_CONNECTIONS) {
+                    ::close(fd);
+                    continue;
+                }
+                Socket::set_nonblocking(fd);
+                connections.push_back({fd, "", ""});
+            }
+        }
+    }
+    for (const auto& connection : connections) ::close(connection.fd);
+}
+
+bool HttpDashboard::read_requests(Connection& connection) {
+    char chunk[4096];
+    bool client_done = false;
     while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-        generate_status_report();
+        ssize_t n = ::recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            connection.in.append(chunk, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        // The client stopped sending; answer what it sent, then close
+        client_done = true;
+        break;
+    }
+    
+    size_t end;
+    while (!connection.close_after_write && (end = connection.in.find("\r\n\r\n")) != std::string::npos) {
+        bool close = false;
+        connection.out += respond(connection.in.substr(0, end), close);
+        connection.in.erase(0, end + 4);
+        connection.close_after_write = close;
+    }
+    if (connection.in.size() > MAX_REQUEST_BYTES) {
+        connection.out += http_response(431, "Request Header Fields Too Large", "text/plain", "", true);
+        connection.close_after_write = true;
+    }
+    if (client_done) connection.close_after_write = true;
+    return true;
+}
+
+bool HttpDashboard::write_pending(Connection& connection) {
+    while (!connection.out.empty()) {
+        ssize_t n = ::send(connection.fd, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        connection.out.erase(0, static_cast<size_t>(n));
     }
+    return !connection.close_after_write;
 }
 
-void HttpDashboard::generate_status_report() {
-    std::cout << "\n=== DistCache Status Report ===\n";
-    std::cout << "Circuit Breaker: " << circuit_breaker_.get_state_string() 
-              << " (failures: " << circuit_breaker_.get_failure_count() << ")\n";
+std::string HttpDashboard::respond(const std::string& request, bool& close) {
+    std::istringstream lines(request);
+    std::string method, target, version;
+    lines >> method >> target >> version;
     
-    auto nodes = hash_ring_.get_all_nodes();
-    std::cout << "Hash Ring: " << nodes.size() << " nodes [";
-    for (size_t i = 0; i < nodes.size(); ++i) {
-        std::cout << nodes[i];
-        if (i < nodes.size() - 1) std::cout << ", ";
+    // HTTP/1.1 keeps the connection open unless asked not to; 1.0 closes
+    close = version != "HTTP/1.1";
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::string lower;
+        for (char c : line) lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        if (lower.rfind("connection:", 0) == 0) {
+            if (lower.find("close") != std::string::npos) close = true;
+            if (lower.find("keep-alive") != std::string::npos) close = false;
+        }
+    }
+    
+    if (method.empty() || target.empty() || version.rfind("HTTP/", 0) != 0) {
+        close = true;
+        return http_response(400, "Bad Request", "text/plain", "bad request\n", close);
+    }
+    if (method != "GET") {
+        return http_response(405, "Method Not Allowed", "text/plain", "only GET is supported\n", close);
+    }
+    std::string path = target.substr(0, target.find('?'));
+    if (path == "/metrics") {
+        return http_response(200, "OK", "text/plain; version=0.0.4", prometheus_metrics(), close);
+    }
+    if (path == "/stats") {
+        return http_response(200, "OK", "application/json", stats_json(), close);
+    }
+    if (path == "/") {
+        return http_response(200, "OK", "text/plain", "/metrics\n/stats\n", close);
+    }
+    return http_response(404, "Not Found", "text/plain", "not found\n", close);
+}
+
+std::string HttpDashboard::prometheus_metrics() const {
+    std::ostringstream out;
+    
+    header(out, "distcache_requests_total", "counter", "Requests answered.");
+    out << "distcache_requests_total " << metrics_.request_count() << "\n";
+    header(out, "distcache_connections", "gauge", "Open client connections.");
+    out << "distcache_connections " << metrics_.active_connections() << "\n";
+    for (const auto& [name, value] : metrics_.counters()) {
+        std::string metric = "distcache_" + metric_name(name) + "_total";
+        header(out, metric, "counter", "Server counter.");
+        out << metric << " " << value << "\n";
     }
-    std::cout << "]\n";
+    for (const auto& [name, value] : metrics_.gauges()) {
+        std::string metric = "distcache_" + metric_name(name);
+        header(out, metric, "gauge", "Server gauge.");
+        out << metric << " " << value << "\n";
+    }
+    
+    // Quantiles over each histogram's sliding window
+    auto summaries = metrics_.latency_summaries();
+    header(out, "distcache_latency_seconds", "gauge", "Latency quantiles over the last minute.");
+    for (const auto& [name, summary] : summaries) {
+        std::pair<const char*, uint64_t> quantiles[] = {
+            {"0.5", summary.p50}, {"0.9", summary.p90}, {"0.99", summary.p99},
+            {"0.999", summary.p999}, {"1", summary.max}};
+        for (const auto& [quantile, ns] : quantiles) {
+            out << "distcache_latency_seconds{name=\"" << escape(name) << "\",quantile=\"" << quantile << "\"} "
+                << ns / 1e9 << "\n";
+        }
+    }
+    header(out, "distcache_latency_samples", "gauge", "Samples behind the latency quantiles.");
+    for (const auto& [name, summary] : summaries) {
+        out << "distcache_latency_samples{name=\"" << escape(name) << "\"} " << summary.count << "\n";
+    }
+    
+    header(out, "distcache_cache_entries", "gauge", "Entries in the cache.");
+    out << "distcache_cache_entries " << cache_.size() << "\n";
+    header(out, "distcache_cache_capacity", "gauge", "Cache capacity in entries.");
+    out << "distcache_cache_capacity " << cache_.capacity() << "\n";
+    header(out, "distcache_cache_hits_total", "counter", "Cache hits.");
+    out << "distcache_cache_hits_total " << cache_.hits() << "\n";
+    header(out, "distcache_cache_misses_total", "counter", "Cache misses.");
+    out << "distcache_cache_misses_total " << cache_.misses() << "\n";
+    
+    auto nodes = hash_ring_.get_all_nodes();
+    header(out, "distcache_ring_nodes", "gauge", "Members of the hash ring.");
+    out << "distcache_ring_nodes " << nodes.size() << "\n";
+    header(out, "distcache_ring_member", "gauge", "1 for each hash ring member.");
+    for (const auto& node : nodes) out << "distcache_ring_member{node=\"" << escape(node) << "\"} 1\n";
     
-    std::cout << "Metrics: " << metrics_.generate_json() << "\n";
-    std::cout << "===============================\n\n";
-}
\ No newline at end of file
+    // 0 closed, 1 open, 2 half open
+    header(out, "distcache_circuit_breaker_state", "gauge", "Breaker state: 0 closed, 1 open, 2 half open.");
+    out << "distcache_circuit_breaker_state{peer=\"local\"} " << circuit_breaker_.get_state() << "\n";
+    if (peer_breakers_) {
+        for (const auto& [peer, state] : peer_breakers_->states()) {
+            out << "distcache_circuit_breaker_state{peer=\"" << escape(peer) << "\"} " << state << "\n";
+        }
+    }
+    header(out, "distcache_circuit_breaker_failures", "gauge", "Failures in the local breaker's window.");
+    out << "distcache_circuit_breaker_failures " << circuit_breaker_.get_failure_count() << "\n";
+    return out.str();
+}
+
+std::string HttpDashboard::stats_json() const {
+    std::ostringstream out;
+    out << "{\"metrics\":" << metrics_.generate_json()
+        << ",\"cache\":{\"entries\":" << cache_.size() << ",\"capacity\":" << cache_.capacity()
+        << ",\"hits\":" << cache_.hits() << ",\"misses\":" << cache_.misses()
+        << ",\"hit_rate\":" << cache_.hit_rate() << "},\"ring\":[";
+    const char* separator = "";
+    for (const auto& node : hash_ring_.get_all_nodes()) {
+        out << separator << "\"" << escape(node) << "\"";
+        separator = ",";
+    }
+    out << "],\"circuit_breakers\":{\"local\":\"" << circuit_breaker_.get_state_string() << "\"";
+    if (peer_breakers_) {
+        for (const auto& [peer, state] : peer_breakers_->states()) {
+            const char* names[] = {"CLOSED", "OPEN", "HALF_OPEN"};
+            out << ",\"" << escape(peer) << "\":\"" << names[state] << "\"";
+        }
+    }
+    out << "}}";
+    return out.str();
+}
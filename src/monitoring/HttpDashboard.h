@@ -1,19 +1,66 @@
 #pragma once
 #include <iostream>
+#include <atomic>
+#include <string>
+#include <thread>
 #include "MetricsCollector.h"
 #include "cluster/HashRing.h"
 #include "patterns/CircuitBreaker.h"
+#include "patterns/CircuitBreakerRegistry.h"
+#include "storage/LRUCache.h"
 
+// Minimal HTTP/1.1 server for monitoring, on its own thread: one poll loop
+// over non-blocking sockets, GET only, keep-alive.
+//
+//   /metrics  Prometheus text format
+//   /stats    the same numbers as JSON
+//
+// Pages are built from atomic counters and short snapshot reads (the cache
+// size takes each shard's shared lock in turn), so a scrape never holds a
+// cache lock for longer than that.
 class HttpDashboard {
 public:
-    HttpDashboard(MetricsCollector& metrics, HashRing& hash_ring, 
+    HttpDashboard(MetricsCollector& metrics, LRUCache& cache, HashRing& hash_ring,
                   CircuitBreaker& circuit_breaker);
+    ~HttpDashboard();
+    
+    // Per-peer breakers to report next to the local one; set before start()
+    void set_peer_breakers(CircuitBreakerRegistry& breakers) { peer_breakers_ = &breakers; }
+    
+    // Binds the port (0 picks a free one) and starts serving
     void start(int port);
+    void stop();
+    int port() const { return port_; }
+    
+    std::string prometheus_metrics() const;
+    std::string stats_json() const;
     
 private:
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string out;
+        bool close_after_write = false;
+    };
+    
     MetricsCollector& metrics_;
+    LRUCache& cache_;
     HashRing& hash_ring_;
     CircuitBreaker& circuit_breaker_;
+    CircuitBreakerRegistry* peer_breakers_ = nullptr;
+    
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    
+    static constexpr size_t MAX_REQUEST_BYTES = 8192;
+    static constexpr size_t MAX_CONNECTIONS = 64;
     
-    void generate_status_report();
+    void serve_loop();
+    // Reads what is available and queues responses; false once the
+    // connection should be dropped
+    bool read_requests(Connection& connection);
+    bool write_pending(Connection& connection);
+    std::string respond(const std::string& request, bool& close);
 };
@@ -0,0 +1,93 @@
+#include "LatencyHistogram.h"
+#include "Clock.h"
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(std::chrono::milliseconds slot_duration, size_t window_slots)
+    : slot_ns_(std::max<uint64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(slot_duration).count())),
+      slot_count_(std::max<size_t>(1, window_slots)), slots_(new Slot[slot_count_]) {
+    for (size_t s = 0; s < slot_count_; ++s) {
+        for (auto& bucket : slots_[s].buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::bucket_of(uint64_t ns) {
+    ns = std::min(ns, MAX_VALUE);
+    if (ns < SUB_BUCKETS) return static_cast<size_t>(ns);
+    // The top SUB_BITS + 1 bits pick the bucket within the power of two
+    unsigned magnitude = 63 - __builtin_clzll(ns);
+    unsigned shift = magnitude - SUB_BITS;
+    return static_cast<size_t>(SUB_BUCKETS * (shift + 1) + ((ns >> shift) - SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::bucket_limit(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lowest + (1ull << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    int64_t epoch = static_cast<int64_t>(Clock::now_ns() / slot_ns_);
+    Slot& slot = slots_[static_cast<size_t>(epoch) % slot_count_];
+    
+    int64_t seen = slot.epoch.load(std::memory_order_acquire);
+    if (seen != epoch) {
+        // Older epoch: this thread claims the slot and zeroes it; a newer one
+        // or a reset in progress means the sample is too late to keep
+        if (seen == RESETTING || seen > epoch) return;
+        if (!slot.epoch.compare_exchange_strong(seen, RESETTING, std::memory_order_acq_rel)) return;
+        for (auto& bucket : slot.buckets) bucket.store(0, std::memory_order_relaxed);
+        slot.count.store(0, std::memory_order_relaxed);
+        slot.max.store(0, std::memory_order_relaxed);
+        slot.epoch.store(epoch, std::memory_order_release);
+    }
+    
+    slot.buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    slot.count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = slot.max.load(std::memory_order_relaxed);
+    while (ns > max && !slot.max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Merged LatencyHistogram::merge() const {
+    Merged merged;
+    merged.buckets.reset(new uint64_t[BUCKETS]());
+    int64_t current = static_cast<int64_t>(Clock::now_ns() / slot_ns_);
+    for (size_t s = 0; s < slot_count_; ++s) {
+        const Slot& slot = slots_[s];
+        int64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch < 0 || epoch > current || current - epoch >= static_cast<int64_t>(slot_count_)) continue;
+        for (size_t i = 0; i < BUCKETS; ++i) merged.buckets[i] += slot.buckets[i].load(std::memory_order_relaxed);
+        merged.max = std::max(merged.max, slot.max.load(std::memory_order_relaxed));
+    }
+    // Counted from the buckets so percentiles stay consistent with them
+    for (size_t i = 0; i < BUCKETS; ++i) merged.count += merged.buckets[i];
+    return merged;
+}
+
+uint64_t LatencyHistogram::value_at(const Merged& merged, double q) {
+    if (merged.count == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * merged.count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += merged.buckets[i];
+        if (seen >= rank) return std::min(bucket_limit(i), merged.max);
+    }
+    return merged.max;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    return value_at(merge(), q);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    Merged merged = merge();
+    Summary summary;
+    summary.count = merged.count;
+    summary.p50 = value_at(merged, 0.5);
+    summary.p90 = value_at(merged, 0.9);
+    summary.p99 = value_at(merged, 0.99);
+    summary.p999 = value_at(merged, 0.999);
+    summary.max = merged.max;
+    return summary;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+// Log-linear latency histogram in nanoseconds, HdrHistogram style: each
+// power of two is split into SUB_BUCKETS linear buckets, so a reported
+// value is within 1/SUB_BUCKETS (~3%) of the recorded one, from 1ns up to
+// MAX_VALUE. Values above that are clamped.
+//
+// Samples land in the slot of the current time window; reports merge the
+// slots still inside the sliding window (window_slots slots of
+// slot_duration each). Recording is a few relaxed atomic adds and never
+// locks. A slot is zeroed when it is reused, and samples that arrive
+// while it is being zeroed are dropped.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BITS;
+    static constexpr unsigned MAX_BITS = 40;  // ~18 minutes
+    static constexpr uint64_t MAX_VALUE = (1ull << MAX_BITS) - 1;
+    static constexpr size_t BUCKETS = SUB_BUCKETS * (MAX_BITS - SUB_BITS + 1);
+    
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+        uint64_t max = 0;
+    };
+    
+    explicit LatencyHistogram(std::chrono::milliseconds slot_duration = std::chrono::seconds(10),
+                              size_t window_slots = 6);
+    
+    void record(uint64_t ns);
+    // Over the sliding window
+    Summary summary() const;
+    uint64_t percentile(double q) const;
+    
+    static size_t bucket_of(uint64_t ns);
+    // Highest value that falls in the bucket
+    static uint64_t bucket_limit(size_t index);
+    
+private:
+    static constexpr int64_t UNUSED = -1;
+    static constexpr int64_t RESETTING = -2;
+    
+    struct Slot {
+        std::atomic<int64_t> epoch{UNUSED};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> max{0};
+        std::atomic<uint64_t> buckets[BUCKETS];
+    };
+    
+    struct Merged {
+        uint64_t count = 0;
+        uint64_t max = 0;
+        std::unique_ptr<uint64_t[]> buckets;
+    };
+    
+    uint64_t slot_ns_;
+    size_t slot_count_;
+    std::unique_ptr<Slot[]> slots_;
+    
+    Merged merge() const;
+    static uint64_t value_at(const Merged& merged, double q);
+};
@@ -0,0 +1,160 @@
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : sink_([](const std::string& lines) {
+    std::fwrite(lines.data(), 1, lines.size(), stdout);
+    std::fflush(stdout);
+}) {
+    drainer_ = std::thread(&Logger::drain_loop, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (drainer_.joinable()) drainer_.join();
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    drain();
+}
+
+bool Logger::parse_level(const std::string& text, Level& level) {
+    std::string lower;
+    for (char c : text) lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    for (Level candidate : {Level::Debug, Level::Info, Level::Warn, Level::Error, Level::Off}) {
+        std::string name = level_name(candidate);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (lower == name) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Logger::level_name(Level level) {
+    switch (level) {
+        case Level::Debug: return "DEBUG";
+        case Level::Info: return "INFO";
+        case Level::Warn: return "WARN";
+        case Level::Error: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+void Logger::set_sink(Sink sink) {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    drain();  // What was logged so far goes to the old sink
+    sink_ = std::move(sink);
+}
+
+Logger::Ring& Logger::local_ring() {
+    thread_local RingHandle handle;
+    if (!handle.ring) {
+        handle.ring = std::make_shared<Ring>(next_thread_.fetch_add(1, std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(handle.ring);
+    }
+    return *handle.ring;
+}
+
+void Logger::log(Level level, const char* component, const std::string& message) {
+    Ring& ring = local_ring();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    Record& record = ring.records[head % RING_CAPACITY];
+    record.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.component = component;
+    record.level = level;
+    record.thread = ring.thread;
+    record.length = static_cast<uint32_t>(std::min(message.size(), MAX_MESSAGE));
+    std::memcpy(record.text, message.data(), record.length);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Logger::flush() {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    drain();
+}
+
+void Logger::drain_loop() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, std::chrono::milliseconds(DRAIN_INTERVAL_MS));
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+            drain();
+        }
+        lock.lock();
+    }
+}
+
+void Logger::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+    
+    std::vector<Record> batch;
+    std::vector<Ring*> finished;
+    for (const auto& ring : rings) {
+        // Checked first: once orphaned, nothing more is written
+        bool orphaned = ring->orphaned.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail < head; ++tail) batch.push_back(ring->records[tail % RING_CAPACITY]);
+        ring->tail.store(tail, std::memory_order_release);
+        if (orphaned) finished.push_back(ring.get());
+    }
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [&](const std::shared_ptr<Ring>& ring) {
+            return std::find(finished.begin(), finished.end(), ring.get()) != finished.end();
+        }), rings_.end());
+    }
+    if (batch.empty()) return;
+    
+    // Each ring is already in order; this interleaves the threads
+    std::stable_sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+        return a.time_us < b.time_us;
+    });
+    std::string lines;
+    for (const auto& record : batch) lines += format(record);
+    if (sink_) sink_(lines);
+}
+
+std::string Logger::format(const Record& record) {
+    std::time_t seconds = static_cast<std::time_t>(record.time_us / 1000000);
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    char stamp[40];
+    size_t length = std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &utc);
+    std::snprintf(stamp + length, sizeof(stamp) - length, ".%06lldZ",
+                  static_cast<long long>(record.time_us % 1000000));
+    
+    std::string line = stamp;
+    line += ' ';
+    line += level_name(record.level);
+    line += " t" + std::to_string(record.thread) + " [" + record.component + "] ";
+    line.append(record.text, record.length);
+    line += '\n';
+    return line;
+}
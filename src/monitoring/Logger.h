@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous leveled logger. Each thread that logs gets its own
+// single-producer/single-consumer ring of fixed-size records; a background
+// thread drains all rings, orders the batch by timestamp and hands the
+// formatted lines to the sink (stdout unless replaced). Producers never
+// lock or block: a record that finds its ring full is dropped and counted.
+//
+// The LOG_* macros test the level before evaluating their arguments, so a
+// disabled line costs one relaxed load and a branch:
+//
+//   LOG_INFO("TCPServer", "Listening on port " << port_);
+class Logger {
+public:
+    enum class Level { Debug, Info, Warn, Error, Off };
+    
+    // Longer messages are truncated
+    static constexpr size_t MAX_MESSAGE = 224;
+    static constexpr size_t RING_CAPACITY = 1024;
+    
+    using Sink = std::function<void(const std::string& lines)>;
+    
+    static Logger& instance();
+    ~Logger();
+    
+    bool enabled(Level level) const { return level >= level_.load(std::memory_order_relaxed); }
+    void set_level(Level level) { level_.store(level, std::memory_order_relaxed); }
+    Level level() const { return level_.load(std::memory_order_relaxed); }
+    // "debug", "info", "warn", "error" or "off"; false if unknown
+    static bool parse_level(const std::string& text, Level& level);
+    static const char* level_name(Level level);
+    
+    void set_sink(Sink sink);
+    // component must outlive the record, e.g. a string literal
+    void log(Level level, const char* component, const std::string& message);
+    // Returns once everything logged before the call has reached the sink
+    void flush();
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    
+private:
+    struct Record {
+        int64_t time_us;  // system_clock
+        const char* component;
+        Level level;
+        uint32_t thread;
+        uint32_t length;
+        char text[MAX_MESSAGE];
+    };
+    
+    struct Ring {
+        explicit Ring(uint32_t thread_id) : thread(thread_id) {}
+        uint32_t thread;
+        std::atomic<bool> orphaned{false};  // Its thread has exited
+        alignas(64) std::atomic<uint64_t> head{0};  // Next to write
+        alignas(64) std::atomic<uint64_t> tail{0};  // Next to read
+        Record records[RING_CAPACITY];
+    };
+    
+    // Detaches the ring when its thread exits
+    struct RingHandle {
+        std::shared_ptr<Ring> ring;
+        ~RingHandle() { if (ring) ring->orphaned.store(true, std::memory_order_release); }
+    };
+    
+    Logger();
+    Ring& local_ring();
+    void drain_loop();
+    // Moves every queued record to the sink; the caller holds drain_mutex_
+    void drain();
+    static std::string format(const Record& record);
+    
+    std::atomic<Level> level_{Level::Info};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint32_t> next_thread_{1};
+    
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    
+    std::mutex drain_mutex_;  // One consumer at a time
+    Sink sink_;
+    
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread drainer_;
+    
+    static constexpr int DRAIN_INTERVAL_MS = 10;
+};
+
+#define DISTCACHE_LOG(level, component, expr)                                        \
+    do {                                                                             \
+        Logger& distcache_logger_ = Logger::instance();                              \
+        if (distcache_logger_.enabled(level)) {                                      \
+            std::ostringstream distcache_log_stream_;                                \
+            distcache_log_stream_ << expr;                                           \
+            distcache_logger_.log(level, component, distcache_log_stream_.str());    \
+        }                                                                            \
+    } while (0)
+
+#define LOG_DEBUG(component, expr) DISTCACHE_LOG(Logger::Level::Debug, component, expr)
+#define LOG_INFO(component, expr) DISTCACHE_LOG(Logger::Level::Info, component, expr)
+#define LOG_WARN(component, expr) DISTCACHE_LOG(Logger::Level::Warn, component, expr)
+#define LOG_ERROR(component, expr) DISTCACHE_LOG(Logger::Level::Error, component, expr)
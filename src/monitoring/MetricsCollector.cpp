@@ -1 +1,129 @@
 #include "MetricsCollector.h"
+#include <sstream>
+#include <stdexcept>
+
+MetricsCollector::MetricsCollector() : shards_(new Shard[SHARDS]) {
+    for (size_t s = 0; s < SHARDS; ++s) {
+        for (auto& cell : shards_[s].counters) cell.store(0, std::memory_order_relaxed);
+        shards_[s].latency_ns.store(0, std::memory_order_relaxed);
+        shards_[s].latency_count.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsCollector::Counter MetricsCollector::counter(const std::string& name) {
+    {
+        std::shared_lock lock(counters_mutex_);
+        auto it = counter_index_.find(name);
+        if (it != counter_index_.end()) return Counter(this, it->second);
+    }
+    std::unique_lock lock(counters_mutex_);
+    auto it = counter_index_.find(name);
+    if (it != counter_index_.end()) return Counter(this, it->second);
+    if (counter_names_.size() >= MAX_COUNTERS) {
+        throw std::runtime_error("too many counters registered, cannot add '" + name + "'");
+    }
+    counter_index_[name] = counter_names_.size();
+    counter_names_.push_back(name);
+    return Counter(this, counter_names_.size() - 1);
+}
+
+uint64_t MetricsCollector::get_counter(const std::string& name) const {
+    size_t index;
+    {
+        std::shared_lock lock(counters_mutex_);
+        auto it = counter_index_.find(name);
+        if (it == counter_index_.end()) return 0;
+        index = it->second;
+    }
+    uint64_t total = 0;
+    for (size_t s = 0; s < SHARDS; ++s) total += shards_[s].counters[index].load(std::memory_order_relaxed);
+    return total;
+}
+
+LatencyHistogram& MetricsCollector::histogram(const std::string& name) {
+    {
+        std::shared_lock lock(histograms_mutex_);
+        auto it = histograms_.find(name);
+        if (it != histograms_.end()) return *it->second;
+    }
+    std::unique_lock lock(histograms_mutex_);
+    auto& histogram = histograms_[name];
+    if (!histogram) histogram = std::make_unique<LatencyHistogram>();
+    return *histogram;
+}
+
+std::map<std::string, LatencyHistogram::Summary> MetricsCollector::latency_summaries() const {
+    std::map<std::string, LatencyHistogram::Summary> summaries;
+    std::shared_lock lock(histograms_mutex_);
+    for (const auto& [name, histogram] : histograms_) summaries[name] = histogram->summary();
+    return summaries;
+}
+
+void MetricsCollector::record_latency(double ms) {
+    Shard& shard = local_shard();
+    shard.latency_ns.fetch_add(static_cast<uint64_t>(ms > 0 ? ms * 1e6 : 0), std::memory_order_relaxed);
+    shard.latency_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+double MetricsCollector::average_latency_ms() const {
+    uint64_t total_ns = 0, count = 0;
+    for (size_t s = 0; s < SHARDS; ++s) {
+        total_ns += shards_[s].latency_ns.load(std::memory_order_relaxed);
+        count += shards_[s].latency_count.load(std::memory_order_relaxed);
+    }
+    return count ? static_cast<double>(total_ns) / 1e6 / count : 0.0;
+}
+
+uint64_t MetricsCollector::request_count() const {
+    uint64_t count = 0;
+    for (size_t s = 0; s < SHARDS; ++s) count += shards_[s].latency_count.load(std::memory_order_relaxed);
+    return count;
+}
+
+std::map<std::string, uint64_t> MetricsCollector::counters() const {
+    std::vector<std::string> names;
+    {
+        std::shared_lock lock(counters_mutex_);
+        names = counter_names_;
+    }
+    std::map<std::string, uint64_t> totals;
+    for (size_t i = 0; i < names.size(); ++i) {
+        uint64_t total = 0;
+        for (size_t s = 0; s < SHARDS; ++s) total += shards_[s].counters[i].load(std::memory_order_relaxed);
+        totals[names[i]] = total;
+    }
+    return totals;
+}
+
+std::map<std::string, double> MetricsCollector::gauges() const {
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    return gauges_;
+}
+
+std::string MetricsCollector::generate_json() const {
+    std::ostringstream json;
+    json << "{\"requests\":" << request_count() << ",\"avg_latency\":" << average_latency_ms()
+         << ",\"connections\":" << active_connections() << ",\"counters\":{";
+    const char* separator = "";
+    for (const auto& [name, value] : counters()) {
+        json << separator << "\"" << name << "\":" << value;
+        separator = ",";
+    }
+    json << "},\"gauges\":{";
+    separator = "";
+    for (const auto& [name, value] : gauges()) {
+        json << separator << "\"" << name << "\":" << value;
+        separator = ",";
+    }
+    json << "},\"latency\":{";
+    separator = "";
+    // Nanoseconds over each histogram's sliding window
+    for (const auto& [name, summary] : latency_summaries()) {
+        json << separator << "\"" << name << "\":{\"count\":" << summary.count << ",\"p50\":" << summary.p50
+             << ",\"p90\":" << summary.p90 << ",\"p99\":" << summary.p99 << ",\"p999\":" << summary.p999
+             << ",\"max\":" << summary.max << "}";
+        separator = ",";
+    }
+    json << "}}";
+    return json.str();
+}
@@ -3,31 +3,103 @@
 #include <string>
 #include <atomic>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "LatencyHistogram.h"
 
+// Counters and request latency are kept in per-thread shards, one cache
+// line aligned block per shard, and summed only when a report is built, so
+// recording is a relaxed add to memory no other core is writing. Hot paths
+// register their counters once and keep the returned handle; the by-name
+// calls look the name up under a shared lock and suit cold paths.
+//
+// Latency distributions are kept in named LatencyHistograms (such as
+// "command.GET" or "phase.wal"), also registered once and recorded into
+// directly.
 class MetricsCollector {
 public:
-    void record_latency(double ms) {
-        // Simple atomic operation
-        double old_val = total_latency_.load();
-        total_latency_.store(old_val + ms);
-        request_count_++;
-    }
+    static constexpr size_t MAX_COUNTERS = 128;
+    static constexpr size_t SHARDS = 16;
     
-    void increment_counter(const std::string& name) {
-        counters_[name]++;
-    }
+    class Counter {
+    public:
+        Counter() = default;  // Detached: increments are dropped
+        inline void increment(uint64_t n = 1) const;
+        
+    private:
+        friend class MetricsCollector;
+        Counter(MetricsCollector* owner, size_t index) : owner_(owner), index_(index) {}
+        MetricsCollector* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+    
+    MetricsCollector();
+    
+    // Registers the name on first use; throws once MAX_COUNTERS are taken
+    Counter counter(const std::string& name);
+    void increment_counter(const std::string& name) { counter(name).increment(); }
+    uint64_t get_counter(const std::string& name) const;
+    
+    // Registers the name on first use; the reference stays valid for the
+    // collector's lifetime
+    LatencyHistogram& histogram(const std::string& name);
+    std::map<std::string, LatencyHistogram::Summary> latency_summaries() const;
+    
+    void record_latency(double ms);
+    double average_latency_ms() const;
+    uint64_t request_count() const;
     
     void record_active_connections(int count) {
-        active_connections_ = count;
+        active_connections_.store(count, std::memory_order_relaxed);
     }
+    int active_connections() const { return active_connections_.load(std::memory_order_relaxed); }
     
-    std::string generate_json() {
-        return "{\"latency\":5.5,\"requests\":" + std::to_string(request_count_.load()) + "}";
+    // Point-in-time values such as replication lag; the last write wins
+    void set_gauge(const std::string& name, double value) {
+        std::lock_guard<std::mutex> lock(gauges_mutex_);
+        gauges_[name] = value;
     }
     
+    double get_gauge(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(gauges_mutex_);
+        auto it = gauges_.find(name);
+        return it != gauges_.end() ? it->second : 0.0;
+    }
+    
+    // Every counter summed over the shards, by name
+    std::map<std::string, uint64_t> counters() const;
+    std::map<std::string, double> gauges() const;
+    std::string generate_json() const;
+    
 private:
-    std::atomic<double> total_latency_{0.0};
-    std::atomic<int> request_count_{0};
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counters[MAX_COUNTERS];
+        std::atomic<uint64_t> latency_ns;
+        std::atomic<uint64_t> latency_count;
+    };
+    
+    std::unique_ptr<Shard[]> shards_;
+    std::unordered_map<std::string, size_t> counter_index_;
+    std::vector<std::string> counter_names_;
+    mutable std::shared_mutex counters_mutex_;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms_;
+    mutable std::shared_mutex histograms_mutex_;
     std::atomic<int> active_connections_{0};
-    std::map<std::string, std::atomic<int>> counters_;
-};
\ No newline at end of file
+    mutable std::mutex gauges_mutex_;
+    std::map<std::string, double> gauges_;
+    
+    // Threads are dealt shards round-robin as they first record
+    Shard& local_shard() const {
+        static std::atomic<size_t> next_thread{0};
+        thread_local size_t index = next_thread.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return shards_[index];
+    }
+};
+
+inline void MetricsCollector::Counter::increment(uint64_t n) const {
+    if (owner_) owner_->local_shard().counters[index_].fetch_add(n, std::memory_order_relaxed);
+}
@@ -0,0 +1,144 @@
+#include "PeerConnection.h"
+#include "monitoring/Logger.h"
+#include "Socket.h"
+#include "RESPParser.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+PeerConnection::PeerConnection(const std::string& host, int port, int connect_timeout_ms,
+                               bool announce_peer, const std::string& peer_secret)
+    : host_(host), port_(port), address_(host + ":" + std::to_string(port)),
+      connect_timeout_ms_(connect_timeout_ms), announce_peer_(announce_peer), peer_secret_(peer_secret) {}
+
+PeerConnection::~PeerConnection() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    disconnect_locked();
+}
+
+bool PeerConnection::connected() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return fd_ >= 0 && !link_->broken;
+}
+
+void PeerConnection::send(const std::string& request, Callback callback) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if ((fd_ < 0 || link_->broken) && !connect_locked()) {
+        callback(false, "-ERR peer " + address_ + " unavailable\r\n");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> queue_lock(link_->queue_mutex);
+        if (link_->broken) {
+            callback(false, "-ERR peer " + address_ + " connection lost\r\n");
+            return;
+        }
+        link_->pending.push_back(std::move(callback));
+    }
+
+    if (!Socket::send_all(fd_, request)) {
+        // The reader sees the shutdown and fails everything still queued,
+        // including this request
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+bool PeerConnection::connect_locked() {
+    disconnect_locked();
+
+    int fd = Socket::connect_tcp(host_, port_, connect_timeout_ms_);
+    if (fd < 0) return false;
+
+    // Each link gets fresh state; a reader still draining the old one keeps
+    // that alive on its own
+    auto link = std::make_shared<Link>(address_);
+    // Tell the peer this link carries forwarded traffic, so it serves the
+    // requests itself instead of routing them again
+    if (announce_peer_) {
+        link->pending.push_back([](bool, std::string) {});
+        std::vector<std::string> hello{"PEER"};
+        if (!peer_secret_.empty()) hello.push_back(peer_secret_);
+        if (!Socket::send_all(fd, RESPParser::serialize_command(hello))) {
+            ::close(fd);
+            return false;
+        }
+    }
+    fd_ = fd;
+    link_ = link;
+    reader_ = std::thread([link, fd]() { read_loop(link, fd); });
+    LOG_INFO("Peer", "Connected to " << address_);
+    return true;
+}
+
+void PeerConnection::disconnect_locked() {
+    if (fd_ >= 0) {
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+    if (reader_.joinable()) {
+        // A reply callback can drop the last reference to this connection
+        // from the reader thread itself. The reader then finishes on its
+        // own Link and closes the socket once it stops reading from it.
+        if (reader_.get_id() == std::this_thread::get_id()) {
+            link_->close_on_exit = true;
+            reader_.detach();
+            fd_ = -1;
+        } else {
+            reader_.join();
+        }
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void PeerConnection::read_loop(std::shared_ptr<Link> link, int fd) {
+    std::string buffer;
+    std::vector<char> chunk(64 * 1024);
+    size_t parsed = 0;
+
+    while (true) {
+        ssize_t n = ::recv(fd, chunk.data(), chunk.size(), 0);
+        if (n <= 0) break;
+        buffer.append(chunk.data(), static_cast<size_t>(n));
+
+        try {
+            RESPParser::Reply reply;
+            size_t consumed = 0;
+            while (RESPParser::parse_reply(std::string_view(buffer).substr(parsed), consumed, reply)) {
+                Callback callback;
+                {
+                    std::lock_guard<std::mutex> lock(link->queue_mutex);
+                    if (link->pending.empty()) break;
+                    callback = std::move(link->pending.front());
+                    link->pending.pop_front();
+                }
+                callback(true, buffer.substr(parsed, consumed));
+                parsed += consumed;
+            }
+        } catch (const std::exception& e) {
+            LOG_WARN("Peer", "Bad reply from " << link->address << ": " << e.what());
+            break;
+        }
+
+        if (parsed > 0) {
+            buffer.erase(0, parsed);
+            parsed = 0;
+        }
+    }
+    if (link->close_on_exit) ::close(fd);
+    fail_pending(*link, "-ERR peer " + link->address + " connection lost\r\n");
+}
+
+void PeerConnection::fail_pending(Link& link, const std::string& error) {
+    std::deque<Callback> failed;
+    {
+        std::lock_guard<std::mutex> lock(link.queue_mutex);
+        link.broken = true;
+        failed.swap(link.pending);
+    }
+    for (auto& callback : failed) {
+        callback(false, error);
+    }
+}
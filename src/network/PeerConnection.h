@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// One persistent, pipelined connection to a peer node. Requests from any
+// number of threads are written back to back; a reader thread matches
+// replies to callbacks in FIFO order. A broken link fails every pending
+// request and is re-dialled by the next send().
+class PeerConnection {
+public:
+    // ok is false when the link failed; reply then holds an error reply
+    using Callback = std::function<void(bool ok, std::string reply)>;
+
+    // announce_peer marks the link as node-to-node traffic (see TCPServer),
+    // presenting peer_secret if the cluster has one; client connections
+    // leave it off so the server still routes them
+    PeerConnection(const std::string& host, int port, int connect_timeout_ms = 1000,
+                   bool announce_peer = true, const std::string& peer_secret = "");
+    ~PeerConnection();
+
+    PeerConnection(const PeerConnection&) = delete;
+    PeerConnection& operator=(const PeerConnection&) = delete;
+
+    // request is a complete RESP command; the callback receives the raw reply
+    void send(const std::string& request, Callback callback);
+    bool connected() const;
+    const std::string& address() const { return address_; }
+
+private:
+    std::string host_;
+    int port_;
+    std::string address_;
+    int connect_timeout_ms_;
+    bool announce_peer_;
+    std::string peer_secret_;
+
+    // What the reader thread works on. It holds its own reference, because
+    // a reply callback can drop the last reference to the connection and
+    // destroy it on the reader thread, which then runs on to the end.
+    struct Link {
+        explicit Link(const std::string& peer) : address(peer) {}
+        std::string address;
+        std::mutex queue_mutex;   // Guards pending and the broken transition
+        std::deque<Callback> pending;
+        std::atomic<bool> broken{false};
+        bool close_on_exit = false;  // Set when the reader was detached
+    };
+
+    mutable std::mutex write_mutex_;  // Orders writes; guards fd_, link_ and reader_
+    int fd_ = -1;
+    std::shared_ptr<Link> link_;
+    std::thread reader_;
+
+    bool connect_locked();
+    void disconnect_locked();
+    static void read_loop(std::shared_ptr<Link> link, int fd);
+    static void fail_pending(Link& link, const std::string& error);
+};
@@ -0,0 +1,161 @@
+#include "PeerPool.h"
+#include "monitoring/Logger.h"
+#include "RESPParser.h"
+#include <algorithm>
+
+PeerPool::PeerPool(size_t connections_per_peer, bool announce_peer, const CircuitBreaker::Config& breaker_config)
+    : connections_per_peer_(connections_per_peer > 0 ? connections_per_peer : 1),
+      announce_peer_(announce_peer), breakers_(breaker_config) {}
+
+PeerPool::~PeerPool() {
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        timer_stopping_ = true;
+    }
+    timer_cv_.notify_all();
+    if (timer_thread_.joinable()) timer_thread_.join();
+}
+
+CircuitBreaker::Config PeerPool::default_breaker_config() {
+    CircuitBreaker::Config config;
+    config.window_size = 20;
+    config.minimum_calls = 5;
+    config.slow_call_ms = 2000;
+    config.slow_call_rate_threshold = 0.8;
+    config.open_timeout_ms = 5000;
+    return config;
+}
+
+void PeerPool::add_peer(const std::string& node_id, const std::string& host, int port) {
+    auto peer = std::make_shared<Peer>();
+    peer->address = host + ":" + std::to_string(port);
+    // Kept across remove/add, so a flapping peer keeps its history
+    peer->breaker = breakers_.get(node_id);
+    peer->budget = std::make_unique<RetryBudget>(hedge_config_.budget_ratio, hedge_config_.budget_burst);
+    for (size_t i = 0; i < connections_per_peer_; ++i) {
+        peer->connections.push_back(std::make_unique<PeerConnection>(host, port, 1000, announce_peer_, peer_secret_));
+    }
+
+    std::unique_lock lock(peers_mutex_);
+    peers_[node_id] = std::move(peer);
+    LOG_INFO("PeerPool", "Added peer " << node_id << " at " << host << ":" << port);
+}
+
+void PeerPool::remove_peer(const std::string& node_id) {
+    std::shared_ptr<Peer> removed;
+    {
+        std::unique_lock lock(peers_mutex_);
+        auto it = peers_.find(node_id);
+        if (it == peers_.end()) return;
+        removed = std::move(it->second);
+        peers_.erase(it);
+    }
+    // Connections close here, outside the lock, once in-flight sends finish
+}
+
+bool PeerPool::has_peer(const std::string& node_id) const {
+    std::shared_lock lock(peers_mutex_);
+    return peers_.count(node_id) > 0;
+}
+
+std::vector<std::string> PeerPool::peer_ids() const {
+    std::shared_lock lock(peers_mutex_);
+    std::vector<std::string> ids;
+    for (const auto& [id, peer] : peers_) ids.push_back(id);
+    return ids;
+}
+
+std::string PeerPool::peer_address(const std::string& node_id) const {
+    auto peer = find_peer(node_id);
+    return peer ? peer->address : "";
+}
+
+std::shared_ptr<PeerPool::Peer> PeerPool::find_peer(const std::string& node_id) const {
+    std::shared_lock lock(peers_mutex_);
+    auto it = peers_.find(node_id);
+    return it == peers_.end() ? nullptr : it->second;
+}
+
+std::future<std::string> PeerPool::forward(const std::string& node_id, const std::vector<std::string>& argv) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    auto future = promise->get_future();
+    forward(node_id, argv, [promise](bool, std::string reply) {
+        promise->set_value(std::move(reply));
+    });
+    return future;
+}
+
+void PeerPool::forward(const std::string& node_id, const std::vector<std::string>& argv,
+                       PeerConnection::Callback callback) {
+    auto peer = find_peer(node_id);
+    if (!peer) {
+        callback(false, "-ERR unknown peer " + node_id + "\r\n");
+        return;
+    }
+    if (!peer->breaker->allow_request()) {
+        callback(false, "-ERR peer " + node_id + " circuit open\r\n");
+        return;
+    }
+
+    peer->budget->deposit();
+    send(peer, argv, std::move(callback));
+}
+
+std::optional<std::chrono::microseconds> PeerPool::hedge_delay(const std::string& node_id) const {
+    auto peer = find_peer(node_id);
+    if (!peer) return std::nullopt;
+    auto latency = peer->breaker->latency_percentile(hedge_config_.percentile, hedge_config_.min_samples);
+    if (!latency) return std::nullopt;
+    return std::max<std::chrono::microseconds>(*latency, std::chrono::milliseconds(hedge_config_.min_delay_ms));
+}
+
+bool PeerPool::hedge(const std::string& node_id, const std::vector<std::string>& argv,
+                     PeerConnection::Callback callback) {
+    auto peer = find_peer(node_id);
+    // Never spend a half-open breaker's probes on duplicates
+    if (!peer || peer->breaker->get_state() != CircuitBreaker::CLOSED) return false;
+    if (!peer->budget->try_spend()) return false;
+    send(peer, argv, std::move(callback));
+    return true;
+}
+
+void PeerPool::schedule(std::chrono::steady_clock::time_point due, std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    if (timer_stopping_) return;
+    if (!timer_thread_.joinable()) timer_thread_ = std::thread([this]() { timer_loop(); });
+    timers_.emplace(due, std::move(task));
+    timer_cv_.notify_all();
+}
+
+void PeerPool::timer_loop() {
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+    while (!timer_stopping_) {
+        if (timers_.empty()) {
+            timer_cv_.wait(lock);
+            continue;
+        }
+        auto due = timers_.begin()->first;
+        if (std::chrono::steady_clock::now() < due) {
+            timer_cv_.wait_until(lock, due);
+            continue;
+        }
+        auto task = std::move(timers_.begin()->second);
+        timers_.erase(timers_.begin());
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+void PeerPool::send(const std::shared_ptr<Peer>& peer, const std::vector<std::string>& argv,
+                    PeerConnection::Callback callback) {
+    auto& connection = peer->connections[peer->next++ % peer->connections.size()];
+    // The wrapper keeps the peer alive until its reply arrives
+    auto sent = std::chrono::steady_clock::now();
+    connection->send(RESPParser::serialize_command(argv),
+                     [peer, sent, callback = std::move(callback)](bool ok, std::string reply) {
+        peer->breaker->record(ok, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - sent));
+        callback(ok, std::move(reply));
+    });
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <future>
+#include <shared_mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include "PeerConnection.h"
+#include "patterns/CircuitBreakerRegistry.h"
+#include "patterns/RetryBudget.h"
+
+// Persistent pipelined connections to every peer, keyed by node id. Each
+// peer gets a few connections used round-robin and its own circuit breaker
+// from the pool's registry, fed with every reply's outcome and latency, so
+// one dead or slow peer fails fast without slowing routing to the others.
+//
+// Next to its breaker each peer has a retry budget: every request sent to
+// it earns a fraction of a token and every hedged duplicate sent to it
+// spends one, so hedging adds at most budget_ratio extra load per peer.
+class PeerPool {
+public:
+    struct HedgeConfig {
+        double percentile = 0.95;  // Of the peer's recent successful replies
+        size_t min_samples = 10;   // No hedging before this many replies
+        int min_delay_ms = 1;
+        double budget_ratio = 0.1;
+        double budget_burst = 10;
+    };
+
+    // announce_peer: see PeerConnection; off for client-side pools
+    explicit PeerPool(size_t connections_per_peer = 2, bool announce_peer = true,
+                      const CircuitBreaker::Config& breaker_config = default_breaker_config());
+    ~PeerPool();
+    
+    // Trips at 50% errors or 80% calls over 2s among the last 20, stays
+    // open 5s, then probes with 3 calls
+    static CircuitBreaker::Config default_breaker_config();
+    CircuitBreakerRegistry& breakers() { return breakers_; }
+    // Applies to peers added afterwards
+    void set_hedge_config(const HedgeConfig& config) { hedge_config_ = config; }
+    // Secret presented with PEER on every link; applies to peers added afterwards
+    void set_peer_secret(const std::string& secret) { peer_secret_ = secret; }
+
+    void add_peer(const std::string& node_id, const std::string& host, int port);
+    void remove_peer(const std::string& node_id);
+    bool has_peer(const std::string& node_id) const;
+    std::vector<std::string> peer_ids() const;
+    // "host:port" of the peer, empty if unknown
+    std::string peer_address(const std::string& node_id) const;
+
+    // Sends argv to the peer; the future yields the raw RESP reply, or an
+    // error reply if the peer is unknown, unreachable or its breaker is open
+    std::future<std::string> forward(const std::string& node_id, const std::vector<std::string>& argv);
+    // Callback form for fan-out; runs on the connection's reader thread, or
+    // inline when the request fails before it is sent
+    void forward(const std::string& node_id, const std::vector<std::string>& argv,
+                 PeerConnection::Callback callback);
+
+    // How long to wait on the peer before hedging: its observed reply
+    // latency at the configured percentile; nullopt while there are too few
+    // samples or the peer is unknown
+    std::optional<std::chrono::microseconds> hedge_delay(const std::string& node_id) const;
+    // Sends a duplicate request to the peer if its retry budget allows;
+    // false, without calling back, if it does not
+    bool hedge(const std::string& node_id, const std::vector<std::string>& argv,
+               PeerConnection::Callback callback);
+    // Runs task on the pool's timer thread at due, so a hedge is armed from
+    // the moment its primary was sent. Tasks must be short; ones still
+    // waiting when the pool is destroyed are dropped.
+    void schedule(std::chrono::steady_clock::time_point due, std::function<void()> task);
+
+private:
+    struct Peer {
+        std::string address;
+        std::vector<std::unique_ptr<PeerConnection>> connections;
+        std::atomic<size_t> next{0};
+        std::shared_ptr<CircuitBreaker> breaker;
+        std::unique_ptr<RetryBudget> budget;
+    };
+
+    size_t connections_per_peer_;
+    bool announce_peer_;
+    std::string peer_secret_;
+    CircuitBreakerRegistry breakers_;
+    HedgeConfig hedge_config_;
+    std::unordered_map<std::string, std::shared_ptr<Peer>> peers_;
+    mutable std::shared_mutex peers_mutex_;
+    
+    // Started by the first schedule()
+    std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> timers_;
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    std::thread timer_thread_;
+    bool timer_stopping_ = false;
+    
+    void timer_loop();
+
+    std::shared_ptr<Peer> find_peer(const std::string& node_id) const;
+    void send(const std::shared_ptr<Peer>& peer, const std::vector<std::string>& argv,
+              PeerConnection::Callback callback);
+};
@@ -1,4 +1,5 @@
 #include "RESPParser.h"
+#include <stdexcept>
 
 std::tuple<std::string, std::vector<std::string>> RESPParser::parse(const std::string& raw) {
     if (raw.empty()) {
@@ -101,4 +102,118 @@ std::string RESPParser::trim(const std::string& str) {
     
     size_t last = str.find_last_not_of(" \t\r\n");
     return str.substr(first, (last - first + 1));
-}
\ No newline at end of file
+}
+
+bool RESPParser::read_line(std::string_view buffer, size_t& pos, std::string_view& line) {
+    size_t end = buffer.find("\r\n", pos);
+    if (end == std::string_view::npos) return false;
+    line = buffer.substr(pos, end - pos);
+    pos = end + 2;
+    return true;
+}
+
+long long RESPParser::parse_length(std::string_view line) {
+    if (line.empty()) throw std::runtime_error("Protocol error: missing length");
+    try {
+        size_t used = 0;
+        long long value = std::stoll(std::string(line), &used);
+        if (used != line.size()) throw std::invalid_argument("trailing data");
+        return value;
+    } catch (const std::exception&) {
+        throw std::runtime_error("Protocol error: invalid length");
+    }
+}
+
+bool RESPParser::parse_request(std::string_view buffer, size_t& consumed, std::vector<std::string>& argv) {
+    argv.clear();
+    if (buffer.empty()) return false;
+    
+    if (buffer[0] != '*') {
+        // Inline command, e.g. "PING\r\n" from nc or telnet
+        size_t end = buffer.find('\n');
+        if (end == std::string_view::npos) return false;
+        argv = split(std::string(buffer.substr(0, end)));
+        consumed = end + 1;
+        return true;
+    }
+    
+    size_t pos = 1;
+    std::string_view line;
+    if (!read_line(buffer, pos, line)) return false;
+    long long count = parse_length(line);
+    if (count < 0 || count > 1024 * 1024) throw std::runtime_error("Protocol error: invalid multibulk length");
+    
+    argv.reserve(static_cast<size_t>(count));
+    for (long long i = 0; i < count; ++i) {
+        if (pos >= buffer.size()) return false;
+        if (buffer[pos] != '$') throw std::runtime_error("Protocol error: expected '$'");
+        pos++;
+        if (!read_line(buffer, pos, line)) return false;
+        long long length = parse_length(line);
+        if (length < 0 || length > 512 * 1024 * 1024) throw std::runtime_error("Protocol error: invalid bulk length");
+        if (buffer.size() < pos + static_cast<size_t>(length) + 2) return false;
+        argv.emplace_back(buffer.substr(pos, static_cast<size_t>(length)));
+        pos += static_cast<size_t>(length) + 2;
+    }
+    consumed = pos;
+    return true;
+}
+
+bool RESPParser::parse_reply(std::string_view buffer, size_t& consumed, Reply& reply) {
+    if (buffer.empty()) return false;
+    
+    reply = Reply{};
+    reply.type = buffer[0];
+    size_t pos = 1;
+    std::string_view line;
+    if (!read_line(buffer, pos, line)) return false;
+    
+    switch (reply.type) {
+        case '+':
+        case '-':
+            reply.str = std::string(line);
+            break;
+        case ':':
+            reply.integer = parse_length(line);
+            break;
+        case '$': {
+            long long length = parse_length(line);
+            if (length < 0) {
+                reply.is_nil = true;
+                break;
+            }
+            if (buffer.size() < pos + static_cast<size_t>(length) + 2) return false;
+            reply.str = std::string(buffer.substr(pos, static_cast<size_t>(length)));
+            pos += static_cast<size_t>(length) + 2;
+            break;
+        }
+        case '*': {
+            long long count = parse_length(line);
+            if (count < 0) {
+                reply.is_nil = true;
+                break;
+            }
+            reply.elements.resize(static_cast<size_t>(count));
+            for (auto& element : reply.elements) {
+                size_t used = 0;
+                if (!parse_reply(buffer.substr(pos), used, element)) return false;
+                pos += used;
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Protocol error: unknown reply type");
+    }
+    consumed = pos;
+    return true;
+}
+
+std::string RESPParser::serialize_command(const std::vector<std::string>& argv) {
+    std::string out = "*" + std::to_string(argv.size()) + "\r\n";
+    for (const auto& arg : argv) {
+        out += "$" + std::to_string(arg.size()) + "\r\n";
+        out += arg;
+        out += "\r\n";
+    }
+    return out;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <tuple>
 #include <sstream>
@@ -8,6 +9,15 @@
 
 class RESPParser {
 public:
+    struct Reply {
+        char type = '+';        // '+', '-', ':', '$' or '*'
+        bool is_nil = false;    // $-1 or *-1
+        std::string str;        // Simple string, error text or bulk payload
+        long long integer = 0;
+        std::vector<Reply> elements;
+    };
+    
+
     // Parse command from client
     std::tuple<std::string, std::vector<std::string>> parse(const std::string& raw);
     
@@ -19,6 +29,14 @@ public:
     std::string serialize_nil();
     std::string serialize_array(const std::vector<std::string>& items);
     
+    // Incremental framing for socket buffers: both return false until the
+    // buffer holds a complete message and then set consumed to its length.
+    // Requests may be RESP arrays of bulk strings or inline commands.
+    // Malformed input throws std::runtime_error.
+    static bool parse_request(std::string_view buffer, size_t& consumed, std::vector<std::string>& argv);
+    static bool parse_reply(std::string_view buffer, size_t& consumed, Reply& reply);
+    static std::string serialize_command(const std::vector<std::string>& argv);
+    
     // Utility functions
     static std::string to_upper(const std::string& str);
     static std::vector<std::string> split(const std::string& str, char delimiter = ' ');
@@ -29,4 +47,6 @@ private:
     std::tuple<std::string, std::vector<std::string>> parse_simple_string(const std::string& raw);
     std::tuple<std::string, std::vector<std::string>> parse_bulk_string(const std::string& raw);
     std::tuple<std::string, std::vector<std::string>> parse_array(const std::string& raw);
+    static bool read_line(std::string_view buffer, size_t& pos, std::string_view& line);
+    static long long parse_length(std::string_view line);
 };
\ No newline at end of file
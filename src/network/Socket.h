@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Thin helpers over BSD sockets shared by the server, peer links and client
+class Socket {
+public:
+    // Bound, listening socket on all interfaces; port 0 picks a free port
+    static int listen_tcp(int port, int backlog = 128);
+    // Resolves host and connects within timeout_ms; -1 on failure
+    static int connect_tcp(const std::string& host, int port, int timeout_ms);
+    // Bound UDP socket on all interfaces; port 0 picks a free port
+    static int bind_udp(int port);
+    static int local_port(int fd);
+    static bool send_all(int fd, std::string_view data);
+    static void set_nodelay(int fd);
+    static void set_nonblocking(int fd);
+    // "host:port" -> host, port; false if malformed
+    static bool split_address(const std::string& address, std::string& host, int& port);
+};
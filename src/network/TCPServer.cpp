@@ -1,107 +1,763 @@
 #include "TCPServer.h"
+#include "monitoring/Logger.h"
+#include "RESPParser.h"
+#include "Socket.h"
+#include "monitoring/Clock.h"
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
 #include <chrono>
-#include <random>
+#include <memory>
+#include <optional>
 
 TCPServer::TCPServer(int port, LRUCache& cache, WAL& wal, HashRing& hash_ring,
                      CircuitBreaker& circuit_breaker, MetricsCollector& metrics)
     : port_(port), cache_(cache), wal_(wal), hash_ring_(hash_ring),
-      circuit_breaker_(circuit_breaker), metrics_(metrics) {}
+      circuit_breaker_(circuit_breaker), metrics_(metrics), counters_(metrics), latencies_(metrics),
+      replication_(cache, wal) {}
+
+TCPServer::Counters::Counters(MetricsCollector& metrics)
+    : success(metrics.counter("requests_success")), failed(metrics.counter("requests_failed")),
+      forwarded(metrics.counter("requests_forwarded")), blocked(metrics.counter("requests_blocked")),
+      shed(metrics.counter("requests_shed")), throttled(metrics.counter("clients_throttled")),
+      quorum_reads(metrics.counter("quorum_reads")), quorum_writes(metrics.counter("quorum_writes")),
+      migration_fallbacks(metrics.counter("migration_fallbacks")), writes_hinted(metrics.counter("writes_hinted")),
+      reads_hedged(metrics.counter("reads_hedged")), hedges_won(metrics.counter("hedges_won")) {}
+
+TCPServer::Latencies::Latencies(MetricsCollector& metrics)
+    : get(metrics.histogram("command.GET")), set(metrics.histogram("command.SET")),
+      del(metrics.histogram("command.DEL")), other(metrics.histogram("command.other")),
+      parse(metrics.histogram("phase.parse")), execute(metrics.histogram("phase.execute")),
+      wal(metrics.histogram("phase.wal")), write(metrics.histogram("phase.write")) {}
+
+LatencyHistogram& TCPServer::Latencies::command(const std::string& cmd) {
+    if (cmd == "GET") return get;
+    if (cmd == "SET") return set;
+    if (cmd == "DEL") return del;
+    return other;
+}
+
+TCPServer::~TCPServer() {
+    stop();
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+}
+
+void TCPServer::enable_forwarding(const std::string& self_id, PeerPool& peers) {
+    self_id_ = self_id;
+    peers_ = &peers;
+}
+
+void TCPServer::listen() {
+    if (listen_fd_ >= 0) return;
+    listen_fd_ = Socket::listen_tcp(port_);
+    port_ = Socket::local_port(listen_fd_);
+}
 
 void TCPServer::start() {
-    std::cout << "[TCPServer] Listening on port " << port_ << "\n";
+    listen();
+    LOG_INFO("TCPServer", "Listening on port " << port_);
+    
+    while (!stopping_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, 200) <= 0) continue;
+        
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        Socket::set_nodelay(fd);
+        
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_fds_.insert(fd);
+        client_threads_++;
+        std::thread([this, fd]() { handle_client(fd); }).detach();
+    }
+    
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void TCPServer::stop() {
+    stopping_ = true;
     
-    // Simulate multiple client connections
-    std::vector<std::thread> client_threads;
-    for (int i = 0; i < 3; ++i) {
-        client_threads.emplace_back([this]() { handle_client_simulation(); });
+    std::unique_lock<std::mutex> lock(clients_mutex_);
+    for (int fd : client_fds_) ::shutdown(fd, SHUT_RDWR);
+    clients_cv_.wait(lock, [this]() { return client_threads_ == 0; });
+}
+
+TCPServer::ClientBuckets::ClientBuckets(const RateLimits& limits)
+    : ops(limits.ops_per_sec, limits.ops_per_sec * limits.burst_seconds),
+      bytes(limits.bytes_per_sec, limits.bytes_per_sec * limits.burst_seconds) {}
+
+std::chrono::nanoseconds TCPServer::ClientBuckets::consume(size_t op_count, size_t byte_count) {
+    return std::max(ops.consume(static_cast<double>(op_count)), bytes.consume(static_cast<double>(byte_count)));
+}
+
+std::string TCPServer::client_command(const std::vector<std::string>& argv, std::string& name,
+                                      std::shared_ptr<ClientBuckets>& buckets) {
+    RESPParser resp;
+    std::string sub = argv.size() > 1 ? RESPParser::to_upper(argv[1]) : "";
+    if (sub == "GETNAME" && argv.size() == 2) {
+        return name.empty() ? resp.serialize_nil() : resp.serialize_bulk(name);
+    }
+    if (sub != "SETNAME" || argv.size() != 3) {
+        return resp.serialize_error("ERR unknown or malformed CLIENT subcommand");
     }
     
-    for (auto& t : client_threads) {
-        if (t.joinable()) t.join();
+    name = argv[2];
+    if (name.empty()) {
+        buckets.reset();
+        return resp.serialize("OK");
+    }
+    std::lock_guard<std::mutex> lock(named_clients_mutex_);
+    auto& slot = named_clients_[name];
+    buckets = slot.lock();
+    if (!buckets) {
+        buckets = std::make_shared<ClientBuckets>(client_limits_);
+        slot = buckets;
     }
+    // Names nobody uses any more
+    for (auto it = named_clients_.begin(); it != named_clients_.end();) {
+        it = it->second.expired() ? named_clients_.erase(it) : std::next(it);
+    }
+    return resp.serialize("OK");
 }
 
-void TCPServer::handle_client_simulation() {
+void TCPServer::pause_reads(std::chrono::nanoseconds delay) {
+    // Unread requests stay in the socket buffer; once it fills the client's
+    // writes block, which is the backpressure
+    auto until = std::chrono::steady_clock::now() + delay;
+    while (!stopping_ && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            until - std::chrono::steady_clock::now(), std::chrono::milliseconds(100)));
+    }
+}
+
+bool TCPServer::background_command(const std::string& cmd) {
+    return cmd == "MIGRATE" || cmd == "HANDOFF-DONE" || cmd == "HINT" || cmd == "MTREE" || cmd == "MKEYS";
+}
+
+void TCPServer::handle_client(int fd) {
     connection_count_++;
-    std::cout << "[TCPServer] Client connected (total: " << connection_count_ << ")\n";
+    LOG_DEBUG("TCPServer", "Client connected (total: " << connection_count_ << ")");
     
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> cmd_dist(0, 2);
-    std::uniform_int_distribution<> key_dist(1, 1000);
+    bool peer_link = false;
+    ClientBuckets connection_buckets(connection_limits_);
+    std::shared_ptr<ClientBuckets> client_buckets;
+    std::string client_name;
+    std::string buffer;
+    std::vector<char> chunk(16 * 1024);
+    std::vector<std::string> argv;
+    std::vector<std::string> sync_request;
     
-    // Simulate client requests
-    for (int i = 0; i < 10; ++i) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    while (!stopping_ && sync_request.empty()) {
+        ssize_t n = ::recv(fd, chunk.data(), chunk.size(), 0);
+        if (n <= 0) break;
+        buffer.append(chunk.data(), static_cast<size_t>(n));
         
-        if (!circuit_breaker_.allow_request()) {
-            std::cout << "[TCPServer] Request blocked by circuit breaker\n";
-            metrics_.increment_counter("requests_blocked");
-            continue;
+        // Run every complete request in the buffer before waiting on any
+        // forwarded reply, so pipelined requests to peers overlap
+        struct Slot {
+            PendingReply reply;
+            uint64_t start;  // Clock::now_ns() once parsed
+            LatencyHistogram* histogram;
+            bool admitted;  // Still holds a limiter permit: a deferred reply
+        };
+        std::vector<Slot> replies;
+        size_t parsed = 0, consumed = 0;
+        bool protocol_error = false;
+        try {
+            for (uint64_t parse_start = Clock::now_ns();
+                 RESPParser::parse_request(std::string_view(buffer).substr(parsed), consumed, argv);
+                 parse_start = Clock::now_ns()) {
+                parsed += consumed;
+                if (argv.empty()) continue;
+                uint64_t start = Clock::now_ns();
+                latencies_.parse.record(start > parse_start ? start - parse_start : 0);
+                std::string cmd = RESPParser::to_upper(argv[0]);
+                // SYNC turns the connection into a replication stream
+                if (cmd == "SYNC") {
+                    sync_request = argv;
+                    break;
+                }
+                LatencyHistogram* histogram = &latencies_.command(cmd);
+                if (cmd == "CLIENT") {
+                    replies.push_back({{client_command(argv, client_name, client_buckets), {}}, start, histogram, false});
+                    continue;
+                }
+                bool admitted = false;
+                if (limiter_ && cmd != "PEER") {
+                    if (!limiter_->try_acquire(background_command(cmd) ? ConcurrencyLimiter::Priority::BACKGROUND
+                                                                       : ConcurrencyLimiter::Priority::CLIENT)) {
+                        counters_.shed.increment();
+                        replies.push_back({{"-BUSY server overloaded, retry later\r\n", {}}, start, histogram, false});
+                        continue;
+                    }
+                    admitted = true;
+                }
+                try {
+                    PendingReply reply = execute(argv, peer_link);
+                    uint64_t executed = Clock::elapsed_ns(start);
+                    latencies_.execute.record(executed);
+                    // A local reply is complete here; only a forwarded one
+                    // keeps its permit until it resolves
+                    if (admitted && !reply.deferred) {
+                        limiter_->release(std::chrono::nanoseconds(executed), false);
+                        admitted = false;
+                    }
+                    replies.push_back({std::move(reply), start, histogram, admitted});
+                } catch (...) {
+                    if (admitted) limiter_->cancel();
+                    throw;
+                }
+            }
+        } catch (const std::exception& e) {
+            replies.push_back({{"-ERR " + std::string(e.what()) + "\r\n", {}}, Clock::now_ns(), &latencies_.other, false});
+            protocol_error = true;
         }
+        buffer.erase(0, parsed);
         
-        std::string cmd, key = "key" + std::to_string(key_dist(gen)), value, response;
-        
-        switch (cmd_dist(gen)) {
-            case 0: cmd = "SET"; value = "value" + std::to_string(i); break;
-            case 1: cmd = "GET"; break;
-            case 2: cmd = "DEL"; break;
+        std::string out;
+        for (const auto& slot : replies) {
+            bool dropped = false;
+            std::string reply = slot.reply.get(dropped);
+            uint64_t elapsed = Clock::elapsed_ns(slot.start);
+            if (slot.admitted) limiter_->release(std::chrono::nanoseconds(elapsed), dropped);
+            out += reply;
+            slot.histogram->record(elapsed);
+            metrics_.record_latency(elapsed / 1e6);
         }
+        uint64_t write_start = Clock::now_ns();
+        bool sent = Socket::send_all(fd, out);
+        latencies_.write.record(Clock::elapsed_ns(write_start));
+        if (!sent || protocol_error) break;
+        if (!sync_request.empty()) serve_replica(fd, sync_request);
         
-        auto start = std::chrono::high_resolution_clock::now();
-        bool success = process_command(cmd, key, value, response);
-        auto end = std::chrono::high_resolution_clock::now();
-        
-        double latency = std::chrono::duration<double, std::milli>(end - start).count();
-        metrics_.record_latency(latency);
-        
-        if (success) {
-            circuit_breaker_.record_success();
-            metrics_.increment_counter("requests_success");
-        } else {
-            circuit_breaker_.record_failure();
-            metrics_.increment_counter("requests_failed");
+        if (!peer_link || peer_secret_.empty()) {
+            size_t bytes = static_cast<size_t>(n) + out.size();
+            auto delay = connection_buckets.consume(replies.size(), bytes);
+            if (client_buckets) delay = std::max(delay, client_buckets->consume(replies.size(), bytes));
+            if (delay.count() > 0) {
+                counters_.throttled.increment();
+                pause_reads(delay);
+            }
         }
-        
-        std::cout << "[TCPServer] " << cmd << " " << key 
-                  << " -> " << response << " (" << latency << "ms)\n";
     }
     
+    ::close(fd);
     connection_count_--;
-    std::cout << "[TCPServer] Client disconnected (total: " << connection_count_ << ")\n";
+    LOG_DEBUG("TCPServer", "Client disconnected (total: " << connection_count_ << ")");
+    
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    client_fds_.erase(fd);
+    client_threads_--;
+    clients_cv_.notify_all();
 }
 
-bool TCPServer::process_command(const std::string& cmd, const std::string& key,
-                               const std::string& value, std::string& response) {
-    // Check which node should handle this key
-    std::string target_node = hash_ring_.get_node(key);
-    std::cout << "[HashRing] Key '" << key << "' -> Node '" << target_node << "'\n";
+TCPServer::PendingReply TCPServer::execute(const std::vector<std::string>& argv, bool& peer_link) {
+    std::string cmd = RESPParser::to_upper(argv[0]);
     
+    if (cmd == "PEER") {
+        if (!peer_secret_.empty() && (argv.size() != 2 || !peer_secret_matches(argv[1]))) {
+            counters_.failed.increment();
+            return {"-ERR invalid peer secret\r\n", {}};
+        }
+        peer_link = true;
+        return {"+OK\r\n", {}};
+    }
+    if (cmd == "NODES") {
+        return {cluster_nodes(), {}};
+    }
+    if (cmd == "ROLE") {
+        return {role(), {}};
+    }
+    if (replica_ && (cmd == "SET" || cmd == "DEL" || cmd == "MSET" || cmd == "QSET" || cmd == "VSET" ||
+                     cmd == "VDEL")) {
+        counters_.failed.increment();
+        return {"-READONLY You can't write against a read only replica.\r\n", {}};
+    }
+    if (cmd == "DEL" || cmd == "EXISTS" || cmd == "MGET" || cmd == "MSET") {
+        return execute_multi_key(cmd, argv, peer_link);
+    }
+    if (cmd == "QGET" || cmd == "QSET") {
+        return execute_quorum(cmd, argv);
+    }
+    
+    // A peer link's GET was balanced by the node that sent it
+    if (cmd == "GET" && argv.size() == 2 && !peer_link && quorum_ && peers_ &&
+        hash_ring_.bounded_load_enabled() && quorum_->replicated(argv[1])) {
+        return execute_balanced_get(argv);
+    }
+    
+    std::string owner;
+    if (argv.size() > 1 && (cmd == "GET" || cmd == "SET") && owned_elsewhere(argv[1], peer_link, owner)) {
+        counters_.forwarded.increment();
+        return forward(owner, argv);
+    }
+    
+    if (!circuit_breaker_.allow_request()) {
+        counters_.blocked.increment();
+        return {"-ERR circuit breaker open\r\n", {}};
+    }
+    if (cmd == "GET") return execute_get(argv);
+    return {execute_local(cmd, argv), {}};
+}
+
+TCPServer::PendingReply TCPServer::execute_balanced_get(const std::vector<std::string>& argv) {
+    uint32_t node = hash_ring_.acquire(argv[1], quorum_->policy_for(argv[1]).n);
+    if (node == HashRing::NO_NODE) return execute_get(argv);
+    
+    const std::string& target = hash_ring_.node_name(node);
+    PendingReply reply;
+    if (target != self_id_) {
+        counters_.forwarded.increment();
+        reply = forward(target, argv);
+    } else if (!circuit_breaker_.allow_request()) {
+        counters_.blocked.increment();
+        reply = {"-ERR circuit breaker open\r\n", {}};
+    } else {
+        reply = execute_get(argv);
+    }
+    
+    // The replica counts as loaded until its reply is in
+    if (!reply.deferred) {
+        hash_ring_.release(node);
+        return reply;
+    }
+    return {"", [deferred = std::move(reply.deferred), ring = &hash_ring_, node](bool& dropped) {
+        std::string out = deferred(dropped);
+        ring->release(node);
+        return out;
+    }};
+}
+
+TCPServer::PendingReply TCPServer::execute_multi_key(const std::string& cmd,
+                                                     const std::vector<std::string>& argv,
+                                                     bool peer_link) {
+    size_t stride = cmd == "MSET" ? 2 : 1;
+    if (argv.size() < 2 || (argv.size() - 1) % stride != 0) {
+        return {"-ERR wrong number of arguments for '" + cmd + "'\r\n", {}};
+    }
+    
+    // Split into one single-key request per key, served here or by the
+    // owner, then combine the replies in key order
+    const std::string single = cmd == "MGET" ? "GET" : cmd == "MSET" ? "SET" : cmd;
+    std::vector<PendingReply> parts;
+    for (size_t i = 1; i < argv.size(); i += stride) {
+        std::vector<std::string> sub{single, argv[i]};
+        if (stride == 2) sub.push_back(argv[i + 1]);
+        
+        std::string owner;
+        if (owned_elsewhere(argv[i], peer_link, owner)) {
+            counters_.forwarded.increment();
+            parts.push_back(forward(owner, sub));
+        } else if (single == "GET") {
+            parts.push_back(execute_get(sub));
+        } else {
+            parts.push_back({execute_local(single, sub), {}});
+        }
+    }
+    
+    auto combine = [cmd, parts = std::move(parts)](bool& dropped) {
+        if (cmd == "MGET") {
+            std::string out = "*" + std::to_string(parts.size()) + "\r\n";
+            for (const auto& part : parts) {
+                std::string reply = part.get(dropped);
+                out += reply[0] == '$' ? reply : "$-1\r\n";
+            }
+            return out;
+        }
+        // A single key keeps its own reply, e.g. a hinted DEL's +ACCEPTED;
+        // across several keys only known deletions are counted
+        if (parts.size() == 1 && cmd != "MSET") return parts.front().get(dropped);
+        long long total = 0;
+        for (const auto& part : parts) {
+            std::string reply = part.get(dropped);
+            if (reply[0] == '-') return reply;
+            if (reply[0] == ':') total += std::stoll(reply.substr(1));
+        }
+        return cmd == "MSET" ? std::string("+OK\r\n") : ":" + std::to_string(total) + "\r\n";
+    };
+    return {"", combine};
+}
+
+std::string TCPServer::execute_local(const std::string& cmd, const std::vector<std::string>& argv) {
+    RESPParser resp;
+    // Every path settles the breaker: a half-open probe that never reports
+    // back would hold its permit. A rejected request is not a node failure.
+    auto reject = [&](const std::string& message) {
+        circuit_breaker_.record_success();
+        return resp.serialize_error(message);
+    };
     try {
-        if (cmd == "SET") {
-            cache_.set(key, value);
-            wal_.append("SET", key, value);
-            response = "OK";
-            return true;
-        } else if (cmd == "GET") {
-            std::string val;
-            if (cache_.get(key, val)) {
-                response = val;
-            } else {
-                response = "(nil)";
+        std::string response;
+        if (cmd == "PING") {
+            response = argv.size() > 1 ? resp.serialize_bulk(argv[1]) : resp.serialize("PONG");
+        } else if (cmd == "GET" && argv.size() == 2) {
+            std::string value;
+            response = cache_.get(argv[1], value) ? resp.serialize_bulk(value) : resp.serialize_nil();
+        } else if (cmd == "SET" && (argv.size() == 3 || argv.size() == 5)) {
+            int ttl = -1;
+            if (argv.size() == 5) {
+                if (RESPParser::to_upper(argv[3]) != "EX") return reject("ERR syntax error");
+                ttl = std::stoi(argv[4]);
+            }
+            if (migration_) migration_->note_write(argv[1]);
+            // Logged under the shard lock so the WAL orders writes to a key
+            // the same way the cache applied them
+            cache_.set(argv[1], argv[2], ttl, [&] { log_set(argv[1], argv[2], ttl); });
+            response = resp.serialize("OK");
+        } else if (cmd == "DEL" && argv.size() == 2) {
+            if (migration_) migration_->note_write(argv[1]);
+            bool existed = cache_.del(argv[1], [&] {
+                log_write("DEL", argv[1]);
+                // Keeps replicas from copying the key back
+                if (anti_entropy_) anti_entropy_->record_delete(argv[1]);
+            });
+            response = resp.serialize_integer(existed ? 1 : 0);
+        } else if (cmd == "EXISTS" && argv.size() == 2) {
+            response = resp.serialize_integer(cache_.exists(argv[1]) ? 1 : 0);
+        } else if (cmd == "MIGRATE" && migration_ && argv.size() >= 5 && argv.size() % 4 == 1) {
+            // MIGRATE key value version ttl [key value version ttl ...]
+            std::vector<LRUCache::VersionedEntry> entries;
+            for (size_t i = 1; i + 3 < argv.size(); i += 4) {
+                entries.push_back({argv[i], argv[i + 1], std::stoull(argv[i + 2]), std::stoi(argv[i + 3])});
             }
-            return true;
-        } else if (cmd == "DEL") {
-            cache_.del(key);
-            wal_.append("DEL", key);
-            response = "OK";
-            return true;
+            response = resp.serialize_integer(static_cast<int>(migration_->receive(entries)));
+        } else if (cmd == "HANDOFF-DONE" && migration_ && argv.size() == 2) {
+            migration_->handoff_done(argv[1]);
+            response = resp.serialize("OK");
+        } else if (cmd == "MTREE" && anti_entropy_ && argv.size() >= 4) {
+            std::vector<size_t> indices;
+            for (size_t i = 3; i < argv.size(); ++i) indices.push_back(std::stoul(argv[i]));
+            std::vector<std::string> items;
+            for (uint64_t hash : anti_entropy_->tree_children(argv[1], std::stoul(argv[2]), indices)) {
+                items.push_back(std::to_string(hash));
+            }
+            response = resp.serialize_array(items);
+        } else if (cmd == "MKEYS" && anti_entropy_ && argv.size() >= 3) {
+            std::vector<size_t> leaves;
+            for (size_t i = 2; i < argv.size(); ++i) leaves.push_back(std::stoul(argv[i]));
+            std::vector<std::string> items;
+            for (const auto& digest : anti_entropy_->leaf_digests(argv[1], leaves)) {
+                items.push_back(digest.key);
+                items.push_back(std::to_string(digest.version));
+                items.push_back(std::to_string(digest.hash));
+                items.push_back(std::to_string(digest.ttl_seconds));
+            }
+            response = resp.serialize_array(items);
+        } else if (cmd == "HINT" && hints_ && argv.size() >= 4) {
+            std::vector<std::string> hinted(argv.begin() + 2, argv.end());
+            if (!hints_->store(argv[1], hinted)) return reject("ERR hint store full");
+            response = resp.serialize("OK");
+        } else if (cmd == "VGET" && argv.size() == 2) {
+            // [value, version, remaining ttl in seconds]
+            std::string value;
+            uint64_t version = 0;
+            int ttl = -1;
+            response = cache_.get_versioned(argv[1], value, version, &ttl)
+                ? resp.serialize_array({value, std::to_string(version), std::to_string(ttl)})
+                : resp.serialize_nil();
+        } else if (cmd == "VSET" && (argv.size() == 4 || argv.size() == 5)) {
+            // Keeps the newer copy, and refuses one older than a delete; used
+            // by quorum writes, read repair and anti-entropy
+            uint64_t version = std::stoull(argv[3]);
+            int ttl = argv.size() == 5 ? std::stoi(argv[4]) : -1;
+            bool stored = !(anti_entropy_ && anti_entropy_->deleted_since(argv[1], version)) &&
+                cache_.set_versioned(argv[1], argv[2], version, ttl, [&] { log_set(argv[1], argv[2], ttl, version); });
+            response = resp.serialize_integer(stored ? 1 : 0);
+        } else if (cmd == "VDEL" && argv.size() == 3) {
+            // Anti-entropy deletes and replayed hints
+            uint64_t version = std::stoull(argv[2]);
+            bool removed = anti_entropy_ ? anti_entropy_->apply_delete(argv[1], version)
+                                         : cache_.del_versioned(argv[1], version, [&] { log_write("DEL", argv[1]); });
+            response = resp.serialize_integer(removed ? 1 : 0);
+        } else if (cmd == "GET" || cmd == "SET" || cmd == "DEL" || cmd == "EXISTS" ||
+                   cmd == "VGET" || cmd == "VSET" || cmd == "VDEL") {
+            return reject("ERR wrong number of arguments for '" + cmd + "'");
+        } else {
+            counters_.failed.increment();
+            return reject("ERR unknown command '" + argv[0] + "'");
         }
         
-        response = "ERR unknown command";
-        return false;
+        circuit_breaker_.record_success();
+        counters_.success.increment();
+        return response;
     } catch (const std::exception& e) {
-        response = "ERR " + std::string(e.what());
-        return false;
+        circuit_breaker_.record_failure();
+        counters_.failed.increment();
+        return resp.serialize_error("ERR " + std::string(e.what()));
+    }
+}
+
+void TCPServer::log_write(const std::string& operation, const std::string& key, const std::string& value) {
+    uint64_t start = Clock::now_ns();
+    wal_.append(operation, key, value);
+    latencies_.wal.record(Clock::elapsed_ns(start));
+}
+
+void TCPServer::log_set(const std::string& key, const std::string& value, int ttl_seconds, uint64_t version) {
+    uint64_t start = Clock::now_ns();
+    wal_.append_set(key, value, ttl_seconds, version);
+    latencies_.wal.record(Clock::elapsed_ns(start));
+}
+
+TCPServer::PendingReply TCPServer::execute_quorum(const std::string& cmd, const std::vector<std::string>& argv) {
+    if (!quorum_) return {"-ERR quorum replication not enabled\r\n", {}};
+    
+    size_t first_option = cmd == "QSET" ? 3 : 2;
+    if (argv.size() < first_option || (argv.size() - first_option) % 2 != 0) {
+        return {"-ERR wrong number of arguments for '" + cmd + "'\r\n", {}};
+    }
+    
+    // Per-request overrides on top of the keyspace policy
+    QuorumCoordinator::Policy policy = quorum_->policy_for(argv[1]);
+    for (size_t i = first_option; i < argv.size(); i += 2) {
+        std::string option = RESPParser::to_upper(argv[i]);
+        size_t value = 0;
+        try {
+            value = std::stoul(argv[i + 1]);
+        } catch (const std::exception&) {
+            return {"-ERR value is not an integer\r\n", {}};
+        }
+        if (option == "N") policy.n = value;
+        else if (option == "R" && cmd == "QGET") policy.r = value;
+        else if (option == "W" && cmd == "QSET") policy.w = value;
+        else return {"-ERR syntax error\r\n", {}};
+    }
+    size_t quorum = cmd == "QGET" ? policy.r : policy.w;
+    if (quorum < 1 || quorum > policy.n) {
+        return {"-ERR quorum must be between 1 and N\r\n", {}};
     }
-}
\ No newline at end of file
+    
+    auto wait = [](auto& future) {
+        return future->wait_for(std::chrono::milliseconds(FORWARD_TIMEOUT_MS)) == std::future_status::ready;
+    };
+    if (cmd == "QGET") {
+        counters_.quorum_reads.increment();
+        auto future = std::make_shared<std::future<QuorumCoordinator::ReadResult>>(quorum_->read(argv[1], policy));
+        return {"", [future, wait](bool& dropped) {
+            if (!wait(future)) {
+                dropped = true;
+                return std::string("-ERR quorum timeout\r\n");
+            }
+            auto result = future->get();
+            if (!result.ok) return "-ERR " + result.error + "\r\n";
+            return result.found ? RESPParser().serialize_bulk(result.value) : RESPParser().serialize_nil();
+        }};
+    }
+    counters_.quorum_writes.increment();
+    auto future = std::make_shared<std::future<QuorumCoordinator::WriteResult>>(
+        quorum_->write(argv[1], argv[2], policy));
+    return {"", [future, wait](bool& dropped) {
+        if (!wait(future)) {
+            dropped = true;
+            return std::string("-ERR quorum timeout\r\n");
+        }
+        auto result = future->get();
+        return result.ok ? std::string("+OK\r\n") : "-ERR " + result.error + "\r\n";
+    }};
+}
+
+std::string TCPServer::cluster_nodes() const {
+    // One "id=host:port" entry per ring member, this node first
+    std::string self_address = node_address_.empty() ? "127.0.0.1:" + std::to_string(port_) : node_address_;
+    std::vector<std::string> entries{(self_id_.empty() ? "local" : self_id_) + "=" + self_address};
+    if (peers_) {
+        for (const auto& node : hash_ring_.get_all_nodes()) {
+            std::string address = peers_->peer_address(node);
+            if (node != self_id_ && !address.empty()) entries.push_back(node + "=" + address);
+        }
+    }
+    return RESPParser().serialize_array(entries);
+}
+
+TCPServer::PendingReply TCPServer::execute_get(const std::vector<std::string>& argv) {
+    std::string reply = execute_local("GET", argv);
+    std::string source;
+    if (!migration_ || !peers_ || argv.size() != 2 || reply != RESPParser().serialize_nil() ||
+        !migration_->fallback_source(argv[1], source)) {
+        return {reply, {}};
+    }
+    
+    // Ownership moved here but the old owner may not have handed the key
+    // over yet: read it from there and keep the copy
+    counters_.migration_fallbacks.increment();
+    auto future = std::make_shared<std::future<std::string>>(peers_->forward(source, {"VGET", argv[1]}));
+    MigrationManager* migration = migration_;
+    std::string key = argv[1];
+    return {"", [future, migration, key](bool& dropped) {
+        if (future->wait_for(std::chrono::milliseconds(FORWARD_TIMEOUT_MS)) != std::future_status::ready) {
+            dropped = true;
+            return RESPParser().serialize_nil();
+        }
+        RESPParser::Reply parsed;
+        size_t consumed = 0;
+        std::string raw = future->get();
+        if (!RESPParser::parse_reply(raw, consumed, parsed) || parsed.type != '*' || parsed.elements.size() < 3) {
+            return RESPParser().serialize_nil();
+        }
+        try {
+            // Keep the old owner's version and expiry, not a fresh local one
+            migration->receive({{key, parsed.elements[0].str, std::stoull(parsed.elements[1].str),
+                                 std::stoi(parsed.elements[2].str)}});
+        } catch (const std::exception&) {
+            return RESPParser().serialize_nil();
+        }
+        return RESPParser().serialize_bulk(parsed.elements[0].str);
+    }};
+}
+
+std::string TCPServer::role() const {
+    if (replica_) {
+        return RESPParser().serialize_array({"replica", replica_->primary_address(),
+                                             replica_->synced() ? "synced" : "syncing",
+                                             std::to_string(replica_->applied_lsn()),
+                                             std::to_string(replica_->lag())});
+    }
+    return RESPParser().serialize_array({"primary", std::to_string(wal_.last_lsn()),
+                                         std::to_string(replication_.replica_count())});
+}
+
+void TCPServer::serve_replica(int fd, const std::vector<std::string>& argv) {
+    uint64_t from_lsn = 0;
+    try {
+        if (argv.size() != 2) throw std::invalid_argument("wrong number of arguments for 'SYNC'");
+        from_lsn = std::stoull(argv[1]);
+    } catch (const std::exception& e) {
+        Socket::send_all(fd, RESPParser().serialize_error("ERR " + std::string(e.what())));
+        return;
+    }
+    replication_.serve(fd, from_lsn, stopping_);
+}
+
+bool TCPServer::peer_secret_matches(const std::string& given) const {
+    unsigned char diff = given.size() == peer_secret_.size() ? 0 : 1;
+    for (size_t i = 0; i < given.size(); ++i) {
+        diff |= static_cast<unsigned char>(given[i] ^ peer_secret_[i % peer_secret_.size()]);
+    }
+    return diff == 0;
+}
+
+bool TCPServer::owned_elsewhere(const std::string& key, bool peer_link, std::string& owner) const {
+    // Forwarded requests are always served here, so a ring disagreement
+    // between nodes cannot bounce a request back and forth
+    if (!peers_ || peer_link) return false;
+    const std::string& target = hash_ring_.get_node(key);
+    if (target == self_id_) return false;
+    owner = target;
+    return true;
+}
+
+TCPServer::PendingReply TCPServer::forward(const std::string& owner, const std::vector<std::string>& argv) {
+    // Only replicated keys have a copy anywhere but on the owner; for any
+    // other key a hedge could only miss and would still spend the budget
+    if (hedged_reads_ && quorum_ && argv.size() == 2 && RESPParser::to_upper(argv[0]) == "GET" &&
+        quorum_->replicated(argv[1])) {
+        // First other replica that is neither the owner nor this node
+        for (const auto& node : hash_ring_.preference_list(argv[1], quorum_->policy_for(argv[1]).n)) {
+            if (node != owner && node != self_id_) return forward_hedged(owner, node, argv);
+        }
+    }
+    
+    auto future = std::make_shared<std::future<std::string>>(peers_->forward(owner, argv));
+    std::string cmd = RESPParser::to_upper(argv[0]);
+    if (!hints_ || (cmd != "SET" && cmd != "DEL")) {
+        return {"", [future](bool& dropped) {
+            if (future->wait_for(std::chrono::milliseconds(FORWARD_TIMEOUT_MS)) != std::future_status::ready) {
+                dropped = true;
+                return std::string("-ERR peer timeout\r\n");
+            }
+            return future->get();
+        }};
+    }
+    
+    // A write the owner cannot take is kept as a hint and replayed later,
+    // versioned now so it cannot overwrite anything written after it.
+    // Whether a hinted DEL removes anything is not known until then, so it
+    // answers +ACCEPTED instead of a count.
+    return {"", [future, owner, argv, cmd, cache = &cache_, hints = hints_,
+                 hinted = counters_.writes_hinted](bool& dropped) {
+        bool answered = future->wait_for(std::chrono::milliseconds(FORWARD_TIMEOUT_MS)) == std::future_status::ready;
+        dropped = !answered;
+        std::string reply = answered ? future->get() : std::string("-ERR peer timeout\r\n");
+        if (!HintedHandoff::unreachable(reply) ||
+            !hints->hand_off(owner, HintedHandoff::versioned(argv, cache->next_version()))) {
+            return reply;
+        }
+        hinted.increment();
+        return std::string(cmd == "SET" ? "+OK\r\n" : "+ACCEPTED\r\n");
+    }};
+}
+
+TCPServer::PendingReply TCPServer::forward_hedged(const std::string& owner, const std::string& backup,
+                                                  const std::vector<std::string>& argv) {
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::optional<std::string> primary;
+        std::optional<std::string> hedge;
+        bool claimed = false;  // A hedge attempt has started
+        bool settled = false;  // ...and finished; hedged says whether it went out
+        bool hedged = false;
+    };
+    auto usable = [](const std::optional<std::string>& reply) { return reply && (*reply)[0] != '-'; };
+    auto found = [](const std::optional<std::string>& reply) {
+        return reply && (*reply)[0] == '$' && reply->compare(0, 3, "$-1") != 0;
+    };
+    auto race = std::make_shared<Race>();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(FORWARD_TIMEOUT_MS);
+    
+    // Sends the duplicate at most once, and not after the owner answered.
+    // Armed from the send time, independently of when the reply loop gets
+    // to this slot: a pipelined read behind a slow one still hedges on time.
+    auto on_hedge = [race](bool, std::string reply) {
+        std::lock_guard<std::mutex> lock(race->mutex);
+        race->hedge = std::move(reply);
+        race->cv.notify_all();
+    };
+    auto launch = [race, usable, deadline, on_hedge, backup, argv, peers = peers_,
+                   hedge_sent = counters_.reads_hedged]() {
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            if (race->claimed || usable(race->primary) || std::chrono::steady_clock::now() >= deadline) return;
+            race->claimed = true;
+        }
+        bool hedged = peers->hedge(backup, argv, on_hedge);
+        if (hedged) hedge_sent.increment();
+        std::lock_guard<std::mutex> lock(race->mutex);
+        race->hedged = hedged;
+        race->settled = true;
+        race->cv.notify_all();
+    };
+    
+    // Without a latency estimate yet, only a failed owner is hedged
+    if (auto delay = peers_->hedge_delay(owner)) {
+        peers_->schedule(std::chrono::steady_clock::now() + *delay, launch);
+    }
+    peers_->forward(owner, argv, [race, usable, launch](bool, std::string reply) {
+        bool failed = reply.empty() || reply[0] == '-';
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            race->primary = std::move(reply);
+            race->cv.notify_all();
+        }
+        if (failed) launch();
+    });
+    
+    return {"", [race, usable, found, deadline, hedge_won = counters_.hedges_won](bool& dropped) {
+        // A replica that lacks the key may just not have been written to,
+        // so its miss only counts once the owner has failed too
+        std::unique_lock<std::mutex> lock(race->mutex);
+        race->cv.wait_until(lock, deadline, [&]() {
+            if (usable(race->primary) || found(race->hedge)) return true;
+            return race->primary && race->settled && (!race->hedged || race->hedge);
+        });
+        if (usable(race->primary)) return *race->primary;
+        if (usable(race->hedge)) {
+            hedge_won.increment();
+            return *race->hedge;
+        }
+        if (race->primary) return *race->primary;
+        dropped = true;
+        return std::string("-ERR peer timeout\r\n");
+    }};
+}
@@ -2,30 +2,198 @@
 #include <iostream>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <string>
+#include <vector>
 #include "storage/LRUCache.h"
 #include "storage/WAL.h"
 #include "cluster/HashRing.h"
+#include "cluster/ReplicationSource.h"
+#include "cluster/Replica.h"
+#include "cluster/QuorumCoordinator.h"
+#include "cluster/MigrationManager.h"
+#include "cluster/AntiEntropy.h"
+#include "cluster/HintedHandoff.h"
 #include "patterns/CircuitBreaker.h"
+#include "patterns/ConcurrencyLimiter.h"
+#include "patterns/TokenBucket.h"
 #include "monitoring/MetricsCollector.h"
+#include "PeerPool.h"
 
 class TCPServer {
 public:
+    // 0 means unlimited; bursts of up to burst_seconds at the full rate
+    struct RateLimits {
+        double ops_per_sec = 0;
+        double bytes_per_sec = 0;
+        double burst_seconds = 1.0;
+    };
+    
     TCPServer(int port, LRUCache& cache, WAL& wal, HashRing& hash_ring,
               CircuitBreaker& circuit_breaker, MetricsCollector& metrics);
+    ~TCPServer();
+    
+    // Cluster mode: requests for keys another ring member owns are proxied
+    // to it over the pool; replies still go back to the client in order
+    void enable_forwarding(const std::string& self_id, PeerPool& peers);
+    // Address clients should use for this node in NODES replies; defaults
+    // to 127.0.0.1:<port>
+    void set_node_address(const std::string& address) { node_address_ = address; }
+    // Replica mode: writes are refused with -READONLY and ROLE reports the
+    // replica's progress; reads are served from the replicated cache
+    void attach_replica(Replica& replica) { replica_ = &replica; }
+    // Quorum commands: QGET key [N n] [R r] and QSET key value [N n] [W w],
+    // defaults from the coordinator's keyspace policy. If the ring has
+    // bounded load enabled, client GETs of replicated keys go to whichever
+    // of the key's N replicas has room (HashRing::acquire), so a hot key's
+    // reads spread over its replicas instead of piling onto the owner.
+    void enable_quorum(QuorumCoordinator& quorum) { quorum_ = &quorum; }
+    // Rebalancing: accepts MIGRATE/HANDOFF-DONE from old owners and, while a
+    // handoff is pending, answers GET misses from the key's previous owner
+    void enable_migration(MigrationManager& migration) { migration_ = &migration; }
+    // Replica repair: serves MTREE/MKEYS so peers can compare range trees
+    void enable_anti_entropy(AntiEntropy& anti_entropy) { anti_entropy_ = &anti_entropy; }
+    // Forwarded SET/DEL whose owner is unreachable are kept as hints and
+    // acknowledged; HINT owner argv... stores one for a peer
+    void enable_hinted_handoff(HintedHandoff& hints) { hints_ = &hints; }
+    // Forwarded GETs of replicated keys (QuorumCoordinator::replicated) the
+    // owner has not answered within its p95 latency are sent again to
+    // another replica of the key (from the quorum policy's preference list),
+    // within the peer pool's retry budget. A replica's value is used only if
+    // it has one, so a hedged read is as fresh as a quorum read with R=1.
+    // Needs quorum and forwarding enabled.
+    void enable_hedged_reads() { hedged_reads_ = true; }
+    // Load shedding: requests past the limiter's in-flight limit get -BUSY
+    // without being run; migration, hint and repair traffic from peers is
+    // admitted at background priority
+    void set_concurrency_limiter(ConcurrencyLimiter& limiter) { limiter_ = &limiter; }
+    // Client rate limits, per connection and per name given with CLIENT
+    // SETNAME (shared by every connection using it). A client over its rate
+    // is not refused: its socket is not read until it is back within
+    // limits, so TCP flow control pushes back on it. Peer links are exempt
+    // only once they presented the peer secret. Set before start().
+    void set_rate_limits(const RateLimits& per_connection, const RateLimits& per_client) {
+        connection_limits_ = per_connection;
+        client_limits_ = per_client;
+    }
+    // Cluster secret peers present with PEER <secret>. A PEER without it is
+    // refused and the connection stays a routed, rate-limited client link.
+    // Without a secret PEER still turns off routing, but never rate limits.
+    // Set before start().
+    void set_peer_secret(const std::string& secret) { peer_secret_ = secret; }
     
+    // Binds the port (0 picks a free one); start() binds if not done yet
+    void listen();
+    // Accept loop, one thread per connection, until stop()
     void start();
+    void stop();
+    int port() const { return port_; }
     int get_connection_count() const { return connection_count_; }
     
 private:
+    // Ops and bytes buckets of one connection or one client name
+    struct ClientBuckets {
+        explicit ClientBuckets(const RateLimits& limits);
+        TokenBucket ops;
+        TokenBucket bytes;
+        // Pause owed after serving ops requests worth bytes of traffic
+        std::chrono::nanoseconds consume(size_t op_count, size_t byte_count);
+    };
+    
+    // Handles for the counters bumped per request, registered up front
+    struct Counters {
+        explicit Counters(MetricsCollector& metrics);
+        MetricsCollector::Counter success, failed, forwarded, blocked, shed, throttled;
+        MetricsCollector::Counter quorum_reads, quorum_writes, migration_fallbacks;
+        MetricsCollector::Counter writes_hinted, reads_hedged, hedges_won;
+    };
+    
+    // Latency histograms per command type and per request phase
+    struct Latencies {
+        explicit Latencies(MetricsCollector& metrics);
+        // GET, SET and DEL have their own; the rest share one
+        LatencyHistogram& command(const std::string& cmd);
+        LatencyHistogram& get;
+        LatencyHistogram& set;
+        LatencyHistogram& del;
+        LatencyHistogram& other;
+        LatencyHistogram& parse;
+        LatencyHistogram& execute;
+        LatencyHistogram& wal;
+        LatencyHistogram& write;
+    };
+    
+    // A reply slot: ready now, or resolved later from forwarded requests.
+    // A deferred reply sets dropped when it gave up waiting downstream,
+    // which the limiter counts as a sign of overload.
+    struct PendingReply {
+        std::string ready;
+        std::function<std::string(bool& dropped)> deferred;
+        std::string get(bool& dropped) const { return deferred ? deferred(dropped) : ready; }
+    };
+    
     int port_;
     LRUCache& cache_;
     WAL& wal_;
     HashRing& hash_ring_;
     CircuitBreaker& circuit_breaker_;
     MetricsCollector& metrics_;
+    Counters counters_;
+    Latencies latencies_;
     std::atomic<int> connection_count_{0};
     
-    void handle_client_simulation();
-    bool process_command(const std::string& cmd, const std::string& key, 
-                        const std::string& value, std::string& response);
+    std::string self_id_;
+    std::string node_address_;
+    PeerPool* peers_ = nullptr;
+    ReplicationSource replication_;
+    Replica* replica_ = nullptr;
+    QuorumCoordinator* quorum_ = nullptr;
+    MigrationManager* migration_ = nullptr;
+    AntiEntropy* anti_entropy_ = nullptr;
+    HintedHandoff* hints_ = nullptr;
+    bool hedged_reads_ = false;
+    ConcurrencyLimiter* limiter_ = nullptr;
+    std::string peer_secret_;
+    RateLimits connection_limits_;
+    RateLimits client_limits_;
+    std::unordered_map<std::string, std::weak_ptr<ClientBuckets>> named_clients_;
+    std::mutex named_clients_mutex_;
+    
+    int listen_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::mutex clients_mutex_;
+    std::condition_variable clients_cv_;
+    std::unordered_set<int> client_fds_;
+    int client_threads_ = 0;
+    
+    static constexpr int FORWARD_TIMEOUT_MS = 2000;
+    
+    void handle_client(int fd);
+    PendingReply execute(const std::vector<std::string>& argv, bool& peer_link);
+    PendingReply execute_balanced_get(const std::vector<std::string>& argv);
+    PendingReply execute_multi_key(const std::string& cmd, const std::vector<std::string>& argv, bool peer_link);
+    std::string cluster_nodes() const;
+    std::string role() const;
+    static bool background_command(const std::string& cmd);
+    std::string client_command(const std::vector<std::string>& argv, std::string& name,
+                               std::shared_ptr<ClientBuckets>& buckets);
+    void pause_reads(std::chrono::nanoseconds delay);
+    PendingReply execute_quorum(const std::string& cmd, const std::vector<std::string>& argv);
+    void serve_replica(int fd, const std::vector<std::string>& argv);
+    std::string execute_local(const std::string& cmd, const std::vector<std::string>& argv);
+    PendingReply execute_get(const std::vector<std::string>& argv);
+    void log_write(const std::string& operation, const std::string& key, const std::string& value = "");
+    // SET-family record carrying the write's expiry and version, if any
+    void log_set(const std::string& key, const std::string& value, int ttl_seconds, uint64_t version = 0);
+    bool owned_elsewhere(const std::string& key, bool peer_link, std::string& owner) const;
+    // Compares in constant time, so the secret cannot be guessed byte by byte
+    bool peer_secret_matches(const std::string& given) const;
+    PendingReply forward(const std::string& owner, const std::vector<std::string>& argv);
+    PendingReply forward_hedged(const std::string& owner, const std::string& backup,
+                                const std::vector<std::string>& argv);
 };
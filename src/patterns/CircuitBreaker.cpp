@@ -1,77 +1,149 @@
 #include "CircuitBreaker.h"
-#include <iostream>
+#include "monitoring/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
-CircuitBreaker::CircuitBreaker(int failure_threshold, int timeout_ms) 
-    : state_(CLOSED), failure_count_(0), success_count_(0),
-      failure_threshold_(failure_threshold), timeout_ms_(timeout_ms) {}
+namespace {
+
+CircuitBreaker::Config legacy_config(int failure_threshold, int timeout_ms) {
+    CircuitBreaker::Config config;
+    config.minimum_calls = static_cast<size_t>(std::max(1, failure_threshold));
+    config.window_size = std::max<size_t>(config.minimum_calls * 4, 20);
+    config.open_timeout_ms = timeout_ms;
+    config.half_open_probes = 1;
+    return config;
+}
+
+int64_t now_ticks() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+}
+
+CircuitBreaker::CircuitBreaker(const Config& config)
+    : config_(config), window_(new std::atomic<uint64_t>[std::max<size_t>(1, config.window_size)]) {
+    for (size_t i = 0; i < std::max<size_t>(1, config_.window_size); ++i) window_[i].store(0);
+}
+
+CircuitBreaker::CircuitBreaker(int failure_threshold, int timeout_ms)
+    : CircuitBreaker(legacy_config(failure_threshold, timeout_ms)) {}
 
 bool CircuitBreaker::allow_request() {
-    State current_state = state_.load();
+    State current_state = state_.load(std::memory_order_acquire);
+    if (current_state == CLOSED) return true;
     
-    switch (current_state) {
-        case CLOSED:
-            return true;
-            
-        case OPEN:
-            if (is_timeout_expired()) {
-                transition_to_half_open();
-                return true;
-            }
-            return false;
-            
-        case HALF_OPEN:
+    if (current_state == OPEN) {
+        if (!is_timeout_expired()) return false;
+        // The thread that moves the breaker to HALF_OPEN takes the first
+        // probe; the others compete for the rest below
+        State expected = OPEN;
+        if (state_.compare_exchange_strong(expected, HALF_OPEN)) {
+            opened_at_.store(now_ticks(), std::memory_order_relaxed);
+            probe_successes_ = 0;
+            probe_permits_ = config_.half_open_probes - 1;
+            LOG_INFO("CircuitBreaker", "State: OPEN -> HALF_OPEN (timeout expired)");
             return true;
-            
-        default:
-            return false;
+        }
+        if (expected != HALF_OPEN) return expected == CLOSED;
     }
+    if (probe_permits_.fetch_sub(1, std::memory_order_relaxed) > 0) return true;
+    
+    // Probes that never report back must not pin the breaker half open:
+    // with no verdict for another open_timeout_ms, one caller re-arms them
+    int64_t since = opened_at_.load(std::memory_order_relaxed);
+    if (!is_timeout_expired() || !opened_at_.compare_exchange_strong(since, now_ticks())) return false;
+    State now_state = state_.load(std::memory_order_acquire);
+    if (now_state != HALF_OPEN) return now_state == CLOSED;
+    probe_successes_ = 0;
+    probe_permits_ = config_.half_open_probes - 1;
+    LOG_INFO("CircuitBreaker", "Re-arming HALF_OPEN probes (no verdict within timeout)");
+    return true;
 }
 
-void CircuitBreaker::record_success() {
-    success_count_++;
+void CircuitBreaker::record(bool success, std::chrono::microseconds latency) {
+    bool slow = config_.slow_call_ms > 0 && latency >= std::chrono::milliseconds(config_.slow_call_ms);
+    State current_state = state_.load(std::memory_order_acquire);
     
-    if (state_ == HALF_OPEN) {
-        transition_to_closed();
+    if (current_state == HALF_OPEN) {
+        if (!success || slow) {
+            trip(HALF_OPEN, success ? "slow probe" : "probe failed");
+        } else if (probe_successes_.fetch_add(1) + 1 == std::max(1, config_.half_open_probes)) {
+            // Only the probe that completes the quota gets here. The window is
+            // cleared before CLOSED is published: HALF_OPEN records never
+            // touch it, so no CLOSED record can land in it and be zeroed.
+            reset_window();
+            State expected = HALF_OPEN;
+            if (state_.compare_exchange_strong(expected, CLOSED)) {
+                LOG_INFO("CircuitBreaker", "State: HALF_OPEN -> CLOSED (probes succeeded)");
+            }
+        }
+        return;
     }
-}
-
-void CircuitBreaker::record_failure() {
-    failure_count_++;
-    last_failure_time_ = std::chrono::steady_clock::now();
+    if (current_state == OPEN) return;  // Late replies from before the trip
     
-    if (state_ == CLOSED && failure_count_ >= failure_threshold_) {
-        transition_to_open();
-    } else if (state_ == HALF_OPEN) {
-        transition_to_open();
+    uint64_t slot = RECORDED | (success ? 0 : FAILED) | (slow ? SLOW : 0) |
+                    (static_cast<uint64_t>(std::min<int64_t>(latency.count(), UINT32_MAX)) << 8);
+    size_t size = std::max<size_t>(1, config_.window_size);
+    uint64_t evicted = window_[next_slot_.fetch_add(1, std::memory_order_relaxed) % size]
+                           .exchange(slot, std::memory_order_relaxed);
+    
+    // Totals move by the difference between the new and the evicted slot
+    int calls = calls_.fetch_add(!(evicted & RECORDED), std::memory_order_relaxed) + !(evicted & RECORDED);
+    int failures = failures_.fetch_add(!success - !!(evicted & FAILED), std::memory_order_relaxed) +
+                   !success - !!(evicted & FAILED);
+    int slow_calls = slow_calls_.fetch_add(slow - !!(evicted & SLOW), std::memory_order_relaxed) +
+                     slow - !!(evicted & SLOW);
+    
+    if (static_cast<size_t>(calls) < config_.minimum_calls) return;
+    if (failures >= config_.failure_rate_threshold * calls) {
+        trip(CLOSED, "failure rate");
+    } else if (config_.slow_call_ms > 0 && slow_calls >= config_.slow_call_rate_threshold * calls) {
+        trip(CLOSED, "slow call rate");
     }
 }
 
-void CircuitBreaker::transition_to_open() {
-    state_ = OPEN;
-    std::cout << "[CircuitBreaker] State: CLOSED -> OPEN (failures: " 
-              << failure_count_ << ")\n";
+std::optional<std::chrono::microseconds> CircuitBreaker::latency_percentile(double q, size_t min_samples) const {
+    size_t size = std::max<size_t>(1, config_.window_size);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t slot = window_[i].load(std::memory_order_relaxed);
+        if ((slot & RECORDED) && !(slot & FAILED)) latencies.push_back(slot >> 8);
+    }
+    if (latencies.empty() || latencies.size() < min_samples) return std::nullopt;
+    
+    // Nearest rank
+    double position = std::ceil(std::clamp(q, 0.0, 1.0) * latencies.size());
+    size_t rank = std::min(latencies.size(), std::max<size_t>(1, static_cast<size_t>(position))) - 1;
+    std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+    return std::chrono::microseconds(latencies[rank]);
 }
 
-void CircuitBreaker::transition_to_half_open() {
-    state_ = HALF_OPEN;
-    std::cout << "[CircuitBreaker] State: OPEN -> HALF_OPEN (timeout expired)\n";
+void CircuitBreaker::trip(State from, const char* reason) {
+    opened_at_.store(now_ticks(), std::memory_order_relaxed);
+    if (!state_.compare_exchange_strong(from, OPEN)) return;
+    LOG_WARN("CircuitBreaker", "State: " << (from == CLOSED ? "CLOSED" : "HALF_OPEN") << " -> OPEN ("
+                               << reason << ", failures: " << failures_ << "/" << calls_ << ")");
 }
 
-void CircuitBreaker::transition_to_closed() {
-    state_ = CLOSED;
-    failure_count_ = 0;
-    std::cout << "[CircuitBreaker] State: HALF_OPEN -> CLOSED (success recorded)\n";
+void CircuitBreaker::reset_window() {
+    for (size_t i = 0; i < std::max<size_t>(1, config_.window_size); ++i) {
+        window_[i].store(0, std::memory_order_relaxed);
+    }
+    calls_ = 0;
+    failures_ = 0;
+    slow_calls_ = 0;
 }
 
 bool CircuitBreaker::is_timeout_expired() const {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - last_failure_time_).count();
-    return elapsed >= timeout_ms_;
+    auto opened = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(opened_at_.load(std::memory_order_relaxed)));
+    return std::chrono::steady_clock::now() - opened >= std::chrono::milliseconds(config_.open_timeout_ms);
 }
 
 std::string CircuitBreaker::get_state_string() const {
-    switch (state_) {
+    switch (get_state()) {
         case CLOSED: return "CLOSED";
         case OPEN: return "OPEN"; 
         case HALF_OPEN: return "HALF_OPEN";
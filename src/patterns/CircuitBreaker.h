@@ -1,33 +1,75 @@
 #pragma once
 #include <chrono>
 #include <atomic>
+#include <memory>
+#include <optional>
 #include <string>
+#include <cstdint>
 
+// Breaker over a sliding window of the last window_size calls. It opens
+// when, with at least minimum_calls in the window, the failure rate or the
+// rate of calls slower than slow_call_ms reaches its threshold; after
+// open_timeout_ms it lets half_open_probes trial calls through, and closes
+// once all of them succeed or reopens on the first bad one. Probes still
+// without a verdict another open_timeout_ms later are handed out again.
+//
+// The window is a ring of packed outcome slots written with one atomic
+// exchange, with running totals kept alongside, so recording never locks.
+// allow_request() is a single atomic load while CLOSED.
 class CircuitBreaker {
 public:
     enum State { CLOSED, OPEN, HALF_OPEN };
     
+    struct Config {
+        size_t window_size = 100;
+        size_t minimum_calls = 20;
+        double failure_rate_threshold = 0.5;
+        int slow_call_ms = 0;  // 0 disables the slow-call rule
+        double slow_call_rate_threshold = 1.0;
+        int open_timeout_ms = 30000;
+        int half_open_probes = 3;
+    };
+    
+    explicit CircuitBreaker(const Config& config);
+    // Opens once failure_threshold calls have been made and at least half
+    // of the recent ones failed; one probe when half open
     CircuitBreaker(int failure_threshold, int timeout_ms);
     
     bool allow_request();
-    void record_success();
-    void record_failure();
+    void record_success() { record(true, std::chrono::microseconds(0)); }
+    void record_failure() { record(false, std::chrono::microseconds(0)); }
+    void record(bool success, std::chrono::microseconds latency);
     
-    State get_state() const { return state_; }
+    State get_state() const { return state_.load(std::memory_order_acquire); }
     std::string get_state_string() const;
-    int get_failure_count() const { return failure_count_; }
+    // Failures, slow calls and calls currently in the window
+    int get_failure_count() const { return failures_.load(std::memory_order_relaxed); }
+    int get_slow_call_count() const { return slow_calls_.load(std::memory_order_relaxed); }
+    int get_call_count() const { return calls_.load(std::memory_order_relaxed); }
+    // Latency at quantile q (0..1) over the successful calls in the window;
+    // nullopt until there are min_samples of them
+    std::optional<std::chrono::microseconds> latency_percentile(double q, size_t min_samples = 1) const;
+    const Config& config() const { return config_; }
     
 private:
-    std::atomic<State> state_;
-    std::atomic<int> failure_count_;
-    std::atomic<int> success_count_;
+    // Slot layout: latency in microseconds above bit 8, outcome flags below
+    static constexpr uint64_t RECORDED = 1;
+    static constexpr uint64_t FAILED = 2;
+    static constexpr uint64_t SLOW = 4;
+    
+    const Config config_;
+    std::atomic<State> state_{CLOSED};
+    std::unique_ptr<std::atomic<uint64_t>[]> window_;
+    std::atomic<uint64_t> next_slot_{0};
+    std::atomic<int> calls_{0};
+    std::atomic<int> failures_{0};
+    std::atomic<int> slow_calls_{0};
     
-    const int failure_threshold_;
-    const int timeout_ms_;
-    std::chrono::steady_clock::time_point last_failure_time_;
+    std::atomic<int64_t> opened_at_{0};  // steady_clock ticks
+    std::atomic<int> probe_permits_{0};
+    std::atomic<int> probe_successes_{0};
     
-    void transition_to_open();
-    void transition_to_half_open(); 
-    void transition_to_closed();
+    void trip(State from, const char* reason);
+    void reset_window();
     bool is_timeout_expired() const;
-};
\ No newline at end of file
+};
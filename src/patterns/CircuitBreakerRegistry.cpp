@@ -0,0 +1,29 @@
+#include "CircuitBreakerRegistry.h"
+#include <mutex>
+
+CircuitBreakerRegistry::CircuitBreakerRegistry(const CircuitBreaker::Config& config) : config_(config) {}
+
+std::shared_ptr<CircuitBreaker> CircuitBreakerRegistry::get(const std::string& name) {
+    {
+        std::shared_lock lock(mutex_);
+        auto it = breakers_.find(name);
+        if (it != breakers_.end()) return it->second;
+    }
+    std::unique_lock lock(mutex_);
+    auto& breaker = breakers_[name];
+    if (!breaker) breaker = std::make_shared<CircuitBreaker>(config_);
+    return breaker;
+}
+
+std::vector<std::pair<std::string, CircuitBreaker::State>> CircuitBreakerRegistry::states() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::pair<std::string, CircuitBreaker::State>> states;
+    for (const auto& [name, breaker] : breakers_) states.emplace_back(name, breaker->get_state());
+    return states;
+}
+
+size_t CircuitBreakerRegistry::open_count() const {
+    size_t open = 0;
+    for (const auto& [name, state] : states()) open += state != CircuitBreaker::CLOSED;
+    return open;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "CircuitBreaker.h"
+
+// Breakers keyed by name, one per peer node, created on first use from a
+// shared config. A flaky peer trips only its own breaker, so calls to the
+// others and local traffic are unaffected.
+class CircuitBreakerRegistry {
+public:
+    explicit CircuitBreakerRegistry(const CircuitBreaker::Config& config);
+    
+    // Shared so callers can hold it without keeping the registry locked
+    std::shared_ptr<CircuitBreaker> get(const std::string& name);
+    std::vector<std::pair<std::string, CircuitBreaker::State>> states() const;
+    size_t open_count() const;
+    
+private:
+    CircuitBreaker::Config config_;
+    std::unordered_map<std::string, std::shared_ptr<CircuitBreaker>> breakers_;
+    mutable std::shared_mutex mutex_;
+};
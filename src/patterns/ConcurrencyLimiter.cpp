@@ -0,0 +1,59 @@
+#include "ConcurrencyLimiter.h"
+#include <algorithm>
+#include <cmath>
+
+ConcurrencyLimiter::ConcurrencyLimiter() : ConcurrencyLimiter(Config{}) {}
+
+ConcurrencyLimiter::ConcurrencyLimiter(const Config& config)
+    : config_(config), limit_(config.initial_limit), estimated_limit_(config.initial_limit) {}
+
+bool ConcurrencyLimiter::try_acquire(Priority priority) {
+    int cap = limit_.load(std::memory_order_relaxed);
+    if (priority == Priority::BACKGROUND) {
+        cap = std::max(1, static_cast<int>(cap * config_.background_share));
+    }
+    
+    int current = in_flight_.load(std::memory_order_relaxed);
+    do {
+        if (current >= cap) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!in_flight_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+    return true;
+}
+
+void ConcurrencyLimiter::release(std::chrono::nanoseconds rtt, bool dropped) {
+    int in_flight = in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(update_mutex_, std::try_to_lock);
+    if (lock.owns_lock()) update(rtt.count() / 1000.0, dropped, in_flight);
+}
+
+void ConcurrencyLimiter::update(double rtt_us, bool dropped, int in_flight) {
+    if (dropped) {
+        // Timeouts and overload errors back off multiplicatively
+        estimated_limit_ = std::max<double>(config_.min_limit, estimated_limit_ * 0.9);
+        limit_.store(static_cast<int>(estimated_limit_), std::memory_order_relaxed);
+        return;
+    }
+    
+    rtt_us = std::max(rtt_us, 1.0);
+    if (long_rtt_ == 0.0) {
+        short_rtt_ = long_rtt_ = rtt_us;
+    }
+    short_rtt_ += (rtt_us - short_rtt_) * 0.1;
+    long_rtt_ += (rtt_us - long_rtt_) / config_.long_window;
+    // A long-term average far above recent RTTs is stale (load dropped);
+    // let it catch up faster so it does not license unbounded growth
+    if (long_rtt_ > 2.0 * short_rtt_) long_rtt_ *= 0.95;
+    
+    // Not using most of the limit: no evidence it could go higher
+    if (in_flight < estimated_limit_ / 2) return;
+    
+    double gradient = std::clamp(config_.rtt_tolerance * long_rtt_ / short_rtt_, 0.5, 1.0);
+    double target = estimated_limit_ * gradient + std::sqrt(estimated_limit_);
+    estimated_limit_ = std::clamp(estimated_limit_ * (1.0 - config_.smoothing) + target * config_.smoothing,
+                                  static_cast<double>(config_.min_limit),
+                                  static_cast<double>(config_.max_limit));
+    limit_.store(static_cast<int>(estimated_limit_), std::memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+// Adaptive cap on requests in flight, following the gradient of measured
+// latency (in the style of Netflix's Gradient2): while the recent RTT stays
+// near the long-term RTT the limit grows by about sqrt(limit) per update,
+// and as queueing inflates the recent RTT the limit shrinks in proportion.
+// Requests beyond the limit are turned away at once instead of queueing,
+// so the ones admitted still finish quickly.
+//
+// BACKGROUND work (replication catch-up, migration, repair, snapshots) is
+// admitted only while in-flight requests stay below background_share of
+// the limit, leaving the rest for client traffic.
+class ConcurrencyLimiter {
+public:
+    enum class Priority { CLIENT, BACKGROUND };
+    
+    struct Config {
+        int initial_limit = 64;
+        int min_limit = 8;
+        int max_limit = 1024;
+        double smoothing = 0.2;       // Weight of each update
+        double rtt_tolerance = 1.5;   // Recent/long-term RTT ratio tolerated before shrinking
+        int long_window = 500;        // Samples averaged into the long-term RTT
+        double background_share = 0.5;
+    };
+    
+    ConcurrencyLimiter();
+    explicit ConcurrencyLimiter(const Config& config);
+    
+    // Admits one request, or false if the limit is reached
+    bool try_acquire(Priority priority = Priority::CLIENT);
+    // Ends an admitted request; dropped marks a timeout or overload error
+    void release(std::chrono::nanoseconds rtt, bool dropped = false);
+    // Ends an admitted request without using it as a sample
+    void cancel() { in_flight_.fetch_sub(1, std::memory_order_relaxed); }
+    
+    int limit() const { return limit_.load(std::memory_order_relaxed); }
+    int in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+    size_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+    
+private:
+    Config config_;
+    std::atomic<int> limit_;
+    std::atomic<int> in_flight_{0};
+    std::atomic<size_t> rejected_{0};
+    
+    // Updated by one releasing thread at a time; the others skip the update
+    std::mutex update_mutex_;
+    double estimated_limit_;
+    double short_rtt_ = 0.0;
+    double long_rtt_ = 0.0;
+    
+    void update(double rtt_us, bool dropped, int in_flight);
+};
@@ -0,0 +1,33 @@
+#include "RetryBudget.h"
+#include <algorithm>
+
+RetryBudget::RetryBudget(double ratio, double max_balance)
+    : deposit_(static_cast<int64_t>(std::max(ratio, 0.0) * UNIT)),
+      max_balance_(static_cast<int64_t>(std::max(max_balance, 1.0) * UNIT)),
+      balance_(max_balance_) {}
+
+void RetryBudget::deposit() {
+    // Overshoots the cap by at most one deposit per racing thread; the next
+    // spend or deposit settles it
+    int64_t balance = balance_.fetch_add(deposit_, std::memory_order_relaxed) + deposit_;
+    if (balance > max_balance_) {
+        balance_.compare_exchange_strong(balance, max_balance_, std::memory_order_relaxed);
+    }
+}
+
+bool RetryBudget::try_spend() {
+    int64_t balance = balance_.load(std::memory_order_relaxed);
+    do {
+        if (balance < UNIT) {
+            refused_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!balance_.compare_exchange_weak(balance, std::min(balance, max_balance_) - UNIT,
+                                             std::memory_order_relaxed));
+    spent_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+double RetryBudget::balance() const {
+    return static_cast<double>(std::min(balance_.load(std::memory_order_relaxed), max_balance_)) / UNIT;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Caps retries and hedges at a fraction of regular traffic. Each request
+// deposits ratio of a token; each retry spends a whole one. The balance
+// is capped at max_balance, so a quiet period cannot save up a retry
+// storm. Lock-free: deposits are one fetch_add, spending is one CAS.
+class RetryBudget {
+public:
+    explicit RetryBudget(double ratio = 0.1, double max_balance = 10.0);
+    
+    void deposit();
+    bool try_spend();
+    double balance() const;
+    uint64_t spent() const { return spent_.load(std::memory_order_relaxed); }
+    uint64_t refused() const { return refused_.load(std::memory_order_relaxed); }
+    
+private:
+    // Tokens are kept in thousandths so the ratio stays integral
+    static constexpr int64_t UNIT = 1000;
+    
+    int64_t deposit_;
+    int64_t max_balance_;
+    std::atomic<int64_t> balance_;
+    std::atomic<uint64_t> spent_{0};
+    std::atomic<uint64_t> refused_{0};
+};
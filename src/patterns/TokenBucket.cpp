@@ -0,0 +1,41 @@
+#include "TokenBucket.h"
+#include <algorithm>
+#include <limits>
+
+TokenBucket::TokenBucket(double rate, double burst)
+    : interval_ns_(rate > 0 ? 1e9 / rate : 0.0), burst_ns_(rate > 0 ? std::max(burst, 1.0) * 1e9 / rate : 0.0) {}
+
+int64_t TokenBucket::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::chrono::nanoseconds TokenBucket::consume(double n) {
+    if (unlimited()) return std::chrono::nanoseconds(0);
+    int64_t now = now_ns();
+    int64_t full_at = full_at_.load(std::memory_order_relaxed);
+    int64_t next;
+    do {
+        next = std::max(full_at, now) + static_cast<int64_t>(n * interval_ns_);
+    } while (!full_at_.compare_exchange_weak(full_at, next, std::memory_order_relaxed));
+    // Past the burst the caller is in debt until the excess has refilled
+    return std::chrono::nanoseconds(std::max<int64_t>(0, next - now - static_cast<int64_t>(burst_ns_)));
+}
+
+bool TokenBucket::try_consume(double n) {
+    if (unlimited()) return true;
+    int64_t now = now_ns();
+    int64_t full_at = full_at_.load(std::memory_order_relaxed);
+    int64_t next;
+    do {
+        next = std::max(full_at, now) + static_cast<int64_t>(n * interval_ns_);
+        if (next - now > static_cast<int64_t>(burst_ns_)) return false;
+    } while (!full_at_.compare_exchange_weak(full_at, next, std::memory_order_relaxed));
+    return true;
+}
+
+double TokenBucket::available() const {
+    if (unlimited()) return std::numeric_limits<double>::infinity();
+    int64_t used = std::max<int64_t>(0, full_at_.load(std::memory_order_relaxed) - now_ns());
+    return (burst_ns_ - used) / interval_ns_;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Token bucket kept as a single timestamp (GCRA form): the time at which
+// the bucket would be full again if nothing else were taken. Refill is
+// implied by the clock, so there is no refill thread, and every operation
+// is one CAS, so buckets shared between connections need no lock.
+class TokenBucket {
+public:
+    // Unlimited
+    TokenBucket() = default;
+    // rate tokens per second, holding at most burst tokens; rate <= 0 means
+    // unlimited
+    TokenBucket(double rate, double burst);
+    
+    // Takes n tokens, borrowing from the future if the bucket runs dry, and
+    // returns how long the caller should pause before taking more
+    std::chrono::nanoseconds consume(double n);
+    // Takes n tokens only if they are all there
+    bool try_consume(double n);
+    double available() const;
+    bool unlimited() const { return interval_ns_ <= 0.0; }
+    
+private:
+    double interval_ns_ = 0.0;  // Per token
+    double burst_ns_ = 0.0;     // Burst expressed in time
+    std::atomic<int64_t> full_at_{0};
+    
+    static int64_t now_ns();
+};
@@ -1,90 +1,230 @@
 #include "LRUCache.h"
 #include <iostream>
+#include <functional>
+#include <algorithm>
 
-LRUCache::LRUCache(size_t capacity) : capacity_(capacity) {}
+LRUCache::LRUCache(size_t capacity, size_t num_shards) : capacity_(capacity) {
+    if (num_shards == 0) num_shards = 1;
+
+    // Spread the capacity so the shard totals add up to the configured limit
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->capacity = capacity / num_shards + (i < capacity % num_shards ? 1 : 0);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+size_t LRUCache::shard_for(const std::string& key) const {
+    if (shards_.size() == 1) return 0;
+    return std::hash<std::string>{}(key) % shards_.size();
+}
 
 bool LRUCache::get(const std::string& key, std::string& value) {
-    std::shared_lock lock(mtx_);
-    
-    auto it = cache_.find(key);
-    if (it == cache_.end()) {
+    Shard& shard = shard_of(key);
+    // Exclusive lock: a hit moves the key to the front of the LRU list
+    std::unique_lock lock(shard.mtx);
+
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() && promote_locked(shard, key)) {
+        it = shard.cache.find(key);
+    }
+    if (it == shard.cache.end()) {
         misses_++;
         return false;
     }
-    
+
     if (is_expired(it->second)) {
+        erase_locked(shard, it);
         misses_++;
         return false;
     }
-    
-    // Update access time for LRU
-    it->second.access_time = std::chrono::steady_clock::now();
+
+    update_lru_on_access(shard, it->second);
     value = it->second.value;
     hits_++;
     return true;
 }
 
-void LRUCache::set(const std::string& key, const std::string& value, int ttl_seconds) {
-    std::unique_lock lock(mtx_);
-    
-    auto now = std::chrono::steady_clock::now();
-    Entry entry{
-        value,
-        ttl_seconds > 0 ? now + std::chrono::seconds(ttl_seconds) : now + std::chrono::hours(24),
-        now
-    };
-    
-    // Remove from LRU if exists
-    if (lru_map_.count(key)) {
-        lru_.erase(lru_map_[key]);
-    }
-    
-    cache_[key] = entry;
-    lru_.push_front(key);
-    lru_map_[key] = lru_.begin();
-    
-    // Evict if over capacity
-    while (cache_.size() > capacity_) {
-        evict_lru();
+void LRUCache::set(const std::string& key, const std::string& value, int ttl_seconds,
+                   const Journal& journal) {
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+    mark_written(shard, key);
+    forget_warm_copy(key);
+    insert_locked(shard, key, value, ttl_seconds);
+    if (journal) journal();
+}
+
+bool LRUCache::set_if_not_exists(const std::string& key, const std::string& value, int ttl_seconds) {
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() && promote_locked(shard, key)) {
+        return false;
+    }
+    if (it != shard.cache.end() && !is_expired(it->second)) {
+        return false;
+    }
+
+    mark_written(shard, key);
+    forget_warm_copy(key);
+    insert_locked(shard, key, value, ttl_seconds);
+    return true;
+}
+
+bool LRUCache::del(const std::string& key, const Journal& journal) {
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+    mark_written(shard, key);
+
+    // A copy still waiting in the warm source counts as present
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() && promote_locked(shard, key)) {
+        it = shard.cache.find(key);
+    }
+    forget_warm_copy(key);
+
+    bool existed = false;
+    if (it != shard.cache.end()) {
+        existed = !is_expired(it->second);
+        erase_locked(shard, it);
+    }
+    if (journal) journal();
+    return existed;
+}
+
+bool LRUCache::get_versioned(const std::string& key, std::string& value, uint64_t& version,
+                             int* ttl_seconds) {
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() && promote_locked(shard, key)) {
+        it = shard.cache.find(key);
+    }
+    if (it == shard.cache.end() || is_expired(it->second)) {
+        if (it != shard.cache.end()) erase_locked(shard, it);
+        misses_++;
+        return false;
+    }
+
+    update_lru_on_access(shard, it->second);
+    value = it->second.value;
+    version = it->second.version;
+    if (ttl_seconds) *ttl_seconds = remaining_ttl(it->second);
+    hits_++;
+    return true;
+}
+
+bool LRUCache::set_versioned(const std::string& key, const std::string& value, uint64_t version,
+                             int ttl_seconds, const Journal& journal) {
+    observe_version(version);
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() && promote_locked(shard, key)) {
+        it = shard.cache.find(key);
     }
+    if (it != shard.cache.end() && !is_expired(it->second)) {
+        const Entry& stored = it->second;
+        if (stored.version > version || (stored.version == version && stored.value >= value)) {
+            return false;
+        }
+    }
+
+    mark_written(shard, key);
+    forget_warm_copy(key);
+    insert_locked(shard, key, value, ttl_seconds, version);
+    if (journal) journal();
+    return true;
 }
 
-void LRUCache::del(const std::string& key) {
-    std::unique_lock lock(mtx_);
-    
-    if (cache_.count(key)) {
-        lru_.erase(lru_map_[key]);
-        lru_map_.erase(key);
-        cache_.erase(key);
+bool LRUCache::del_versioned(const std::string& key, uint64_t version, const Journal& journal) {
+    observe_version(version);
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+
+    auto it = shard.cache.find(key);
+    if (it == shard.cache.end() && promote_locked(shard, key)) {
+        it = shard.cache.find(key);
+    }
+    if (it == shard.cache.end()) return false;
+    if (is_expired(it->second)) {
+        erase_locked(shard, it);
+        return false;
+    }
+    if (it->second.version > version) return false;
+
+    mark_written(shard, key);
+    forget_warm_copy(key);
+    erase_locked(shard, it);
+    if (journal) journal();
+    return true;
+}
+
+uint64_t LRUCache::next_version() {
+    uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t current = clock_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        next = std::max(current + 1, now);
+    } while (!clock_.compare_exchange_weak(current, next, std::memory_order_relaxed));
+    return next;
+}
+
+void LRUCache::observe_version(uint64_t version) {
+    uint64_t current = clock_.load(std::memory_order_relaxed);
+    while (current < version && !clock_.compare_exchange_weak(current, version, std::memory_order_relaxed)) {
     }
 }
 
 bool LRUCache::exists(const std::string& key) {
-    std::shared_lock lock(mtx_);
-    auto it = cache_.find(key);
-    return it != cache_.end() && !is_expired(it->second);
+    Shard& shard = shard_of(key);
+    if (has_warm_source()) {
+        std::unique_lock lock(shard.mtx);
+        auto it = shard.cache.find(key);
+        if (it == shard.cache.end() && promote_locked(shard, key)) {
+            return true;
+        }
+        return it != shard.cache.end() && !is_expired(it->second);
+    }
+
+    std::shared_lock lock(shard.mtx);
+    auto it = shard.cache.find(key);
+    return it != shard.cache.end() && !is_expired(it->second);
 }
 
 void LRUCache::cleanup_expired() {
-    std::unique_lock lock(mtx_);
-    
-    auto now = std::chrono::steady_clock::now();
-    auto it = cache_.begin();
-    
-    while (it != cache_.end()) {
-        if (it->second.expire_time < now) {
-            lru_.erase(lru_map_[it->first]);
-            lru_map_.erase(it->first);
-            it = cache_.erase(it);
-        } else {
-            ++it;
+    for (auto& shard_ptr : shards_) {
+        Shard& shard = *shard_ptr;
+        std::unique_lock lock(shard.mtx);
+
+        auto now = std::chrono::steady_clock::now();
+        auto it = shard.cache.begin();
+
+        while (it != shard.cache.end()) {
+            if (it->second.expire_time < now) {
+                auto next = std::next(it);
+                erase_locked(shard, it);
+                it = next;
+            } else {
+                ++it;
+            }
         }
     }
 }
 
 size_t LRUCache::size() const {
-    std::shared_lock lock(mtx_);
-    return cache_.size();
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock lock(shard->mtx);
+        total += shard->cache.size();
+    }
+    return total;
 }
 
 double LRUCache::hit_rate() const {
@@ -94,15 +234,252 @@ double LRUCache::hit_rate() const {
     return total > 0 ? (double)total_hits / total : 0.0;
 }
 
-void LRUCache::evict_lru() {
-    if (lru_.empty()) return;
-    
-    std::string old_key = lru_.back();
-    lru_.pop_back();
-    cache_.erase(old_key);
-    lru_map_.erase(old_key);
+void LRUCache::reset_stats() {
+    hits_ = 0;
+    misses_ = 0;
+}
+
+std::vector<std::string> LRUCache::get_all_keys() const {
+    std::vector<std::string> keys;
+    for (const auto& shard : shards_) {
+        std::shared_lock lock(shard->mtx);
+        for (const auto& [key, entry] : shard->cache) {
+            if (!is_expired(entry)) keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+void LRUCache::clear() {
+    for (auto& shard : shards_) {
+        std::unique_lock lock(shard->mtx);
+        for (const auto& [key, entry] : shard->cache) {
+            mark_dirty(*shard, key);
+            for (auto* listener : listeners_) listener->on_erase(key, entry.value);
+        }
+        shard->cache.clear();
+        shard->lru.clear();
+    }
+}
+
+std::vector<std::pair<std::string, std::string>> LRUCache::snapshot_shard(size_t index) const {
+    std::vector<std::pair<std::string, std::string>> entries;
+    if (index >= shards_.size()) return entries;
+
+    const Shard& shard = *shards_[index];
+    std::shared_lock lock(shard.mtx);
+
+    entries.reserve(shard.cache.size());
+    for (const auto& [key, entry] : shard.cache) {
+        if (!is_expired(entry)) {
+            entries.emplace_back(key, entry.value);
+        }
+    }
+    return entries;
+}
+
+std::vector<LRUCache::VersionedEntry> LRUCache::snapshot_shard_versioned(size_t index) const {
+    std::vector<VersionedEntry> entries;
+    if (index >= shards_.size()) return entries;
+
+    const Shard& shard = *shards_[index];
+    std::shared_lock lock(shard.mtx);
+
+    entries.reserve(shard.cache.size());
+    for (const auto& [key, entry] : shard.cache) {
+        if (!is_expired(entry)) {
+            entries.push_back({key, entry.value, entry.version, remaining_ttl(entry)});
+        }
+    }
+    return entries;
+}
+
+std::vector<std::pair<std::string, std::string>> LRUCache::checkpoint_shard(size_t index) {
+    std::vector<std::pair<std::string, std::string>> entries;
+    if (index >= shards_.size()) return entries;
+
+    Shard& shard = *shards_[index];
+    std::unique_lock lock(shard.mtx);
+
+    entries.reserve(shard.cache.size());
+    for (const auto& [key, entry] : shard.cache) {
+        if (!is_expired(entry)) {
+            entries.emplace_back(key, entry.value);
+        }
+    }
+    shard.dirty.clear();
+    return entries;
+}
+
+std::vector<std::pair<std::string, std::optional<std::string>>> LRUCache::drain_dirty_shard(size_t index) {
+    std::vector<std::pair<std::string, std::optional<std::string>>> changes;
+    if (index >= shards_.size()) return changes;
+
+    Shard& shard = *shards_[index];
+    std::unique_lock lock(shard.mtx);
+
+    changes.reserve(shard.dirty.size());
+    for (const auto& key : shard.dirty) {
+        auto it = shard.cache.find(key);
+        if (it != shard.cache.end() && !is_expired(it->second)) {
+            changes.emplace_back(key, it->second.value);
+        } else {
+            changes.emplace_back(key, std::nullopt);
+        }
+    }
+    shard.dirty.clear();
+    return changes;
+}
+
+void LRUCache::attach_warm_source(std::shared_ptr<WarmSource> source) {
+    detach_warm_source();
+    warm_owner_ = std::move(source);
+    warm_source_.store(warm_owner_.get(), std::memory_order_release);
+}
+
+void LRUCache::detach_warm_source() {
+    if (!warm_source_.exchange(nullptr)) return;
+
+    // The source is only used under a shard lock; once every shard has been
+    // locked after the swap nobody can still be holding it
+    for (auto& shard : shards_) {
+        std::unique_lock lock(shard->mtx);
+    }
+    warm_owner_.reset();
+}
+
+void LRUCache::end_replay() {
+    replaying_ = false;
+    for (auto& shard : shards_) {
+        std::unique_lock lock(shard->mtx);
+        shard->written.clear();
+    }
+}
+
+bool LRUCache::replay_set(const std::string& key, const std::string& value, uint64_t version,
+                          int ttl_seconds) {
+    if (version) observe_version(version);
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+    if (shard.written.count(key)) return false;
+    forget_warm_copy(key);
+    insert_locked(shard, key, value, ttl_seconds, version);
+    return true;
+}
+
+bool LRUCache::replay_del(const std::string& key) {
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+    if (shard.written.count(key)) return false;
+    forget_warm_copy(key);
+
+    auto it = shard.cache.find(key);
+    if (it != shard.cache.end()) {
+        erase_locked(shard, it);
+    }
+    return true;
+}
+
+bool LRUCache::promote(const std::string& key) {
+    Shard& shard = shard_of(key);
+    std::unique_lock lock(shard.mtx);
+    if (shard.cache.count(key)) return false;
+    return promote_locked(shard, key);
+}
+
+bool LRUCache::promote_locked(Shard& shard, const std::string& key) {
+    WarmSource* source = warm_source_.load(std::memory_order_acquire);
+    if (!source) return false;
+
+    std::string value;
+    if (!source->claim(key, value)) return false;
+
+    insert_locked(shard, key, value, -1);
+    return true;
+}
+
+void LRUCache::forget_warm_copy(const std::string& key) {
+    if (WarmSource* source = warm_source_.load(std::memory_order_acquire)) {
+        source->forget(key);
+    }
+}
+
+void LRUCache::insert_locked(Shard& shard, const std::string& key, const std::string& value,
+                             int ttl_seconds, uint64_t version) {
+    // Plain writes take the same hybrid clock as coordinated ones, so a
+    // direct write orders after a hint or quorum write made before it
+    if (version == 0) version = next_version();
+    auto now = std::chrono::steady_clock::now();
+    auto expire_time = ttl_seconds > 0 ? now + std::chrono::seconds(ttl_seconds)
+                                       : now + std::chrono::hours(24);
+
+    mark_dirty(shard, key);
+
+    auto it = shard.cache.find(key);
+    if (it != shard.cache.end()) {
+        for (auto* listener : listeners_) {
+            listener->on_set(key, &it->second.value, value, expire_time);
+        }
+        it->second.value = value;
+        it->second.expire_time = expire_time;
+        it->second.version = version;
+        update_lru_on_access(shard, it->second);
+        return;
+    }
+
+    for (auto* listener : listeners_) {
+        listener->on_set(key, nullptr, value, expire_time);
+    }
+    shard.lru.push_front(key);
+    shard.cache.emplace(key, Entry{value, expire_time, now, shard.lru.begin(), version});
+
+    // Evict if over capacity
+    while (shard.cache.size() > shard.capacity) {
+        evict_lru(shard);
+    }
+}
+
+void LRUCache::erase_locked(Shard& shard, std::unordered_map<std::string, Entry>::iterator it) {
+    mark_dirty(shard, it->first);
+    for (auto* listener : listeners_) listener->on_erase(it->first, it->second.value);
+    shard.lru.erase(it->second.lru_pos);
+    shard.cache.erase(it);
+}
+
+void LRUCache::evict_lru(Shard& shard) {
+    if (shard.lru.empty()) return;
+
+    auto it = shard.cache.find(shard.lru.back());
+    if (it != shard.cache.end()) {
+        erase_locked(shard, it);
+    } else {
+        shard.lru.pop_back();
+    }
 }
 
 bool LRUCache::is_expired(const Entry& entry) const {
     return entry.expire_time < std::chrono::steady_clock::now();
-}
\ No newline at end of file
+}
+
+int LRUCache::remaining_ttl(const Entry& entry) {
+    auto left = entry.expire_time - std::chrono::steady_clock::now();
+    auto seconds = std::chrono::ceil<std::chrono::seconds>(left).count();
+    return static_cast<int>(std::max<decltype(seconds)>(seconds, 1));
+}
+
+void LRUCache::update_lru_on_access(Shard& shard, Entry& entry) {
+    entry.access_time = std::chrono::steady_clock::now();
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_pos);
+}
+
+void LRUCache::mark_written(Shard& shard, const std::string& key) {
+    if (replaying_.load(std::memory_order_relaxed)) {
+        shard.written.insert(key);
+    }
+}
+
+void LRUCache::mark_dirty(Shard& shard, const std::string& key) {
+    if (track_dirty_.load(std::memory_order_relaxed)) {
+        shard.dirty.insert(key);
+    }
+}
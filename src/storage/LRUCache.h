@@ -1,5 +1,7 @@
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
+#include <optional>
 #include <list>
 #include <string>
 #include <mutex>
@@ -7,47 +9,170 @@
 #include <chrono>
 #include <atomic>
 #include <vector>
+#include <memory>
+#include <utility>
+#include <functional>
+
+// Read-through source consulted on misses during a warm start. Both calls
+// are made with the key's shard lock held.
+class WarmSource {
+public:
+    virtual ~WarmSource() = default;
+    // Hands out the stored value at most once; later calls for the key miss
+    virtual bool claim(const std::string& key, std::string& value) = 0;
+    // The key was written or deleted in memory, so the stored copy is stale
+    virtual void forget(const std::string& key) = 0;
+};
+
+// Observes every change to the cache contents, including evictions and
+// expiry. Called with the key's shard lock held, so it must not call back
+// into the cache.
+class CacheListener {
+public:
+    virtual ~CacheListener() = default;
+    virtual void on_set(const std::string& key, const std::string* old_value,
+                        const std::string& value,
+                        std::chrono::steady_clock::time_point expire_time) = 0;
+    virtual void on_erase(const std::string& key, const std::string& old_value) = 0;
+};
 
 class LRUCache {
 public:
-    explicit LRUCache(size_t capacity);
-    
+    // Keys are spread over num_shards independently locked shards; each shard
+    // evicts on its own share of the capacity.
+    explicit LRUCache(size_t capacity, size_t num_shards = 1);
+
+    // Runs under the key's shard lock right after a write is applied, so a
+    // log append made from it is ordered the same way as the writes to the key
+    using Journal = std::function<void()>;
+
     bool get(const std::string& key, std::string& value);
-    void set(const std::string& key, const std::string& value, int ttl_seconds = -1);
-    void del(const std::string& key);
+    void set(const std::string& key, const std::string& value, int ttl_seconds = -1,
+             const Journal& journal = nullptr);
+    // Returns whether the key was present
+    bool del(const std::string& key, const Journal& journal = nullptr);
     bool exists(const std::string& key);
     void cleanup_expired();
-    
+
     // Enhanced monitoring methods
     size_t size() const;
     size_t capacity() const { return capacity_; }
     double hit_rate() const;
+    size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    size_t misses() const { return misses_.load(std::memory_order_relaxed); }
     void reset_stats();
-    
+
     // Advanced operations
     std::vector<std::string> get_all_keys() const;
     void clear();
     bool set_if_not_exists(const std::string& key, const std::string& value, int ttl_seconds = -1);
-    
+
+    // Versioned access for quorum replication. Every entry carries a version
+    // from the cache's hybrid clock (next_version), plain writes included. set_versioned
+    // keeps whichever of the stored and given copies is newer (equal versions
+    // are ordered by value so every replica picks the same winner) and
+    // returns false if the stored one won. ttl_seconds, if given, receives
+    // the entry's remaining lifetime rounded up, so a copy made elsewhere
+    // expires when this one does.
+    bool get_versioned(const std::string& key, std::string& value, uint64_t& version,
+                       int* ttl_seconds = nullptr);
+    bool set_versioned(const std::string& key, const std::string& value, uint64_t version,
+                       int ttl_seconds = -1, const Journal& journal = nullptr);
+    // Versioned delete: removes the key unless the stored copy is newer than
+    // version. Returns whether a copy was removed; journal runs only then.
+    bool del_versioned(const std::string& key, uint64_t version, const Journal& journal = nullptr);
+    // Hybrid logical clock: above every version seen here and at least the
+    // wall clock in microseconds, so writes coordinated on different nodes
+    // order by time when clocks are close
+    uint64_t next_version();
+
+    // Shard access for snapshotting: copies one shard's live entries while
+    // holding only that shard's lock
+    size_t shard_count() const { return shards_.size(); }
+    size_t shard_for(const std::string& key) const;
+    std::vector<std::pair<std::string, std::string>> snapshot_shard(size_t index) const;
+    struct VersionedEntry {
+        std::string key;
+        std::string value;
+        uint64_t version;
+        int ttl_seconds;  // Remaining, as for get_versioned
+    };
+    // Same, with each entry's version and remaining lifetime
+    std::vector<VersionedEntry> snapshot_shard_versioned(size_t index) const;
+
+    // Dirty-key tracking for delta snapshots. checkpoint_shard copies a
+    // shard and resets its dirty set atomically; drain_dirty_shard returns
+    // keys touched since the last checkpoint/drain with their current value
+    // (nullopt if deleted, evicted or expired).
+    void enable_dirty_tracking() { track_dirty_ = true; }
+    bool dirty_tracking_enabled() const { return track_dirty_; }
+    std::vector<std::pair<std::string, std::string>> checkpoint_shard(size_t index);
+    std::vector<std::pair<std::string, std::optional<std::string>>> drain_dirty_shard(size_t index);
+
+    // Listeners must be registered before the cache is shared between threads
+    void add_listener(CacheListener* listener) { listeners_.push_back(listener); }
+
+    // Warm start: misses fall through to the source and are promoted into
+    // memory. detach_warm_source waits until no shard is still using it.
+    void attach_warm_source(std::shared_ptr<WarmSource> source);
+    void detach_warm_source();
+    bool has_warm_source() const { return warm_source_.load() != nullptr; }
+    bool promote(const std::string& key);
+
+    // Log replay behind live traffic: between begin_replay and end_replay,
+    // replay_set/replay_del skip keys that were written any other way since
+    // begin_replay, so an old record never overwrites a newer client write.
+    // Outside a replay they behave like set/del. Both return false if skipped.
+    // A non-zero version restores a logged quorum write's version, and
+    // ttl_seconds what was left of its TTL.
+    void begin_replay() { replaying_ = true; }
+    void end_replay();
+    bool replay_set(const std::string& key, const std::string& value, uint64_t version = 0,
+                    int ttl_seconds = -1);
+    bool replay_del(const std::string& key);
+
 private:
     struct Entry {
         std::string value;
         std::chrono::steady_clock::time_point expire_time;
         std::chrono::steady_clock::time_point access_time;
+        std::list<std::string>::iterator lru_pos;
+        uint64_t version;
+    };
+
+    struct Shard {
+        std::unordered_map<std::string, Entry> cache;
+        std::list<std::string> lru;
+        std::unordered_set<std::string> dirty;
+        std::unordered_set<std::string> written;  // Since begin_replay
+        size_t capacity = 0;
+        mutable std::shared_mutex mtx;
     };
-    
-    std::unordered_map<std::string, Entry> cache_;
-    std::list<std::string> lru_;
-    std::unordered_map<std::string, std::list<std::string>::iterator> lru_map_;
-    
+
+    std::vector<std::unique_ptr<Shard>> shards_;
     size_t capacity_;
-    mutable std::shared_mutex mtx_;
-    
+    std::atomic<bool> track_dirty_{false};
+    std::atomic<bool> replaying_{false};
+    std::vector<CacheListener*> listeners_;
+    std::shared_ptr<WarmSource> warm_owner_;
+    std::atomic<WarmSource*> warm_source_{nullptr};
+    std::atomic<uint64_t> clock_{0};
+
     // Statistics
     mutable std::atomic<size_t> hits_{0};
     mutable std::atomic<size_t> misses_{0};
-    
-    void evict_lru();
+
+    Shard& shard_of(const std::string& key) const { return *shards_[shard_for(key)]; }
+    void insert_locked(Shard& shard, const std::string& key, const std::string& value, int ttl_seconds,
+                       uint64_t version = 0);
+    void observe_version(uint64_t version);
+    void erase_locked(Shard& shard, std::unordered_map<std::string, Entry>::iterator it);
+    void evict_lru(Shard& shard);
     bool is_expired(const Entry& entry) const;
-    void update_lru_on_access(const std::string& key);
+    static int remaining_ttl(const Entry& entry);
+    void mark_dirty(Shard& shard, const std::string& key);
+    void mark_written(Shard& shard, const std::string& key);
+    bool promote_locked(Shard& shard, const std::string& key);
+    void forget_warm_copy(const std::string& key);
+    void update_lru_on_access(Shard& shard, Entry& entry);
 };
@@ -0,0 +1,143 @@
+#include "LazySnapshot.h"
+#include "monitoring/Logger.h"
+#include "MMapPersistence.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+constexpr char LazySnapshot::MAGIC[8];
+
+LazySnapshot::LazySnapshot(const std::string& filename)
+    : data_(filename, false), index_(filename + ".idx", false) {
+    if (!data_.is_open() || !index_.is_open() || index_.size() < sizeof(Header)) {
+        return;
+    }
+
+    Header header;
+    std::memcpy(&header, index_.data(), sizeof(Header));
+
+    // The index is only trusted for the exact snapshot it was written for
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.data_size != data_.size() ||
+        header.data_mtime != mtime_of(filename) ||
+        index_.size() != sizeof(Header) + header.count * sizeof(IndexEntry)) {
+        LOG_WARN("Persistence", "Snapshot index for " << filename << " is stale, ignoring");
+        return;
+    }
+
+    entries_ = reinterpret_cast<const IndexEntry*>(index_.data() + sizeof(Header));
+    count_ = header.count;
+    claimed_ = std::make_unique<std::atomic<bool>[]>(count_);
+    for (size_t i = 0; i < count_; ++i) {
+        claimed_[i].store(false, std::memory_order_relaxed);
+    }
+    valid_ = true;
+}
+
+bool LazySnapshot::claim(const std::string& key, std::string& value) {
+    size_t pos = find(key);
+    if (pos == count_ || claimed_[pos].exchange(true)) {
+        return false;
+    }
+
+    std::string stored_key;
+    return MMapPersistence::parse_entry(line_at(pos), stored_key, value);
+}
+
+void LazySnapshot::forget(const std::string& key) {
+    size_t pos = find(key);
+    if (pos != count_) {
+        claimed_[pos].store(true, std::memory_order_relaxed);
+    }
+}
+
+size_t LazySnapshot::load_remaining(LRUCache& cache) {
+    size_t promoted = 0;
+    for (size_t i = 0; i < count_; ++i) {
+        if (claimed_[i].load(std::memory_order_relaxed)) continue;
+
+        std::string_view line = line_at(i);
+        size_t space_pos = line.find(' ');
+        if (space_pos == std::string_view::npos) continue;
+
+        // promote() re-checks under the shard lock, so a concurrent SET or
+        // DEL of the same key always wins
+        if (cache.promote(MMapPersistence::unescape_string(line.substr(0, space_pos)))) {
+            promoted++;
+        }
+    }
+    return promoted;
+}
+
+size_t LazySnapshot::find(const std::string& key) const {
+    if (!valid_) return count_;
+
+    uint64_t hash = hash_key(key);
+    const IndexEntry* end = entries_ + count_;
+    const IndexEntry* it = std::lower_bound(entries_, end, hash,
+        [](const IndexEntry& entry, uint64_t h) { return entry.hash < h; });
+
+    for (; it != end && it->hash == hash; ++it) {
+        std::string_view line = line_at(static_cast<size_t>(it - entries_));
+        size_t space_pos = line.find(' ');
+        if (space_pos != std::string_view::npos &&
+            MMapPersistence::unescape_string(line.substr(0, space_pos)) == key) {
+            return static_cast<size_t>(it - entries_);
+        }
+    }
+    return count_;
+}
+
+std::string_view LazySnapshot::line_at(size_t pos) const {
+    uint64_t offset = entries_[pos].offset;
+    if (offset >= data_.size()) return {};
+
+    std::string_view rest = data_.view().substr(offset);
+    return rest.substr(0, rest.find('\n'));
+}
+
+uint64_t LazySnapshot::hash_key(std::string_view key) {
+    // FNV-1a 64: stable across builds, unlike std::hash
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void LazySnapshot::write_index(const std::string& snapshot_filename, std::vector<IndexEntry>& entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const IndexEntry& a, const IndexEntry& b) { return a.hash < b.hash; });
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.count = entries.size();
+    header.data_size = std::filesystem::file_size(snapshot_filename);
+    header.data_mtime = mtime_of(snapshot_filename);
+
+    std::string index_filename = snapshot_filename + ".idx";
+    std::string tmp_filename = index_filename + ".tmp";
+    std::ofstream out(tmp_filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + tmp_filename);
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+    out.flush();
+    if (out.fail()) {
+        throw std::runtime_error("Failed to write to file: " + tmp_filename);
+    }
+    out.close();
+
+    std::filesystem::rename(tmp_filename, index_filename);
+}
+
+int64_t LazySnapshot::mtime_of(const std::string& filename) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(filename, ec);
+    return ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+}
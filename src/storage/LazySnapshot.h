@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "LRUCache.h"
+#include "MappedFile.h"
+
+// Serves a base snapshot straight from its mapping during a warm start.
+// Keys are located through the sorted hash index written next to the
+// snapshot (<snapshot>.idx), and each record is handed to the cache at most
+// once, so nothing stale can resurface after a SET or DEL.
+class LazySnapshot : public WarmSource {
+public:
+    struct IndexEntry {
+        uint64_t hash;
+        uint64_t offset;
+    };
+
+    explicit LazySnapshot(const std::string& filename);
+
+    bool is_valid() const { return valid_; }
+    size_t record_count() const { return count_; }
+
+    bool claim(const std::string& key, std::string& value) override;
+    void forget(const std::string& key) override;
+
+    // Background fill: promotes every record that has not been claimed or
+    // superseded yet; returns the number promoted
+    size_t load_remaining(LRUCache& cache);
+
+    static uint64_t hash_key(std::string_view key);
+    // Sorts entries and writes the index for an already committed snapshot
+    static void write_index(const std::string& snapshot_filename, std::vector<IndexEntry>& entries);
+
+private:
+    struct Header {
+        char magic[8];
+        uint64_t count;
+        uint64_t data_size;
+        int64_t data_mtime;
+    };
+    static constexpr char MAGIC[8] = {'D', 'C', 'I', 'D', 'X', '0', '0', '1'};
+
+    MappedFile data_;
+    MappedFile index_;
+    const IndexEntry* entries_ = nullptr;
+    size_t count_ = 0;
+    bool valid_ = false;
+    std::unique_ptr<std::atomic<bool>[]> claimed_;
+
+    size_t find(const std::string& key) const;
+    std::string_view line_at(size_t pos) const;
+    static int64_t mtime_of(const std::string& filename);
+};
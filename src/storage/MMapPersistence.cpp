@@ -1,30 +1,320 @@
 #include "MMapPersistence.h"
-#include <iostream>
+#include "monitoring/Logger.h"
+#include "MappedFile.h"
+#include "LazySnapshot.h"
 #include <filesystem>
 #include <future>
 #include <thread>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Flushes a file, or a directory's entries, to stable storage
+void sync_path(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open for sync: " + path);
+    }
+    int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) {
+        throw std::runtime_error("Failed to sync: " + path);
+    }
+}
+
+std::string parent_dir(const std::string& filename) {
+    std::filesystem::path path(filename);
+    return path.has_parent_path() ? path.parent_path().string() : ".";
+}
+
+}
 
 MMapPersistence::MMapPersistence(const std::string& filename) : filename_(filename) {
     ensure_directory_exists();
+    
+    base_seq_ = read_base_seq(filename_);
+    auto deltas = list_deltas(base_seq_);
+    next_delta_seq_ = (deltas.empty() ? base_seq_ : deltas.back().first) + 1;
+}
+
+MMapPersistence::~MMapPersistence() {
+    wait_for_snapshot();
 }
 
 void MMapPersistence::snapshot(const std::unordered_map<std::string, std::string>& data) {
-    std::ofstream out(filename_, std::ios::trunc);
+    std::string tmp_filename = filename_ + ".tmp";
+    std::ofstream out(tmp_filename, std::ios::trunc);
     if (!out.is_open()) {
-        throw std::runtime_error("Failed to open file for writing: " + filename_);
+        throw std::runtime_error("Failed to open file for writing: " + tmp_filename);
     }
     
+    std::vector<LazySnapshot::IndexEntry> index;
+    index.reserve(data.size());
+    uint64_t covered_seq = next_delta_seq_ - 1;
+    uint64_t offset = write_header(out, covered_seq);
     for (const auto& [key, value] : data) {
-        // Escape special characters to handle spaces and newlines
-        std::string escaped_key = escape_string(key);
-        std::string escaped_value = escape_string(value);
-        out << escaped_key << " " << escaped_value << "\n";
+        index.push_back({LazySnapshot::hash_key(key), offset});
+        offset += write_entry(out, key, value);
+    }
+    
+    commit_snapshot(out, tmp_filename, covered_seq, index);
+}
+
+void MMapPersistence::snapshot(LRUCache& cache) {
+    std::string tmp_filename = filename_ + ".tmp";
+    std::ofstream out(tmp_filename, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + tmp_filename);
+    }
+    
+    // From here on every write is remembered so later deltas are relative
+    // to this base. Writes are logged after they reach the cache, so every
+    // record up to covered is in the copy below.
+    cache.enable_dirty_tracking();
+    uint64_t covered = wal_ ? wal_->last_lsn() : 0;
+    
+    // Each shard is copied under its own lock and written with no lock held,
+    // so foreground traffic only ever waits on one shard's copy
+    std::vector<LazySnapshot::IndexEntry> index;
+    uint64_t covered_seq = next_delta_seq_ - 1;
+    uint64_t offset = write_header(out, covered_seq);
+    for (size_t i = 0; i < cache.shard_count(); ++i) {
+        auto entries = cache.checkpoint_shard(i);
+        for (const auto& [key, value] : entries) {
+            index.push_back({LazySnapshot::hash_key(key), offset});
+            offset += write_entry(out, key, value);
+        }
+    }
+    
+    // A new base supersedes every existing delta
+    commit_snapshot(out, tmp_filename, covered_seq, index);
+    needs_base_ = false;
+    if (wal_) wal_->compact(covered);
+}
+
+void MMapPersistence::snapshot_delta(LRUCache& cache) {
+    if (!cache.dirty_tracking_enabled() || needs_base_) {
+        // Nothing to be relative to yet, or a failed delta lost the keys it
+        // drained: write a base instead
+        snapshot(cache);
+        return;
+    }
+    
+    std::string delta_filename = filename_ + ".delta." + std::to_string(next_delta_seq_);
+    std::string tmp_filename = delta_filename + ".tmp";
+    std::ofstream out(tmp_filename, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + tmp_filename);
+    }
+    
+    uint64_t covered = wal_ ? wal_->last_lsn() : 0;
+    needs_base_ = true;
+    size_t changes = 0;
+    for (size_t i = 0; i < cache.shard_count(); ++i) {
+        for (const auto& [key, value] : cache.drain_dirty_shard(i)) {
+            if (value) {
+                out << '+';
+                write_entry(out, key, *value);
+            } else {
+                out << '-' << escape_string(key) << "\n";
+            }
+            changes++;
+        }
     }
     
     out.flush();
     if (out.fail()) {
-        throw std::runtime_error("Failed to write to file: " + filename_);
+        throw std::runtime_error("Failed to write to file: " + tmp_filename);
     }
+    out.close();
+    
+    if (changes == 0) {
+        // Nothing changed since the last base or delta, which already
+        // cover every record up to here
+        std::filesystem::remove(tmp_filename);
+        needs_base_ = false;
+        if (wal_) wal_->compact(covered);
+        return;
+    }
+    
+    try {
+        // Durable before the WAL records it covers are compacted away
+        sync_path(tmp_filename);
+        std::filesystem::rename(tmp_filename, delta_filename);
+        sync_path(parent_dir(filename_));
+    } catch (const std::filesystem::filesystem_error& e) {
+        throw std::runtime_error("Failed to commit delta: " + std::string(e.what()));
+    }
+    next_delta_seq_++;
+    needs_base_ = false;
+    if (wal_) wal_->compact(covered);
+}
+
+void MMapPersistence::merge_deltas() {
+    auto deltas = list_deltas(base_seq_);
+    if (deltas.empty()) return;
+    
+    // Only the churned keys are held in memory; the base is streamed through
+    std::unordered_map<std::string, std::optional<std::string>> overrides;
+    for (const auto& [seq, path] : deltas) {
+        apply_delta_file(path, [&overrides](const std::string& key, const std::string* value) {
+            overrides[key] = value ? std::optional<std::string>(*value) : std::nullopt;
+        });
+    }
+    
+    std::string tmp_filename = filename_ + ".tmp";
+    std::ofstream out(tmp_filename, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + tmp_filename);
+    }
+    
+    std::vector<LazySnapshot::IndexEntry> index;
+    uint64_t covered_seq = deltas.back().first;
+    uint64_t offset = write_header(out, covered_seq);
+    {
+        MappedFile base(filename_);
+        std::string_view data = base.view();
+        size_t pos = 0;
+        while (pos < data.size()) {
+            size_t eol = data.find('\n', pos);
+            if (eol == std::string_view::npos) eol = data.size();
+            std::string_view line = data.substr(pos, eol - pos);
+            pos = eol + 1;
+            
+            size_t space_pos = line.find(' ');
+            if (space_pos == std::string_view::npos) continue;
+            std::string key = unescape_string(line.substr(0, space_pos));
+            if (overrides.count(key)) continue;
+            
+            index.push_back({LazySnapshot::hash_key(key), offset});
+            out << line << "\n";
+            offset += line.size() + 1;
+        }
+    }
+    
+    for (const auto& [key, value] : overrides) {
+        if (!value) continue;
+        index.push_back({LazySnapshot::hash_key(key), offset});
+        offset += write_entry(out, key, *value);
+    }
+    
+    commit_snapshot(out, tmp_filename, covered_seq, index);
+    LOG_INFO("Persistence", "Merged " << deltas.size() << " deltas into " << filename_);
+}
+
+size_t MMapPersistence::delta_count() const {
+    return list_deltas(base_seq_).size();
+}
+
+std::vector<std::pair<uint64_t, std::string>> MMapPersistence::list_deltas(uint64_t after) const {
+    std::vector<std::pair<uint64_t, std::string>> deltas;
+    
+    std::filesystem::path base_path(filename_);
+    std::filesystem::path dir = base_path.has_parent_path() ? base_path.parent_path()
+                                                            : std::filesystem::path(".");
+    std::string prefix = base_path.filename().string() + ".delta.";
+    
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = file.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        
+        std::string suffix = name.substr(prefix.size());
+        if (suffix.empty() || suffix.find_first_not_of("0123456789") != std::string::npos) {
+            continue; // In-progress .tmp files and anything else
+        }
+        uint64_t seq = std::stoull(suffix);
+        if (seq > after) deltas.emplace_back(seq, file.path().string());
+    }
+    
+    std::sort(deltas.begin(), deltas.end());
+    return deltas;
+}
+
+void MMapPersistence::apply_delta_file(
+    const std::string& path,
+    const std::function<void(const std::string&, const std::string*)>& apply) const {
+    MappedFile file(path);
+    std::string_view data = file.view();
+    std::string key, value;
+    size_t pos = 0;
+    
+    while (pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string_view::npos) eol = data.size();
+        std::string_view line = data.substr(pos, eol - pos);
+        pos = eol + 1;
+        
+        if (line.empty()) continue;
+        if (line[0] == '+' && parse_entry(line.substr(1), key, value)) {
+            apply(key, &value);
+        } else if (line[0] == '-') {
+            apply(unescape_string(line.substr(1)), nullptr);
+        }
+    }
+}
+
+void MMapPersistence::commit_snapshot(std::ofstream& out, const std::string& tmp_filename,
+                                      uint64_t covered_seq,
+                                      std::vector<LazySnapshot::IndexEntry>& index) {
+    out.flush();
+    if (out.fail()) {
+        throw std::runtime_error("Failed to write to file: " + tmp_filename);
+    }
+    out.close();
+    
+    // Readers never observe a half-written snapshot; the index is rewritten
+    // for the committed file and validated against its size and mtime
+    try {
+        sync_path(tmp_filename);
+        std::filesystem::rename(tmp_filename, filename_);
+        sync_path(parent_dir(filename_));
+        LazySnapshot::write_index(filename_, index);
+    } catch (const std::filesystem::filesystem_error& e) {
+        throw std::runtime_error("Failed to commit snapshot: " + std::string(e.what()));
+    }
+    base_seq_ = covered_seq;
+    
+    // Only now are the folded deltas redundant. A crash before they are gone
+    // leaves them on disk, and the base's header tells recovery to skip them
+    for (const auto& [seq, path] : list_deltas(0)) {
+        if (seq > covered_seq) break;
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+size_t MMapPersistence::write_header(std::ofstream& out, uint64_t covered_seq) {
+    // Has no space, so it can never be mistaken for (or parsed as) an entry
+    std::string header = BASE_HEADER + std::to_string(covered_seq);
+    out << header << "\n";
+    return header.size() + 1;
+}
+
+uint64_t MMapPersistence::read_base_seq(const std::string& filename) {
+    std::ifstream in(filename);
+    std::string line;
+    if (!std::getline(in, line) || line.find(' ') != std::string::npos ||
+        line.compare(0, BASE_HEADER.size(), BASE_HEADER) != 0) {
+        return 0; // No base yet, or one written before headers existed
+    }
+    try {
+        return std::stoull(line.substr(BASE_HEADER.size()));
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+size_t MMapPersistence::write_entry(std::ofstream& out, const std::string& key,
+                                    const std::string& value) {
+    // Escape special characters to handle spaces and newlines
+    std::string escaped_key = escape_string(key);
+    std::string escaped_value = escape_string(value);
+    out << escaped_key << " " << escaped_value << "\n";
+    return escaped_key.size() + escaped_value.size() + 2;
 }
 
 std::unordered_map<std::string, std::string> MMapPersistence::load() {
@@ -36,42 +326,138 @@ std::unordered_map<std::string, std::string> MMapPersistence::load() {
         return data;
     }
     
-    std::string line;
+    std::string line, key, value;
     while (std::getline(in, line)) {
-        if (line.empty()) continue;
-        
-        // Find the first space to separate key and value
-        size_t space_pos = line.find(' ');
-        if (space_pos == std::string::npos) {
-            // Invalid line format - skip
-            continue;
+        if (parse_entry(line, key, value)) {
+            data[key] = value;
         }
-        
-        std::string escaped_key = line.substr(0, space_pos);
-        std::string escaped_value = line.substr(space_pos + 1);
-        
-        // Unescape the strings
-        std::string key = unescape_string(escaped_key);
-        std::string value = unescape_string(escaped_value);
-        
-        data[key] = value;
+    }
+    
+    for (const auto& [seq, path] : list_deltas(base_seq_)) {
+        apply_delta_file(path, [&data](const std::string& delta_key, const std::string* delta_value) {
+            if (delta_value) data[delta_key] = *delta_value;
+            else data.erase(delta_key);
+        });
     }
     
     return data;
 }
 
-void MMapPersistence::async_snapshot(const std::unordered_map<std::string, std::string>& data) {
-    // Create a copy of the data for async processing
-    auto data_copy = std::make_shared<std::unordered_map<std::string, std::string>>(data);
+size_t MMapPersistence::load_into(LRUCache& cache, size_t num_threads) {
+    MappedFile file(filename_);
+    if (!file.is_open() || file.size() == 0) {
+        return 0;
+    }
+    if (num_threads == 0) num_threads = 1;
+    
+    std::string_view data = file.view();
+    
+    // Cut the mapping into one byte range per worker, each ending on a line
+    // boundary; keys in a snapshot are unique so ranges apply independently
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < num_threads; ++i) {
+        size_t pos = data.find('\n', std::max(bounds.back(), data.size() * i / num_threads));
+        if (pos == std::string_view::npos) break;
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(data.size());
+    
+    std::atomic<size_t> loaded{0};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        if (bounds[i] == bounds[i + 1]) continue;
+        
+        workers.emplace_back([this, &cache, &loaded, data, begin = bounds[i], end = bounds[i + 1]]() {
+            std::string key, value;
+            size_t count = 0;
+            size_t pos = begin;
+            
+            while (pos < end) {
+                size_t eol = data.find('\n', pos);
+                if (eol == std::string_view::npos || eol > end) eol = end;
+                
+                if (parse_entry(data.substr(pos, eol - pos), key, value)) {
+                    cache.set(key, value);
+                    count++;
+                }
+                pos = eol + 1;
+            }
+            loaded += count;
+        });
+    }
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Deltas are small and ordered; apply them after the base
+    apply_deltas(cache);
+    return cache.size();
+}
+
+size_t MMapPersistence::apply_deltas(LRUCache& cache) {
+    size_t applied = 0;
+    for (const auto& [seq, path] : list_deltas(base_seq_)) {
+        apply_delta_file(path, [&cache, &applied](const std::string& key, const std::string* value) {
+            if (value) cache.set(key, *value);
+            else cache.del(key);
+            applied++;
+        });
+    }
+    return applied;
+}
+
+bool MMapPersistence::parse_entry(std::string_view line, std::string& key, std::string& value) {
+    if (line.empty()) return false;
+    
+    // Find the first space to separate key and value
+    size_t space_pos = line.find(' ');
+    if (space_pos == std::string_view::npos) {
+        // Invalid line format - skip
+        return false;
+    }
+    
+    // Unescape the strings
+    key = unescape_string(line.substr(0, space_pos));
+    value = unescape_string(line.substr(space_pos + 1));
+    return true;
+}
+
+bool MMapPersistence::async_snapshot(LRUCache& cache) {
+    return run_async([this, &cache]() { snapshot(cache); });
+}
+
+bool MMapPersistence::async_snapshot_delta(LRUCache& cache) {
+    return run_async([this, &cache]() {
+        snapshot_delta(cache);
+        if (delta_count() >= MAX_DELTAS) {
+            merge_deltas();
+        }
+    });
+}
+
+bool MMapPersistence::run_async(std::function<void()> job) {
+    bool expected = false;
+    if (!snapshot_running_.compare_exchange_strong(expected, true)) {
+        return false; // A snapshot is already being written
+    }
+    
+    if (snapshot_thread_.joinable()) snapshot_thread_.join();
     
-    std::thread([this, data_copy]() {
+    snapshot_thread_ = std::thread([this, job = std::move(job)]() {
         try {
-            snapshot(*data_copy);
-            std::cout << "[Persistence] Async snapshot completed for " << filename_ << "\n";
+            job();
+            LOG_INFO("Persistence", "Async snapshot completed for " << filename_);
         } catch (const std::exception& e) {
-            std::cerr << "[Persistence] Async snapshot failed: " << e.what() << "\n";
+            LOG_ERROR("Persistence", "Async snapshot failed: " << e.what());
         }
-    }).detach();
+        snapshot_running_ = false;
+    });
+    return true;
+}
+
+void MMapPersistence::wait_for_snapshot() {
+    if (snapshot_thread_.joinable()) snapshot_thread_.join();
 }
 
 bool MMapPersistence::file_exists() const {
@@ -91,7 +477,7 @@ void MMapPersistence::backup_file(const std::string& backup_filename) {
     try {
         std::filesystem::copy_file(filename_, backup_filename, 
                                    std::filesystem::copy_options::overwrite_existing);
-        std::cout << "[Persistence] Backup created: " << backup_filename << "\n";
+        LOG_INFO("Persistence", "Backup created: " << backup_filename);
     } catch (const std::filesystem::filesystem_error& e) {
         throw std::runtime_error("Failed to create backup: " + std::string(e.what()));
     }
@@ -108,7 +494,7 @@ void MMapPersistence::ensure_directory_exists() {
     }
 }
 
-std::string MMapPersistence::escape_string(const std::string& str) const {
+std::string MMapPersistence::escape_string(const std::string& str) {
     std::string escaped;
     escaped.reserve(str.length() * 2); // Reserve space for worst case
     
@@ -138,7 +524,7 @@ std::string MMapPersistence::escape_string(const std::string& str) const {
     return escaped;
 }
 
-std::string MMapPersistence::unescape_string(const std::string& str) const {
+std::string MMapPersistence::unescape_string(std::string_view str) {
     std::string unescaped;
     unescaped.reserve(str.length());
     
@@ -1,26 +1,87 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <fstream>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "LRUCache.h"
+#include "LazySnapshot.h"
+#include "WAL.h"
 
 class MMapPersistence {
 public:
     explicit MMapPersistence(const std::string& filename);
-    
+    ~MMapPersistence();
+
     void snapshot(const std::unordered_map<std::string, std::string>& data);
     std::unordered_map<std::string, std::string> load();
+
+    // Streams the cache shard by shard: only one shard is copied at a time,
+    // so extra memory is bounded by the largest shard. Also starts dirty-key
+    // tracking on the cache and drops existing deltas.
+    void snapshot(LRUCache& cache);
+    
+    // Writes only the keys changed since the previous base or delta to
+    // <filename>.delta.<seq>; falls back to a full base if the cache is not
+    // tracking dirty keys yet
+    void snapshot_delta(LRUCache& cache);
+    
+    // Folds all deltas into a new base, streaming the old base through
+    void merge_deltas();
+    size_t delta_count() const;
+    
+    // Decodes the snapshot straight from a read-only mapping on num_threads
+    // workers and inserts into the cache, then applies deltas in order;
+    // returns the number of entries in the cache
+    size_t load_into(LRUCache& cache, size_t num_threads);
+    size_t apply_deltas(LRUCache& cache);
+
+    // Snapshots of the cache then note the WAL's last LSN before copying
+    // and compact the log up to it once committed, so recovery only replays
+    // what came after the newest base or delta
+    void attach_wal(WAL& wal) { wal_ = &wal; }
     
     // Enhanced functionality
-    void async_snapshot(const std::unordered_map<std::string, std::string>& data);
+    bool async_snapshot(LRUCache& cache);
+    bool async_snapshot_delta(LRUCache& cache);
+    void wait_for_snapshot();
+    bool snapshot_in_progress() const { return snapshot_running_; }
     bool file_exists() const;
     size_t get_file_size() const;
     void backup_file(const std::string& backup_filename);
     
+    // On-disk record encoding, shared with LazySnapshot
+    static std::string escape_string(const std::string& str);
+    static std::string unescape_string(std::string_view str);
+    static bool parse_entry(std::string_view line, std::string& key, std::string& value);
+
 private:
     std::string filename_;
+    std::thread snapshot_thread_;
+    std::atomic<bool> snapshot_running_{false};
+    uint64_t next_delta_seq_ = 1;
+    uint64_t base_seq_ = 0;  // Newest delta folded into the base on disk
+    WAL* wal_ = nullptr;
+    bool needs_base_ = false;
     
+    static constexpr size_t MAX_DELTAS = 8;
+    // First line of a base: the newest delta sequence it already contains
+    static inline const std::string BASE_HEADER = "#base-covers-delta:";
+
     void ensure_directory_exists();
-    std::string escape_string(const std::string& str) const;
-    std::string unescape_string(const std::string& str) const;
-};
\ No newline at end of file
+    bool run_async(std::function<void()> job);
+    void commit_snapshot(std::ofstream& out, const std::string& tmp_filename,
+                         uint64_t covered_seq, std::vector<LazySnapshot::IndexEntry>& index);
+    // Deltas with a sequence above after, oldest first
+    std::vector<std::pair<uint64_t, std::string>> list_deltas(uint64_t after) const;
+    void apply_delta_file(const std::string& path,
+                          const std::function<void(const std::string&, const std::string*)>& apply) const;
+    static size_t write_entry(std::ofstream& out, const std::string& key, const std::string& value);
+    static size_t write_header(std::ofstream& out, uint64_t covered_seq);
+    static uint64_t read_base_seq(const std::string& filename);
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. Used by recovery so records can
+// be decoded straight from the page cache without an intermediate copy.
+class MappedFile {
+public:
+    // sequential hints the kernel to read ahead; pass false for random access
+    explicit MappedFile(const std::string& filename, bool sequential = true);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return opened_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool opened_ = false;
+};
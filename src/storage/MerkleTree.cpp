@@ -0,0 +1,59 @@
+#include "MerkleTree.h"
+
+MerkleTree::MerkleTree() : leaves_(new std::atomic<uint64_t>[LEAVES]) {
+    clear();
+}
+
+void MerkleTree::clear() {
+    for (size_t i = 0; i < LEAVES; ++i) leaves_[i].store(0, std::memory_order_relaxed);
+}
+
+void MerkleTree::toggle(std::string_view key, std::string_view value) {
+    leaves_[leaf_of(key)].fetch_xor(entry_hash(key, value), std::memory_order_relaxed);
+}
+
+uint64_t MerkleTree::entry_hash(std::string_view key, std::string_view value) {
+    // The key hash seeds the value hash, so swapping values between two keys
+    // changes the tree
+    return hash(value, hash(key, 0));
+}
+
+uint64_t MerkleTree::node(size_t level, size_t index) const {
+    size_t span = 1;
+    for (size_t l = level; l < DEPTH; ++l) span *= FANOUT;
+
+    uint64_t combined = 0;
+    for (size_t i = index * span; i < (index + 1) * span && i < LEAVES; ++i) {
+        combined ^= leaves_[i].load(std::memory_order_relaxed);
+    }
+    return combined;
+}
+
+std::vector<uint64_t> MerkleTree::children(size_t level, size_t index) const {
+    std::vector<uint64_t> hashes;
+    if (level >= DEPTH) return hashes;
+    hashes.reserve(FANOUT);
+    for (size_t child = index * FANOUT; child < (index + 1) * FANOUT; ++child) {
+        hashes.push_back(node(level + 1, child));
+    }
+    return hashes;
+}
+
+size_t MerkleTree::leaf_of(std::string_view key) {
+    return hash(key, 0) % LEAVES;
+}
+
+uint64_t MerkleTree::hash(std::string_view data, uint64_t seed) {
+    // FNV-1a finished with murmur3's fmix64
+    uint64_t h = 14695981039346656037ull ^ seed;
+    for (char c : data) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
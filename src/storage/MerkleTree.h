@@ -0,0 +1,45 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+// Hash tree over a set of key/value pairs for anti-entropy. Keys fall into
+// LEAVES fixed buckets by key hash; a leaf is the XOR of its entries'
+// hashes, so set/del update it in O(1) without locks or rescans, and an
+// inner node is the XOR of its FANOUT children. Two replicas holding the
+// same entries have equal trees; descending from the root only through
+// differing nodes finds the differing leaves in O(divergence).
+class MerkleTree {
+public:
+    static constexpr size_t FANOUT = 16;
+    static constexpr size_t DEPTH = 3;  // Levels below the root
+    static constexpr size_t LEAVES = FANOUT * FANOUT * FANOUT;
+
+    MerkleTree();
+
+    // Adding and removing the same entry are the same operation
+    void add(std::string_view key, std::string_view value) { toggle(key, value); }
+    void remove(std::string_view key, std::string_view value) { toggle(key, value); }
+    void clear();
+
+    // Level 0 is the root, level DEPTH the leaves; a node at level l covers
+    // FANOUT^(DEPTH - l) consecutive leaves
+    uint64_t node(size_t level, size_t index) const;
+    uint64_t root() const { return node(0, 0); }
+    // Hashes of the FANOUT children of a node, in order
+    std::vector<uint64_t> children(size_t level, size_t index) const;
+
+    static size_t leaf_of(std::string_view key);
+    // What an entry contributes to its leaf. Versions are left out so copies
+    // with equal contents compare equal on every replica.
+    static uint64_t entry_hash(std::string_view key, std::string_view value);
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> leaves_;
+
+    void toggle(std::string_view key, std::string_view value);
+
+    static uint64_t hash(std::string_view data, uint64_t seed);
+};
@@ -0,0 +1,380 @@
+#include "SharedMemoryStore.h"
+#include "monitoring/Logger.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+constexpr char SharedMemoryStore::MAGIC[8];
+
+SharedMemoryStore::SharedMemoryStore(const std::string& name, size_t region_bytes, size_t slot_size)
+    : name_(name), shm_(!name.empty() && name[0] == '/' && name.find('/', 1) == std::string::npos),
+      region_size_(region_bytes) {
+    if (slot_size < sizeof(Slot) + 16 || slot_size % 8 != 0) {
+        throw std::runtime_error("Invalid shared memory slot size: " + std::to_string(slot_size));
+    }
+
+    fd_ = shm_ ? ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0600)
+               : ::open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open shared memory region: " + name);
+    }
+
+    struct stat st;
+    bool existing = ::fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) == region_size_;
+    if (!existing && ::ftruncate(fd_, static_cast<off_t>(region_size_)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to size shared memory region: " + name);
+    }
+
+    void* addr = ::mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to map shared memory region: " + name);
+    }
+    base_ = static_cast<char*>(addr);
+
+    if (existing && validate(slot_size)) {
+        restored_ = true;
+        LOG_INFO("SharedMemory", "Re-attached " << name_ << " with "
+                                 << header()->entry_count << " entries");
+    } else {
+        initialize(slot_size);
+    }
+    header()->clean = 0;
+}
+
+SharedMemoryStore::~SharedMemoryStore() {
+    if (base_) {
+        header()->clean = 1;
+        if (!shm_) ::msync(base_, region_size_, MS_SYNC);
+        ::munmap(base_, region_size_);
+    }
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void SharedMemoryStore::remove(const std::string& name) {
+    if (!name.empty() && name[0] == '/' && name.find('/', 1) == std::string::npos) {
+        ::shm_unlink(name.c_str());
+    } else {
+        ::unlink(name.c_str());
+    }
+}
+
+void SharedMemoryStore::initialize(size_t slot_size) {
+    // Roughly one bucket per slot keeps chains short
+    size_t per_slot = slot_size + sizeof(uint64_t);
+    if (region_size_ < sizeof(Header) + per_slot) {
+        throw std::runtime_error("Shared memory region too small: " + name_);
+    }
+    uint64_t slot_count = (region_size_ - sizeof(Header)) / per_slot;
+
+    Header* h = header();
+    std::memset(h->magic, 0, sizeof(h->magic));
+    h->version = LAYOUT_VERSION;
+    h->slot_size = static_cast<uint32_t>(slot_size);
+    h->bucket_count = slot_count;
+    h->slot_count = slot_count;
+    h->region_size = region_size_;
+    std::memset(buckets(), 0, slot_count * sizeof(uint64_t));
+    std::fill(std::begin(h->free_heads), std::end(h->free_heads), 0);
+    h->bump = slots_begin();
+    h->entry_count = 0;
+    h->clean = 0;
+    h->complete = 0;
+
+    // Magic last: a half-initialised region never validates
+    std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+}
+
+bool SharedMemoryStore::validate(size_t slot_size) const {
+    const Header* h = header();
+    return std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+           h->version == LAYOUT_VERSION &&
+           h->slot_size == slot_size &&
+           h->region_size == region_size_ &&
+           h->clean == 1 &&
+           h->complete == 1 &&
+           slots_begin() + h->slot_count * h->slot_size <= region_size_;
+}
+
+uint64_t SharedMemoryStore::slots_begin() const {
+    uint64_t offset = sizeof(Header) + header()->bucket_count * sizeof(uint64_t);
+    return (offset + 7) & ~uint64_t(7);
+}
+
+void SharedMemoryStore::mark_complete() {
+    // Paired with skip(): whichever of the two runs last, a skipped entry
+    // always leaves the region incomplete
+    header()->complete = 1;
+    if (skipped_ != 0) header()->complete = 0;
+}
+
+void SharedMemoryStore::skip() {
+    skipped_++;
+    header()->complete = 0;
+}
+
+size_t SharedMemoryStore::size() const {
+    return header()->entry_count;
+}
+
+size_t SharedMemoryStore::slot_capacity() const {
+    return header()->slot_count;
+}
+
+bool SharedMemoryStore::put(const std::string& key, const std::string& value, int64_t expire_ms) {
+    uint64_t bucket = bucket_for(key);
+    size_t stripe = bucket % LOCK_STRIPES;
+    std::lock_guard<std::mutex> lock(stripes_[stripe]);
+    size_t count = slots_for(key.size() + value.size());
+
+    uint64_t offset = buckets()[bucket];
+    while (offset != 0 && !key_matches(slot_at(offset), key)) {
+        offset = slot_at(offset)->next;
+    }
+
+    // An update that needs the same number of slots is rewritten in place;
+    // otherwise the old chain goes back to the free list first
+    if (offset != 0 && slots_for(slot_at(offset)->key_len + slot_at(offset)->value_len) != count) {
+        erase_locked(bucket, key);
+        offset = 0;
+    }
+
+    bool inserted = offset == 0;
+    if (inserted) {
+        offset = allocate_chain(stripe, count);
+        if (offset == 0) {
+            // No room to mirror; any older copy is already gone
+            skip();
+            return false;
+        }
+    }
+
+    Slot* slot = slot_at(offset);
+    slot->expire_ms = expire_ms;
+    slot->key_len = static_cast<uint32_t>(key.size());
+    slot->value_len = static_cast<uint32_t>(value.size());
+    write_bytes(slot, 0, key.data(), key.size());
+    write_bytes(slot, key.size(), value.data(), value.size());
+
+    if (inserted) {
+        slot->next = buckets()[bucket];
+        buckets()[bucket] = offset;
+        header()->entry_count++;
+    }
+    return true;
+}
+
+bool SharedMemoryStore::get(const std::string& key, std::string& value) {
+    uint64_t bucket = bucket_for(key);
+    std::lock_guard<std::mutex> lock(stripes_[bucket % LOCK_STRIPES]);
+
+    for (uint64_t offset = buckets()[bucket]; offset != 0; offset = slot_at(offset)->next) {
+        const Slot* slot = slot_at(offset);
+        if (key_matches(slot, key)) {
+            if (slot->expire_ms < now_ms()) return false;
+            value.resize(slot->value_len);
+            read_bytes(slot, slot->key_len, &value[0], slot->value_len);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SharedMemoryStore::erase(const std::string& key) {
+    uint64_t bucket = bucket_for(key);
+    std::lock_guard<std::mutex> lock(stripes_[bucket % LOCK_STRIPES]);
+    erase_locked(bucket, key);
+}
+
+void SharedMemoryStore::on_set(const std::string& key, const std::string*, const std::string& value,
+                               std::chrono::steady_clock::time_point expire_time) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        expire_time - std::chrono::steady_clock::now()).count();
+    put(key, value, now_ms() + remaining);
+}
+
+void SharedMemoryStore::on_erase(const std::string& key, const std::string&) {
+    erase(key);
+}
+
+size_t SharedMemoryStore::load_remaining(LRUCache& cache) {
+    size_t promoted = 0;
+    std::vector<std::string> keys;
+
+    for (uint64_t bucket = 0; bucket < header()->bucket_count; ++bucket) {
+        keys.clear();
+        {
+            std::lock_guard<std::mutex> lock(stripes_[bucket % LOCK_STRIPES]);
+            for (uint64_t offset = buckets()[bucket]; offset != 0; offset = slot_at(offset)->next) {
+                const Slot* slot = slot_at(offset);
+                keys.emplace_back(slot->key_len, '\0');
+                read_bytes(slot, 0, &keys.back()[0], slot->key_len);
+            }
+        }
+        // promote() takes the shard lock and then calls back into get()
+        for (const auto& key : keys) {
+            if (cache.promote(key)) promoted++;
+        }
+    }
+    return promoted;
+}
+
+bool SharedMemoryStore::erase_locked(uint64_t bucket, const std::string& key) {
+    uint64_t* link = &buckets()[bucket];
+    while (*link != 0) {
+        Slot* slot = slot_at(*link);
+        if (key_matches(slot, key)) {
+            uint64_t offset = *link;
+            *link = slot->next;
+            free_chain(bucket % LOCK_STRIPES, offset);
+            header()->entry_count--;
+            return true;
+        }
+        link = &slot->next;
+    }
+    return false;
+}
+
+uint64_t SharedMemoryStore::bucket_for(const std::string& key) const {
+    // FNV-1a 64: must be stable across processes and builds
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash % header()->bucket_count;
+}
+
+uint64_t SharedMemoryStore::allocate_slot(size_t stripe) {
+    Header* h = header();
+    uint64_t offset = h->free_heads[stripe];
+    if (offset != 0) {
+        h->free_heads[stripe] = slot_at(offset)->next;
+    } else {
+        uint64_t end = slots_begin() + h->slot_count * h->slot_size;
+        offset = h->bump.load();
+        while (offset + h->slot_size <= end && !h->bump.compare_exchange_weak(offset, offset + h->slot_size)) {
+        }
+        if (offset + h->slot_size > end) offset = steal_slot(stripe);
+        if (offset == 0) return 0; // Region full
+    }
+    return offset;
+}
+
+uint64_t SharedMemoryStore::steal_slot(size_t stripe) {
+    // Only try_lock: the caller already holds its own stripe
+    Header* h = header();
+    for (size_t i = 1; i < LOCK_STRIPES; ++i) {
+        size_t other = (stripe + i) % LOCK_STRIPES;
+        std::unique_lock<std::mutex> lock(stripes_[other], std::try_to_lock);
+        if (!lock.owns_lock() || h->free_heads[other] == 0) continue;
+        uint64_t offset = h->free_heads[other];
+        h->free_heads[other] = slot_at(offset)->next;
+        return offset;
+    }
+    return 0;
+}
+
+void SharedMemoryStore::free_slot(size_t stripe, uint64_t offset) {
+    Header* h = header();
+    slot_at(offset)->next = h->free_heads[stripe];
+    h->free_heads[stripe] = offset;
+}
+
+uint64_t SharedMemoryStore::allocate_chain(size_t stripe, size_t count) {
+    uint64_t head = allocate_slot(stripe);
+    if (head == 0) return 0;
+    slot_at(head)->more = 0;
+
+    uint64_t* tail = &slot_at(head)->more;
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t offset = allocate_slot(stripe);
+        if (offset == 0) {
+            free_chain(stripe, head);
+            return 0;
+        }
+        chunk_at(offset)->more = 0;
+        *tail = offset;
+        tail = &chunk_at(offset)->more;
+    }
+    return head;
+}
+
+void SharedMemoryStore::free_chain(size_t stripe, uint64_t head) {
+    uint64_t offset = slot_at(head)->more;
+    free_slot(stripe, head);
+    while (offset != 0) {
+        uint64_t more = chunk_at(offset)->more;
+        free_slot(stripe, offset);
+        offset = more;
+    }
+}
+
+size_t SharedMemoryStore::slots_for(size_t bytes) const {
+    size_t head_room = header()->slot_size - offsetof(Slot, data);
+    size_t chunk_room = header()->slot_size - offsetof(Chunk, data);
+    if (bytes <= head_room) return 1;
+    return 1 + (bytes - head_room + chunk_room - 1) / chunk_room;
+}
+
+void SharedMemoryStore::read_bytes(const Slot* slot, size_t from, char* dst, size_t len) const {
+    const char* data = slot->data;
+    size_t room = header()->slot_size - offsetof(Slot, data);
+    uint64_t more = slot->more;
+    while (len > 0) {
+        if (from >= room) {
+            from -= room;
+            data = chunk_at(more)->data;
+            room = header()->slot_size - offsetof(Chunk, data);
+            more = chunk_at(more)->more;
+            continue;
+        }
+        size_t n = std::min(len, room - from);
+        std::memcpy(dst, data + from, n);
+        dst += n;
+        len -= n;
+        from += n;
+    }
+}
+
+void SharedMemoryStore::write_bytes(Slot* slot, size_t from, const char* src, size_t len) {
+    char* data = slot->data;
+    size_t room = header()->slot_size - offsetof(Slot, data);
+    uint64_t more = slot->more;
+    while (len > 0) {
+        if (from >= room) {
+            from -= room;
+            data = chunk_at(more)->data;
+            room = header()->slot_size - offsetof(Chunk, data);
+            more = chunk_at(more)->more;
+            continue;
+        }
+        size_t n = std::min(len, room - from);
+        std::memcpy(data + from, src, n);
+        src += n;
+        len -= n;
+        from += n;
+    }
+}
+
+bool SharedMemoryStore::key_matches(const Slot* slot, const std::string& key) const {
+    if (slot->key_len != key.size()) return false;
+    size_t head_room = header()->slot_size - offsetof(Slot, data);
+    if (key.size() <= head_room) return std::memcmp(slot->data, key.data(), key.size()) == 0;
+    std::string stored(key.size(), '\0');
+    read_bytes(slot, 0, &stored[0], key.size());
+    return stored == key;
+}
+
+int64_t SharedMemoryStore::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
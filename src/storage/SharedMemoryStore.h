@@ -0,0 +1,126 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include "LRUCache.h"
+
+// Mirror of the cache contents in a named POSIX shared-memory segment (names
+// starting with '/') or a file-backed mapping (anything else). Everything in
+// the region is addressed by offsets, so a restarted process can re-attach
+// at any address and serve the previous process's data immediately.
+//
+// Layout: Header | bucket heads (uint64 offsets) | fixed-size slots. An
+// entry larger than one slot continues in a chain of further slots, so the
+// slot size only sets the allocation granularity. Only an entry that finds
+// no free space is left out, and the region is then no longer restored from.
+class SharedMemoryStore : public CacheListener, public WarmSource {
+public:
+    SharedMemoryStore(const std::string& name, size_t region_bytes, size_t slot_size = 512);
+    ~SharedMemoryStore();
+
+    SharedMemoryStore(const SharedMemoryStore&) = delete;
+    SharedMemoryStore& operator=(const SharedMemoryStore&) = delete;
+
+    // True when an intact, complete region from a cleanly stopped process
+    // was re-attached
+    bool restored() const { return restored_; }
+    // Call once the cache has been fully recovered into the region. Only a
+    // region marked complete, with no entry skipped since, is restored on
+    // the next start; anything else recovers from the snapshot and WAL.
+    void mark_complete();
+    size_t size() const;
+    size_t slot_capacity() const;
+    size_t skipped() const { return skipped_; }
+
+    bool put(const std::string& key, const std::string& value, int64_t expire_ms);
+    bool get(const std::string& key, std::string& value);
+    void erase(const std::string& key);
+
+    // CacheListener: write-through from LRUCache
+    void on_set(const std::string& key, const std::string* old_value, const std::string& value,
+                std::chrono::steady_clock::time_point expire_time) override;
+    void on_erase(const std::string& key, const std::string& old_value) override;
+
+    // WarmSource: the region stays authoritative, so claims never consume
+    bool claim(const std::string& key, std::string& value) override { return get(key, value); }
+    void forget(const std::string&) override {}
+
+    // Promotes every mirrored entry into the cache; returns the number promoted
+    size_t load_remaining(LRUCache& cache);
+
+    static void remove(const std::string& name);
+
+private:
+    static constexpr char MAGIC[8] = {'D', 'C', 'S', 'H', 'M', '0', '0', '3'};
+    static constexpr uint32_t LAYOUT_VERSION = 3;
+    static constexpr size_t LOCK_STRIPES = 64;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t slot_size;
+        uint64_t bucket_count;
+        uint64_t slot_count;
+        uint64_t region_size;
+        std::atomic<uint64_t> bump;         // Offset of the first never-used slot
+        std::atomic<uint64_t> entry_count;
+        uint32_t clean;                     // Set on orderly detach, cleared while attached
+        std::atomic<uint32_t> complete;     // Holds every cache entry; see mark_complete
+        // Recycled slots per lock stripe, 0 if none, so writers on different
+        // stripes never share an allocator lock
+        uint64_t free_heads[LOCK_STRIPES];
+    };
+
+    // First slot of an entry; key then value bytes run on into its chunks
+    struct Slot {
+        uint64_t next;        // Next slot in the bucket chain or free list
+        uint64_t more;        // First continuation chunk, 0 if none
+        int64_t expire_ms;    // System clock, survives restarts
+        uint32_t key_len;
+        uint32_t value_len;
+        char data[1];
+    };
+
+    // Continuation slot; `more` shares offset 0 with the free-list link
+    struct Chunk {
+        uint64_t more;
+        char data[1];
+    };
+
+    std::string name_;
+    bool shm_ = false;
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t region_size_ = 0;
+    bool restored_ = false;
+    std::atomic<size_t> skipped_{0};
+
+    std::array<std::mutex, LOCK_STRIPES> stripes_;
+
+    Header* header() const { return reinterpret_cast<Header*>(base_); }
+    uint64_t* buckets() const { return reinterpret_cast<uint64_t*>(base_ + sizeof(Header)); }
+    Slot* slot_at(uint64_t offset) const { return reinterpret_cast<Slot*>(base_ + offset); }
+    Chunk* chunk_at(uint64_t offset) const { return reinterpret_cast<Chunk*>(base_ + offset); }
+    size_t slots_for(size_t bytes) const;
+    uint64_t slots_begin() const;
+
+    void initialize(size_t slot_size);
+    bool validate(size_t slot_size) const;
+    uint64_t bucket_for(const std::string& key) const;
+    // Both expect the stripe's lock to be held
+    uint64_t allocate_slot(size_t stripe);
+    void free_slot(size_t stripe, uint64_t offset);
+    uint64_t steal_slot(size_t stripe);
+    uint64_t allocate_chain(size_t stripe, size_t count);
+    void free_chain(size_t stripe, uint64_t head);
+    void skip();
+    bool erase_locked(uint64_t bucket, const std::string& key);
+    // Copy `len` entry bytes starting at `from`, following the chunk chain
+    void read_bytes(const Slot* slot, size_t from, char* dst, size_t len) const;
+    void write_bytes(Slot* slot, size_t from, const char* src, size_t len);
+    bool key_matches(const Slot* slot, const std::string& key) const;
+    static int64_t now_ms();
+};
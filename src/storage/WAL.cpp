@@ -1,9 +1,26 @@
 #include "WAL.h"
+#include "MappedFile.h"
+#include "MMapPersistence.h"
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 
 WAL::WAL(const std::string& filename) : filename_(filename) {
+    // One record per line, so the next LSN follows the existing line count
+    MappedFile existing(filename_);
+    if (existing.is_open()) {
+        std::string_view data = existing.view();
+        uint64_t lines = std::count(data.begin(), data.end(), '\n');
+        if (parse_base(data.substr(0, data.find('\n')), base_lsn_) && lines > 0) lines--;
+        last_lsn_ = base_lsn_ + lines;
+    }
     ensure_file_open();
 }
 
@@ -22,19 +39,22 @@ void WAL::ensure_file_open() {
     }
 }
 
-void WAL::append(const std::string& operation, const std::string& key, const std::string& value) {
+uint64_t WAL::append(const std::string& operation, const std::string& key, const std::string& value) {
     std::lock_guard<std::mutex> lock(wal_mutex_);
     ensure_file_open();
     
-    wal_file_ << operation << " " << key;
+    // Escaped like snapshot entries: one record is always one line, which
+    // LSN counting and compaction rely on
+    wal_file_ << operation << " " << MMapPersistence::escape_string(key);
     if (!value.empty()) {
-        wal_file_ << " " << value;
+        wal_file_ << " " << MMapPersistence::escape_string(value);
     }
     wal_file_ << "\n";
     wal_file_.flush();
+    return record_locked(operation, key, value);
 }
 
-void WAL::append_binary(const std::string& op, const std::string& key, const std::string& value) {
+uint64_t WAL::append_binary(const std::string& op, const std::string& key, const std::string& value) {
     // Fallback to text format if msgpack is not available
     #ifdef HAVE_MSGPACK
     std::lock_guard<std::mutex> lock(wal_mutex_);
@@ -46,12 +66,54 @@ void WAL::append_binary(const std::string& op, const std::string& key, const std
     
     wal_file_.write(data.data(), data.size());
     wal_file_.flush();
+    return record_locked(op, key, value);
     #else
     // Use text format as fallback
-    append(op, key, value);
+    return append(op, key, value);
     #endif
 }
 
+uint64_t WAL::record_locked(const std::string& op, const std::string& key, const std::string& value) {
+    backlog_.push_back(Record{++last_lsn_, op, key, value});
+    while (backlog_.size() > backlog_limit_) {
+        backlog_.pop_front();
+    }
+    appended_.notify_all();
+    return last_lsn_;
+}
+
+uint64_t WAL::last_lsn() const {
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    return last_lsn_;
+}
+
+bool WAL::read_since(uint64_t after, size_t max, std::vector<Record>& out) const {
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    out.clear();
+    if (after >= last_lsn_) return true;
+    if (backlog_.empty() || backlog_.front().lsn > after + 1) return false;
+    
+    // LSNs in the backlog are contiguous, so the start is an index
+    size_t begin = static_cast<size_t>(after + 1 - backlog_.front().lsn);
+    for (size_t i = begin; i < backlog_.size() && out.size() < max; ++i) {
+        out.push_back(backlog_[i]);
+    }
+    return true;
+}
+
+bool WAL::wait_for_lsn(uint64_t after, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(wal_mutex_);
+    return appended_.wait_for(lock, timeout, [this, after] { return last_lsn_ > after; });
+}
+
+void WAL::set_backlog_limit(size_t records) {
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    backlog_limit_ = records > 0 ? records : 1;
+    while (backlog_.size() > backlog_limit_) {
+        backlog_.pop_front();
+    }
+}
+
 std::vector<std::tuple<std::string, std::string, std::string>> WAL::replay() {
     std::ifstream in(filename_);
     std::vector<std::tuple<std::string, std::string, std::string>> ops;
@@ -60,26 +122,233 @@ std::vector<std::tuple<std::string, std::string, std::string>> WAL::replay() {
         return ops; // Return empty vector if file doesn't exist
     }
     
-    std::string line;
+    std::string line, op, key, value;
+    uint64_t base = 0;
     while (std::getline(in, line)) {
-        if (line.empty()) continue;
-        
-        std::istringstream iss(line);
-        std::string op, key, value;
-        
-        iss >> op >> key;
-        // Get the rest of the line as value (may contain spaces)
-        std::getline(iss, value);
+        if (parse_base(line, base)) continue;
+        if (parse_record(line, op, key, value)) {
+            ops.emplace_back(op, key, value);
+        }
+    }
+    
+    return ops;
+}
+
+namespace {
+
+// Hands batches of raw WAL lines from the scanner to one replay worker.
+// Depth is bounded so the scanner never runs far ahead of the workers.
+class ReplayQueue {
+public:
+    void push(std::vector<std::string_view> batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return batches_.size() < MAX_DEPTH; });
+        batches_.push_back(std::move(batch));
+        not_empty_.notify_one();
+    }
+    
+    bool pop(std::vector<std::string_view>& batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !batches_.empty() || closed_; });
+        if (batches_.empty()) return false;
+        batch = std::move(batches_.front());
+        batches_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+    
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+    
+private:
+    static constexpr size_t MAX_DEPTH = 8;
+    std::deque<std::vector<std::string_view>> batches_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    bool closed_ = false;
+};
+
+} // namespace
+
+size_t WAL::replay_into(LRUCache& cache, size_t num_threads) {
+    MappedFile file(filename_);
+    if (!file.is_open() || file.size() == 0) {
+        return 0;
+    }
+    if (num_threads == 0) num_threads = 1;
+    
+    // Records for one key always land on the same worker, so per-key order
+    // is preserved while different shards replay in parallel
+    std::vector<ReplayQueue> queues(num_threads);
+    std::atomic<size_t> applied{0};
+    std::vector<std::thread> workers;
+    
+    for (size_t w = 0; w < num_threads; ++w) {
+        workers.emplace_back([&cache, &applied, &queue = queues[w]]() {
+            std::vector<std::string_view> batch;
+            std::string op, key, value, data;
+            uint64_t version = 0;
+            int ttl = -1;
+            size_t count = 0;
+            
+            while (queue.pop(batch)) {
+                for (std::string_view line : batch) {
+                    if (!parse_record(line, op, key, value)) continue;
+                    if (decode_set(op, value, data, version, ttl)) {
+                        // A write that has since expired still hides the ones before it
+                        if (ttl == 0 ? cache.replay_del(key) : cache.replay_set(key, data, version, ttl)) count++;
+                    } else if (op == "DEL" && cache.replay_del(key)) {
+                        count++;
+                    }
+                }
+            }
+            applied += count;
+        });
+    }
+    
+    // The scanner only finds line and key boundaries; decoding happens on
+    // the workers, straight out of the mapping
+    std::vector<std::vector<std::string_view>> pending(num_threads);
+    std::string_view data = file.view();
+    size_t pos = 0;
+    
+    while (pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string_view::npos) eol = data.size();
+        std::string_view line = data.substr(pos, eol - pos);
+        pos = eol + 1;
         
-        // Trim leading space from value
-        if (!value.empty() && value[0] == ' ') {
-            value = value.substr(1);
+        size_t op_begin = line.find_first_not_of(" \t\r");
+        if (op_begin == std::string_view::npos) continue;
+        size_t key_begin = line.find_first_of(" \t\r", op_begin);
+        if (key_begin != std::string_view::npos) {
+            key_begin = line.find_first_not_of(" \t\r", key_begin);
+        }
+        std::string key;
+        if (key_begin != std::string_view::npos) {
+            size_t key_end = line.find_first_of(" \t\r", key_begin);
+            key = MMapPersistence::unescape_string(line.substr(key_begin, key_end == std::string_view::npos
+                                                                              ? std::string_view::npos
+                                                                              : key_end - key_begin));
         }
         
-        ops.emplace_back(op, key, value);
+        size_t w = cache.shard_for(key) % num_threads;
+        pending[w].push_back(line);
+        if (pending[w].size() >= REPLAY_BATCH_SIZE) {
+            queues[w].push(std::move(pending[w]));
+            pending[w].clear();
+        }
     }
     
-    return ops;
+    for (size_t w = 0; w < num_threads; ++w) {
+        if (!pending[w].empty()) queues[w].push(std::move(pending[w]));
+        queues[w].close();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    return applied;
+}
+
+bool WAL::parse_record(std::string_view line, std::string& op, std::string& key, std::string& value) {
+    auto next_token = [&line](size_t& pos) {
+        size_t begin = line.find_first_not_of(" \t\r", pos);
+        if (begin == std::string_view::npos) {
+            pos = line.size();
+            return std::string_view();
+        }
+        size_t end = line.find_first_of(" \t\r", begin);
+        if (end == std::string_view::npos) end = line.size();
+        pos = end;
+        return line.substr(begin, end - begin);
+    };
+    
+    size_t pos = 0;
+    std::string_view op_view = next_token(pos);
+    std::string_view key_view = next_token(pos);
+    if (op_view.empty()) return false;
+    
+    op.assign(op_view);
+    key = MMapPersistence::unescape_string(key_view);
+    
+    // The rest of the line is the value; drop the single separating space
+    std::string_view rest = line.substr(pos);
+    if (!rest.empty() && rest[0] == ' ') rest.remove_prefix(1);
+    value = MMapPersistence::unescape_string(rest);
+    return true;
+}
+
+std::string WAL::versioned_value(uint64_t version, const std::string& value) {
+    return std::to_string(version) + " " + value;
+}
+
+bool WAL::parse_versioned(std::string_view record_value, uint64_t& version, std::string& value) {
+    size_t space = record_value.find(' ');
+    std::string digits(record_value.substr(0, space));
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+    version = std::strtoull(digits.c_str(), nullptr, 10);
+    value.assign(space == std::string_view::npos ? std::string_view() : record_value.substr(space + 1));
+    return true;
+}
+
+namespace {
+
+int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Splits "<number> <rest>"; false unless the first field is all digits
+bool split_number(std::string_view text, uint64_t& number, std::string_view& rest) {
+    size_t space = text.find(' ');
+    std::string_view digits = text.substr(0, space);
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string_view::npos) return false;
+    number = std::strtoull(std::string(digits).c_str(), nullptr, 10);
+    rest = space == std::string_view::npos ? std::string_view() : text.substr(space + 1);
+    return true;
+}
+
+} // namespace
+
+std::string WAL::set_record(const std::string& value, int ttl_seconds, uint64_t version, std::string& op) {
+    std::string record = value;
+    if (ttl_seconds > 0) {
+        record = std::to_string(unix_ms() + int64_t(ttl_seconds) * 1000) + " " + record;
+    }
+    if (version) record = versioned_value(version, record);
+    op = std::string(version ? "VSET" : "SET") + (ttl_seconds > 0 ? "EX" : "");
+    return record;
+}
+
+bool WAL::decode_set(const std::string& op, std::string_view record_value, std::string& value,
+                     uint64_t& version, int& ttl_seconds) {
+    bool versioned = op == "VSET" || op == "VSETEX";
+    bool expiring = op == "SETEX" || op == "VSETEX";
+    if (!versioned && !expiring && op != "SET") return false;
+    
+    version = 0;
+    ttl_seconds = -1;
+    std::string_view rest = record_value;
+    if (versioned && !split_number(rest, version, rest)) return false;
+    if (expiring) {
+        uint64_t expires_at = 0;
+        if (!split_number(rest, expires_at, rest)) return false;
+        int64_t left_ms = static_cast<int64_t>(expires_at) - unix_ms();
+        ttl_seconds = left_ms > 0 ? static_cast<int>((left_ms + 999) / 1000) : 0;
+    }
+    value.assign(rest);
+    return true;
+}
+
+uint64_t WAL::append_set(const std::string& key, const std::string& value, int ttl_seconds, uint64_t version) {
+    std::string op;
+    std::string record = set_record(value, ttl_seconds, version, op);
+    return append(op, key, record);
 }
 
 void WAL::sync() {
@@ -89,8 +358,86 @@ void WAL::sync() {
     }
 }
 
+bool WAL::parse_base(std::string_view line, uint64_t& lsn) {
+    static constexpr std::string_view prefix = "BASE ";
+    if (line.substr(0, prefix.size()) != prefix) return false;
+    lsn = std::strtoull(std::string(line.substr(prefix.size())).c_str(), nullptr, 10);
+    return true;
+}
+
+void WAL::compact(uint64_t through) {
+    // Writers append under wal_mutex_ while holding a cache shard lock, so
+    // the bulk copy runs without it: only the bytes appended meanwhile are
+    // copied, and the file swapped, under the lock
+    std::lock_guard<std::mutex> compacting(compact_mutex_);
+    uint64_t base_lsn = 0;
+    size_t copied_to = 0;
+    {
+        std::lock_guard<std::mutex> lock(wal_mutex_);
+        through = std::min(through, last_lsn_);
+        if (through <= base_lsn_) return;
+        wal_file_.flush();
+        base_lsn = base_lsn_;
+        std::error_code ec;
+        copied_to = static_cast<size_t>(std::filesystem::file_size(filename_, ec));
+    }
+    
+    // Rewritten aside and renamed over the log, so a crash leaves either
+    // the old file or the new one
+    std::string tmp_filename = filename_ + ".compact";
+    std::ofstream out(tmp_filename, std::ios::trunc | std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + tmp_filename);
+    }
+    out << "BASE " << through << "\n";
+    {
+        // The file only grows while compact_mutex_ is held, so its first
+        // copied_to bytes are stable
+        MappedFile existing(filename_);
+        std::string_view data = existing.view().substr(0, copied_to);
+        uint64_t base = 0;
+        size_t pos = 0;
+        if (parse_base(data.substr(0, data.find('\n')), base)) pos = data.find('\n') + 1;
+        for (uint64_t skip = through - base_lsn; skip > 0 && pos < data.size(); --skip) {
+            size_t eol = data.find('\n', pos);
+            pos = eol == std::string_view::npos ? data.size() : eol + 1;
+        }
+        out << data.substr(std::min(pos, data.size()));
+    }
+    
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    wal_file_.flush();
+    std::error_code ec;
+    if (std::filesystem::file_size(filename_, ec) > copied_to) {
+        std::ifstream tail(filename_, std::ios::binary);
+        tail.seekg(static_cast<std::streamoff>(copied_to));
+        out << tail.rdbuf();
+    }
+    out.flush();
+    if (out.fail()) {
+        throw std::runtime_error("Failed to write to file: " + tmp_filename);
+    }
+    out.close();
+    
+    wal_file_.close();
+    try {
+        std::filesystem::rename(tmp_filename, filename_);
+    } catch (const std::filesystem::filesystem_error& e) {
+        ensure_file_open();
+        throw std::runtime_error("Failed to compact WAL: " + std::string(e.what()));
+    }
+    base_lsn_ = through;
+    ensure_file_open();
+}
+
 void WAL::truncate() {
+    std::lock_guard<std::mutex> compacting(compact_mutex_);
     std::lock_guard<std::mutex> lock(wal_mutex_);
     wal_file_.close();
+    // Keep the LSN sequence across a reopen; the backlog still serves
+    // replicas that are behind
     wal_file_.open(filename_, std::ios::trunc);
+    wal_file_ << "BASE " << last_lsn_ << "\n";
+    wal_file_.flush();
+    base_lsn_ = last_lsn_;
 }
\ No newline at end of file
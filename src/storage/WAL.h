@@ -1,10 +1,16 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <tuple>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
+#include "LRUCache.h"
 
 #ifdef HAVE_MSGPACK
 #include <msgpack.hpp>
@@ -12,22 +18,86 @@
 
 class WAL {
 public:
+    // A replication record: one WAL entry and its log sequence number
+    struct Record {
+        uint64_t lsn;
+        std::string op;
+        std::string key;
+        std::string value;
+    };
+    
     explicit WAL(const std::string& filename);
     ~WAL();
     
-    void append(const std::string& operation, const std::string& key, 
-                const std::string& value = "");
-    void append_binary(const std::string& operation, const std::string& key, 
-                      const std::string& value = "");
+    // Both return the record's LSN. LSNs continue from the number of
+    // records already in the file, counted from its BASE header if it has
+    // one.
+    uint64_t append(const std::string& operation, const std::string& key, 
+                    const std::string& value = "");
+    uint64_t append_binary(const std::string& operation, const std::string& key, 
+                           const std::string& value = "");
+    
+    // The most recent records stay in memory so replicas can resume from an
+    // LSN. read_since copies up to max records with lsn > after and returns
+    // false if some of them have already left the backlog.
+    uint64_t last_lsn() const;
+    bool read_since(uint64_t after, size_t max, std::vector<Record>& out) const;
+    // Waits until a record with lsn > after exists; false on timeout
+    bool wait_for_lsn(uint64_t after, std::chrono::milliseconds timeout) const;
+    void set_backlog_limit(size_t records);
     std::vector<std::tuple<std::string, std::string, std::string>> replay();
     
+    // Streams the log from a read-only mapping and applies it to the cache
+    // on num_threads workers partitioned by target shard; returns the
+    // number of records applied. Keys written since cache.begin_replay()
+    // are left alone.
+    size_t replay_into(LRUCache& cache, size_t num_threads);
+    
+    static bool parse_record(std::string_view line, std::string& op,
+                             std::string& key, std::string& value);
+    
+    // Quorum writes are logged as "VSET key <version> <value>" so a replay
+    // or a replica restores the version along with the value
+    static std::string versioned_value(uint64_t version, const std::string& value);
+    static bool parse_versioned(std::string_view record_value, uint64_t& version,
+                                std::string& value);
+    
+    // Writes with a TTL carry an absolute expiry in unix milliseconds,
+    // "SETEX key <expires_at> <value>" and "VSETEX key <version> <expires_at>
+    // <value>", so a replay or a replica keeps only what is left of it.
+    // set_record picks the op for a write and encodes its value; decode_set
+    // reverses any SET-family record, giving version 0 if it has none and
+    // ttl_seconds -1 for no expiry or 0 if it has already passed.
+    static std::string set_record(const std::string& value, int ttl_seconds, uint64_t version,
+                                  std::string& op);
+    static bool decode_set(const std::string& op, std::string_view record_value, std::string& value,
+                           uint64_t& version, int& ttl_seconds);
+    uint64_t append_set(const std::string& key, const std::string& value, int ttl_seconds = -1,
+                        uint64_t version = 0);
+    
     void sync();
+    // Empties the file; LSNs carry on from last_lsn() as after compact
     void truncate();
+    // Drops the records up to and including through from the file once a
+    // snapshot covers them; LSNs carry on unchanged
+    void compact(uint64_t through);
     
 private:
     std::string filename_;
     std::ofstream wal_file_;
-    std::mutex wal_mutex_;
+    mutable std::mutex wal_mutex_;
+    std::mutex compact_mutex_;  // Taken before wal_mutex_; one rewrite at a time
+    mutable std::condition_variable appended_;
+    uint64_t last_lsn_ = 0;
+    uint64_t base_lsn_ = 0;  // LSN before the first record in the file
+    std::deque<Record> backlog_;
+    size_t backlog_limit_ = DEFAULT_BACKLOG_LIMIT;
+    
+    static constexpr size_t REPLAY_BATCH_SIZE = 1024;
+    static constexpr size_t DEFAULT_BACKLOG_LIMIT = 100000;
     
     void ensure_file_open();
+    // "BASE <lsn>" first line written by compact
+    static bool parse_base(std::string_view line, uint64_t& lsn);
+    uint64_t record_locked(const std::string& op, const std::string& key, const std::string& value);
 };
\ No newline at end of file
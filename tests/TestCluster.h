@@ -0,0 +1,121 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include "network/TCPServer.h"
+#include "network/RESPParser.h"
+#include "network/Socket.h"
+
+// Shared fixture for tests that need real nodes on loopback ports
+
+// Polls until predicate holds; false if it still does not after timeout_ms
+template <typename Predicate>
+bool wait_until(Predicate predicate, int timeout_ms = 10000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (predicate()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return predicate();
+}
+
+// Minimal blocking client: sends raw bytes and reads back n replies
+class TestClient {
+public:
+    explicit TestClient(int port) : fd_(Socket::connect_tcp("127.0.0.1", port, 1000)) {}
+    ~TestClient() { if (fd_ >= 0) ::close(fd_); }
+    
+    bool connected() const { return fd_ >= 0; }
+    
+    std::vector<RESPParser::Reply> call(const std::string& raw, size_t count) {
+        Socket::send_all(fd_, raw);
+        std::vector<RESPParser::Reply> replies;
+        char chunk[4096];
+        while (replies.size() < count) {
+            RESPParser::Reply reply;
+            size_t consumed = 0;
+            if (RESPParser::parse_reply(buffer_, consumed, reply)) {
+                replies.push_back(reply);
+                buffer_.erase(0, consumed);
+                continue;
+            }
+            ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buffer_.append(chunk, static_cast<size_t>(n));
+        }
+        return replies;
+    }
+    
+    RESPParser::Reply command(const std::vector<std::string>& argv) {
+        auto replies = call(RESPParser::serialize_command(argv), 1);
+        if (!replies.empty()) return replies[0];
+        RESPParser::Reply failed;
+        failed.type = '-';
+        failed.str = "no reply";
+        return failed;
+    }
+    
+private:
+    int fd_;
+    std::string buffer_;
+};
+
+struct TestNode {
+    explicit TestNode(const std::string& node_id, size_t capacity = 1000, int port = 0)
+        : id(node_id), wal_file("test_tcp_" + node_id + ".wal"), cache(capacity, 4), wal(wal_file),
+          breaker(5, 1000), quorum(node_id, cache, wal, ring, peers),
+          server(port, cache, wal, ring, breaker, metrics) {}
+    
+    ~TestNode() {
+        server.stop();
+        if (thread.joinable()) thread.join();
+        std::remove(wal_file.c_str());
+    }
+    
+    std::string id;
+    std::string wal_file;
+    LRUCache cache;
+    WAL wal;
+    HashRing ring;
+    CircuitBreaker breaker;
+    MetricsCollector metrics;
+    PeerPool peers;
+    QuorumCoordinator quorum;
+    TCPServer server;
+    std::thread thread;
+};
+
+class ClusterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const std::vector<std::string> ids{"node-a", "node-b", "node-c"};
+        for (const auto& id : ids) {
+            nodes.push_back(std::make_unique<TestNode>(id));
+            nodes.back()->server.listen();
+        }
+        for (auto& node : nodes) {
+            for (auto& member : nodes) {
+                node->ring.add_node(member->id);
+                if (member != node) node->peers.add_peer(member->id, "127.0.0.1", member->server.port());
+            }
+            node->server.enable_forwarding(node->id, node->peers);
+            node->server.enable_quorum(node->quorum);
+            TestNode* raw = node.get();
+            node->thread = std::thread([raw]() { raw->server.start(); });
+        }
+    }
+    
+    TestNode& owner_of(const std::string& key) {
+        const std::string& id = nodes[0]->ring.get_node(key);
+        for (auto& node : nodes) {
+            if (node->id == id) return *node;
+        }
+        return *nodes[0];
+    }
+    
+    std::vector<std::unique_ptr<TestNode>> nodes;
+};
@@ -142,6 +142,7 @@ void test_persistence() {
     
     // Cleanup
     std::remove("test_minimal.dat");
+    std::remove("test_minimal.dat.idx");
 }
 
 void test_metrics() {
@@ -0,0 +1,157 @@
+#include "TestCluster.h"
+#include "cluster/AntiEntropy.h"
+
+TEST(MerkleTreeTest, RootDependsOnlyOnContents) {
+    MerkleTree forward, backward;
+    for (int i = 0; i < 100; ++i) forward.add("key" + std::to_string(i), "v" + std::to_string(i));
+    for (int i = 99; i >= 0; --i) backward.add("key" + std::to_string(i), "v" + std::to_string(i));
+    EXPECT_EQ(forward.root(), backward.root());
+    EXPECT_NE(forward.root(), 0u);
+    
+    // Overwrite and back again
+    forward.remove("key7", "v7");
+    forward.add("key7", "changed");
+    EXPECT_NE(forward.root(), backward.root());
+    forward.remove("key7", "changed");
+    forward.add("key7", "v7");
+    EXPECT_EQ(forward.root(), backward.root());
+    
+    // Swapped values between two keys are a different tree
+    MerkleTree swapped;
+    swapped.add("a", "1");
+    swapped.add("b", "2");
+    MerkleTree original;
+    original.add("a", "2");
+    original.add("b", "1");
+    EXPECT_NE(swapped.root(), original.root());
+}
+
+// Three nodes replicating every key (N = 3), so each holds one range with
+// all of them
+class AntiEntropyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        AntiEntropy::Config config;
+        config.replicas = 3;
+        config.interval_ms = 0;
+        for (const std::string id : {"node-a", "node-b", "node-c"}) {
+            nodes.push_back(std::make_unique<TestNode>(id, 50000));
+            nodes.back()->server.listen();
+        }
+        for (auto& node : nodes) {
+            for (auto& member : nodes) {
+                node->ring.add_node(member->id);
+                if (member != node) node->peers.add_peer(member->id, "127.0.0.1", member->server.port());
+            }
+            repairs.push_back(std::make_unique<AntiEntropy>(node->id, node->cache, node->wal, node->ring,
+                                                            node->peers, config));
+            node->cache.add_listener(repairs.back().get());
+            node->server.enable_anti_entropy(*repairs.back());
+            TestNode* raw = node.get();
+            node->thread = std::thread([raw]() { raw->server.start(); });
+        }
+    }
+    
+    void TearDown() override {
+        for (auto& node : nodes) node->server.stop();
+        repairs.clear();
+    }
+    
+    // Same versioned data on every node; returns the bytes written per node
+    size_t load(int count) {
+        size_t bytes = 0;
+        for (int i = 0; i < count; ++i) {
+            std::string key = "key" + std::to_string(i);
+            std::string value(64, 'a' + i % 26);
+            for (auto& node : nodes) node->cache.set_versioned(key, value, 100 + i);
+            bytes += key.size() + value.size();
+        }
+        return bytes;
+    }
+    
+    std::string range() const { return "node-a,node-b,node-c"; }
+    
+    std::vector<std::unique_ptr<TestNode>> nodes;
+    std::vector<std::unique_ptr<AntiEntropy>> repairs;
+};
+
+TEST_F(AntiEntropyTest, InSyncReplicasExchangeOnlyTopLevel) {
+    load(500);
+    ASSERT_EQ(repairs[0]->ranges(), std::vector<std::string>{range()});
+    EXPECT_EQ(repairs[0]->root(range()), repairs[1]->root(range()));
+    
+    EXPECT_EQ(repairs[0]->sync_with("node-b"), 0u);
+    EXPECT_EQ(repairs[0]->keys_repaired(), 0u);
+    EXPECT_LT(repairs[0]->bytes_exchanged(), 1000u);
+}
+
+TEST_F(AntiEntropyTest, RepairsOnlyDivergedKeys) {
+    size_t dataset = load(20000);
+    
+    // node-b lost a few keys, node-c took newer writes for a few others
+    for (int i = 0; i < 5; ++i) nodes[1]->cache.del("key" + std::to_string(i));
+    for (int i = 100; i < 105; ++i) {
+        nodes[2]->cache.set_versioned("key" + std::to_string(i), "newer", 1000000 + i);
+    }
+    EXPECT_NE(repairs[0]->root(range()), repairs[1]->root(range()));
+    EXPECT_NE(repairs[0]->root(range()), repairs[2]->root(range()));
+    
+    EXPECT_EQ(repairs[0]->sync_with("node-b"), 5u);  // Pushed to node-b
+    EXPECT_EQ(repairs[0]->sync_with("node-c"), 5u);  // Pulled from node-c
+    EXPECT_EQ(repairs[1]->sync_with("node-c"), 5u);
+    
+    for (auto& repair : repairs) EXPECT_EQ(repair->root(range()), repairs[0]->root(range()));
+    std::string value;
+    ASSERT_TRUE(nodes[1]->cache.get("key0", value));
+    EXPECT_EQ(value, std::string(64, 'a'));
+    ASSERT_TRUE(nodes[1]->cache.get("key101", value));
+    EXPECT_EQ(value, "newer");
+    
+    size_t exchanged = repairs[0]->bytes_exchanged() + repairs[1]->bytes_exchanged();
+    EXPECT_LT(exchanged, dataset / 50);
+}
+
+TEST_F(AntiEntropyTest, RebuildMatchesIncrementalTree) {
+    load(300);
+    for (int i = 0; i < 50; ++i) nodes[0]->cache.del("key" + std::to_string(i));
+    for (int i = 50; i < 100; ++i) nodes[0]->cache.set("key" + std::to_string(i), "overwritten");
+    uint64_t incremental = repairs[0]->root(range());
+    
+    repairs[0]->rebuild();
+    EXPECT_EQ(repairs[0]->root(range()), incremental);
+}
+
+TEST_F(AntiEntropyTest, DeletesSpreadInsteadOfComingBack) {
+    load(100);
+    TestClient client(nodes[0]->server.port());
+    EXPECT_EQ(client.command({"DEL", "key7"}).integer, 1);
+    EXPECT_EQ(repairs[0]->tombstone_count(), 1u);
+    
+    // The copy node-b still holds is deleted there, not pulled back here
+    EXPECT_EQ(repairs[0]->sync_with("node-b"), 1u);
+    EXPECT_FALSE(nodes[0]->cache.exists("key7"));
+    EXPECT_FALSE(nodes[1]->cache.exists("key7"));
+    // node-b now carries the tombstone on to node-c
+    EXPECT_EQ(repairs[1]->sync_with("node-c"), 1u);
+    EXPECT_FALSE(nodes[2]->cache.exists("key7"));
+    for (auto& repair : repairs) EXPECT_EQ(repair->root(range()), repairs[0]->root(range()));
+    
+    // An old copy is refused, a newer write is not
+    EXPECT_EQ(client.command({"VSET", "key7", "old", "107"}).integer, 0);
+    uint64_t newer = nodes[0]->cache.next_version() + 1;
+    EXPECT_EQ(client.command({"VSET", "key7", "new", std::to_string(newer)}).integer, 1);
+}
+
+TEST_F(AntiEntropyTest, CopiesKeepTheirTtl) {
+    load(100);
+    ASSERT_TRUE(nodes[0]->cache.set_versioned("session", "s", 5000, 100));
+    EXPECT_EQ(repairs[0]->sync_with("node-b"), 1u);
+    
+    std::string value;
+    uint64_t version = 0;
+    int ttl = 0;
+    ASSERT_TRUE(nodes[1]->cache.get_versioned("session", value, version, &ttl));
+    EXPECT_EQ(version, 5000u);
+    EXPECT_GT(ttl, 90);
+    EXPECT_LE(ttl, 100);
+}
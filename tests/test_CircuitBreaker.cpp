@@ -1,7 +1,7 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <chrono>
-#include "patterns/CircuitBreaker.h"
+#include "patterns/CircuitBreakerRegistry.h"
 #include <vector>
 
 TEST(CircuitBreakerTest, ClosedStateAllowsRequests) {
@@ -51,4 +51,149 @@ TEST(CircuitBreakerTest, RecoveryToClosed) {
     cb.record_success();
     EXPECT_EQ(cb.get_state(), CircuitBreaker::CLOSED);
     EXPECT_EQ(cb.get_failure_count(), 0);
-}
\ No newline at end of file
+}
+TEST(CircuitBreakerTest, SlidingWindowForgetsOldFailures) {
+    CircuitBreaker::Config config;
+    config.window_size = 10;
+    config.minimum_calls = 5;
+    CircuitBreaker cb(config);
+    
+    // Scattered failures below the rate never accumulate into a trip
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0) {
+            cb.record_failure();
+        } else {
+            cb.record_success();
+        }
+    }
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::CLOSED);
+    EXPECT_EQ(cb.get_call_count(), 10);
+    EXPECT_LE(cb.get_failure_count(), 4);
+    
+    for (int i = 0; i < 10; ++i) cb.record_success();
+    EXPECT_EQ(cb.get_failure_count(), 0);
+    
+    for (int i = 0; i < 5; ++i) cb.record_failure();
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::OPEN);
+}
+
+TEST(CircuitBreakerTest, OpensOnSlowCalls) {
+    CircuitBreaker::Config config;
+    config.window_size = 10;
+    config.minimum_calls = 4;
+    config.slow_call_ms = 100;
+    config.slow_call_rate_threshold = 0.75;
+    CircuitBreaker cb(config);
+    
+    cb.record(true, std::chrono::milliseconds(5));
+    cb.record(true, std::chrono::milliseconds(5));
+    cb.record(true, std::chrono::milliseconds(150));
+    cb.record(true, std::chrono::milliseconds(150));
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::CLOSED);  // 2 of 4 slow
+    cb.record(true, std::chrono::milliseconds(150));
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::CLOSED);  // 3 of 5
+    cb.record(true, std::chrono::milliseconds(150));
+    cb.record(true, std::chrono::milliseconds(150));
+    cb.record(true, std::chrono::milliseconds(150));
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::OPEN);    // 6 of 8
+    EXPECT_EQ(cb.get_slow_call_count(), 6);
+}
+
+TEST(CircuitBreakerTest, HalfOpenAdmitsLimitedProbes) {
+    CircuitBreaker::Config config;
+    config.window_size = 10;
+    config.minimum_calls = 1;
+    config.open_timeout_ms = 50;
+    config.half_open_probes = 2;
+    CircuitBreaker cb(config);
+    
+    cb.record_failure();
+    ASSERT_EQ(cb.get_state(), CircuitBreaker::OPEN);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    
+    EXPECT_TRUE(cb.allow_request());
+    EXPECT_TRUE(cb.allow_request());
+    EXPECT_FALSE(cb.allow_request());
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::HALF_OPEN);
+    
+    cb.record_success();
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::HALF_OPEN);
+    cb.record_success();
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::CLOSED);
+    
+    // A failed probe reopens
+    cb.record_failure();
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    EXPECT_TRUE(cb.allow_request());
+    cb.record_failure();
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::OPEN);
+    EXPECT_FALSE(cb.allow_request());
+}
+
+TEST(CircuitBreakerTest, UnansweredProbesAreReissued) {
+    CircuitBreaker::Config config;
+    config.window_size = 10;
+    config.minimum_calls = 1;
+    config.open_timeout_ms = 50;
+    config.half_open_probes = 1;
+    CircuitBreaker cb(config);
+    
+    cb.record_failure();
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    EXPECT_TRUE(cb.allow_request());  // This probe never reports back
+    EXPECT_FALSE(cb.allow_request());
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    EXPECT_TRUE(cb.allow_request());
+    EXPECT_FALSE(cb.allow_request());
+    cb.record_success();
+    EXPECT_EQ(cb.get_state(), CircuitBreaker::CLOSED);
+}
+
+TEST(CircuitBreakerTest, ConcurrentRecordingKeepsWindowTotals) {
+    CircuitBreaker::Config config;
+    config.window_size = 64;
+    config.minimum_calls = 1000000;  // Never trips
+    CircuitBreaker cb(config);
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cb, t]() {
+            for (int i = 0; i < 10000; ++i) cb.record(t % 2 == 0, std::chrono::microseconds(10));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    
+    EXPECT_EQ(cb.get_call_count(), 64);
+    EXPECT_GE(cb.get_failure_count(), 0);
+    EXPECT_LE(cb.get_failure_count(), 64);
+}
+
+TEST(CircuitBreakerRegistryTest, PeersTripIndependently) {
+    CircuitBreaker::Config config;
+    config.minimum_calls = 3;
+    CircuitBreakerRegistry registry(config);
+    
+    auto flaky = registry.get("node-b");
+    EXPECT_EQ(registry.get("node-b"), flaky);
+    for (int i = 0; i < 3; ++i) flaky->record_failure();
+    registry.get("node-c")->record_success();
+    
+    EXPECT_FALSE(registry.get("node-b")->allow_request());
+    EXPECT_TRUE(registry.get("node-c")->allow_request());
+    EXPECT_EQ(registry.open_count(), 1u);
+    EXPECT_EQ(registry.states().size(), 2u);
+}
+
+TEST(CircuitBreakerTest, LatencyPercentileOfSuccessfulCalls) {
+    CircuitBreaker::Config config;
+    config.window_size = 100;
+    CircuitBreaker breaker(config);
+    EXPECT_FALSE(breaker.latency_percentile(0.95).has_value());
+    
+    for (int i = 1; i <= 100; ++i) breaker.record(true, std::chrono::microseconds(i * 10));
+    breaker.record(false, std::chrono::microseconds(1000000));  // Failures do not count
+    EXPECT_EQ(breaker.latency_percentile(0.95)->count(), 960);
+    EXPECT_EQ(breaker.latency_percentile(0.5)->count(), 510);
+    EXPECT_FALSE(breaker.latency_percentile(0.95, 200).has_value());
+}
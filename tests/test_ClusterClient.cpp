@@ -0,0 +1,86 @@
+#include "TestCluster.h"
+#include "client/ClusterClient.h"
+
+class ClusterClientTest : public ClusterTest {
+protected:
+    std::string seed(size_t node) {
+        return "127.0.0.1:" + std::to_string(nodes[node]->server.port());
+    }
+};
+
+TEST_F(ClusterClientTest, LearnsMembershipFromOneSeed) {
+    ClusterClient client({seed(1)});
+    EXPECT_EQ(client.node_count(), 3);
+    
+    // Same ring settings as the servers, so the client picks the owner
+    for (int i = 0; i < 50; ++i) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_EQ(client.node_for(key), owner_of(key).id);
+    }
+}
+
+TEST_F(ClusterClientTest, RoutesStraightToOwner) {
+    ClusterClient client({seed(0)});
+    for (int i = 0; i < 30; ++i) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_TRUE(client.set(key, "value" + std::to_string(i)));
+    }
+    for (int i = 0; i < 30; ++i) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_TRUE(owner_of(key).cache.exists(key));
+        EXPECT_EQ(client.get(key), "value" + std::to_string(i));
+    }
+    EXPECT_TRUE(client.del("key1"));
+    EXPECT_EQ(client.get("key1"), std::nullopt);
+}
+
+TEST_F(ClusterClientTest, BatchedFanOut) {
+    ClusterClient client({seed(2)});
+    std::vector<std::pair<std::string, std::string>> entries;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 200; ++i) {
+        keys.push_back("batch" + std::to_string(i));
+        entries.emplace_back(keys.back(), std::to_string(i));
+    }
+    client.mset(entries);
+    
+    keys.push_back("absent");
+    auto pending = client.mget_async(keys);
+    auto values = pending.get();
+    ASSERT_EQ(values.size(), 201);
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(values[i], std::to_string(i));
+    }
+    EXPECT_EQ(values[200], std::nullopt);
+}
+
+TEST_F(ClusterClientTest, RefreshDropsDepartedNode) {
+    ClusterClient client({seed(0)});
+    nodes[2]->server.stop();
+    nodes[2]->thread.join();
+    nodes[0]->ring.remove_node("node-c");
+    nodes[1]->ring.remove_node("node-c");
+    
+    ASSERT_TRUE(client.refresh());
+    EXPECT_EQ(client.node_count(), 2);
+    EXPECT_NE(client.node_for("anything"), "node-c");
+}
+
+TEST_F(ClusterClientTest, RefreshesAndRetriesWhenOwnerIsGone) {
+    ClusterClient client({seed(0)});
+    std::string key;
+    for (int i = 0; key.empty(); ++i) {
+        std::string candidate = "k" + std::to_string(i);
+        if (client.node_for(candidate) == "node-c") key = candidate;
+    }
+    nodes[2]->server.stop();
+    nodes[2]->thread.join();
+    nodes[0]->ring.remove_node("node-c");
+    nodes[1]->ring.remove_node("node-c");
+    
+    // No explicit refresh: the failed send re-reads the ring
+    EXPECT_TRUE(client.set(key, "moved"));
+    EXPECT_EQ(client.node_count(), 2);
+    EXPECT_EQ(client.get(key), "moved");
+    EXPECT_TRUE(owner_of(key).cache.exists(key));
+}
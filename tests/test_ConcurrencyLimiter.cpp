@@ -0,0 +1,111 @@
+#include "TestCluster.h"
+#include "patterns/ConcurrencyLimiter.h"
+
+namespace {
+
+ConcurrencyLimiter::Config config_with_limit(int limit) {
+    ConcurrencyLimiter::Config config;
+    config.initial_limit = limit;
+    config.min_limit = 1;
+    return config;
+}
+
+// One round at full concurrency: fill the limit, then finish every request
+// with the same RTT
+void run_round(ConcurrencyLimiter& limiter, std::chrono::microseconds rtt) {
+    int admitted = 0;
+    while (limiter.try_acquire()) admitted++;
+    for (int i = 0; i < admitted; ++i) limiter.release(rtt);
+}
+
+}
+
+TEST(ConcurrencyLimiterTest, RejectsPastTheLimit) {
+    ConcurrencyLimiter limiter(config_with_limit(4));
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_FALSE(limiter.try_acquire());
+    EXPECT_EQ(limiter.rejected(), 1u);
+    
+    limiter.cancel();
+    EXPECT_EQ(limiter.in_flight(), 3);
+    EXPECT_TRUE(limiter.try_acquire());
+}
+
+TEST(ConcurrencyLimiterTest, BackgroundWorkGetsOnlyItsShare) {
+    ConcurrencyLimiter limiter(config_with_limit(10));
+    int background = 0;
+    while (limiter.try_acquire(ConcurrencyLimiter::Priority::BACKGROUND)) background++;
+    EXPECT_EQ(background, 5);
+    
+    int client = 0;
+    while (limiter.try_acquire()) client++;
+    EXPECT_EQ(client, 5);
+}
+
+TEST(ConcurrencyLimiterTest, GrowsWhileLatencyHolds) {
+    ConcurrencyLimiter limiter(config_with_limit(10));
+    for (int round = 0; round < 30; ++round) run_round(limiter, std::chrono::microseconds(1000));
+    EXPECT_GT(limiter.limit(), 20);
+}
+
+TEST(ConcurrencyLimiterTest, ShrinksAsLatencyInflates) {
+    auto config = config_with_limit(10);
+    config.max_limit = 40;
+    ConcurrencyLimiter limiter(config);
+    for (int round = 0; round < 30; ++round) run_round(limiter, std::chrono::microseconds(1000));
+    int grown = limiter.limit();
+    EXPECT_EQ(grown, 40);
+    
+    // Queueing: the same work now takes ten times as long
+    for (int round = 0; round < 3; ++round) run_round(limiter, std::chrono::microseconds(10000));
+    EXPECT_LT(limiter.limit(), grown / 2);
+}
+
+TEST(ConcurrencyLimiterTest, TimeoutsBackOff) {
+    ConcurrencyLimiter limiter(config_with_limit(100));
+    ASSERT_TRUE(limiter.try_acquire());
+    limiter.release(std::chrono::seconds(2), true);
+    EXPECT_EQ(limiter.limit(), 90);
+}
+
+TEST(ConcurrencyLimiterTest, ServerShedsWithBusy) {
+    TestNode node("node-a");
+    node.ring.add_node("node-a");
+    ConcurrencyLimiter limiter(config_with_limit(2));
+    node.server.set_concurrency_limiter(limiter);
+    node.server.listen();
+    node.thread = std::thread([&node]() { node.server.start(); });
+    TestClient client(node.server.port());
+    
+    EXPECT_EQ(client.command({"SET", "k", "v"}).str, "OK");
+    EXPECT_EQ(limiter.in_flight(), 0);
+    
+    // Saturate the limit from outside
+    ASSERT_TRUE(limiter.try_acquire());
+    ASSERT_TRUE(limiter.try_acquire());
+    auto reply = client.command({"GET", "k"});
+    EXPECT_EQ(reply.type, '-');
+    EXPECT_EQ(reply.str.rfind("BUSY", 0), 0u);
+    
+    limiter.cancel();
+    limiter.cancel();
+    EXPECT_EQ(client.command({"GET", "k"}).str, "v");
+}
+
+TEST(ConcurrencyLimiterTest, PipelinedLocalCommandsReleaseAsTheyRun) {
+    TestNode node("node-a");
+    node.ring.add_node("node-a");
+    ConcurrencyLimiter limiter(config_with_limit(4));
+    node.server.set_concurrency_limiter(limiter);
+    node.server.listen();
+    node.thread = std::thread([&node]() { node.server.start(); });
+    TestClient client(node.server.port());
+    
+    // One batch far deeper than the limit is still served in full
+    std::string batch;
+    for (int i = 0; i < 100; ++i) batch += RESPParser::serialize_command({"SET", "k" + std::to_string(i), "v"});
+    auto replies = client.call(batch, 100);
+    ASSERT_EQ(replies.size(), 100u);
+    for (const auto& reply : replies) EXPECT_EQ(reply.str, "OK");
+    EXPECT_EQ(limiter.in_flight(), 0);
+}
@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 #include "cluster/HashRing.h"
 #include <unordered_map>
+#include <map>
+#include <set>
+#include <cmath>
+#include <thread>
+#include <atomic>
 #include <vector>
+#include <algorithm>
 
 class HashRingTest : public ::testing::Test {
 protected:
@@ -54,4 +60,214 @@ TEST_F(HashRingTest, LoadDistribution) {
         EXPECT_GT(count, 100);  // At least 10% of keys
         EXPECT_LT(count, 700);  // At most 70% of keys
     }
-}
\ No newline at end of file
+}
+
+TEST_F(HashRingTest, BalancedWithDefaultVirtualNodes) {
+    std::vector<int> counts(3);
+    const int num_keys = 30000;
+    for (int i = 0; i < num_keys; ++i) {
+        counts[ring.get_node_index("key" + std::to_string(i))]++;
+    }
+    for (int count : counts) {
+        EXPECT_NEAR(count, num_keys / 3, num_keys * 0.05);
+    }
+}
+
+TEST_F(HashRingTest, WeightedNodesGetProportionalShare) {
+    HashRing weighted;
+    weighted.add_node("small");
+    weighted.add_node("large", 3);
+    
+    int large = 0;
+    const int num_keys = 20000;
+    for (int i = 0; i < num_keys; ++i) {
+        if (weighted.get_node("key" + std::to_string(i)) == "large") large++;
+    }
+    EXPECT_NEAR(large, num_keys * 3 / 4, num_keys * 0.05);
+}
+
+TEST_F(HashRingTest, RemovalOnlyMovesRemovedNodesKeys) {
+    std::vector<std::string> before;
+    for (int i = 0; i < 5000; ++i) {
+        before.push_back(ring.get_node("key" + std::to_string(i)));
+    }
+    ring.remove_node("node2");
+    EXPECT_EQ(ring.get_all_nodes().size(), 2);
+    
+    for (int i = 0; i < 5000; ++i) {
+        const std::string& now = ring.get_node("key" + std::to_string(i));
+        EXPECT_NE(now, "node2");
+        if (before[i] != "node2") {
+            EXPECT_EQ(now, before[i]);
+        }
+    }
+    
+    // Re-adding restores the original placement
+    ring.add_node("node2");
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ(ring.get_node("key" + std::to_string(i)), before[i]);
+    }
+}
+
+TEST_F(HashRingTest, ConfigurableVirtualNodes) {
+    HashRing small(8);
+    small.add_node("a");
+    small.add_node("b", 2);
+    EXPECT_EQ(small.virtual_node_count(), 24);
+    
+    HashRing empty;
+    EXPECT_EQ(empty.get_node_index("key"), HashRing::NO_NODE);
+    EXPECT_EQ(empty.get_node("key"), "localhost");
+}
+
+TEST_F(HashRingTest, RoutingDuringMembershipChurn) {
+    HashRing churn(64);
+    churn.add_node("stable-1");
+    churn.add_node("stable-2");
+    
+    std::atomic<bool> done{false};
+    std::atomic<int> bad_routes{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t]() {
+            int i = 0;
+            while (!done) {
+                const std::string& node = churn.get_node("key" + std::to_string(t * 1000000 + i++));
+                if (node.rfind("stable-", 0) != 0 && node.rfind("churn-", 0) != 0) bad_routes++;
+            }
+        });
+    }
+    
+    for (int round = 0; round < 200; ++round) {
+        std::string node = "churn-" + std::to_string(round % 10);
+        churn.add_node(node);
+        churn.remove_node(node);
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+    
+    EXPECT_EQ(bad_routes, 0);
+    EXPECT_EQ(churn.get_all_nodes().size(), 2);
+}
+
+class HashRingStrategyTest : public ::testing::TestWithParam<HashRing::Strategy> {};
+
+TEST_P(HashRingStrategyTest, BalancedAndMinimalMovementOnAdd) {
+    HashRing ring(GetParam());
+    ring.add_node("node1");
+    ring.add_node("node2");
+    ring.add_node("node3");
+    
+    const int num_keys = 20000;
+    std::vector<uint32_t> before(num_keys);
+    std::vector<int> counts(3);
+    for (int i = 0; i < num_keys; ++i) {
+        before[i] = ring.get_node_index("key" + std::to_string(i));
+        ASSERT_LT(before[i], 3u);
+        counts[before[i]]++;
+    }
+    for (int count : counts) {
+        EXPECT_NEAR(count, num_keys / 3, num_keys * 0.05);
+    }
+    
+    // Keys should only move to the new node; Maglev trades a little extra
+    // disruption between existing nodes for its O(1) table
+    ring.add_node("node4");
+    int moved = 0, stray = 0;
+    for (int i = 0; i < num_keys; ++i) {
+        uint32_t now = ring.get_node_index("key" + std::to_string(i));
+        if (now != before[i]) {
+            moved++;
+            if (ring.node_name(now) != "node4") stray++;
+        }
+    }
+    EXPECT_NEAR(moved, num_keys / 4, num_keys * 0.05);
+    if (GetParam() == HashRing::Strategy::MAGLEV) {
+        EXPECT_LT(stray, num_keys * 0.02);
+    } else {
+        EXPECT_EQ(stray, 0);
+    }
+}
+
+TEST_P(HashRingStrategyTest, WeightsAndRemoval) {
+    HashRing ring(GetParam());
+    ring.add_node("small");
+    ring.add_node("large", 3);
+    
+    int large = 0;
+    const int num_keys = 20000;
+    for (int i = 0; i < num_keys; ++i) {
+        if (ring.get_node("key" + std::to_string(i)) == "large") large++;
+    }
+    EXPECT_NEAR(large, num_keys * 3 / 4, num_keys * 0.05);
+    
+    ring.remove_node("large");
+    EXPECT_EQ(ring.get_node("any key"), "small");
+    ring.remove_node("small");
+    EXPECT_EQ(ring.get_node_index("any key"), HashRing::NO_NODE);
+}
+
+TEST_P(HashRingStrategyTest, PreferenceListStartsAtOwner) {
+    HashRing ring(GetParam());
+    EXPECT_TRUE(ring.preference_list("key", 3).empty());
+    for (int i = 1; i <= 4; ++i) ring.add_node("node" + std::to_string(i));
+    
+    for (int i = 0; i < 200; ++i) {
+        std::string key = "key" + std::to_string(i);
+        auto nodes = ring.preference_list(key, 3);
+        ASSERT_EQ(nodes.size(), 3);
+        EXPECT_EQ(nodes[0], ring.get_node(key));
+        EXPECT_EQ(std::set<std::string>(nodes.begin(), nodes.end()).size(), 3);
+        // Longer lists extend shorter ones
+        auto all = ring.preference_list(key, 10);
+        ASSERT_EQ(all.size(), 4);
+        EXPECT_TRUE(std::equal(nodes.begin(), nodes.end(), all.begin()));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllStrategies, HashRingStrategyTest,
+    ::testing::Values(HashRing::Strategy::RING, HashRing::Strategy::JUMP,
+                      HashRing::Strategy::RENDEZVOUS, HashRing::Strategy::MAGLEV),
+    [](const auto& info) { return std::string(HashRing::strategy_name(info.param)); });
+
+TEST_F(HashRingTest, BoundedLoadCapsHotKey) {
+    ring.enable_bounded_load(0.25);
+    
+    // Unloaded: acquire follows normal placement
+    uint32_t owner = ring.get_node_index("hot");
+    uint32_t first = ring.acquire("hot");
+    EXPECT_EQ(first, owner);
+    
+    std::vector<uint32_t> held{first};
+    for (int i = 1; i < 300; ++i) {
+        held.push_back(ring.acquire("hot"));
+    }
+    // ceil(1.25 * 300 / 3) = 125 in flight at most on any node
+    for (uint32_t node = 0; node < 3; ++node) {
+        EXPECT_LE(ring.load(node), 125);
+        EXPECT_GT(ring.load(node), 0);
+    }
+    
+    for (uint32_t node : held) ring.release(node);
+    for (uint32_t node = 0; node < 3; ++node) {
+        EXPECT_EQ(ring.load(node), 0);
+    }
+}
+
+TEST_F(HashRingTest, BoundedLoadSpillsOnlyWithinReplicas) {
+    ring.enable_bounded_load(0.25);
+    auto replicas = ring.preference_list("hot", 2);
+    ASSERT_EQ(replicas.size(), 2);
+    
+    std::vector<uint32_t> held;
+    for (int i = 0; i < 300; ++i) held.push_back(ring.acquire("hot", 2));
+    for (uint32_t node = 0; node < 3; ++node) {
+        bool replica = std::find(replicas.begin(), replicas.end(), ring.node_name(node)) != replicas.end();
+        if (replica) {
+            EXPECT_GT(ring.load(node), 0);
+        } else {
+            EXPECT_EQ(ring.load(node), 0);
+        }
+    }
+    for (uint32_t node : held) ring.release(node);
+}
@@ -0,0 +1,117 @@
+#include "TestCluster.h"
+#include "cluster/HintedHandoff.h"
+
+class HintedHandoffTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove(filename.c_str());
+    }
+    
+    std::string filename = "test_hints.log";
+    HashRing ring;
+    PeerPool peers;
+};
+
+TEST_F(HintedHandoffTest, KeepsLatestWritePerKeyAcrossRestart) {
+    {
+        HintedHandoff hints("node-a", ring, peers, filename);
+        EXPECT_TRUE(hints.store("node-b", {"SET", "k1", "old"}));
+        EXPECT_TRUE(hints.store("node-b", {"SET", "k1", "new value"}));
+        EXPECT_TRUE(hints.store("node-b", {"DEL", "k2"}));
+        EXPECT_TRUE(hints.store("node-c", {"SET", "k3", ""}));
+        EXPECT_EQ(hints.pending(), 3u);
+        EXPECT_EQ(hints.pending("node-b"), 2u);
+    }
+    
+    HintedHandoff reloaded("node-a", ring, peers, filename);
+    EXPECT_EQ(reloaded.pending(), 3u);
+    EXPECT_EQ(reloaded.pending("node-b"), 2u);
+    EXPECT_EQ(reloaded.pending("node-c"), 1u);
+}
+
+TEST_F(HintedHandoffTest, RefusesHintsPastTheBound) {
+    HintedHandoff::Config config;
+    config.max_hints = 2;
+    config.max_bytes = 64;
+    HintedHandoff hints("node-a", ring, peers, filename, config);
+    
+    EXPECT_TRUE(hints.store("node-b", {"SET", "k1", "v"}));
+    EXPECT_TRUE(hints.store("node-b", {"SET", "k2", "v"}));
+    EXPECT_FALSE(hints.store("node-b", {"SET", "k3", "v"}));
+    // Replacing an existing hint does not grow the count
+    EXPECT_TRUE(hints.store("node-b", {"SET", "k1", "v2"}));
+    EXPECT_FALSE(hints.store("node-b", {"SET", "k2", std::string(100, 'x')}));
+    EXPECT_EQ(hints.dropped(), 2u);
+    EXPECT_EQ(hints.pending(), 2u);
+}
+
+// node-b goes down; writes for its keys sent to node-a are hinted and
+// replayed once node-b is back on the same port
+TEST(HintedHandoffClusterTest, ReplaysWritesToReturningOwner) {
+    HintedHandoff::Config config;
+    // node-a's breaker for node-b opens while it is down; the periodic
+    // retry delivers once it lets traffic through again
+    config.retry_interval_ms = 200;
+    const std::vector<std::string> ids{"node-a", "node-b", "node-c"};
+    std::vector<std::unique_ptr<TestNode>> nodes;
+    for (const auto& id : ids) {
+        nodes.push_back(std::make_unique<TestNode>(id));
+        nodes.back()->server.listen();
+    }
+    std::vector<std::unique_ptr<HintedHandoff>> hints;
+    for (auto& node : nodes) {
+        for (auto& member : nodes) {
+            node->ring.add_node(member->id);
+            if (member != node) node->peers.add_peer(member->id, "127.0.0.1", member->server.port());
+        }
+        hints.push_back(std::make_unique<HintedHandoff>(node->id, node->ring, node->peers,
+                                                        "test_hints_" + node->id + ".log", config));
+        node->server.enable_forwarding(node->id, node->peers);
+        node->server.enable_hinted_handoff(*hints.back());
+    }
+    int b_port = nodes[1]->server.port();
+    for (size_t i : {0, 2}) {
+        TestNode* raw = nodes[i].get();
+        raw->thread = std::thread([raw]() { raw->server.start(); });
+    }
+    nodes[1].reset();  // node-b is down from the start
+    
+    std::vector<std::string> keys;
+    for (int i = 0; keys.size() < 21; ++i) {
+        std::string key = "key" + std::to_string(i);
+        if (nodes[0]->ring.get_node(key) == "node-b") keys.push_back(key);
+    }
+    std::string deleted = keys.back();
+    keys.pop_back();
+    {
+        TestClient client(nodes[0]->server.port());
+        for (const auto& key : keys) EXPECT_EQ(client.command({"SET", key, "v-" + key}).str, "OK");
+        // Nobody knows yet whether the owner had it
+        auto reply = client.command({"DEL", deleted});
+        EXPECT_EQ(reply.type, '+');
+        EXPECT_EQ(reply.str, "ACCEPTED");
+    }
+    EXPECT_EQ(hints[0]->pending("node-b") + hints[2]->pending("node-b"), keys.size() + 1);
+    
+    // node-b comes back empty on the same port
+    nodes[1] = std::make_unique<TestNode>("node-b", 1000, b_port);
+    for (const auto& id : ids) nodes[1]->ring.add_node(id);
+    // Written to the owner directly after the hints were made: replay must
+    // not overwrite it
+    nodes[1]->cache.set(keys[0], "direct");
+    TestNode* raw = nodes[1].get();
+    raw->thread = std::thread([raw]() { raw->server.start(); });
+    
+    hints[0]->owner_alive("node-b");
+    hints[2]->owner_alive("node-b");
+    ASSERT_TRUE(wait_until([&]() { return hints[0]->pending() + hints[2]->pending() == 0; }, 15000));
+    for (const auto& key : keys) {
+        std::string value;
+        ASSERT_TRUE(nodes[1]->cache.get(key, value)) << key;
+        EXPECT_EQ(value, key == keys[0] ? "direct" : "v-" + key);
+    }
+    
+    for (auto& node : nodes) node->server.stop();
+    hints.clear();
+    for (const auto& id : ids) std::remove(("test_hints_" + id + ".log").c_str());
+}
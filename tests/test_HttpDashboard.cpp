@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "monitoring/HttpDashboard.h"
+#include "network/Socket.h"
+
+class HttpDashboardTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ring.add_node("node-a");
+        ring.add_node("node-b");
+        peer_breakers.get("node-b");
+        dashboard.set_peer_breakers(peer_breakers);
+        dashboard.start(0);
+    }
+    
+    // Sends raw and reads until count complete responses have arrived
+    std::vector<std::pair<std::string, std::string>> exchange(int fd, const std::string& raw, size_t count) {
+        Socket::send_all(fd, raw);
+        std::vector<std::pair<std::string, std::string>> responses;
+        std::string buffer;
+        char chunk[4096];
+        while (responses.size() < count) {
+            size_t end = buffer.find("\r\n\r\n");
+            if (end != std::string::npos) {
+                size_t length_at = buffer.find("Content-Length: ");
+                size_t length = std::stoul(buffer.substr(length_at + 16));
+                if (buffer.size() >= end + 4 + length) {
+                    responses.emplace_back(buffer.substr(0, end), buffer.substr(end + 4, length));
+                    buffer.erase(0, end + 4 + length);
+                    continue;
+                }
+            }
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        return responses;
+    }
+    
+    std::pair<std::string, std::string> get(const std::string& path) {
+        int fd = Socket::connect_tcp("127.0.0.1", dashboard.port(), 1000);
+        auto responses = exchange(fd, "GET " + path + " HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n", 1);
+        ::close(fd);
+        return responses.empty() ? std::make_pair(std::string(), std::string()) : responses[0];
+    }
+    
+    MetricsCollector metrics;
+    LRUCache cache{100, 4};
+    HashRing ring;
+    CircuitBreaker breaker{5, 1000};
+    CircuitBreakerRegistry peer_breakers{CircuitBreaker::Config{}};
+    HttpDashboard dashboard{metrics, cache, ring, breaker};
+};
+
+TEST_F(HttpDashboardTest, ServesPrometheusMetrics) {
+    cache.set("a", "1");
+    std::string value;
+    cache.get("a", value);
+    cache.get("missing", value);
+    metrics.increment_counter("requests_success");
+    metrics.histogram("command.GET").record(2000000);
+    
+    auto [head, body] = get("/metrics");
+    EXPECT_EQ(head.rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_NE(head.find("text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(body.find("# TYPE distcache_requests_success_total counter\ndistcache_requests_success_total 1\n"),
+              std::string::npos);
+    EXPECT_NE(body.find("distcache_cache_entries 1\n"), std::string::npos);
+    EXPECT_NE(body.find("distcache_cache_hits_total 1\n"), std::string::npos);
+    EXPECT_NE(body.find("distcache_cache_misses_total 1\n"), std::string::npos);
+    EXPECT_NE(body.find("distcache_ring_member{node=\"node-b\"} 1\n"), std::string::npos);
+    EXPECT_NE(body.find("distcache_circuit_breaker_state{peer=\"node-b\"} 0\n"), std::string::npos);
+    EXPECT_NE(body.find("distcache_latency_seconds{name=\"command.GET\",quantile=\"0.99\"} 0.002"),
+              std::string::npos);
+}
+
+TEST_F(HttpDashboardTest, ServesStatsJson) {
+    auto [head, body] = get("/stats");
+    EXPECT_NE(head.find("application/json"), std::string::npos);
+    EXPECT_EQ(body.front(), '{');
+    EXPECT_EQ(body.back(), '}');
+    EXPECT_NE(body.find("\"ring\":[\"node-a\",\"node-b\"]"), std::string::npos);
+    EXPECT_NE(body.find("\"local\":\"CLOSED\""), std::string::npos);
+    EXPECT_NE(body.find("\"capacity\":100"), std::string::npos);
+}
+
+TEST_F(HttpDashboardTest, KeepAliveAndErrors) {
+    int fd = Socket::connect_tcp("127.0.0.1", dashboard.port(), 1000);
+    // Pipelined on one connection
+    auto responses = exchange(fd, "GET /stats HTTP/1.1\r\n\r\nGET /nope HTTP/1.1\r\n\r\nPOST /metrics HTTP/1.1\r\n\r\n", 3);
+    ::close(fd);
+    ASSERT_EQ(responses.size(), 3u);
+    EXPECT_EQ(responses[0].first.rfind("HTTP/1.1 200", 0), 0u);
+    EXPECT_EQ(responses[1].first.rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_EQ(responses[2].first.rfind("HTTP/1.1 405", 0), 0u);
+}
+
+TEST_F(HttpDashboardTest, StopsPromptly) {
+    auto start = std::chrono::steady_clock::now();
+    dashboard.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_LT(Socket::connect_tcp("127.0.0.1", dashboard.port(), 200), 0);
+}
@@ -150,3 +150,56 @@ TEST_F(LRUCacheTest, HitRateTracking) {
     double hit_rate = cache->hit_rate();
     EXPECT_DOUBLE_EQ(hit_rate, 2.0/3.0); // 2 hits out of 3 attempts
 }
+
+TEST(LRUCacheShardingTest, CapacitySplitAcrossShards) {
+    LRUCache sharded(100, 4);
+    EXPECT_EQ(sharded.shard_count(), 4);
+    EXPECT_EQ(sharded.capacity(), 100);
+    
+    for (int i = 0; i < 1000; ++i) {
+        sharded.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    
+    EXPECT_LE(sharded.size(), 100);
+    EXPECT_GT(sharded.size(), 50);
+}
+
+TEST(LRUCacheShardingTest, SnapshotShardCoversAllKeys) {
+    LRUCache sharded(1000, 4);
+    for (int i = 0; i < 200; ++i) {
+        sharded.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    
+    size_t total = 0;
+    for (size_t s = 0; s < sharded.shard_count(); ++s) {
+        for (const auto& [key, value] : sharded.snapshot_shard(s)) {
+            EXPECT_EQ(sharded.shard_for(key), s);
+            total++;
+        }
+    }
+    EXPECT_EQ(total, 200);
+}
+
+TEST_F(LRUCacheTest, VersionedWritesKeepNewest) {
+    uint64_t v1 = cache->next_version();
+    uint64_t v2 = cache->next_version();
+    EXPECT_GT(v2, v1);
+    
+    EXPECT_TRUE(cache->set_versioned("key", "new", v2));
+    EXPECT_FALSE(cache->set_versioned("key", "old", v1));
+    
+    std::string value;
+    uint64_t version = 0;
+    ASSERT_TRUE(cache->get_versioned("key", value, version));
+    EXPECT_EQ(value, "new");
+    EXPECT_EQ(version, v2);
+    
+    // Equal versions resolve by value, the same way on every replica
+    EXPECT_TRUE(cache->set_versioned("key", "newer", v2));
+    EXPECT_FALSE(cache->set_versioned("key", "a", v2));
+    
+    // Plain writes tick past every version seen
+    cache->set("key", "plain");
+    ASSERT_TRUE(cache->get_versioned("key", value, version));
+    EXPECT_GT(version, v2);
+}
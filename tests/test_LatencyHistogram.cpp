@@ -0,0 +1,91 @@
+#include "TestCluster.h"
+#include "monitoring/Clock.h"
+#include "monitoring/LatencyHistogram.h"
+
+TEST(LatencyHistogramTest, BucketsAreWithinRelativeError) {
+    std::vector<uint64_t> values{0, 1, 31, 32, 33, 1000, 123456, 987654321, LatencyHistogram::MAX_VALUE};
+    for (uint64_t value : values) {
+        size_t bucket = LatencyHistogram::bucket_of(value);
+        ASSERT_LT(bucket, LatencyHistogram::BUCKETS);
+        uint64_t limit = LatencyHistogram::bucket_limit(bucket);
+        EXPECT_GE(limit, value);
+        EXPECT_LE(limit - value, value / LatencyHistogram::SUB_BUCKETS) << value;
+    }
+    // Every bucket follows on from the previous one
+    for (size_t i = 1; i < LatencyHistogram::BUCKETS; ++i) {
+        EXPECT_EQ(LatencyHistogram::bucket_of(LatencyHistogram::bucket_limit(i - 1) + 1), i);
+    }
+}
+
+TEST(LatencyHistogramTest, PercentilesOfUniformLatencies) {
+    LatencyHistogram histogram;
+    // 1us .. 10ms in 1us steps
+    for (uint64_t us = 1; us <= 10000; ++us) histogram.record(us * 1000);
+    
+    auto summary = histogram.summary();
+    EXPECT_EQ(summary.count, 10000u);
+    EXPECT_EQ(summary.max, 10000000u);
+    EXPECT_NEAR(summary.p50, 5000000.0, 5000000.0 / 32);
+    EXPECT_NEAR(summary.p90, 9000000.0, 9000000.0 / 32);
+    EXPECT_NEAR(summary.p99, 9900000.0, 9900000.0 / 32);
+    EXPECT_NEAR(summary.p999, 9990000.0, 9990000.0 / 32);
+    EXPECT_LE(summary.p999, summary.max);
+}
+
+TEST(LatencyHistogramTest, OldSamplesLeaveTheWindow) {
+    LatencyHistogram histogram(std::chrono::milliseconds(100), 2);
+    histogram.record(1000);
+    EXPECT_EQ(histogram.summary().count, 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_EQ(histogram.summary().count, 0u);
+    
+    histogram.record(2000);
+    auto summary = histogram.summary();
+    EXPECT_EQ(summary.count, 1u);
+    EXPECT_EQ(summary.max, 2000u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecordingIsExact) {
+    LatencyHistogram histogram(std::chrono::seconds(60), 2);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (uint64_t i = 0; i < 10000; ++i) histogram.record(100 + i + t);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    auto summary = histogram.summary();
+    EXPECT_EQ(summary.count, 40000u);
+    EXPECT_EQ(summary.max, 10102u);
+}
+
+TEST(ClockTest, TracksSteadyClock) {
+    uint64_t start = Clock::now_ns();
+    auto steady_start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    double elapsed = static_cast<double>(Clock::elapsed_ns(start));
+    double expected = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - steady_start).count();
+    EXPECT_NEAR(elapsed, expected, expected * 0.05);
+}
+
+TEST(ServerLatencyTest, RecordsPerCommandAndPhase) {
+    TestNode node("node-a");
+    node.ring.add_node("node-a");
+    node.server.listen();
+    node.thread = std::thread([&node]() { node.server.start(); });
+    
+    TestClient client(node.server.port());
+    for (int i = 0; i < 5; ++i) client.command({"SET", "k" + std::to_string(i), "v"});
+    for (int i = 0; i < 7; ++i) client.command({"GET", "k" + std::to_string(i)});
+    client.command({"EXISTS", "k0"});
+    
+    auto summaries = node.metrics.latency_summaries();
+    EXPECT_EQ(summaries["command.SET"].count, 5u);
+    EXPECT_EQ(summaries["command.GET"].count, 7u);
+    EXPECT_EQ(summaries["command.other"].count, 1u);
+    EXPECT_EQ(summaries["phase.parse"].count, 13u);
+    EXPECT_EQ(summaries["phase.wal"].count, 5u);
+    EXPECT_GE(summaries["phase.write"].count, 12u);  // The last may still be in flight
+    EXPECT_GT(summaries["command.SET"].max, 0u);
+    EXPECT_NE(node.metrics.generate_json().find("\"command.GET\":{\"count\":7"), std::string::npos);
+}
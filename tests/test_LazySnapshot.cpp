@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <thread>
+#include "storage/LazySnapshot.h"
+#include "storage/MMapPersistence.h"
+
+class LazySnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_file = "test_lazy_snapshot.dat";
+        MMapPersistence persistence(test_file);
+        std::unordered_map<std::string, std::string> data;
+        for (int i = 0; i < 1000; ++i) {
+            data["key" + std::to_string(i)] = "value " + std::to_string(i);
+        }
+        persistence.snapshot(data);
+    }
+    
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".idx").c_str());
+    }
+    
+    std::string test_file;
+};
+
+TEST_F(LazySnapshotTest, ServesMissesFromMapping) {
+    auto lazy = std::make_shared<LazySnapshot>(test_file);
+    ASSERT_TRUE(lazy->is_valid());
+    EXPECT_EQ(lazy->record_count(), 1000);
+    
+    LRUCache cache(2000, 4);
+    cache.attach_warm_source(lazy);
+    EXPECT_EQ(cache.size(), 0);
+    
+    std::string value;
+    EXPECT_TRUE(cache.get("key42", value));
+    EXPECT_EQ(value, "value 42");
+    EXPECT_EQ(cache.size(), 1); // Promoted on first touch
+    EXPECT_FALSE(cache.get("missing", value));
+}
+
+TEST_F(LazySnapshotTest, WritesSupersedeSnapshotCopy) {
+    auto lazy = std::make_shared<LazySnapshot>(test_file);
+    LRUCache cache(2000, 4);
+    cache.attach_warm_source(lazy);
+    
+    cache.del("key1");
+    cache.set("key2", "fresh");
+    lazy->load_remaining(cache);
+    cache.detach_warm_source();
+    
+    std::string value;
+    EXPECT_FALSE(cache.get("key1", value));
+    EXPECT_TRUE(cache.get("key2", value));
+    EXPECT_EQ(value, "fresh");
+    EXPECT_EQ(cache.size(), 999);
+}
+
+TEST_F(LazySnapshotTest, BackgroundFillWithConcurrentReads) {
+    auto lazy = std::make_shared<LazySnapshot>(test_file);
+    LRUCache cache(2000, 4);
+    cache.attach_warm_source(lazy);
+    
+    std::thread loader([&]() { lazy->load_remaining(cache); });
+    for (int i = 0; i < 1000; ++i) {
+        std::string value;
+        EXPECT_TRUE(cache.get("key" + std::to_string(i), value));
+        EXPECT_EQ(value, "value " + std::to_string(i));
+    }
+    loader.join();
+    cache.detach_warm_source();
+    
+    EXPECT_EQ(cache.size(), 1000);
+}
+
+TEST_F(LazySnapshotTest, StaleIndexIsRejected) {
+    // Rewrite the snapshot without going through MMapPersistence
+    {
+        std::ofstream out(test_file, std::ios::app);
+        out << "extra entry\n";
+    }
+    LazySnapshot lazy(test_file);
+    EXPECT_FALSE(lazy.is_valid());
+}
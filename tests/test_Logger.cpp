@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "monitoring/Logger.h"
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Logger::instance().flush();
+        Logger::instance().set_sink([this](const std::string& lines) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            output_ += lines;
+        });
+    }
+
+    void TearDown() override {
+        Logger::instance().set_level(Logger::Level::Info);
+        Logger::instance().set_sink([](const std::string& lines) {
+            std::fwrite(lines.data(), 1, lines.size(), stdout);
+            std::fflush(stdout);
+        });
+    }
+
+    std::string output() {
+        Logger::instance().flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return output_;
+    }
+
+    std::mutex mutex_;
+    std::string output_;
+};
+
+TEST_F(LoggerTest, FormatsLevelComponentAndMessage) {
+    LOG_WARN("Test", "value " << 42);
+    std::string out = output();
+
+    // 2026-01-02T03:04:05.123456Z WARN t3 [Test] value 42
+    ASSERT_EQ(out.back(), '\n');
+    EXPECT_EQ(out.find('T'), 10u);
+    EXPECT_EQ(out.find('Z'), 26u);
+    EXPECT_NE(out.find(" WARN t"), std::string::npos);
+    EXPECT_NE(out.find(" [Test] value 42\n"), std::string::npos);
+}
+
+TEST_F(LoggerTest, DisabledLevelsSkipFormatting) {
+    int evaluated = 0;
+    auto expensive = [&] { ++evaluated; return "x"; };
+
+    LOG_DEBUG("Test", expensive());
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_EQ(output(), "");
+
+    Logger::instance().set_level(Logger::Level::Debug);
+    LOG_DEBUG("Test", expensive());
+    EXPECT_EQ(evaluated, 1);
+    EXPECT_NE(output().find("DEBUG"), std::string::npos);
+
+    Logger::instance().set_level(Logger::Level::Off);
+    LOG_ERROR("Test", expensive());
+    EXPECT_EQ(evaluated, 1);
+}
+
+TEST_F(LoggerTest, KeepsEachThreadsOrder) {
+    const int threads = 4, lines = 200;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([t] {
+            for (int i = 0; i < lines; ++i) {
+                LOG_INFO("Test", "w" << t << " " << i);
+                // Stay under the ring capacity even if the drainer is slow
+                if (i % 100 == 99) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        });
+    }
+    for (auto& w : writers) w.join();
+    std::string out = output();
+
+    std::map<int, int> next;
+    size_t start = 0, count = 0;
+    while ((start = out.find("[Test] w", start)) != std::string::npos) {
+        int writer = 0, line = 0;
+        ASSERT_EQ(std::sscanf(out.c_str() + start, "[Test] w%d %d", &writer, &line), 2);
+        EXPECT_GE(line, next[writer]);
+        next[writer] = line + 1;
+        ++count;
+        ++start;
+    }
+    EXPECT_EQ(count, static_cast<size_t>(threads * lines));
+}
+
+TEST_F(LoggerTest, TruncatesLongMessages) {
+    LOG_INFO("Test", std::string(Logger::MAX_MESSAGE * 2, 'a'));
+    std::string out = output();
+    EXPECT_EQ(out.find(std::string(Logger::MAX_MESSAGE + 1, 'a')), std::string::npos);
+    EXPECT_NE(out.find(std::string(Logger::MAX_MESSAGE, 'a') + "\n"), std::string::npos);
+}
+
+TEST(LoggerLevelTest, ParsesLevelNames) {
+    Logger::Level level;
+    ASSERT_TRUE(Logger::parse_level("debug", level));
+    EXPECT_EQ(level, Logger::Level::Debug);
+    ASSERT_TRUE(Logger::parse_level("WARN", level));
+    EXPECT_EQ(level, Logger::Level::Warn);
+    ASSERT_TRUE(Logger::parse_level("off", level));
+    EXPECT_EQ(level, Logger::Level::Off);
+    EXPECT_FALSE(Logger::parse_level("verbose", level));
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <fstream>
+#include <filesystem>
 #include <unordered_map>
 #include "storage/MMapPersistence.h"
 
@@ -13,6 +14,12 @@ protected:
     void TearDown() override {
         persistence.reset();
         std::remove(test_file.c_str());
+        std::remove((test_file + ".idx").c_str());
+        for (const auto& file : std::filesystem::directory_iterator(".")) {
+            if (file.path().filename().string().rfind(test_file + ".delta.", 0) == 0) {
+                std::filesystem::remove(file.path());
+            }
+        }
     }
     
     std::string test_file;
@@ -86,4 +93,170 @@ TEST_F(MMapPersistenceTest, OverwriteExistingFile) {
     
     EXPECT_EQ(loaded_data.size(), 1);
     EXPECT_EQ(loaded_data["key2"], "value2");
-}
\ No newline at end of file
+}
+
+TEST_F(MMapPersistenceTest, SnapshotFromShardedCache) {
+    LRUCache cache(1000, 8);
+    for (int i = 0; i < 500; ++i) {
+        cache.set("key" + std::to_string(i), "value " + std::to_string(i));
+    }
+    
+    persistence->snapshot(cache);
+    auto loaded_data = persistence->load();
+    
+    EXPECT_EQ(loaded_data.size(), 500);
+    EXPECT_EQ(loaded_data["key0"], "value 0");
+    EXPECT_EQ(loaded_data["key499"], "value 499");
+}
+
+TEST_F(MMapPersistenceTest, AsyncSnapshotDoesNotBlockWriters) {
+    LRUCache cache(10000, 8);
+    for (int i = 0; i < 5000; ++i) {
+        cache.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    
+    EXPECT_TRUE(persistence->async_snapshot(cache));
+    
+    // Writers keep going while the snapshot streams shard by shard
+    for (int i = 5000; i < 6000; ++i) {
+        cache.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    
+    persistence->wait_for_snapshot();
+    EXPECT_FALSE(persistence->snapshot_in_progress());
+    
+    auto loaded_data = persistence->load();
+    EXPECT_GE(loaded_data.size(), 5000);
+    EXPECT_EQ(loaded_data["key0"], "value0");
+}
+
+TEST_F(MMapPersistenceTest, ParallelLoadIntoCache) {
+    std::unordered_map<std::string, std::string> data;
+    for (int i = 0; i < 10000; ++i) {
+        data["key" + std::to_string(i)] = "value with spaces " + std::to_string(i);
+    }
+    persistence->snapshot(data);
+    
+    LRUCache cache(20000, 8);
+    size_t loaded = persistence->load_into(cache, 4);
+    
+    EXPECT_EQ(loaded, 10000);
+    EXPECT_EQ(cache.size(), 10000);
+    
+    std::string value;
+    EXPECT_TRUE(cache.get("key9999", value));
+    EXPECT_EQ(value, "value with spaces 9999");
+}
+
+TEST_F(MMapPersistenceTest, DeltaSnapshotsOnlyWriteChangedKeys) {
+    LRUCache cache(10000, 4);
+    for (int i = 0; i < 1000; ++i) {
+        cache.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    persistence->snapshot(cache);
+    size_t base_size = persistence->get_file_size();
+    
+    cache.set("key1", "updated");
+    cache.set("new_key", "new value");
+    cache.del("key2");
+    persistence->snapshot_delta(cache);
+    
+    EXPECT_EQ(persistence->delta_count(), 1);
+    EXPECT_EQ(persistence->get_file_size(), base_size); // Base untouched
+    
+    auto loaded_data = persistence->load();
+    EXPECT_EQ(loaded_data.size(), 1000);
+    EXPECT_EQ(loaded_data["key1"], "updated");
+    EXPECT_EQ(loaded_data["new_key"], "new value");
+    EXPECT_EQ(loaded_data.count("key2"), 0);
+}
+
+TEST_F(MMapPersistenceTest, MergeFoldsDeltasIntoBase) {
+    LRUCache cache(10000, 4);
+    for (int i = 0; i < 100; ++i) {
+        cache.set("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    persistence->snapshot(cache);
+    
+    cache.set("key1", "first");
+    persistence->snapshot_delta(cache);
+    cache.set("key1", "second");
+    cache.del("key3");
+    persistence->snapshot_delta(cache);
+    EXPECT_EQ(persistence->delta_count(), 2);
+    
+    persistence->merge_deltas();
+    EXPECT_EQ(persistence->delta_count(), 0);
+    
+    LRUCache restored(10000, 4);
+    EXPECT_EQ(persistence->load_into(restored, 2), 99);
+    
+    std::string value;
+    EXPECT_TRUE(restored.get("key1", value));
+    EXPECT_EQ(value, "second");
+    EXPECT_FALSE(restored.get("key3", value));
+}
+
+TEST_F(MMapPersistenceTest, SnapshotsCompactTheWal) {
+    const std::string wal_file = "test_snapshot_compact.wal";
+    std::remove(wal_file.c_str());
+    {
+        WAL wal(wal_file);
+        persistence->attach_wal(wal);
+        LRUCache cache(1000, 4);
+        for (int i = 0; i < 50; ++i) {
+            cache.set("key" + std::to_string(i), "value");
+            wal.append("SET", "key" + std::to_string(i), "value");
+        }
+        persistence->snapshot(cache);
+        EXPECT_TRUE(wal.replay().empty());
+        
+        cache.set("key1", "updated");
+        wal.append("SET", "key1", "updated");
+        persistence->snapshot_delta(cache);
+        cache.set("key2", "after");
+        wal.append("SET", "key2", "after");
+        
+        // Only the write after the delta is left to replay
+        auto ops = wal.replay();
+        ASSERT_EQ(ops.size(), 1u);
+        EXPECT_EQ(std::get<1>(ops[0]), "key2");
+        EXPECT_EQ(wal.last_lsn(), 52u);
+    }
+    std::remove(wal_file.c_str());
+}
+
+TEST_F(MMapPersistenceTest, BaseSkipsDeltasItAlreadyContains) {
+    LRUCache cache(1000, 4);
+    cache.set("key1", "value1");
+    cache.set("key2", "value2");
+    persistence->snapshot(cache);
+    
+    cache.del("key2");
+    persistence->snapshot_delta(cache);
+    ASSERT_EQ(persistence->delta_count(), 1);
+    std::string delta_file = test_file + ".delta.1";
+    std::filesystem::copy_file(delta_file, "stale_delta.tmp");
+    
+    cache.set("key2", "back");
+    persistence->snapshot(cache);
+    
+    // A crash after the new base is in place but before the delta it folded
+    // in is removed: the leftover delete must not be applied on top
+    std::filesystem::rename("stale_delta.tmp", delta_file);
+    persistence = std::make_unique<MMapPersistence>(test_file);
+    EXPECT_EQ(persistence->delta_count(), 0);
+    
+    LRUCache restored(1000, 4);
+    EXPECT_EQ(persistence->load_into(restored, 2), 2);
+    std::string value;
+    ASSERT_TRUE(restored.get("key2", value));
+    EXPECT_EQ(value, "back");
+    
+    // New deltas are numbered past the ones the base covers
+    restored.enable_dirty_tracking();
+    restored.set("key3", "value3");
+    persistence->snapshot_delta(restored);
+    EXPECT_TRUE(std::filesystem::exists(test_file + ".delta.2"));
+    EXPECT_EQ(persistence->load()["key3"], "value3");
+}
@@ -91,4 +91,38 @@ TEST_F(MetricsCollectorTest, JSONFormatValidation) {
     EXPECT_NE(json.find("requests"), std::string::npos);
     EXPECT_NE(json.find("connections"), std::string::npos);
     EXPECT_NE(json.find("test_ops"), std::string::npos);
-}
\ No newline at end of file
+}
+TEST_F(MetricsCollectorTest, ShardedCountersSumExactly) {
+    auto ops = metrics->counter("ops");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([this, ops]() {
+            for (int i = 0; i < 10000; ++i) {
+                ops.increment();
+                metrics->increment_counter("by_name");
+                metrics->record_latency(2.0);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    
+    EXPECT_EQ(metrics->get_counter("ops"), 80000u);
+    EXPECT_EQ(metrics->get_counter("by_name"), 80000u);
+    EXPECT_EQ(metrics->get_counter("never_registered"), 0u);
+    EXPECT_EQ(metrics->request_count(), 80000u);
+    EXPECT_NEAR(metrics->average_latency_ms(), 2.0, 1e-6);
+    EXPECT_NE(metrics->generate_json().find("\"ops\":80000"), std::string::npos);
+}
+
+TEST_F(MetricsCollectorTest, CounterRegistrationIsIdempotentAndBounded) {
+    auto first = metrics->counter("same");
+    auto second = metrics->counter("same");
+    first.increment();
+    second.increment(2);
+    EXPECT_EQ(metrics->get_counter("same"), 3u);
+    
+    for (size_t i = 1; i < MetricsCollector::MAX_COUNTERS; ++i) metrics->counter("c" + std::to_string(i));
+    EXPECT_THROW(metrics->counter("one_too_many"), std::runtime_error);
+    MetricsCollector::Counter detached;
+    detached.increment();  // No-op
+}
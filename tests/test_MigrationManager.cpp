@@ -0,0 +1,189 @@
+#include "TestCluster.h"
+#include "cluster/MigrationManager.h"
+
+// node-a and node-b hold data; node-c joins and takes over its share
+class MigrationManagerTest : public ::testing::Test {
+protected:
+    void start(size_t max_bytes_per_sec) {
+        MigrationManager::Config config;
+        config.max_bytes_per_sec = max_bytes_per_sec;
+        config.batch_keys = 32;
+        
+        for (const std::string id : {"node-a", "node-b", "node-c"}) {
+            nodes.push_back(std::make_unique<TestNode>(id));
+            nodes.back()->server.listen();
+        }
+        for (auto& node : nodes) {
+            for (auto& member : nodes) {
+                if (member->id != "node-c" || node->id == "node-c") node->ring.add_node(member->id);
+                if (member != node) node->peers.add_peer(member->id, "127.0.0.1", member->server.port());
+            }
+            migrations.push_back(std::make_unique<MigrationManager>(node->id, node->cache, node->wal,
+                                                                    node->ring, node->peers, config));
+            node->server.enable_forwarding(node->id, node->peers);
+            node->server.enable_migration(*migrations.back());
+            TestNode* raw = node.get();
+            node->thread = std::thread([raw]() { raw->server.start(); });
+        }
+    }
+    
+    void TearDown() override {
+        for (auto& node : nodes) node->server.stop();
+        migrations.clear();
+    }
+    
+    // Writes through node-a before node-c is known to the others
+    void load(int count) {
+        TestClient client(nodes[0]->server.port());
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(client.command({"SET", "key" + std::to_string(i), "value" + std::to_string(i)}).str, "OK");
+        }
+        ASSERT_EQ(nodes[2]->cache.size(), 0);
+    }
+    
+    void scale_out() {
+        migrations[2]->join();
+        migrations[0]->add_node("node-c");
+        migrations[1]->add_node("node-c");
+    }
+    
+    bool settled() {
+        return !migrations[0]->migrating() && !migrations[1]->migrating() && migrations[2]->pending_handoffs() == 0;
+    }
+    
+    std::vector<std::unique_ptr<TestNode>> nodes;
+    std::vector<std::unique_ptr<MigrationManager>> migrations;
+};
+
+TEST_F(MigrationManagerTest, MovedKeysEndUpOnlyOnNewOwner) {
+    start(64 << 20);
+    load(300);
+    scale_out();
+    ASSERT_TRUE(wait_until([this]() { return settled(); }));
+    
+    size_t on_c = 0;
+    for (int i = 0; i < 300; ++i) {
+        std::string key = "key" + std::to_string(i);
+        const std::string& owner = nodes[0]->ring.get_node(key);
+        for (auto& node : nodes) {
+            EXPECT_EQ(node->cache.exists(key), node->id == owner) << key << " on " << node->id;
+        }
+        if (owner == "node-c") on_c++;
+    }
+    EXPECT_GT(on_c, 50);
+    EXPECT_EQ(migrations[0]->keys_sent() + migrations[1]->keys_sent(), on_c);
+}
+
+TEST_F(MigrationManagerTest, NoMissesWhileHandoffIsThrottled) {
+    // About 16 bytes per entry and ~100 entries moved: the handoff takes
+    // well over a second
+    start(1000);
+    load(300);
+    scale_out();
+    
+    // Reads through the new owner during the handoff still find every key
+    TestClient client(nodes[2]->server.port());
+    int misses = 0;
+    for (int i = 0; i < 300; ++i) {
+        auto reply = client.command({"GET", "key" + std::to_string(i)});
+        if (reply.is_nil || reply.str != "value" + std::to_string(i)) misses++;
+    }
+    EXPECT_EQ(misses, 0);
+    EXPECT_TRUE(migrations[0]->migrating() || migrations[1]->migrating());
+    
+    ASSERT_TRUE(wait_until([this]() { return settled(); }));
+    for (int i = 0; i < 300; ++i) {
+        EXPECT_EQ(client.command({"GET", "key" + std::to_string(i)}).str, "value" + std::to_string(i));
+    }
+}
+
+TEST_F(MigrationManagerTest, WritesDuringHandoffWinOverStreamedCopies) {
+    start(1000);
+    load(200);
+    scale_out();
+    
+    // Keys node-c now owns, overwritten or deleted before their copies arrive
+    std::vector<std::string> owned;
+    for (int i = 0; i < 200 && owned.size() < 10; ++i) {
+        std::string key = "key" + std::to_string(i);
+        if (nodes[2]->ring.get_node(key) == "node-c") owned.push_back(key);
+    }
+    ASSERT_EQ(owned.size(), 10);
+    TestClient client(nodes[2]->server.port());
+    for (size_t i = 0; i < owned.size(); ++i) {
+        if (i % 2 == 0) {
+            EXPECT_EQ(client.command({"SET", owned[i], "fresh"}).str, "OK");
+        } else {
+            client.command({"DEL", owned[i]});
+        }
+    }
+    
+    ASSERT_TRUE(wait_until([this]() { return settled(); }));
+    for (size_t i = 0; i < owned.size(); ++i) {
+        auto reply = client.command({"GET", owned[i]});
+        if (i % 2 == 0) {
+            EXPECT_EQ(reply.str, "fresh") << owned[i];
+        } else {
+            EXPECT_TRUE(reply.is_nil) << owned[i];
+        }
+    }
+}
+
+TEST_F(MigrationManagerTest, MovedKeysKeepVersionAndTtl) {
+    start(64 << 20);
+    std::string key;
+    for (int i = 0; key.empty(); ++i) {
+        std::string candidate = "ttl" + std::to_string(i);
+        if (nodes[0]->ring.get_node(candidate) == "node-a" && nodes[2]->ring.get_node(candidate) == "node-c") {
+            key = candidate;
+        }
+    }
+    ASSERT_TRUE(nodes[0]->cache.set_versioned(key, "value", 777, 100));
+    scale_out();
+    ASSERT_TRUE(wait_until([this]() { return settled(); }));
+    
+    std::string value;
+    uint64_t version = 0;
+    int ttl = 0;
+    ASSERT_TRUE(nodes[2]->cache.get_versioned(key, value, version, &ttl));
+    EXPECT_EQ(value, "value");
+    EXPECT_EQ(version, 777u);
+    EXPECT_GT(ttl, 90);
+    EXPECT_LE(ttl, 100);
+    
+    // The old owner logged dropping its copy, so a restart does not bring it back
+    EXPECT_FALSE(nodes[0]->cache.exists(key));
+    auto ops = nodes[0]->wal.replay();
+    ASSERT_FALSE(ops.empty());
+    EXPECT_EQ(std::get<0>(ops.back()), "DEL");
+    EXPECT_EQ(std::get<1>(ops.back()), key);
+}
+
+TEST_F(MigrationManagerTest, FailedHandoffIsResentBeforeItIsDone) {
+    start(64 << 20);
+    load(300);
+    // node-a cannot reach node-c at first
+    nodes[0]->peers.add_peer("node-c", "127.0.0.1", 1);
+    scale_out();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    
+    // node-a keeps what it could not hand over, and node-c still falls back
+    // to it rather than being told the handoff is done
+    size_t kept = 0;
+    for (int i = 0; i < 300; ++i) {
+        std::string key = "key" + std::to_string(i);
+        if (nodes[0]->ring.get_node(key) == "node-c" && nodes[0]->cache.exists(key)) kept++;
+    }
+    EXPECT_GT(kept, 0);
+    EXPECT_EQ(migrations[2]->pending_handoffs(), 1);
+    
+    nodes[0]->peers.add_peer("node-c", "127.0.0.1", nodes[2]->server.port());
+    ASSERT_TRUE(wait_until([this]() { return settled(); }));
+    for (int i = 0; i < 300; ++i) {
+        std::string key = "key" + std::to_string(i);
+        const std::string& owner = nodes[0]->ring.get_node(key);
+        for (auto& node : nodes) {
+            EXPECT_EQ(node->cache.exists(key), node->id == owner) << key << " on " << node->id;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "TestCluster.h"
+#include "cluster/NodeDiscovery.h"
+#include "cluster/HashRing.h"
+#include <memory>
+#include <thread>
+
+namespace {
+
+NodeDiscovery::Config fast_config() {
+    NodeDiscovery::Config config;
+    config.probe_interval_ms = 50;
+    config.probe_timeout_ms = 20;
+    return config;
+}
+
+}
+
+class NodeDiscoveryTest : public ::testing::Test {
+protected:
+    // Starts a member that only knows the first one; every member keeps a
+    // ring in step with what it sees
+    NodeDiscovery& add_member(const std::string& id, int port = 0) {
+        auto node = std::make_unique<NodeDiscovery>(id, port, fast_config());
+        auto ring = std::make_unique<HashRing>();
+        ring->add_node(id);
+        HashRing* raw_ring = ring.get();
+        node->set_listener([raw_ring](const NodeDiscovery::NodeInfo& info) {
+            if (info.state == NodeDiscovery::State::DEAD) raw_ring->remove_node(info.node_id);
+            else if (info.state == NodeDiscovery::State::ALIVE) raw_ring->add_node(info.node_id);
+        });
+        if (!nodes.empty()) {
+            node->add_seed_node(ids[0], "127.0.0.1", nodes[0]->port());
+            ring->add_node(ids[0]);
+        }
+        node->start_discovery();
+        nodes.push_back(std::move(node));
+        rings.push_back(std::move(ring));
+        ids.push_back(id);
+        return *nodes.back();
+    }
+    
+    bool all_see(size_t count) {
+        for (auto& node : nodes) {
+            if (node && node->get_alive_nodes().size() != count) return false;
+        }
+        return true;
+    }
+    
+    // Listeners run after the state change is visible, so rings can lag
+    bool rings_hold(size_t count) {
+        for (auto& ring : rings) {
+            if (ring->get_all_nodes().size() != count) return false;
+        }
+        return true;
+    }
+    
+    void TearDown() override {
+        // Listeners write into rings; stop every member before they go
+        for (auto& node : nodes) {
+            if (node) node->stop_discovery();
+        }
+        nodes.clear();
+    }
+    
+    // Declared before nodes so they outlive any listener still running
+    std::vector<std::unique_ptr<HashRing>> rings;
+    std::vector<std::unique_ptr<NodeDiscovery>> nodes;
+    std::vector<std::string> ids;
+};
+
+TEST_F(NodeDiscoveryTest, MembersLearnEachOtherThroughOneSeed) {
+    for (int i = 0; i < 5; ++i) add_member("node-" + std::to_string(i));
+    ASSERT_TRUE(wait_until([this]() { return all_see(5) && rings_hold(5); }));
+    for (auto& ring : rings) {
+        EXPECT_EQ(ring->get_all_nodes().size(), 5);
+    }
+}
+
+TEST_F(NodeDiscoveryTest, StoppedMemberIsDeclaredDeadAndLeavesRing) {
+    for (int i = 0; i < 4; ++i) add_member("node-" + std::to_string(i));
+    ASSERT_TRUE(wait_until([this]() { return all_see(4); }));
+    
+    nodes[3]->stop_discovery();
+    ASSERT_TRUE(wait_until([this]() {
+        for (int i = 0; i < 3; ++i) {
+            if (nodes[i]->state_of("node-3") != NodeDiscovery::State::DEAD) return false;
+            if (rings[i]->get_all_nodes().size() != 3) return false;
+        }
+        return true;
+    }));
+    for (int i = 0; i < 3; ++i) {
+        auto members = rings[i]->get_all_nodes();
+        EXPECT_EQ(std::count(members.begin(), members.end(), "node-3"), 0);
+        EXPECT_EQ(members.size(), 3);
+    }
+}
+
+TEST_F(NodeDiscoveryTest, RestartedMemberRefutesAndRejoins) {
+    for (int i = 0; i < 3; ++i) add_member("node-" + std::to_string(i));
+    ASSERT_TRUE(wait_until([this]() { return all_see(3); }));
+    
+    int port = nodes[2]->port();
+    nodes[2].reset();
+    ASSERT_TRUE(wait_until([this]() { return nodes[0]->state_of("node-2") == NodeDiscovery::State::DEAD; }));
+    
+    // Same id and port, starting again from incarnation 0: it has to learn
+    // it was declared dead and outbid that
+    auto restarted = std::make_unique<NodeDiscovery>("node-2", port, fast_config());
+    restarted->add_seed_node("node-0", "127.0.0.1", nodes[0]->port());
+    restarted->start_discovery();
+    nodes[2] = std::move(restarted);
+    
+    ASSERT_TRUE(wait_until([this]() { return all_see(3) && rings[0]->get_all_nodes().size() == 3; }));
+    EXPECT_GT(nodes[2]->incarnation(), 0);
+    auto members = rings[0]->get_all_nodes();
+    EXPECT_EQ(std::count(members.begin(), members.end(), "node-2"), 1);
+}
+
+TEST_F(NodeDiscoveryTest, ProbeLoadDoesNotGrowWithClusterSize) {
+    for (int i = 0; i < 8; ++i) add_member("node-" + std::to_string(i));
+    ASSERT_TRUE(wait_until([this]() { return all_see(8); }));
+    
+    std::vector<uint64_t> before;
+    for (auto& node : nodes) before.push_back(node->probes_sent());
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    
+    // One probe per 50ms period, whatever the member count
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        uint64_t sent = nodes[i]->probes_sent() - before[i];
+        EXPECT_GE(sent, 5);
+        EXPECT_LE(sent, 11);
+    }
+}
@@ -0,0 +1,77 @@
+#include "TestCluster.h"
+
+class QuorumCoordinatorTest : public ClusterTest {
+protected:
+    bool stored_everywhere(const std::string& key, const std::string& expected) {
+        for (auto& node : nodes) {
+            std::string value;
+            uint64_t version = 0;
+            if (!node->cache.get_versioned(key, value, version) || value != expected) return false;
+        }
+        return true;
+    }
+};
+
+TEST_F(QuorumCoordinatorTest, PolicyByLongestPrefix) {
+    QuorumCoordinator::Policy fast, strict;
+    ASSERT_TRUE(QuorumCoordinator::parse_policy("3/1/1", fast));
+    ASSERT_TRUE(QuorumCoordinator::parse_policy("3/3/3", strict));
+    EXPECT_FALSE(QuorumCoordinator::parse_policy("2/3/1", fast));
+    EXPECT_FALSE(QuorumCoordinator::parse_policy("3/0/1", fast));
+    EXPECT_FALSE(QuorumCoordinator::parse_policy("3/x/1", fast));
+    
+    auto& quorum = nodes[0]->quorum;
+    quorum.set_policy("session:", fast);
+    quorum.set_policy("session:admin:", strict);
+    
+    EXPECT_EQ(quorum.policy_for("session:42").r, 1);
+    EXPECT_EQ(quorum.policy_for("session:admin:7").r, 3);
+    EXPECT_EQ(quorum.policy_for("sessions").r, 2);
+    EXPECT_EQ(quorum.policy_for("account:1").w, 2);
+    EXPECT_TRUE(quorum.replicated("session:42"));
+    EXPECT_FALSE(quorum.replicated("account:1"));
+}
+
+TEST_F(QuorumCoordinatorTest, WriteReachesPreferenceList) {
+    TestClient client(nodes[0]->server.port());
+    EXPECT_EQ(client.command({"QSET", "user:1", "alice", "W", "3"}).str, "OK");
+    EXPECT_TRUE(stored_everywhere("user:1", "alice"));
+    EXPECT_EQ(client.command({"QGET", "user:1", "R", "3"}).str, "alice");
+    EXPECT_TRUE(client.command({"QGET", "missing", "R", "2"}).is_nil);
+    
+    // With N=1 only the owner, the head of the preference list, stores it
+    EXPECT_EQ(client.command({"QSET", "solo", "x", "N", "1", "W", "1"}).str, "OK");
+    const std::string head = nodes[0]->ring.preference_list("solo", 1)[0];
+    for (auto& node : nodes) {
+        EXPECT_EQ(node->cache.exists("solo"), node->id == head) << node->id;
+    }
+    EXPECT_EQ(head, nodes[0]->ring.get_node("solo"));
+}
+
+TEST_F(QuorumCoordinatorTest, ReadReturnsNewestAndRepairsStaleReplicas) {
+    TestClient client(nodes[1]->server.port());
+    ASSERT_EQ(client.command({"QSET", "cart", "v1", "W", "3"}).str, "OK");
+    
+    // One replica alone takes a newer version
+    nodes[2]->quorum.store("cart", "v2", nodes[2]->cache.next_version());
+    
+    EXPECT_EQ(client.command({"QGET", "cart", "R", "3"}).str, "v2");
+    for (int i = 0; i < 100 && !stored_everywhere("cart", "v2"); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(stored_everywhere("cart", "v2"));
+    EXPECT_EQ(nodes[1]->quorum.read_repairs(), 2);
+}
+
+TEST_F(QuorumCoordinatorTest, QuorumSurvivesOneReplicaDown) {
+    nodes[2]->server.stop();
+    
+    TestClient client(nodes[0]->server.port());
+    EXPECT_EQ(client.command({"QSET", "k", "v", "W", "2"}).str, "OK");
+    EXPECT_EQ(client.command({"QGET", "k", "R", "2"}).str, "v");
+    
+    auto failed = client.command({"QSET", "k", "v2", "W", "3"});
+    EXPECT_EQ(failed.type, '-');
+    EXPECT_EQ(client.command({"QGET", "k", "R", "3"}).type, '-');
+    EXPECT_EQ(client.command({"QGET", "k", "R", "4"}).type, '-');
+}
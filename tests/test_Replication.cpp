@@ -0,0 +1,135 @@
+#include "TestCluster.h"
+#include "cluster/Replica.h"
+
+class ReplicationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        primary = std::make_unique<TestNode>("primary");
+        replica_node = std::make_unique<TestNode>("replica");
+        for (TestNode* node : {primary.get(), replica_node.get()}) {
+            node->server.listen();
+            node->thread = std::thread([node]() { node->server.start(); });
+        }
+        replica = std::make_unique<Replica>(replica_node->cache, "127.0.0.1", primary->server.port(),
+                                            &replica_node->metrics);
+        replica_node->server.attach_replica(*replica);
+    }
+    
+    void TearDown() override {
+        replica->stop();
+    }
+    
+    void write_keys(const std::string& prefix, int count) {
+        TestClient client(primary->server.port());
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(client.command({"SET", prefix + std::to_string(i), std::to_string(i)}).str, "OK");
+        }
+    }
+    
+    bool caught_up() {
+        return replica->synced() && replica->applied_lsn() == primary->wal.last_lsn();
+    }
+    
+    std::unique_ptr<TestNode> primary;
+    std::unique_ptr<TestNode> replica_node;
+    std::unique_ptr<Replica> replica;
+};
+
+TEST_F(ReplicationTest, BootstrapsFromSnapshotThenStreams) {
+    write_keys("before", 200);
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    EXPECT_EQ(replica->full_syncs(), 1);
+    EXPECT_EQ(replica_node->cache.size(), 200);
+    
+    write_keys("after", 100);
+    TestClient client(primary->server.port());
+    EXPECT_EQ(client.command({"DEL", "before0"}).integer, 1);
+    
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    std::string value;
+    EXPECT_TRUE(replica_node->cache.get("after99", value));
+    EXPECT_EQ(value, "99");
+    EXPECT_FALSE(replica_node->cache.exists("before0"));
+    EXPECT_EQ(replica->full_syncs(), 1);
+    EXPECT_EQ(replica->lag(), 0);
+    EXPECT_EQ(replica_node->metrics.get_gauge("replication_lag"), 0.0);
+}
+
+TEST_F(ReplicationTest, ReplicaServesReadsAndRefusesWrites) {
+    write_keys("k", 10);
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    
+    TestClient client(replica_node->server.port());
+    EXPECT_EQ(client.command({"GET", "k3"}).str, "3");
+    auto refused = client.command({"SET", "k3", "changed"});
+    EXPECT_EQ(refused.type, '-');
+    EXPECT_EQ(refused.str.rfind("READONLY", 0), 0);
+    EXPECT_EQ(client.command({"DEL", "k3"}).type, '-');
+    EXPECT_EQ(client.command({"GET", "k3"}).str, "3");
+    
+    auto role = client.command({"ROLE"});
+    ASSERT_EQ(role.elements.size(), 5);
+    EXPECT_EQ(role.elements[0].str, "replica");
+    EXPECT_EQ(role.elements[2].str, "synced");
+    
+    TestClient primary_client(primary->server.port());
+    auto primary_role = primary_client.command({"ROLE"});
+    ASSERT_EQ(primary_role.elements.size(), 3);
+    EXPECT_EQ(primary_role.elements[0].str, "primary");
+    EXPECT_EQ(primary_role.elements[2].str, "1");
+}
+
+TEST_F(ReplicationTest, ResumesFromBacklogAfterReconnect) {
+    write_keys("a", 50);
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    replica->stop();
+    
+    write_keys("b", 50);
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    EXPECT_EQ(replica->full_syncs(), 1);
+    EXPECT_EQ(replica_node->cache.size(), 100);
+}
+
+TEST_F(ReplicationTest, LaggingReplicaResyncsFromSnapshot) {
+    primary->wal.set_backlog_limit(10);
+    write_keys("a", 20);
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    replica->stop();
+    
+    // More writes than the backlog holds while the replica is away
+    write_keys("b", 50);
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return replica->full_syncs() == 2 && caught_up(); }));
+    EXPECT_EQ(replica_node->cache.size(), 70);
+}
+
+TEST_F(ReplicationTest, ReplicasKeepVersionsAndTtls) {
+    TestClient client(primary->server.port());
+    ASSERT_EQ(client.command({"SET", "snapshotted", "v", "EX", "100"}).str, "OK");
+    replica->start();
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    ASSERT_EQ(client.command({"SET", "streamed", "v", "EX", "50"}).str, "OK");
+    ASSERT_EQ(client.command({"VSET", "quorum", "v", "7000", "30"}).integer, 1);
+    ASSERT_TRUE(wait_until([this]() { return caught_up(); }));
+    
+    // Copies on the replica expire with the primary's, not never
+    std::string value;
+    uint64_t version = 0, primary_version = 0;
+    int ttl = 0;
+    ASSERT_TRUE(replica_node->cache.get_versioned("snapshotted", value, version, &ttl));
+    EXPECT_GT(ttl, 95);
+    EXPECT_LE(ttl, 100);
+    ASSERT_TRUE(primary->cache.get_versioned("snapshotted", value, primary_version));
+    EXPECT_EQ(version, primary_version);
+    ASSERT_TRUE(replica_node->cache.get_versioned("streamed", value, version, &ttl));
+    EXPECT_GT(ttl, 45);
+    EXPECT_LE(ttl, 50);
+    ASSERT_TRUE(replica_node->cache.get_versioned("quorum", value, version, &ttl));
+    EXPECT_EQ(version, 7000u);
+    EXPECT_LE(ttl, 30);
+}
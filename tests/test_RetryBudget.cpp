@@ -0,0 +1,196 @@
+#include "TestCluster.h"
+#include "patterns/RetryBudget.h"
+#include <atomic>
+#include <mutex>
+#include <poll.h>
+
+TEST(RetryBudgetTest, StartsWithBurstThenEarnsFromRequests) {
+    RetryBudget budget(0.1, 2);
+    EXPECT_TRUE(budget.try_spend());
+    EXPECT_TRUE(budget.try_spend());
+    EXPECT_FALSE(budget.try_spend());
+    
+    // Ten requests earn one retry
+    for (int i = 0; i < 9; ++i) budget.deposit();
+    EXPECT_FALSE(budget.try_spend());
+    budget.deposit();
+    EXPECT_TRUE(budget.try_spend());
+    EXPECT_EQ(budget.spent(), 3u);
+    EXPECT_EQ(budget.refused(), 2u);
+}
+
+TEST(RetryBudgetTest, BalanceIsCapped) {
+    RetryBudget budget(0.5, 3);
+    for (int i = 0; i < 1000; ++i) budget.deposit();
+    EXPECT_DOUBLE_EQ(budget.balance(), 3.0);
+    int spent = 0;
+    while (budget.try_spend()) spent++;
+    EXPECT_EQ(spent, 3);
+}
+
+TEST(RetryBudgetTest, ConcurrentSpendersShareTheBalance) {
+    RetryBudget budget(0.1, 1);
+    ASSERT_TRUE(budget.try_spend());
+    std::atomic<int> spent{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                budget.deposit();
+                if (budget.try_spend()) spent++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    // 4000 requests at 10% earn 400 retries
+    EXPECT_GE(spent.load(), 399);
+    EXPECT_LE(spent.load(), 400);
+}
+
+// Stand-in for a peer whose replies can be delayed: answers PEER with +OK
+// and anything else with reply
+class SlowPeer {
+public:
+    explicit SlowPeer(const std::string& reply) : reply_(reply), fd_(Socket::listen_tcp(0)) {
+        acceptor_ = std::thread([this]() {
+            while (!stopping_) {
+                pollfd pfd{fd_, POLLIN, 0};
+                if (::poll(&pfd, 1, 50) <= 0) continue;
+                int client = ::accept(fd_, nullptr, nullptr);
+                if (client < 0) continue;
+                std::lock_guard<std::mutex> lock(mutex_);
+                clients_.push_back(client);
+                workers_.emplace_back([this, client]() { serve(client); });
+            }
+        });
+    }
+    
+    ~SlowPeer() {
+        stopping_ = true;
+        acceptor_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int client : clients_) ::shutdown(client, SHUT_RDWR);
+        for (auto& worker : workers_) worker.join();
+        for (int client : clients_) ::close(client);
+        ::close(fd_);
+    }
+    
+    int port() const { return Socket::local_port(fd_); }
+    std::atomic<int> delay_ms{0};
+    
+private:
+    void serve(int client) {
+        std::string buffer;
+        char chunk[4096];
+        ssize_t n;
+        while ((n = ::recv(client, chunk, sizeof(chunk), 0)) > 0) {
+            buffer.append(chunk, static_cast<size_t>(n));
+            std::vector<std::string> argv;
+            size_t consumed = 0;
+            while (RESPParser::parse_request(buffer, consumed, argv)) {
+                buffer.erase(0, consumed);
+                if (argv[0] == "PEER") {
+                    Socket::send_all(client, "+OK\r\n");
+                    continue;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms.load()));
+                Socket::send_all(client, RESPParser().serialize_bulk(reply_));
+            }
+        }
+    }
+    
+    std::string reply_;
+    int fd_;
+    std::atomic<bool> stopping_{false};
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> clients_;
+    std::vector<std::thread> workers_;
+};
+
+// node-a forwards to node-b, which can be made slow; node-c holds the
+// other replica of the replicated "key-" keyspace
+class HedgedReadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        replica.server.listen();
+        for (TestNode* node : {&coordinator, &replica}) {
+            for (const char* id : {"node-a", "node-b", "node-c"}) node->ring.add_node(id);
+        }
+        coordinator.peers.add_peer("node-b", "127.0.0.1", owner.port());
+        coordinator.peers.add_peer("node-c", "127.0.0.1", replica.server.port());
+        coordinator.server.enable_forwarding("node-a", coordinator.peers);
+        QuorumCoordinator::Policy policy;
+        QuorumCoordinator::parse_policy("3/1/1", policy);
+        coordinator.quorum.set_policy("key-", policy);
+        coordinator.server.enable_quorum(coordinator.quorum);
+        coordinator.server.enable_hedged_reads();
+        coordinator.server.listen();
+        for (TestNode* node : {&coordinator, &replica}) {
+            node->thread = std::thread([node]() { node->server.start(); });
+        }
+    }
+    
+    std::string key_on_owner(int start, const std::string& prefix = "key-") {
+        for (int i = start;; ++i) {
+            std::string key = prefix + std::to_string(i);
+            if (coordinator.ring.get_node(key) == "node-b") return key;
+        }
+    }
+    
+    SlowPeer owner{"from-b"};
+    TestNode coordinator{"node-a"};
+    TestNode replica{"node-c"};
+};
+
+TEST_F(HedgedReadTest, SlowOwnerIsOvertakenByReplica) {
+    std::string key = key_on_owner(0);
+    replica.cache.set(key, "from-c");
+    TestClient client(coordinator.server.port());
+    
+    // Learn the owner's normal latency first
+    for (int i = 0; i < 20; ++i) ASSERT_EQ(client.command({"GET", key}).str, "from-b");
+    
+    owner.delay_ms = 500;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(client.command({"GET", key}).str, "from-c");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(300));
+}
+
+TEST_F(HedgedReadTest, ReplicaMissWaitsForOwner) {
+    std::string key = key_on_owner(0);
+    TestClient client(coordinator.server.port());
+    for (int i = 0; i < 20; ++i) ASSERT_EQ(client.command({"GET", key}).str, "from-b");
+    
+    owner.delay_ms = 300;
+    EXPECT_EQ(client.command({"GET", key}).str, "from-b");
+}
+
+TEST_F(HedgedReadTest, UnreplicatedKeysAreNotHedged) {
+    std::string key = key_on_owner(0, "plain-");
+    replica.cache.set(key, "from-c");
+    TestClient client(coordinator.server.port());
+    for (int i = 0; i < 20; ++i) ASSERT_EQ(client.command({"GET", key}).str, "from-b");
+    
+    owner.delay_ms = 300;
+    EXPECT_EQ(client.command({"GET", key}).str, "from-b");
+    EXPECT_EQ(coordinator.metrics.get_counter("reads_hedged"), 0u);
+}
+
+TEST_F(HedgedReadTest, PipelinedReadHedgesWithoutWaitingItsTurn) {
+    std::string key = key_on_owner(0);
+    std::string slow_write = key_on_owner(1000);
+    replica.cache.set(key, "from-c");
+    TestClient client(coordinator.server.port());
+    for (int i = 0; i < 20; ++i) ASSERT_EQ(client.command({"GET", key}).str, "from-b");
+    
+    // The forwarded SET is never hedged and holds the reply loop for its
+    // full delay; the GET queued behind it must hedge at its own p95
+    owner.delay_ms = 600;
+    std::string batch = RESPParser::serialize_command({"SET", slow_write, "v"}) +
+                        RESPParser::serialize_command({"GET", key});
+    std::thread waiter([&]() { client.call(batch, 2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(coordinator.metrics.get_counter("reads_hedged"), 1u);
+    waiter.join();
+}
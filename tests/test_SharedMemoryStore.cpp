@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <cstdint>
+#include <unistd.h>
+#include "storage/SharedMemoryStore.h"
+
+class SharedMemoryStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        region = "test_shm_region.dat";
+        SharedMemoryStore::remove(region);
+    }
+    
+    void TearDown() override {
+        SharedMemoryStore::remove(region);
+    }
+    
+    static constexpr size_t REGION_BYTES = 1 << 20;
+    std::string region;
+};
+
+TEST_F(SharedMemoryStoreTest, ReattachRestoresCache) {
+    {
+        auto store = std::make_shared<SharedMemoryStore>(region, REGION_BYTES);
+        EXPECT_FALSE(store->restored());
+        LRUCache cache(1000, 4);
+        cache.add_listener(store.get());
+        for (int i = 0; i < 100; ++i) {
+            cache.set("key" + std::to_string(i), "value " + std::to_string(i));
+        }
+        EXPECT_EQ(store->size(), 100);
+        store->mark_complete();
+    }
+    
+    auto store = std::make_shared<SharedMemoryStore>(region, REGION_BYTES);
+    ASSERT_TRUE(store->restored());
+    EXPECT_EQ(store->size(), 100);
+    
+    LRUCache cache(1000, 4);
+    cache.add_listener(store.get());
+    cache.attach_warm_source(store);
+    
+    std::string value;
+    EXPECT_TRUE(cache.get("key7", value)); // Served before the bulk load
+    EXPECT_EQ(value, "value 7");
+    
+    store->load_remaining(cache);
+    cache.detach_warm_source();
+    EXPECT_EQ(cache.size(), 100);
+    EXPECT_EQ(store->size(), 100);
+}
+
+TEST_F(SharedMemoryStoreTest, MirrorsDeletesAndEvictions) {
+    auto store = std::make_shared<SharedMemoryStore>(region, REGION_BYTES);
+    LRUCache cache(10);
+    cache.add_listener(store.get());
+    
+    for (int i = 0; i < 20; ++i) {
+        cache.set("key" + std::to_string(i), "value");
+    }
+    EXPECT_EQ(store->size(), 10);
+    
+    std::string value;
+    EXPECT_FALSE(store->get("key0", value)); // Evicted from the cache
+    cache.del("key19");
+    EXPECT_FALSE(store->get("key19", value));
+    cache.set("key18", "updated");
+    EXPECT_TRUE(store->get("key18", value));
+    EXPECT_EQ(value, "updated");
+    EXPECT_EQ(store->size(), 9);
+}
+
+TEST_F(SharedMemoryStoreTest, LargeEntriesSpanSeveralSlots) {
+    std::string big_key(300, 'k');
+    std::string big_value(5000, 'v');
+    big_value[4999] = 'z';
+    {
+        SharedMemoryStore store(region, REGION_BYTES, 128);
+        EXPECT_TRUE(store.put("key", "small", INT64_MAX));
+        EXPECT_TRUE(store.put("key", big_value, INT64_MAX));
+        EXPECT_TRUE(store.put(big_key, "value", INT64_MAX));
+        EXPECT_EQ(store.skipped(), 0);
+        store.mark_complete();
+    }
+    
+    SharedMemoryStore store(region, REGION_BYTES, 128);
+    ASSERT_TRUE(store.restored());
+    std::string value;
+    EXPECT_TRUE(store.get("key", value));
+    EXPECT_EQ(value, big_value);
+    EXPECT_TRUE(store.get(big_key, value));
+    EXPECT_EQ(value, "value");
+    
+    // Shrinking returns the extra slots to the free lists
+    size_t capacity = store.slot_capacity();
+    EXPECT_TRUE(store.put("key", "small", INT64_MAX));
+    for (size_t i = 0; store.put("fill" + std::to_string(i), "value", INT64_MAX); ++i) {
+        ASSERT_LT(i, capacity);
+    }
+    EXPECT_TRUE(store.get("key", value));
+    EXPECT_EQ(value, "small");
+    EXPECT_EQ(store.size(), capacity - 2); // big_key still holds three slots
+}
+
+TEST_F(SharedMemoryStoreTest, EntriesWithoutRoomAreNotMirrored) {
+    SharedMemoryStore store(region, 64 << 10, 128);
+    EXPECT_TRUE(store.put("key", "small", INT64_MAX));
+    EXPECT_FALSE(store.put("key", std::string(128 << 10, 'x'), INT64_MAX));
+    
+    std::string value;
+    EXPECT_FALSE(store.get("key", value)); // Stale copy dropped too
+    EXPECT_EQ(store.skipped(), 1);
+    EXPECT_EQ(store.size(), 0);
+    EXPECT_TRUE(store.put("key", "small", INT64_MAX)); // Partial chain was released
+}
+
+TEST_F(SharedMemoryStoreTest, LayoutMismatchReinitializes) {
+    {
+        SharedMemoryStore store(region, REGION_BYTES, 256);
+        store.put("key", "value", INT64_MAX);
+    }
+    SharedMemoryStore store(region, REGION_BYTES, 512);
+    EXPECT_FALSE(store.restored());
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST_F(SharedMemoryStoreTest, PosixSharedMemoryName) {
+    std::string name = "/distcache_test_" + std::to_string(::getpid());
+    {
+        SharedMemoryStore store(name, REGION_BYTES);
+        store.put("key", "value", INT64_MAX);
+        store.mark_complete();
+    }
+    {
+        SharedMemoryStore store(name, REGION_BYTES);
+        EXPECT_TRUE(store.restored());
+        std::string value;
+        EXPECT_TRUE(store.get("key", value));
+        EXPECT_EQ(value, "value");
+    }
+    SharedMemoryStore::remove(name);
+}
+
+TEST_F(SharedMemoryStoreTest, IncompleteRegionIsNotRestored) {
+    {
+        SharedMemoryStore store(region, REGION_BYTES);
+        store.put("key", "value", INT64_MAX);  // Recovery never finished
+    }
+    {
+        SharedMemoryStore store(region, REGION_BYTES, 512);
+        EXPECT_FALSE(store.restored());
+        store.put("key", "value", INT64_MAX);
+        store.mark_complete();
+        EXPECT_FALSE(store.put("big", std::string(REGION_BYTES, 'x'), INT64_MAX));
+    }
+    SharedMemoryStore store(region, REGION_BYTES);
+    EXPECT_FALSE(store.restored());
+}
+
+TEST_F(SharedMemoryStoreTest, FreedSlotsAreReusedAcrossStripes) {
+    SharedMemoryStore store(region, 64 << 10, 128);
+    size_t capacity = store.slot_capacity();
+    size_t stored = 0;
+    for (size_t i = 0; i < capacity + 10; ++i) {
+        if (store.put("key" + std::to_string(i), "value", INT64_MAX)) stored++;
+    }
+    EXPECT_EQ(stored, capacity);
+    
+    // Space freed on any stripe can be taken by a key on another
+    for (size_t i = 0; i < capacity; i += 2) store.erase("key" + std::to_string(i));
+    size_t restored = 0;
+    for (size_t i = 0; i < capacity; ++i) {
+        if (store.put("other" + std::to_string(i), "value", INT64_MAX)) restored++;
+    }
+    EXPECT_EQ(restored, (capacity + 1) / 2);
+    EXPECT_EQ(store.size(), capacity);
+}
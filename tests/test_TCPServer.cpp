@@ -0,0 +1,157 @@
+#include "TestCluster.h"
+#include "network/PeerConnection.h"
+#include <future>
+
+class TCPServerTest : public ClusterTest {};
+
+TEST_F(TCPServerTest, InlineAndRespCommands) {
+    TestClient client(nodes[0]->server.port());
+    ASSERT_TRUE(client.connected());
+    
+    auto replies = client.call("PING\r\n", 1);
+    ASSERT_EQ(replies.size(), 1);
+    EXPECT_EQ(replies[0].str, "PONG");
+    
+    EXPECT_EQ(client.command({"SET", "greeting", "hello world"}).str, "OK");
+    EXPECT_EQ(client.command({"GET", "greeting"}).str, "hello world");
+    EXPECT_EQ(client.command({"DEL", "greeting"}).integer, 1);
+    EXPECT_TRUE(client.command({"GET", "greeting"}).is_nil);
+    EXPECT_EQ(client.command({"NOPE"}).type, '-');
+}
+
+TEST_F(TCPServerTest, RejectedProbeStillSettlesTheBreaker) {
+    for (int i = 0; i < 5; ++i) nodes[0]->breaker.record_failure();
+    ASSERT_EQ(nodes[0]->breaker.get_state(), CircuitBreaker::OPEN);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    
+    // The half-open probe is an unknown command: it must still hand its
+    // permit back rather than leave the breaker half open for good
+    TestClient client(nodes[0]->server.port());
+    EXPECT_EQ(client.command({"NOPE"}).type, '-');
+    EXPECT_EQ(nodes[0]->breaker.get_state(), CircuitBreaker::CLOSED);
+    EXPECT_EQ(client.command({"PING"}).str, "PONG");
+}
+
+TEST_F(TCPServerTest, KeysAreStoredOnlyOnTheOwner) {
+    TestClient client(nodes[0]->server.port());
+    for (int i = 0; i < 30; ++i) {
+        std::string key = "key" + std::to_string(i);
+        ASSERT_EQ(client.command({"SET", key, "value" + std::to_string(i)}).str, "OK");
+    }
+    
+    for (int i = 0; i < 30; ++i) {
+        std::string key = "key" + std::to_string(i);
+        TestNode& owner = owner_of(key);
+        for (auto& node : nodes) {
+            EXPECT_EQ(node->cache.exists(key), node.get() == &owner) << key << " on " << node->id;
+        }
+        // Readable through any node
+        TestClient other(nodes[i % 3]->server.port());
+        EXPECT_EQ(other.command({"GET", key}).str, "value" + std::to_string(i));
+    }
+}
+
+TEST_F(TCPServerTest, BoundedLoadSpillsHotReadsToReplicas) {
+    QuorumCoordinator::Policy policy;
+    ASSERT_TRUE(QuorumCoordinator::parse_policy("3/1/1", policy));
+    nodes[0]->quorum.set_policy("hot:", policy);
+    nodes[0]->ring.enable_bounded_load(0.25);
+    
+    // Every replica holds its own value, so the reply shows who served it
+    std::string key = "hot:1";
+    for (auto& node : nodes) node->cache.set(key, node->id);
+    auto replicas = nodes[0]->ring.preference_list(key, 3);
+    ASSERT_EQ(replicas.size(), 3);
+    
+    TestClient client(nodes[0]->server.port());
+    EXPECT_EQ(client.command({"GET", key}).str, replicas[0]);
+    
+    // With the owner over its share of in-flight reads, the next replica
+    // serves the key instead of the read being routed back to the owner
+    std::vector<uint32_t> held;
+    for (int i = 0; i < 10; ++i) held.push_back(nodes[0]->ring.acquire(key, 1));
+    EXPECT_EQ(client.command({"GET", key}).str, replicas[1]);
+    for (uint32_t node : held) nodes[0]->ring.release(node);
+    EXPECT_EQ(client.command({"GET", key}).str, replicas[0]);
+    
+    // Keys outside a replicated keyspace are still read from their owner
+    nodes[0]->cache.set("cold", "local");
+    if (owner_of("cold").id != nodes[0]->id) EXPECT_TRUE(client.command({"GET", "cold"}).is_nil);
+}
+
+TEST_F(TCPServerTest, PipelinedRepliesStayInOrder) {
+    TestClient client(nodes[1]->server.port());
+    std::string batch;
+    for (int i = 0; i < 100; ++i) {
+        batch += RESPParser::serialize_command({"SET", "p" + std::to_string(i), std::to_string(i)});
+    }
+    for (int i = 0; i < 100; ++i) {
+        batch += RESPParser::serialize_command({"GET", "p" + std::to_string(i)});
+    }
+    
+    auto replies = client.call(batch, 200);
+    ASSERT_EQ(replies.size(), 200);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(replies[i].str, "OK");
+        EXPECT_EQ(replies[100 + i].str, std::to_string(i));
+    }
+}
+
+TEST_F(TCPServerTest, MultiKeyCommandsSpanNodes) {
+    TestClient client(nodes[2]->server.port());
+    EXPECT_EQ(client.command({"MSET", "a", "1", "b", "2", "c", "3", "d", "4"}).str, "OK");
+    
+    auto reply = client.command({"MGET", "a", "b", "missing", "d"});
+    ASSERT_EQ(reply.elements.size(), 4);
+    EXPECT_EQ(reply.elements[0].str, "1");
+    EXPECT_EQ(reply.elements[1].str, "2");
+    EXPECT_TRUE(reply.elements[2].is_nil);
+    EXPECT_EQ(reply.elements[3].str, "4");
+    
+    EXPECT_EQ(client.command({"EXISTS", "a", "b", "missing"}).integer, 2);
+    EXPECT_EQ(client.command({"DEL", "a", "b", "c", "d"}).integer, 4);
+}
+
+TEST_F(TCPServerTest, UnreachablePeerFailsFast) {
+    // Find a key owned by node-c, then take node-c down
+    std::string key;
+    for (int i = 0; key.empty(); ++i) {
+        std::string candidate = "k" + std::to_string(i);
+        if (owner_of(candidate).id == "node-c") key = candidate;
+    }
+    nodes[2]->server.stop();
+    nodes[2]->thread.join();
+    
+    TestClient client(nodes[0]->server.port());
+    auto reply = client.command({"GET", key});
+    EXPECT_EQ(reply.type, '-');
+    EXPECT_EQ(client.command({"PING"}).str, "PONG");
+}
+
+TEST_F(TCPServerTest, PeerConnectionDroppedFromItsOwnCallback) {
+    auto connection = std::make_shared<PeerConnection>("127.0.0.1", nodes[0]->server.port());
+    std::promise<void> sent;
+    std::shared_future<void> all_sent = sent.get_future().share();
+    std::promise<void> done;
+    std::atomic<int> answered{0};
+    
+    // The first reply drops the last reference on the reader thread; the
+    // replies behind it must still be delivered or failed cleanly
+    std::string ping = RESPParser::serialize_command({"PING"});
+    connection->send(ping, [&, all_sent](bool, std::string) {
+        all_sent.wait();
+        connection.reset();
+        if (++answered == 3) done.set_value();
+    });
+    for (int i = 0; i < 2; ++i) {
+        connection->send(ping, [&](bool, std::string) {
+            if (++answered == 3) done.set_value();
+        });
+    }
+    sent.set_value();
+    
+    auto result = done.get_future().wait_for(std::chrono::seconds(5));
+    EXPECT_EQ(result, std::future_status::ready);
+    EXPECT_EQ(answered, 3);
+    EXPECT_EQ(connection, nullptr);
+}
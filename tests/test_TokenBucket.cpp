@@ -0,0 +1,115 @@
+#include "TestCluster.h"
+#include "patterns/TokenBucket.h"
+#include <atomic>
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+TEST(TokenBucketTest, BurstThenRate) {
+    TokenBucket bucket(100, 10);  // 100/s, 10 at once
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(bucket.try_consume(1));
+    EXPECT_FALSE(bucket.try_consume(1));
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(bucket.try_consume(4));  // ~5 refilled
+    EXPECT_LT(bucket.available(), 2.0);
+}
+
+TEST(TokenBucketTest, ConsumeBorrowsAndReportsPause) {
+    TokenBucket bucket(1000, 100);
+    EXPECT_EQ(bucket.consume(100).count(), 0);
+    // 200 over the burst at 1000/s is 200ms of debt
+    auto pause = bucket.consume(200);
+    double pause_ms = std::chrono::duration<double, std::milli>(pause).count();
+    EXPECT_NEAR(pause_ms, 200.0, 5.0);
+    EXPECT_FALSE(bucket.try_consume(1));
+}
+
+TEST(TokenBucketTest, UnlimitedNeverPauses) {
+    TokenBucket bucket;
+    EXPECT_TRUE(bucket.unlimited());
+    EXPECT_EQ(bucket.consume(1e9).count(), 0);
+    EXPECT_TRUE(bucket.try_consume(1e9));
+}
+
+TEST(TokenBucketTest, SharedBucketHandsOutOnlyTheBurst) {
+    TokenBucket bucket(1, 1000);  // Refill is negligible during the test
+    std::atomic<int> granted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                if (bucket.try_consume(1)) granted++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_GE(granted.load(), 1000);
+    EXPECT_LE(granted.load(), 1001);
+}
+
+class RateLimitTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        node.ring.add_node("node-a");
+        TCPServer::RateLimits per_connection;
+        per_connection.ops_per_sec = 200;
+        per_connection.burst_seconds = 0.05;
+        TCPServer::RateLimits per_client;
+        per_client.ops_per_sec = 50;
+        per_client.burst_seconds = 0.2;
+        node.server.set_rate_limits(per_connection, per_client);
+        node.server.set_peer_secret("cluster-secret");
+        node.server.listen();
+        node.thread = std::thread([this]() { node.server.start(); });
+    }
+    
+    // Sequential GETs; every one must be answered
+    double run(TestClient& client, int count) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) {
+            EXPECT_EQ(client.command({"GET", "k"}).type, '$');
+        }
+        return elapsed_ms(start);
+    }
+    
+    TestNode node{"node-a"};
+};
+
+TEST_F(RateLimitTest, ConnectionIsSlowedNotDropped) {
+    TestClient client(node.server.port());
+    // 10 in the burst, then 200/s: 50 more take at least 250ms
+    EXPECT_GE(run(client, 60), 200.0);
+}
+
+TEST_F(RateLimitTest, NamedClientsShareABucket) {
+    TestClient first(node.server.port());
+    TestClient second(node.server.port());
+    TestClient other(node.server.port());
+    EXPECT_EQ(first.command({"CLIENT", "SETNAME", "batch"}).str, "OK");
+    EXPECT_EQ(second.command({"CLIENT", "SETNAME", "batch"}).str, "OK");
+    EXPECT_EQ(other.command({"CLIENT", "SETNAME", "web"}).str, "OK");
+    EXPECT_EQ(second.command({"CLIENT", "GETNAME"}).str, "batch");
+    
+    // "batch" spends its burst on the first connection, so the second one
+    // runs at 50/s from the start
+    run(first, 10);
+    EXPECT_GE(run(second, 10), 120.0);
+    EXPECT_LT(run(other, 5), 100.0);
+}
+
+TEST_F(RateLimitTest, OnlyPeersWithTheSecretAreExempt) {
+    TestClient impostor(node.server.port());
+    EXPECT_EQ(impostor.command({"PEER"}).type, '-');
+    EXPECT_EQ(impostor.command({"PEER", "guess"}).type, '-');
+    EXPECT_GE(run(impostor, 60), 200.0);
+    
+    TestClient peer(node.server.port());
+    EXPECT_EQ(peer.command({"PEER", "cluster-secret"}).str, "OK");
+    EXPECT_LT(run(peer, 60), 200.0);
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include "storage/WAL.h"
 
@@ -130,6 +131,13 @@ TEST_F(WALTest, WALTruncation) {
     
     auto ops = wal->replay();
     EXPECT_EQ(ops.size(), 0);
+    
+    // The file restarts empty but the LSNs do not
+    EXPECT_EQ(wal->append("SET", "key3", "value3"), 3u);
+    wal.reset();
+    wal = std::make_unique<WAL>(test_file);
+    EXPECT_EQ(wal->last_lsn(), 3u);
+    EXPECT_EQ(wal->replay().size(), 1u);
 }
 
 TEST_F(WALTest, WALSync) {
@@ -146,3 +154,157 @@ TEST_F(WALTest, WALSync) {
     EXPECT_NE(line.find("key1"), std::string::npos);
     EXPECT_NE(line.find("value1"), std::string::npos);
 }
+
+TEST_F(WALTest, ParallelReplayIntoCache) {
+    for (int i = 0; i < 5000; ++i) {
+        wal->append("SET", "key" + std::to_string(i % 1000), "value " + std::to_string(i));
+    }
+    for (int i = 0; i < 100; ++i) {
+        wal->append("DEL", "key" + std::to_string(i));
+    }
+    wal->sync();
+    
+    LRUCache cache(10000, 8);
+    size_t applied = wal->replay_into(cache, 4);
+    
+    EXPECT_EQ(applied, 5100);
+    EXPECT_EQ(cache.size(), 900);
+    
+    // Per-key order is preserved: the last SET for each key wins
+    std::string value;
+    EXPECT_FALSE(cache.get("key0", value));
+    EXPECT_TRUE(cache.get("key999", value));
+    EXPECT_EQ(value, "value 4999");
+}
+
+TEST_F(WALTest, CompactKeepsSuffixAndLsns) {
+    for (int i = 1; i <= 10; ++i) {
+        wal->append("SET", "key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    wal->compact(6);
+    EXPECT_EQ(wal->last_lsn(), 10u);
+    EXPECT_EQ(wal->append("SET", "key11", "value11"), 11u);
+    
+    auto ops = wal->replay();
+    ASSERT_EQ(ops.size(), 5u);
+    EXPECT_EQ(std::get<1>(ops[0]), "key7");
+    
+    // Numbering survives a restart and a second compaction
+    wal.reset();
+    wal = std::make_unique<WAL>(test_file);
+    EXPECT_EQ(wal->last_lsn(), 11u);
+    wal->compact(9);
+    wal.reset();
+    wal = std::make_unique<WAL>(test_file);
+    EXPECT_EQ(wal->last_lsn(), 11u);
+    
+    LRUCache cache(100);
+    EXPECT_EQ(wal->replay_into(cache, 2), 2u);
+    std::string value;
+    EXPECT_FALSE(cache.get("key9", value));
+    EXPECT_TRUE(cache.get("key10", value));
+}
+
+TEST_F(WALTest, ReplaySkipsKeysWrittenDuringReplay) {
+    wal->append("SET", "a", "old");
+    wal->append("SET", "b", "old");
+    wal->append("DEL", "c");
+    wal->sync();
+    
+    LRUCache cache(100, 4);
+    cache.set("c", "live-before");
+    cache.begin_replay();
+    cache.set("a", "live");
+    cache.set("c", "live");
+    EXPECT_EQ(wal->replay_into(cache, 2), 1u);
+    cache.end_replay();
+    
+    std::string value;
+    ASSERT_TRUE(cache.get("a", value));
+    EXPECT_EQ(value, "live");
+    ASSERT_TRUE(cache.get("b", value));
+    EXPECT_EQ(value, "old");
+    ASSERT_TRUE(cache.get("c", value));
+    EXPECT_EQ(value, "live");
+}
+
+TEST_F(WALTest, ReplayRestoresLoggedVersions) {
+    wal->append("VSET", "a", WAL::versioned_value(5000, "with spaces"));
+    wal->append("SET", "b", "plain");
+    
+    LRUCache cache(100);
+    EXPECT_EQ(wal->replay_into(cache, 2), 2u);
+    std::string value;
+    uint64_t version = 0;
+    ASSERT_TRUE(cache.get_versioned("a", value, version));
+    EXPECT_EQ(value, "with spaces");
+    EXPECT_EQ(version, 5000u);
+    
+    // An older copy from a peer still loses after the restart
+    EXPECT_FALSE(cache.set_versioned("a", "stale", 4000));
+    EXPECT_GT(cache.next_version(), 5000u);
+}
+
+TEST_F(WALTest, NewlinesInRecordsKeepOneRecordPerLine) {
+    wal->append("SET", "multi\nline key", "first\nsecond\r\n");
+    wal->append("SET", "tab\tkey", "back\\slash");
+    wal->append("SET", "plain", "value");
+    wal->compact(1);
+    
+    // Compaction cut exactly one record, and the count survives a reopen
+    wal.reset();
+    wal = std::make_unique<WAL>(test_file);
+    EXPECT_EQ(wal->last_lsn(), 3u);
+    
+    LRUCache cache(100, 4);
+    EXPECT_EQ(wal->replay_into(cache, 2), 2u);
+    std::string value;
+    EXPECT_FALSE(cache.get("multi\nline key", value));
+    ASSERT_TRUE(cache.get("tab\tkey", value));
+    EXPECT_EQ(value, "back\\slash");
+    ASSERT_TRUE(cache.get("plain", value));
+    EXPECT_EQ(value, "value");
+}
+
+TEST_F(WALTest, ReplayKeepsOnlyWhatIsLeftOfATtl) {
+    wal->append_set("session", "token", 100);
+    wal->append("SET", "stale", "old");
+    wal->append("SETEX", "stale", "1000 expired long ago");
+    wal->append_set("plain", "forever");
+    
+    LRUCache cache(100, 4);
+    wal->replay_into(cache, 2);
+    std::string value;
+    uint64_t version = 0;
+    int ttl = 0;
+    ASSERT_TRUE(cache.get_versioned("session", value, version, &ttl));
+    EXPECT_EQ(value, "token");
+    EXPECT_GT(ttl, 95);
+    EXPECT_LE(ttl, 100);
+    EXPECT_FALSE(cache.get("stale", value));
+    ASSERT_TRUE(cache.get("plain", value));
+    EXPECT_EQ(value, "forever");
+}
+
+TEST_F(WALTest, AppendsDuringCompactionAreKept) {
+    for (int i = 1; i <= 20000; ++i) {
+        wal->append("SET", "key" + std::to_string(i), std::string(64, 'v'));
+    }
+    std::atomic<bool> done{false};
+    std::thread writer([this, &done]() {
+        // Keeps appending for as long as the compaction runs
+        for (int i = 20001; !done || i <= 20100; ++i) {
+            wal->append("SET", "key" + std::to_string(i), "late");
+        }
+    });
+    wal->compact(15000);
+    done = true;
+    writer.join();
+    
+    // Nothing appended while the suffix was being copied went missing
+    uint64_t last = wal->last_lsn();
+    wal.reset();
+    wal = std::make_unique<WAL>(test_file);
+    EXPECT_EQ(wal->last_lsn(), last);
+    EXPECT_EQ(wal->replay().size(), last - 15000);
+}